@@ -0,0 +1,118 @@
+// bench_busy_poll.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+#include <time.h>
+}
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+
+// 原样回送收到的字节
+class BenchEchoServer : public TcpServer {
+public:
+    BenchEchoServer(const std::string &listen_addr, uint16_t listen_port) : TcpServer(listen_addr, listen_port) {}
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[4096];
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            send_data_nonblock(client_fd, buf, static_cast<uint16_t>(len));
+        }
+    }
+};
+
+static double process_cpu_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000.0 + static_cast<double>(ts.tv_nsec) / 1e6;
+}
+
+/*
+    忙轮询对比：单个客户端在请求之间停顿一段时间（模拟稀疏的低延迟请求），统计往返时延分位数（us），
+    以及进程在测量期间占用的CPU时间，对比普通的阻塞epoll_wait与enable_busy_poll()
+*/
+int bench_busy_poll()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18099;
+    const size_t ROUNDS = 2000;
+    const std::chrono::microseconds GAP(100);
+    const std::string message(64, 'b');
+
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "mode" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+        << std::setw(12) << "cpu ms" << "spin hits" << std::endl;
+    for (bool busy : { false, true }) {
+        try {
+            uint16_t port = static_cast<uint16_t>(server_port + (busy ? 1 : 0));
+            BenchEchoServer server(server_addr, port);
+            if (busy) {
+                TcpBusyPollConfig config;
+                config.spin_budget = GAP * 2;
+                server.enable_busy_poll(config);
+            }
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+
+            std::vector<double> samples;
+            double cpu_begin = 0;
+            {
+                TcpClient client(server_addr, port);
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                cpu_begin = process_cpu_ms();
+                char buf[4096];
+                for (size_t i = 0; i < ROUNDS && ok; i++) {
+                    std::this_thread::sleep_for(GAP);
+                    auto begin = std::chrono::steady_clock::now();
+                    send_data_nonblock(client.get_fd(), message.c_str(), static_cast<uint16_t>(message.size()));
+                    size_t received = 0;
+                    while (received < message.size()) {
+                        struct pollfd pfd = { client.get_fd(), POLLIN, 0 };
+                        ssize_t len = poll(&pfd, 1, 2000) > 0 ? recv(client.get_fd(), buf, sizeof(buf), MSG_DONTWAIT) : -1;
+                        if (len <= 0) {
+                            ok = false;
+                            break;
+                        }
+                        received += static_cast<size_t>(len);
+                    }
+                    samples.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - begin).count());
+                }
+            }
+            double cpu_used = process_cpu_ms() - cpu_begin;
+            running = false;
+            server_thread.join();
+
+            if (ok && !samples.empty()) {
+                TcpBusyPollStats stats = server.get_busy_poll_stats();
+                std::sort(samples.begin(), samples.end());
+                std::cout << std::left << std::setw(12) << (busy ? "busy poll" : "blocking") << std::fixed
+                    << std::setprecision(1) << std::setw(12) << samples[samples.size() / 2] << std::setw(12)
+                    << samples[samples.size() * 99 / 100] << std::setw(12) << cpu_used << std::setprecision(2)
+                    << stats.spin_hit_ratio() << std::endl;
+            }
+        } catch (const TcpRuntimeException& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << (ok ? "Busy poll benchmark finished" : "Busy poll benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,189 @@
+// bench_codec.cpp
+extern "C" {
+#include <arpa/inet.h>
+}
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <cstring>
+
+#include "tcp_codec.hpp"
+
+struct BenchOrder {
+    static constexpr uint16_t TYPE_ID = 3;
+    uint32_t order_id = 0;
+    uint16_t quantity = 0;
+    int32_t price = 0;
+    uint64_t timestamp = 0;
+    std::string_view symbol;
+    using Fields = TcpFields<&BenchOrder::order_id, &BenchOrder::quantity, &BenchOrder::price,
+        &BenchOrder::timestamp, &BenchOrder::symbol>;
+};
+
+// 改造前的写法：逐字段拼接std::string，解码时把字符串拷贝出来
+struct CopiedOrder {
+    uint32_t order_id = 0;
+    uint16_t quantity = 0;
+    int32_t price = 0;
+    uint64_t timestamp = 0;
+    std::string symbol;
+};
+
+static std::string copy_encode(const CopiedOrder& order)
+{
+    std::string body;
+    uint32_t order_id = htonl(order.order_id);
+    uint16_t quantity = htons(order.quantity);
+    uint32_t price = htonl(static_cast<uint32_t>(order.price));
+    uint32_t timestamp[2] = { htonl(static_cast<uint32_t>(order.timestamp >> 32)),
+        htonl(static_cast<uint32_t>(order.timestamp)) };
+    uint16_t symbol_length = htons(static_cast<uint16_t>(order.symbol.size()));
+    body.append(reinterpret_cast<const char *>(&order_id), sizeof(order_id));
+    body.append(reinterpret_cast<const char *>(&quantity), sizeof(quantity));
+    body.append(reinterpret_cast<const char *>(&price), sizeof(price));
+    body.append(reinterpret_cast<const char *>(timestamp), sizeof(timestamp));
+    body.append(reinterpret_cast<const char *>(&symbol_length), sizeof(symbol_length));
+    body.append(order.symbol);
+
+    uint16_t header[2] = { htons(static_cast<uint16_t>(TCP_FRAME_HEADER_SIZE + body.size())),
+        htons(BenchOrder::TYPE_ID) };
+    return std::string(reinterpret_cast<const char *>(header), sizeof(header)) + body;
+}
+
+static bool copy_decode(const std::string& frame, CopiedOrder& order)
+{
+    if (frame.size() < TCP_FRAME_HEADER_SIZE + 20 || ntohs(*(uint16_t *)frame.data()) != frame.size() ||
+        ntohs(*(uint16_t *)(frame.data() + 2)) != BenchOrder::TYPE_ID) {
+        return false;
+    }
+    std::string body = frame.substr(TCP_FRAME_HEADER_SIZE);
+    order.order_id = ntohl(*(uint32_t *)body.data());
+    order.quantity = ntohs(*(uint16_t *)(body.data() + 4));
+    order.price = static_cast<int32_t>(ntohl(*(uint32_t *)(body.data() + 6)));
+    order.timestamp = (static_cast<uint64_t>(ntohl(*(uint32_t *)(body.data() + 10))) << 32) |
+        ntohl(*(uint32_t *)(body.data() + 14));
+    size_t symbol_length = ntohs(*(uint16_t *)(body.data() + 18));
+    if (body.size() != 20 + symbol_length) {
+        return false;
+    }
+    order.symbol = body.substr(20);
+    return true;
+}
+
+// 手写的最优写法：memcpy加字节序转换，直接读写定长缓冲区，字符串不拷贝
+static size_t hand_encode(const BenchOrder& order, char *out)
+{
+    uint16_t length = static_cast<uint16_t>(TCP_FRAME_HEADER_SIZE + 20 + order.symbol.size());
+    uint16_t header[2] = { htons(length), htons(BenchOrder::TYPE_ID) };
+    uint32_t order_id = htonl(order.order_id);
+    uint16_t quantity = htons(order.quantity);
+    uint32_t price = htonl(static_cast<uint32_t>(order.price));
+    uint32_t timestamp[2] = { htonl(static_cast<uint32_t>(order.timestamp >> 32)),
+        htonl(static_cast<uint32_t>(order.timestamp)) };
+    uint16_t symbol_length = htons(static_cast<uint16_t>(order.symbol.size()));
+    memcpy(out, header, 4);
+    memcpy(out + 4, &order_id, 4);
+    memcpy(out + 8, &quantity, 2);
+    memcpy(out + 10, &price, 4);
+    memcpy(out + 14, timestamp, 8);
+    memcpy(out + 22, &symbol_length, 2);
+    memcpy(out + 24, order.symbol.data(), order.symbol.size());
+    return length;
+}
+
+static bool hand_decode(const char *frame, size_t length, BenchOrder& order)
+{
+    uint16_t header[2];
+    memcpy(header, frame, sizeof(header));
+    if (length < 24 || ntohs(header[0]) != length || ntohs(header[1]) != BenchOrder::TYPE_ID) {
+        return false;
+    }
+    uint32_t order_id;
+    uint16_t quantity;
+    uint32_t price;
+    uint32_t timestamp[2];
+    uint16_t symbol_length;
+    memcpy(&order_id, frame + 4, 4);
+    memcpy(&quantity, frame + 8, 2);
+    memcpy(&price, frame + 10, 4);
+    memcpy(timestamp, frame + 14, 8);
+    memcpy(&symbol_length, frame + 22, 2);
+    if (length != 24 + static_cast<size_t>(ntohs(symbol_length))) {
+        return false;
+    }
+    order.order_id = ntohl(order_id);
+    order.quantity = ntohs(quantity);
+    order.price = static_cast<int32_t>(ntohl(price));
+    order.timestamp = (static_cast<uint64_t>(ntohl(timestamp[0])) << 32) | ntohl(timestamp[1]);
+    order.symbol = std::string_view(frame + 24, length - 24);
+    return true;
+}
+
+/*
+    对比一条订单消息编码再解码的耗时（ns/message）：改造前逐字段拼接std::string并拷贝解码，
+    手写的memcpy加字节序转换，与模板编解码直接读写池中的帧缓冲区
+*/
+int bench_codec()
+{
+    const size_t ITERATIONS = 5000000;
+    const std::string symbols[] = { "AAPL", "MSFT", "BRK.B", "GOOGL" };
+    size_t checksum[3] = { 0, 0, 0 };
+    bool ok = true;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS && ok; i++) {
+        CopiedOrder order;
+        order.order_id = static_cast<uint32_t>(i);
+        order.quantity = static_cast<uint16_t>(i);
+        order.price = -static_cast<int32_t>(i);
+        order.timestamp = i << 20;
+        order.symbol = symbols[i % 4];
+        CopiedOrder decoded;
+        ok = copy_decode(copy_encode(order), decoded);
+        checksum[0] += decoded.order_id + decoded.quantity + decoded.symbol.size() + decoded.timestamp;
+    }
+    double copy_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    TcpFramePool pool;
+    TcpFrameBuffer buffer = pool.acquire();
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS && ok; i++) {
+        BenchOrder order;
+        order.order_id = static_cast<uint32_t>(i);
+        order.quantity = static_cast<uint16_t>(i);
+        order.price = -static_cast<int32_t>(i);
+        order.timestamp = i << 20;
+        order.symbol = symbols[i % 4];
+        BenchOrder decoded;
+        ok = hand_decode(buffer.data(), hand_encode(order, buffer.data()), decoded);
+        checksum[1] += decoded.order_id + decoded.quantity + decoded.symbol.size() + decoded.timestamp;
+    }
+    double hand_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS && ok; i++) {
+        BenchOrder order;
+        order.order_id = static_cast<uint32_t>(i);
+        order.quantity = static_cast<uint16_t>(i);
+        order.price = -static_cast<int32_t>(i);
+        order.timestamp = i << 20;
+        order.symbol = symbols[i % 4];
+        BenchOrder decoded;
+        ok = tcp_decode(buffer.data(), tcp_encode(order, buffer.data(), TcpFrameBuffer::CAPACITY), decoded);
+        checksum[2] += decoded.order_id + decoded.quantity + decoded.symbol.size() + decoded.timestamp;
+    }
+    double codec_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << std::left << std::setw(16) << "method" << "ns/message" << std::endl;
+    std::cout << std::left << std::setw(16) << "string copy" << std::fixed << std::setprecision(1)
+        << copy_ns / ITERATIONS << std::endl;
+    std::cout << std::left << std::setw(16) << "hand memcpy" << hand_ns / ITERATIONS << std::endl;
+    std::cout << std::left << std::setw(16) << "typed codec" << codec_ns / ITERATIONS << std::endl;
+
+    ok = ok && checksum[0] == checksum[1] && checksum[1] == checksum[2];
+    std::cout << (ok ? "Codec benchmark finished" : "Codec benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
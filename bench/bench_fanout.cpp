@@ -0,0 +1,244 @@
+// bench_fanout.cpp
+extern "C" {
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_set>
+#include <cstring>
+
+#include "tcp_server.hpp"
+
+// 每个新连接订阅同一主题，开始后每轮发布BURST帧
+class BroadcastServer : public TcpServer {
+private:
+    bool fanout;
+    std::unordered_set<int32_t> clients;
+    uint32_t next_seq = 0;
+
+public:
+    static constexpr uint32_t BURST = 10;
+    static constexpr size_t FRAME_SIZE = 64;
+
+    std::atomic<size_t> connected{0};
+    std::atomic<uint32_t> to_publish{0};
+    std::atomic<bool> closing{false}; // 结束时由服务端关闭全部连接
+
+    BroadcastServer(const std::string &listen_addr, uint16_t listen_port, bool fanout) :
+        TcpServer(listen_addr, listen_port), fanout(fanout) {}
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        static_cast<void>(client_addr);
+        this->subscribe(client_fd, "ticks");
+        this->clients.insert(client_fd);
+        this->connected++;
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[256];
+        static_cast<void>(recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT));
+    }
+
+    void deal_client_close(int32_t client_fd) override
+    {
+        this->clients.erase(client_fd);
+        this->connected--;
+    }
+
+    // 改造前的写法：每个订阅者各拷贝一份帧并单独send
+    void deal_loop_end() override
+    {
+        if (this->closing) {
+            std::vector<int32_t> remaining(this->clients.begin(), this->clients.end());
+            for (int32_t client_fd : remaining) {
+                this->close_client(client_fd);
+            }
+            return;
+        }
+        for (uint32_t i = 0; i < BURST && this->to_publish > 0; i++, this->to_publish--) {
+            char frame[FRAME_SIZE] = {0};
+            uint16_t length = htons(FRAME_SIZE);
+            uint32_t seq = htonl(this->next_seq++);
+            memcpy(frame, &length, sizeof(length));
+            memcpy(frame + sizeof(length), &seq, sizeof(seq));
+            if (this->fanout) {
+                this->publish("ticks", frame, sizeof(frame));
+                continue;
+            }
+            for (int32_t client_fd : this->clients) {
+                std::string copy(frame, sizeof(frame));
+                send_data_nonblock(client_fd, copy.data(), static_cast<uint16_t>(copy.size()));
+            }
+        }
+    }
+
+    int32_t get_loop_timeout() override
+    {
+        return this->to_publish > 0 ? 0 : 10;
+    }
+};
+
+// 子进程：建立subscribers个连接，就绪后通知父进程，收齐expected字节后再通知一次，服务端关闭全部连接后退出
+static void run_subscribers(uint16_t port, size_t subscribers, size_t expected, int32_t notify_fd)
+{
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    int32_t epoll_fd = epoll_create1(0);
+    std::vector<int32_t> fds;
+    // 分批连接，每批等握手完成后再继续
+    const size_t BATCH = 256;
+    while (fds.size() < subscribers) {
+        size_t begin = fds.size();
+        for (size_t i = 0; i < BATCH && fds.size() < subscribers; i++) {
+            int32_t fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+            static_cast<void>(connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)));
+            fds.push_back(fd);
+        }
+        for (size_t i = begin; i < fds.size(); i++) {
+            struct pollfd pfd = { fds[i], POLLOUT, 0 };
+            if (poll(&pfd, 1, 5000) <= 0) {
+                _exit(1);
+            }
+            struct epoll_event event = { .events = EPOLLIN, .data = { .fd = fds[i] } };
+            epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fds[i], &event);
+        }
+    }
+    static_cast<void>(write(notify_fd, "r", 1));
+
+    std::vector<char> buf(64 * 1024);
+    struct epoll_event events[256];
+    size_t received = 0;
+    while (received < expected) {
+        int32_t count = epoll_wait(epoll_fd, events, 256, 30000);
+        if (count <= 0) {
+            _exit(1);
+        }
+        for (int32_t i = 0; i < count; i++) {
+            ssize_t len = recv(events[i].data.fd, buf.data(), buf.size(), MSG_DONTWAIT);
+            if (len > 0) {
+                received += static_cast<size_t>(len);
+            }
+        }
+    }
+    static_cast<void>(write(notify_fd, "d", 1));
+
+    // 等服务端先关闭连接再退出，服务端不必处理大量对端关闭事件
+    size_t closed = 0;
+    while (closed < subscribers) {
+        int32_t count = epoll_wait(epoll_fd, events, 256, 30000);
+        if (count <= 0) {
+            _exit(1);
+        }
+        for (int32_t i = 0; i < count; i++) {
+            if (recv(events[i].data.fd, buf.data(), buf.size(), MSG_DONTWAIT) == 0) {
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, events[i].data.fd, nullptr);
+                closed++;
+            }
+        }
+    }
+    _exit(0);
+}
+
+// 返回从开始发布到全部订阅者收齐的秒数，失败时返回负数
+static double run_broadcast(uint16_t port, size_t subscribers, uint32_t messages, bool fanout)
+{
+    BroadcastServer server("127.0.0.1", port, fanout);
+    // 放大全连接队列，上万个连接在服务端accept之前不至于因队列满而重传SYN
+    static_cast<void>(listen(server.get_listen_fd(), 4096));
+    int32_t notify[2];
+    if (pipe(notify) < 0) {
+        return -1;
+    }
+    size_t expected = subscribers * messages * BroadcastServer::FRAME_SIZE;
+    pid_t child = fork();
+    if (child == 0) {
+        close(notify[0]);
+        run_subscribers(port, subscribers, expected, notify[1]);
+    }
+    close(notify[1]);
+
+    std::atomic<bool> running(true);
+    std::thread server_thread([&]() {
+        while (running) {
+            server.listen_loop();
+        }
+    });
+
+    double seconds = -1;
+    char state = 0;
+    if (read(notify[0], &state, 1) == 1 && state == 'r') {
+        while (server.connected < subscribers) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        auto begin = std::chrono::steady_clock::now();
+        server.to_publish = messages;
+        if (read(notify[0], &state, 1) == 1 && state == 'd') {
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+    }
+
+    server.closing = true;
+    while (server.connected > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    running = false;
+    server_thread.join();
+    close(notify[0]);
+    int32_t status = 0;
+    waitpid(child, &status, 0);
+    return seconds;
+}
+
+/*
+    一个发布者向N个订阅者广播64字节的帧（每轮10帧，共100帧），订阅端在子进程中以epoll读取：
+    对比每个订阅者各拷贝一份、逐帧send，与编码一次共享引用、每轮合并为一次sendmsg，
+    统计从开始发布到全部订阅者收齐的时间与每秒送达的帧数
+*/
+int bench_fanout()
+{
+    const uint32_t MESSAGES = 100;
+    const size_t SUBSCRIBERS[] = { 1000, 10000 };
+
+    bool ok = true;
+    uint16_t port = 18112;
+    std::cout << std::left << std::setw(14) << "subscribers" << std::setw(16) << "method" << std::setw(12) << "ms"
+        << "frames/s" << std::endl;
+    for (size_t subscribers : SUBSCRIBERS) {
+        for (bool fanout : { false, true }) {
+            double seconds = -1;
+            try {
+                seconds = run_broadcast(port++, subscribers, MESSAGES, fanout);
+            } catch (const TcpRuntimeException& e) {
+                std::cerr << "Exception: " << e.what() << std::endl;
+            }
+            if (seconds < 0) {
+                ok = false;
+                continue;
+            }
+            std::cout << std::left << std::setw(14) << subscribers << std::setw(16)
+                << (fanout ? "shared fanout" : "per-client copy") << std::fixed << std::setprecision(1)
+                << std::setw(12) << seconds * 1000 << std::setprecision(0)
+                << static_cast<double>(subscribers * MESSAGES) / seconds << std::endl;
+        }
+    }
+
+    std::cout << (ok ? "Fanout benchmark finished" : "Fanout benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
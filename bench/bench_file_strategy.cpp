@@ -0,0 +1,130 @@
+// bench_file_strategy.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+
+// 发送请求并读完整个响应，返回响应体长度，失败时返回-1
+static ssize_t fetch(int32_t fd, const std::string& request, std::vector<char>& buf)
+{
+    send_data_nonblock(fd, request.c_str(), static_cast<uint16_t>(request.size()));
+
+    std::string head;
+    size_t expected = 0;
+    size_t received = 0;
+    bool header_done = false;
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return -1;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            continue;
+        }
+
+        if (!header_done) {
+            head.append(buf.data(), static_cast<size_t>(len));
+            size_t end = head.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                continue;
+            }
+            size_t pos = head.find("Content-Length: ");
+            if (pos == std::string::npos || pos > end) {
+                return -1;
+            }
+            expected = std::stoul(head.substr(pos + 16));
+            received = head.size() - end - 4;
+            header_done = true;
+        } else {
+            received += static_cast<size_t>(len);
+        }
+
+        if (received >= expected) {
+            return static_cast<ssize_t>(expected);
+        }
+    }
+}
+
+/*
+    对比各文件发送策略的吞吐：对每种文件大小，在同一keep-alive连接上顺序请求，
+    统计每秒请求数与MB/s。文件均大于热点缓存的上限，不会从内存缓存回复。
+*/
+int bench_file_strategy()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18090;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_http_bench";
+    const std::vector<size_t> file_sizes = { 128 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+    const size_t BYTES_PER_CASE = 256 * 1024 * 1024;
+    const std::vector<HttpFileStrategy> strategies = {
+        HTTP_FILE_SENDFILE, HTTP_FILE_SPLICE, HTTP_FILE_MMAP, HTTP_FILE_AUTO
+    };
+
+    std::filesystem::create_directories(web_root);
+    for (size_t size : file_sizes) {
+        std::ofstream(web_root / ("file_" + std::to_string(size) + ".bin")) << std::string(size, 'b');
+    }
+
+    bool ok = true;
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::vector<char> buf(256 * 1024);
+        std::cout << std::left << std::setw(10) << "strategy" << std::setw(12) << "file size"
+            << std::setw(12) << "requests" << std::setw(12) << "req/s" << "MB/s" << std::endl;
+        for (HttpFileStrategy strategy : strategies) {
+            server.set_file_strategy(strategy);
+            for (size_t size : file_sizes) {
+                TcpClient client(server_addr, server_port);
+                const std::string request = "GET /file_" + std::to_string(size) + ".bin HTTP/1.1\r\n\r\n";
+                size_t requests = std::max<size_t>(8, BYTES_PER_CASE / size);
+
+                // 预热页缓存
+                ok &= fetch(client.get_fd(), request, buf) == static_cast<ssize_t>(size);
+
+                auto begin = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < requests && ok; i++) {
+                    ok &= fetch(client.get_fd(), request, buf) == static_cast<ssize_t>(size);
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+                std::cout << std::left << std::setw(10) << HttpTransfer::get_strategy_name(strategy)
+                    << std::setw(12) << std::to_string(size / 1024) + "K"
+                    << std::setw(12) << requests
+                    << std::setw(12) << std::fixed << std::setprecision(0) << requests / seconds
+                    << std::setprecision(1) << requests * size / seconds / (1024 * 1024) << std::endl;
+            }
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "File strategy benchmark finished" : "File strategy benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,90 @@
+// bench_header_builder.cpp
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+#include "http_header_builder.hpp"
+
+// 改造前的写法：按值返回MIME类型，响应头以std::string拼接
+static std::string concat_mime_type(const std::string& filepath)
+{
+    static std::unordered_map<std::string, std::string> mime_types = {
+        {".html", "text/html"}, {".css", "text/css"}, {".js", "application/javascript"},
+        {".png", "image/png"}, {".jpg", "image/jpeg"}, {".json", "application/json"},
+    };
+    size_t dot_pos = filepath.find_last_of('.');
+    if (dot_pos != std::string::npos) {
+        auto it = mime_types.find(filepath.substr(dot_pos));
+        if (it != mime_types.end()) {
+            return it->second;
+        }
+    }
+    return "application/octet-stream";
+}
+
+static std::string concat_headers(const std::string& filepath, off_t size, const std::string& etag,
+    const std::string& last_modified)
+{
+    std::string mime_type = concat_mime_type(filepath);
+    return
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: " + mime_type + "\r\n"
+        "Content-Length: " + std::to_string(size) + "\r\n" +
+        "ETag: " + etag + "\r\n"
+        "Last-Modified: " + last_modified + "\r\n"
+        "Cache-Control: public\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+}
+
+static void build_headers(HttpHeaderBuilder& header, const std::string& filepath, off_t size,
+    const std::string& etag, const std::string& last_modified)
+{
+    header.clear();
+    header.status(200)
+        .add("Content-Type", HttpHeaderBuilder::get_mime_type(filepath))
+        .add("Content-Length", size)
+        .add("ETag", etag)
+        .add("Last-Modified", last_modified)
+        .add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+}
+
+/*
+    对比渲染一个200响应头的耗时：std::string拼接加unordered_map查MIME，
+    与在定长缓冲区中拼接加编译期完美哈希查MIME
+*/
+int bench_header_builder()
+{
+    const size_t ITERATIONS = 2000000;
+    const std::string paths[] = { "/index.html", "/static/app.js", "/img/logo.png", "/download/data.bin" };
+    const std::string etag = "\"1a2b3c-4d5e-17f0c3e2d\"";
+    const std::string last_modified = "Sun, 18 Oct 2026 10:00:00 GMT";
+
+    size_t checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        checksum += concat_headers(paths[i % 4], static_cast<off_t>(i), etag, last_modified).size();
+    }
+    double concat_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    HttpHeaderBuilder header;
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < ITERATIONS; i++) {
+        build_headers(header, paths[i % 4], static_cast<off_t>(i), etag, last_modified);
+        checksum -= header.view().size();
+    }
+    double builder_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << std::left << std::setw(16) << "method" << "ns/header" << std::endl;
+    std::cout << std::left << std::setw(16) << "string concat" << std::fixed << std::setprecision(1)
+        << concat_ns / ITERATIONS << std::endl;
+    std::cout << std::left << std::setw(16) << "header builder" << builder_ns / ITERATIONS << std::endl;
+
+    bool ok = checksum == 0;
+    std::cout << (ok ? "Header builder benchmark finished" : "Header builder benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+// bench_http2.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "http2_frame.hpp"
+#include "http2_hpack.hpp"
+#include "tcp_client.hpp"
+
+static bool send_all(int32_t fd, const std::string& data)
+{
+    for (size_t sent = 0; sent < data.size(); ) {
+        ssize_t len = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            poll(&pfd, 1, 100);
+            continue;
+        }
+        sent += static_cast<size_t>(len);
+    }
+    return true;
+}
+
+// 在keep-alive连接上顺序请求，读完整个响应（依据Content-Length）
+static bool fetch_http1(int32_t fd, const std::string& path, std::vector<char>& buf)
+{
+    if (!send_all(fd, "GET " + path + " HTTP/1.1\r\n\r\n")) {
+        return false;
+    }
+    std::string head;
+    size_t expected = 0;
+    size_t received = 0;
+    bool header_done = false;
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            continue;
+        }
+        if (!header_done) {
+            head.append(buf.data(), static_cast<size_t>(len));
+            size_t end = head.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                continue;
+            }
+            size_t pos = head.find("Content-Length: ");
+            if (pos == std::string::npos || pos > end) {
+                return false;
+            }
+            expected = std::stoul(head.substr(pos + 16));
+            received = head.size() - end - 4;
+            header_done = true;
+        } else {
+            received += static_cast<size_t>(len);
+        }
+        if (received >= expected) {
+            return true;
+        }
+    }
+}
+
+static void append_frame(std::string& out, uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+{
+    Http2FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = type;
+    header.flags = flags;
+    header.stream_id = stream_id;
+    header.serialize(out);
+    out += payload;
+}
+
+// 在同一个HTTP/2连接上一次发出全部请求，等待所有流结束；收到的DATA立即归还窗口
+static bool fetch_http2(int32_t fd, uint32_t& next_stream_id, HpackEncoder& encoder,
+    const std::vector<std::string>& paths, std::string& input, std::vector<char>& buf)
+{
+    std::string out;
+    for (const std::string& path : paths) {
+        std::string block;
+        encoder.encode({ { ":method", "GET" }, { ":scheme", "http" }, { ":authority", "127.0.0.1" },
+            { ":path", path } }, block);
+        append_frame(out, HTTP2_FRAME_HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, next_stream_id, block);
+        next_stream_id += 2;
+    }
+    if (!send_all(fd, out)) {
+        return false;
+    }
+
+    size_t pending = paths.size();
+    while (pending > 0) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            continue;
+        }
+        input.append(buf.data(), static_cast<size_t>(len));
+
+        std::string reply;
+        size_t pos = 0;
+        while (input.size() - pos >= Http2FrameHeader::SIZE) {
+            Http2FrameHeader header = Http2FrameHeader::parse(input.data() + pos);
+            if (input.size() - pos < Http2FrameHeader::SIZE + header.length) {
+                break;
+            }
+            // 响应头只需判断是否结束，头部块不必解码
+            bool end_stream = (header.type == HTTP2_FRAME_HEADERS || header.type == HTTP2_FRAME_DATA) &&
+                (header.flags & HTTP2_FLAG_END_STREAM);
+            if (header.type == HTTP2_FRAME_DATA && header.length > 0) {
+                std::string increment = {
+                    static_cast<char>((header.length >> 24) & 0xff), static_cast<char>((header.length >> 16) & 0xff),
+                    static_cast<char>((header.length >> 8) & 0xff), static_cast<char>(header.length & 0xff),
+                };
+                append_frame(reply, HTTP2_FRAME_WINDOW_UPDATE, 0, 0, increment);
+                if (!end_stream) {
+                    append_frame(reply, HTTP2_FRAME_WINDOW_UPDATE, 0, header.stream_id, increment);
+                }
+            } else if (header.type == HTTP2_FRAME_SETTINGS && !(header.flags & HTTP2_FLAG_ACK)) {
+                append_frame(reply, HTTP2_FRAME_SETTINGS, HTTP2_FLAG_ACK, 0, "");
+            } else if (header.type == HTTP2_FRAME_RST_STREAM || header.type == HTTP2_FRAME_GOAWAY) {
+                return false;
+            }
+            if (end_stream) {
+                pending--;
+            }
+            pos += Http2FrameHeader::SIZE + header.length;
+        }
+        input.erase(0, pos);
+        if (!reply.empty() && !send_all(fd, reply)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_row(const std::string& mode, std::vector<double>& samples)
+{
+    std::sort(samples.begin(), samples.end());
+    double sum = 0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    std::cout << std::left << std::setw(24) << mode << std::fixed << std::setprecision(2)
+        << std::setw(12) << sum / samples.size()
+        << std::setw(12) << samples[samples.size() / 2]
+        << samples[samples.size() * 99 / 100] << std::endl;
+}
+
+/*
+    模拟页面加载：一个页面引用大量小资源。HTTP/1.1按浏览器的习惯开6条keep-alive连接，
+    每条连接顺序请求分到的资源；HTTP/2在一条连接上同时发出全部请求。
+    统计整页加载耗时（ms）的均值、p50与p99，连接均在计时前建立。
+*/
+int bench_http2()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18091;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_http2_bench";
+    const size_t ASSET_COUNT = 60;
+    const size_t HTTP1_CONNECTIONS = 6;
+    const size_t PAGE_LOADS = 200;
+
+    std::filesystem::create_directories(web_root);
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < ASSET_COUNT; i++) {
+        // 2K~20K的资源，大小交错
+        std::string name = "asset_" + std::to_string(i) + ".js";
+        std::ofstream(web_root / name) << std::string(2048 + (i * 7919) % (18 * 1024), 'j');
+        paths.push_back("/" + name);
+    }
+
+    bool ok = true;
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::cout << std::left << std::setw(24) << "mode" << std::setw(12) << "mean ms"
+            << std::setw(12) << "p50 ms" << "p99 ms" << std::endl;
+
+        {
+            std::vector<std::unique_ptr<TcpClient>> clients;
+            for (size_t i = 0; i < HTTP1_CONNECTIONS; i++) {
+                clients.push_back(std::make_unique<TcpClient>(server_addr, server_port));
+            }
+            std::vector<double> samples;
+            for (size_t load = 0; load <= PAGE_LOADS && ok; load++) {
+                std::atomic<bool> loaded(true);
+                auto begin = std::chrono::steady_clock::now();
+                std::vector<std::thread> threads;
+                for (size_t c = 0; c < HTTP1_CONNECTIONS; c++) {
+                    threads.emplace_back([&, c]() {
+                        std::vector<char> buf(64 * 1024);
+                        for (size_t i = c; i < paths.size(); i += HTTP1_CONNECTIONS) {
+                            if (!fetch_http1(clients[c]->get_fd(), paths[i], buf)) {
+                                loaded = false;
+                            }
+                        }
+                    });
+                }
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+                ok &= loaded;
+                // 第一次加载用于预热缓存，不计入结果
+                if (load > 0) {
+                    samples.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - begin).count());
+                }
+            }
+            if (ok) {
+                print_row("HTTP/1.1 x" + std::to_string(HTTP1_CONNECTIONS) + " conns", samples);
+            }
+        }
+
+        {
+            TcpClient client(server_addr, server_port);
+            // 与常见HTTP/2客户端一致关闭Nagle，否则WINDOW_UPDATE等小帧会等待延迟ACK
+            int optval = 1;
+            setsockopt(client.get_fd(), IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval));
+            std::string preface = Http2Session::CLIENT_PREFACE;
+            append_frame(preface, HTTP2_FRAME_SETTINGS, 0, 0, "");
+            ok &= send_all(client.get_fd(), preface);
+
+            HpackEncoder encoder;
+            uint32_t next_stream_id = 1;
+            std::string input;
+            std::vector<char> buf(256 * 1024);
+            std::vector<double> samples;
+            for (size_t load = 0; load <= PAGE_LOADS && ok; load++) {
+                auto begin = std::chrono::steady_clock::now();
+                ok &= fetch_http2(client.get_fd(), next_stream_id, encoder, paths, input, buf);
+                if (load > 0) {
+                    samples.push_back(std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - begin).count());
+                }
+            }
+            if (ok) {
+                print_row("HTTP/2 x1 conn", samples);
+            }
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP/2 benchmark finished" : "HTTP/2 benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
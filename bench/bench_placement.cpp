@@ -0,0 +1,152 @@
+// bench_placement.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "cpu_placement.hpp"
+
+// 发送请求并读完整个响应，返回响应体长度，失败时返回-1
+static ssize_t fetch(int32_t fd, const std::string& request, std::vector<char>& buf)
+{
+    send_data_nonblock(fd, request.c_str(), static_cast<uint16_t>(request.size()));
+
+    std::string head;
+    size_t expected = 0;
+    size_t received = 0;
+    bool header_done = false;
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return -1;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            continue;
+        }
+
+        if (!header_done) {
+            head.append(buf.data(), static_cast<size_t>(len));
+            size_t end = head.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                continue;
+            }
+            size_t pos = head.find("Content-Length: ");
+            if (pos == std::string::npos || pos > end) {
+                return -1;
+            }
+            expected = std::stoul(head.substr(pos + 16));
+            received = head.size() - end - 4;
+            header_done = true;
+        } else {
+            received += static_cast<size_t>(len);
+        }
+
+        if (received >= expected) {
+            return static_cast<ssize_t>(expected);
+        }
+    }
+}
+
+/*
+    线程绑定对比：同一组客户端以keep-alive连接持续请求超过热点缓存上限的文件（每个请求都经过工作线程），
+    统计吞吐（请求/秒）与延迟分位数（ms），对比线程不绑定与CpuPlacement::automatic()的绑定规划
+*/
+int bench_placement()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18096;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_placement_bench";
+    const size_t FILE_SIZE = 128 * 1024;
+    const size_t CLIENTS = 4;
+    const std::chrono::seconds DURATION(3);
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "page.bin") << std::string(FILE_SIZE, 'p');
+
+    CpuPlacement pinned = CpuPlacement::automatic();
+    std::cout << "usable cpus: " << CpuPlacement::get_usable_cpu_count() << ", reactor cpu " << pinned.reactor_cpu
+        << ", " << pinned.worker_cpus.size() << " pinned workers" << std::endl;
+
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "mode" << std::setw(12) << "req/s" << std::setw(12) << "p50 ms"
+        << "p99 ms" << std::endl;
+    for (bool pin : { false, true }) {
+        try {
+            uint16_t port = static_cast<uint16_t>(server_port + (pin ? 1 : 0));
+            // 两种模式使用相同的工作线程数，只比较是否绑定
+            std::vector<int32_t> cpus = pin ? pinned.worker_cpus : std::vector<int32_t>();
+            auto executor = std::make_unique<WorkStealingExecutor>(pinned.worker_cpus.size(),
+                WorkStealingExecutor::DEFAULT_QUEUE_CAPACITY, cpus);
+            HttpServer server(server_addr, port, web_root.string(), std::move(executor));
+            server.set_loop_cpu(pin ? pinned.reactor_cpu : -1);
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            std::atomic<bool> fetching(true);
+            std::vector<std::vector<double>> samples(CLIENTS);
+            std::vector<std::thread> clients;
+            for (size_t i = 0; i < CLIENTS; i++) {
+                clients.emplace_back([&, i]() {
+                    TcpClient client(server_addr, port);
+                    std::vector<char> buf(256 * 1024);
+                    while (fetching) {
+                        auto begin = std::chrono::steady_clock::now();
+                        if (fetch(client.get_fd(), "GET /page.bin HTTP/1.1\r\n\r\n", buf) !=
+                            static_cast<ssize_t>(FILE_SIZE)) {
+                            ok = false;
+                            return;
+                        }
+                        samples[i].push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - begin).count());
+                    }
+                });
+            }
+            std::this_thread::sleep_for(DURATION);
+            fetching = false;
+            for (std::thread& thread : clients) {
+                thread.join();
+            }
+            running = false;
+            server_thread.join();
+
+            std::vector<double> all;
+            for (const std::vector<double>& client_samples : samples) {
+                all.insert(all.end(), client_samples.begin(), client_samples.end());
+            }
+            if (ok && !all.empty()) {
+                std::sort(all.begin(), all.end());
+                std::cout << std::left << std::setw(12) << (pin ? "pinned" : "floating") << std::fixed
+                    << std::setprecision(0) << std::setw(12) << static_cast<double>(all.size()) / DURATION.count()
+                    << std::setprecision(3) << std::setw(12) << all[all.size() / 2]
+                    << all[all.size() * 99 / 100] << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "Placement benchmark finished" : "Placement benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+// bench_post_send.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+
+// 只负责接入连接，记录其fd与连接ID；发送全部由其他线程发起
+class PostTargetServer : public TcpServer {
+public:
+    std::atomic<int32_t> client_fd{-1};
+    std::atomic<uint64_t> conn_id{0};
+
+    using TcpServer::TcpServer;
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        static_cast<void>(client_addr);
+        this->conn_id = this->get_conn_id(client_fd);
+        this->client_fd = client_fd;
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[256];
+        static_cast<void>(recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT));
+    }
+};
+
+// 读满length字节，超时返回false
+static bool drain(int32_t fd, size_t length)
+{
+    std::vector<char> buf(256 * 1024);
+    size_t received = 0;
+    while (received < length) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(len);
+    }
+    return true;
+}
+
+/*
+    多个线程向同一连接发送256字节的帧：改造前的写法各线程直接send_data_nonblock()，须以互斥锁保护socket才不交错；
+    post_send()投递到无锁队列，由事件循环线程合并写出。统计全部帧送达的吞吐，以及空闲事件循环被唤醒后送达单帧的时延
+*/
+int bench_post_send()
+{
+    const size_t TOTAL_FRAMES = 200000;
+    const size_t FRAME_SIZE = 256;
+    const size_t PRODUCERS[] = { 1, 4, 16 };
+    const size_t LATENCY_ROUNDS = 2000;
+
+    bool ok = true;
+    try {
+        PostTargetServer server("127.0.0.1", 18117);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        TcpClient client("127.0.0.1", 18117);
+        while (server.conn_id == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const std::string frame(FRAME_SIZE, 'p');
+        const TcpSharedFrame shared = make_shared_frame(frame.data(), frame.size());
+
+        std::cout << std::left << std::setw(12) << "producers" << std::setw(18) << "method" << "frames/s" << std::endl;
+        for (size_t producers : PRODUCERS) {
+            for (bool post : { false, true }) {
+                std::mutex socket_mutex;
+                std::vector<std::thread> threads;
+                auto begin = std::chrono::steady_clock::now();
+                for (size_t p = 0; p < producers; p++) {
+                    threads.emplace_back([&, post]() {
+                        for (size_t i = 0; i < TOTAL_FRAMES / producers; i++) {
+                            if (post) {
+                                server.post_send(server.conn_id, shared);
+                            } else {
+                                std::lock_guard<std::mutex> lock(socket_mutex);
+                                send_data_nonblock(server.client_fd, frame.data(), static_cast<uint16_t>(frame.size()));
+                            }
+                        }
+                    });
+                }
+                ok &= drain(client.get_fd(), TOTAL_FRAMES / producers * producers * FRAME_SIZE);
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                for (std::thread& thread : threads) {
+                    thread.join();
+                }
+                std::cout << std::left << std::setw(12) << producers << std::setw(18)
+                    << (post ? "post_send" : "mutex + send") << std::fixed << std::setprecision(0)
+                    << static_cast<double>(TOTAL_FRAMES) / seconds << std::endl;
+            }
+        }
+
+        // 事件循环阻塞在epoll_wait中时，投递一帧到客户端收到的时延
+        std::vector<double> samples;
+        for (size_t i = 0; i < LATENCY_ROUNDS && ok; i++) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            auto begin = std::chrono::steady_clock::now();
+            server.post_send(server.conn_id, shared);
+            ok = drain(client.get_fd(), FRAME_SIZE);
+            samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+        }
+        if (ok) {
+            std::sort(samples.begin(), samples.end());
+            std::cout << "idle wakeup to delivery: p50 " << std::fixed << std::setprecision(1)
+                << samples[samples.size() / 2] << " us, p99 " << samples[samples.size() * 99 / 100] << " us" << std::endl;
+        }
+
+        running = false;
+        server.post_send(0, shared);
+        server_thread.join();
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "Post send benchmark finished" : "Post send benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,160 @@
+// bench_shaping.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+
+// 发送请求并读完整个响应，返回响应体长度，失败时返回-1
+static ssize_t fetch(int32_t fd, const std::string& request, std::vector<char>& buf)
+{
+    send_data_nonblock(fd, request.c_str(), static_cast<uint16_t>(request.size()));
+
+    std::string head;
+    size_t expected = 0;
+    size_t received = 0;
+    bool header_done = false;
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return -1;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            continue;
+        }
+
+        if (!header_done) {
+            head.append(buf.data(), static_cast<size_t>(len));
+            size_t end = head.find("\r\n\r\n");
+            if (end == std::string::npos) {
+                continue;
+            }
+            size_t pos = head.find("Content-Length: ");
+            if (pos == std::string::npos || pos > end) {
+                return -1;
+            }
+            expected = std::stoul(head.substr(pos + 16));
+            received = head.size() - end - 4;
+            header_done = true;
+        } else {
+            received += static_cast<size_t>(len);
+        }
+
+        if (received >= expected) {
+            return static_cast<ssize_t>(expected);
+        }
+    }
+}
+
+/*
+    大文件下载与小请求混合：若干连接不停地下载大文件，另一条连接顺序请求小页面，
+    统计小请求的延迟（ms）均值、p50与p99，以及同期的下载吞吐，对比不整形与差额轮询整形（不限速）
+*/
+int bench_shaping()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18092;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_shaping_bench";
+    const size_t BULK_SIZE = 64 * 1024 * 1024;
+    const size_t BULK_CONNECTIONS = 4;
+    const size_t SMALL_REQUESTS = 500;
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "bulk.bin") << std::string(BULK_SIZE, 'b');
+    std::ofstream(web_root / "index.html") << std::string(4096, 'h');
+
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "mode" << std::setw(12) << "mean ms" << std::setw(12) << "p50 ms"
+        << std::setw(12) << "p99 ms" << "bulk MB/s" << std::endl;
+    for (bool shaping : { false, true }) {
+        try {
+            uint16_t port = static_cast<uint16_t>(server_port + (shaping ? 1 : 0));
+            HttpServer server(server_addr, port, web_root.string());
+            if (shaping) {
+                server.enable_shaping();
+            }
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            std::atomic<bool> downloading(true);
+            std::atomic<size_t> bulk_bytes(0);
+            std::vector<std::thread> downloaders;
+            for (size_t i = 0; i < BULK_CONNECTIONS; i++) {
+                downloaders.emplace_back([&]() {
+                    TcpClient client(server_addr, port);
+                    std::vector<char> buf(256 * 1024);
+                    while (downloading) {
+                        ssize_t size = fetch(client.get_fd(), "GET /bulk.bin HTTP/1.1\r\n\r\n", buf);
+                        if (size < 0) {
+                            ok = false;
+                            return;
+                        }
+                        bulk_bytes += static_cast<size_t>(size);
+                    }
+                });
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+            TcpClient client(server_addr, port);
+            std::vector<char> buf(64 * 1024);
+            std::vector<double> samples;
+            size_t bulk_before = bulk_bytes;
+            auto begin = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SMALL_REQUESTS && ok; i++) {
+                auto request_begin = std::chrono::steady_clock::now();
+                ok &= fetch(client.get_fd(), "GET /index.html HTTP/1.1\r\n\r\n", buf) == 4096;
+                samples.push_back(std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - request_begin).count());
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            double bulk_rate = static_cast<double>(bulk_bytes - bulk_before) / seconds / (1024 * 1024);
+
+            downloading = false;
+            for (std::thread& thread : downloaders) {
+                thread.join();
+            }
+            running = false;
+            server_thread.join();
+
+            if (ok) {
+                std::sort(samples.begin(), samples.end());
+                double sum = 0;
+                for (double sample : samples) {
+                    sum += sample;
+                }
+                std::cout << std::left << std::setw(12) << (shaping ? "drr" : "none") << std::fixed
+                    << std::setprecision(3) << std::setw(12) << sum / samples.size()
+                    << std::setw(12) << samples[samples.size() / 2]
+                    << std::setw(12) << samples[samples.size() * 99 / 100]
+                    << std::setprecision(0) << bulk_rate << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "Shaping benchmark finished" : "Shaping benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,201 @@
+// bench_socket_options.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "tcp_socket_options.hpp"
+
+// 分两次写出回复：先是一个小的帧头，随后是帧体，与未合并的响应头+响应体相同
+class SplitReplyServer : public TcpServer {
+public:
+    SplitReplyServer(const std::string &listen_addr, uint16_t listen_port) : TcpServer(listen_addr, listen_port) {}
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[4096];
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            send_data_nonblock(client_fd, buf, 8);
+            send_data_nonblock(client_fd, buf + 8, static_cast<uint16_t>(len - 8));
+        }
+    }
+};
+
+// 读满length字节，超时或连接关闭时返回false
+static bool recv_exact(int32_t fd, size_t length, std::vector<char>& buf)
+{
+    size_t received = 0;
+    while (received < length) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), std::min(buf.size(), length - received), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(len);
+    }
+    return true;
+}
+
+// 发送请求并读完整个响应，返回响应体长度，失败时返回-1
+static ssize_t fetch(int32_t fd, const std::string& request, std::vector<char>& buf)
+{
+    send_data_nonblock(fd, request.c_str(), static_cast<uint16_t>(request.size()));
+
+    std::string head;
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return -1;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            return -1;
+        }
+        head.append(buf.data(), static_cast<size_t>(len));
+        size_t end = head.find("\r\n\r\n");
+        if (end == std::string::npos) {
+            continue;
+        }
+        size_t pos = head.find("Content-Length: ");
+        if (pos == std::string::npos || pos > end) {
+            return -1;
+        }
+        size_t expected = std::stoul(head.substr(pos + 16));
+        size_t received = head.size() - end - 4;
+        if (received < expected && !recv_exact(fd, expected - received, buf)) {
+            return -1;
+        }
+        return static_cast<ssize_t>(expected);
+    }
+}
+
+/*
+    TCP选项预设对比，两个负载分别对应两组预设的目标场景：
+    1. 小帧往返：服务端把回复分两次写出，统计往返时延分位数（us），Nagle与延迟确认相互等待时尾延迟明显升高
+    2. 大文件：多个keep-alive客户端持续请求1MB文件，统计吞吐（MB/s）
+*/
+int bench_socket_options()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18103;
+    const size_t ROUNDS = 2000;
+    const std::string frame(256, 'f');
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_options_bench";
+    const size_t FILE_SIZE = 1024 * 1024;
+    const size_t CLIENTS = 4;
+    const std::chrono::seconds DURATION(3);
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "large.bin") << std::string(FILE_SIZE, 'l');
+
+    const std::vector<std::pair<const char *, TcpSocketOptions>> profiles = {
+        { "default", TcpSocketOptions() },
+        { "latency", TcpSocketOptions::latency() },
+        { "throughput", TcpSocketOptions::throughput() },
+    };
+
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "profile" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+        << "file MB/s" << std::endl;
+    for (size_t p = 0; p < profiles.size(); p++) {
+        const TcpSocketOptions& options = profiles[p].second;
+        std::vector<double> samples;
+        double megabytes_per_second = 0;
+        try {
+            uint16_t port = static_cast<uint16_t>(server_port + p * 2);
+            SplitReplyServer server(server_addr, port);
+            server.set_socket_options(options);
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+            {
+                TcpClient client(server_addr, port, options);
+                std::vector<char> buf(4096);
+                for (size_t i = 0; i < ROUNDS && ok; i++) {
+                    auto begin = std::chrono::steady_clock::now();
+                    send_data_nonblock(client.get_fd(), frame.c_str(), static_cast<uint16_t>(frame.size()));
+                    ok = recv_exact(client.get_fd(), frame.size(), buf);
+                    samples.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - begin).count());
+                }
+            }
+            running = false;
+            server_thread.join();
+        } catch (const TcpRuntimeException& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+
+        try {
+            uint16_t port = static_cast<uint16_t>(server_port + p * 2 + 1);
+            HttpServer server(server_addr, port, web_root.string(), 1);
+            server.set_socket_options(options);
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+
+            std::atomic<bool> fetching(true);
+            std::atomic<size_t> fetched(0);
+            std::vector<std::thread> clients;
+            for (size_t i = 0; i < CLIENTS; i++) {
+                clients.emplace_back([&]() {
+                    TcpClient client(server_addr, port, options);
+                    std::vector<char> buf(256 * 1024);
+                    while (fetching) {
+                        if (fetch(client.get_fd(), "GET /large.bin HTTP/1.1\r\n\r\n", buf) !=
+                            static_cast<ssize_t>(FILE_SIZE)) {
+                            ok = false;
+                            return;
+                        }
+                        fetched++;
+                    }
+                });
+            }
+            std::this_thread::sleep_for(DURATION);
+            fetching = false;
+            for (std::thread& thread : clients) {
+                thread.join();
+            }
+            running = false;
+            server_thread.join();
+            megabytes_per_second = static_cast<double>(fetched * FILE_SIZE) / (1024.0 * 1024.0) / DURATION.count();
+        } catch (const TcpRuntimeException& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+
+        if (ok && !samples.empty()) {
+            std::sort(samples.begin(), samples.end());
+            std::cout << std::left << std::setw(12) << profiles[p].first << std::fixed << std::setprecision(1)
+                << std::setw(12) << samples[samples.size() / 2] << std::setw(12) << samples[samples.size() * 99 / 100]
+                << std::setprecision(0) << megabytes_per_second << std::endl;
+        }
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "Socket options benchmark finished" : "Socket options benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
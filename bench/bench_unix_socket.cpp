@@ -0,0 +1,122 @@
+// bench_unix_socket.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <filesystem>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+#include "tcp_address.hpp"
+
+// 原样回送收到的字节
+class LocalEchoServer : public TcpServer {
+public:
+    explicit LocalEchoServer(const TcpAddress& address) : TcpServer(address) {}
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        std::vector<char> buf(64 * 1024);
+        ssize_t len = recv(client_fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len > 0) {
+            send_data_nonblock(client_fd, buf.data(), static_cast<uint16_t>(len));
+        }
+    }
+};
+
+// 发送message并读回等长的回送，失败时返回false
+static bool round_trip(int32_t fd, const std::string& message, std::vector<char>& buf)
+{
+    send_data_nonblock(fd, message.c_str(), static_cast<uint16_t>(message.size()));
+    size_t received = 0;
+    while (received < message.size()) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 5000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        received += static_cast<size_t>(len);
+    }
+    return true;
+}
+
+/*
+    本机传输对比：同一回送服务器分别监听127.0.0.1的TCP端口与Unix域socket（文件路径与抽象命名空间），
+    统计64字节消息往返时延分位数（us），以及32KB消息逐条往返的吞吐（MB/s，按两个方向的字节计）
+*/
+int bench_unix_socket()
+{
+    const size_t ROUNDS = 5000;
+    const size_t BULK_ROUNDS = 5000;
+    const std::string small(64, 's');
+    const std::string bulk(32 * 1024, 'b');
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "tcp_example_unix_bench.sock";
+
+    const std::vector<std::pair<const char *, TcpAddress>> transports = {
+        { "tcp", TcpAddress::inet("127.0.0.1", 18109) },
+        { "unix", TcpAddress::local(path.string()) },
+        { "abstract", TcpAddress::local("@tcp_example_unix_bench") },
+    };
+
+    bool ok = true;
+    std::cout << std::left << std::setw(12) << "transport" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us"
+        << "MB/s" << std::endl;
+    for (const auto& transport : transports) {
+        try {
+            LocalEchoServer server(transport.second);
+            std::atomic<bool> running(true);
+            std::thread server_thread([&]() {
+                while (running) {
+                    server.listen_loop();
+                }
+            });
+
+            std::vector<double> samples;
+            double megabytes_per_second = 0;
+            {
+                TcpClient client(transport.second);
+                std::vector<char> buf(64 * 1024);
+                for (size_t i = 0; i < ROUNDS && ok; i++) {
+                    auto begin = std::chrono::steady_clock::now();
+                    ok = round_trip(client.get_fd(), small, buf);
+                    samples.push_back(std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - begin).count());
+                }
+
+                auto begin = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < BULK_ROUNDS && ok; i++) {
+                    ok = round_trip(client.get_fd(), bulk, buf);
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                megabytes_per_second = static_cast<double>(BULK_ROUNDS * bulk.size() * 2) / (1024.0 * 1024.0) / seconds;
+            }
+            running = false;
+            server_thread.join();
+
+            if (ok) {
+                std::sort(samples.begin(), samples.end());
+                std::cout << std::left << std::setw(12) << transport.first << std::fixed << std::setprecision(1)
+                    << std::setw(12) << samples[samples.size() / 2] << std::setw(12)
+                    << samples[samples.size() * 99 / 100] << std::setprecision(0) << megabytes_per_second << std::endl;
+            }
+        } catch (const TcpRuntimeException& e) {
+            std::cerr << "Exception: " << e.what() << std::endl;
+            ok = false;
+        }
+    }
+
+    std::cout << (ok ? "Unix socket benchmark finished" : "Unix socket benchmark FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
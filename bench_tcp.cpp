@@ -0,0 +1,28 @@
+int bench_file_strategy();
+int bench_http2();
+int bench_header_builder();
+int bench_shaping();
+int bench_placement();
+int bench_busy_poll();
+int bench_socket_options();
+int bench_unix_socket();
+int bench_codec();
+int bench_fanout();
+int bench_post_send();
+
+int main()
+{
+    bench_file_strategy();
+    bench_http2();
+    bench_header_builder();
+    bench_shaping();
+    bench_placement();
+    bench_busy_poll();
+    bench_socket_options();
+    bench_unix_socket();
+    bench_codec();
+    bench_fanout();
+    bench_post_send();
+
+    return 0;
+}
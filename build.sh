@@ -6,4 +6,6 @@ elif [ $1 = "check" ]; then
     cppcheck src/ --enable=all -I /usr/include -I include/ 2>&1 | tee cppcheck.log
 elif [ $1 = "test" ]; then
     cmake . && make clean && make -j4 test_tcp && ./test_tcp | tee test_tcp.log
+elif [ $1 = "bench" ]; then
+    cmake . && make clean && make -j4 bench_tcp && ./bench_tcp | tee bench_tcp.log
 fi
\ No newline at end of file
@@ -0,0 +1,24 @@
+// http_pack_main.cpp
+// 发布时把web根目录打包为单个归档，由http_server以HTTP_PACK指定后直接提供服务
+#include <iostream>
+#include "http_pack.hpp"
+
+int main(const int argc, const char **argv)
+{
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <source_dir> <pack_file>" << std::endl;
+        return -1;
+    }
+
+    try {
+        HttpPackBuildStats stats = HttpPack::build(argv[1], argv[2]);
+        std::cout << "===> packed " << stats.files << " files (" << stats.bytes << " bytes), "
+            << stats.gzip_files << " with gzip variants (" << stats.gzip_bytes << " bytes) into " << argv[2]
+            << std::endl;
+    } catch (std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+
+    return 0;
+}
@@ -1,16 +1,52 @@
 // main.cpp
 #include "http_server.hpp"
+#include "tcp_handoff.hpp"
+#include "cpu_placement.hpp"
 #include <iostream>
 #include <csignal>
+#include <atomic>
+#include <memory>
+#include <thread>
 
-static HttpServer* g_server = nullptr;
+// 收到退出信号后最多等待在途请求的时长
+static constexpr std::chrono::seconds DRAIN_TIMEOUT(30);
+// 新进程收到监听fd后须在该时限内确认接管
+static constexpr int32_t HANDOFF_CONFIRM_TIMEOUT = 5000; // ms
+
+// 信号处理函数中只能做异步信号安全的操作，这里仅记录信号，由事件循环退出后统一处理
+static volatile sig_atomic_t g_stop_signal = 0;
 
 void signal_handler(int signal) {
-    LOG_INFO("Received signal %d, shutting down...", signal);
-    if (g_server) {
-        // 这里可以添加清理逻辑
+    g_stop_signal = signal;
+}
+
+// 解析形如"/api/=127.0.0.1:9000,127.0.0.1:9001;/svc/=127.0.0.1:9100"的反向代理路由表
+static void add_proxy_routes(HttpServer& server, const std::string& spec)
+{
+    size_t start = 0;
+    while (start < spec.size()) {
+        size_t end = std::min(spec.find(';', start), spec.size());
+        std::string route = spec.substr(start, end - start);
+        start = end + 1;
+        size_t eq = route.find('=');
+        if (eq == std::string::npos) {
+            throw TcpRuntimeException("invalid proxy route: " + route, __FILENAME__, __LINE__);
+        }
+
+        std::vector<HttpUpstreamAddress> upstreams;
+        size_t pos = eq + 1;
+        while (pos < route.size()) {
+            size_t comma = std::min(route.find(',', pos), route.size());
+            std::string address = route.substr(pos, comma - pos);
+            pos = comma + 1;
+            size_t colon = address.rfind(':');
+            if (colon == std::string::npos) {
+                throw TcpRuntimeException("invalid upstream address: " + address, __FILENAME__, __LINE__);
+            }
+            upstreams.push_back({address.substr(0, colon), static_cast<uint16_t>(std::stoul(address.substr(colon + 1)))});
+        }
+        server.add_proxy_route(route.substr(0, eq), upstreams);
     }
-    exit(0);
 }
 
 int main() {
@@ -18,22 +54,114 @@ int main() {
         // 注册信号处理器
         signal(SIGINT, signal_handler);
         signal(SIGTERM, signal_handler);
-        
+
+        // 设置了交接路径时支持热重启：新进程启动后从旧进程接过监听socket，旧进程随即排空退出
+        const char *handoff_path = getenv("HTTP_HANDOFF_SOCKET");
+        std::unique_ptr<ListenHandoff> handoff;
+        int32_t inherited_fd = -1;
+        if (handoff_path != nullptr) {
+            handoff = std::make_unique<ListenHandoff>(handoff_path);
+            inherited_fd = handoff->receive(HANDOFF_CONFIRM_TIMEOUT);
+        }
+
+        // 设置了CPU规划（"auto"或如"0:1-3"）时把事件循环线程与工作线程绑定到指定的CPU，否则线程不绑定
+        const char *cpu_placement = getenv("HTTP_CPU_PLACEMENT");
+        CpuPlacement placement;
+        if (cpu_placement != nullptr) {
+            placement = CpuPlacement::parse(cpu_placement);
+        }
+        auto executor = std::make_unique<WorkStealingExecutor>(placement.worker_cpus.empty() ? 0 :
+            placement.worker_cpus.size(), WorkStealingExecutor::DEFAULT_QUEUE_CAPACITY, placement.worker_cpus);
+
         // 创建 HTTP 服务器实例
-        HttpServer server("127.0.0.1", 8080, "./html");
-        g_server = &server;
-        
+        std::unique_ptr<HttpServer> server = inherited_fd >= 0 ?
+            std::make_unique<HttpServer>(inherited_fd, "./html", std::move(executor)) :
+            std::make_unique<HttpServer>("127.0.0.1", 8080, "./html", std::move(executor));
+        server->set_loop_cpu(placement.reactor_cpu);
+
+        // 设置了选项预设（"latency"或"throughput"）时按其设置监听socket与新连接的TCP选项
+        const char *socket_profile = getenv("HTTP_SOCKET_PROFILE");
+        if (socket_profile != nullptr) {
+            server->set_socket_options(TcpSocketOptions::parse(socket_profile));
+        }
+
+        // 设置了自旋预算（微秒）时启用低延迟的忙轮询模式，宜同时用HTTP_CPU_PLACEMENT让事件循环独占一个CPU
+        const char *busy_poll_us = getenv("HTTP_BUSY_POLL_US");
+        if (busy_poll_us != nullptr) {
+            TcpBusyPollConfig busy_poll_config;
+            busy_poll_config.spin_budget = std::chrono::microseconds(std::stoul(busy_poll_us));
+            server->enable_busy_poll(busy_poll_config);
+        }
+
+        // 指定了打包归档时从归档提供服务，见http_pack工具
+        const char *pack_path = getenv("HTTP_PACK");
+        if (pack_path != nullptr) {
+            server->serve_pack(pack_path);
+        }
+
+        // 设置了上传大小上限时接受PUT/POST上传到web根目录
+        const char *upload_max_size = getenv("HTTP_UPLOAD_MAX_SIZE");
+        if (upload_max_size != nullptr) {
+            server->enable_uploads(std::stoull(upload_max_size));
+        }
+
+        // 设置了路由表时把匹配前缀的请求转发到上游服务器
+        const char *proxy_routes = getenv("HTTP_PROXY_ROUTES");
+        if (proxy_routes != nullptr) {
+            add_proxy_routes(*server, proxy_routes);
+        }
+
+        // 设置了慢请求阈值（毫秒）或抽样间隔时跟踪各请求的阶段耗时
+        const char *slow_request_ms = getenv("HTTP_SLOW_REQUEST_MS");
+        const char *trace_sample = getenv("HTTP_TRACE_SAMPLE");
+        if (slow_request_ms != nullptr || trace_sample != nullptr) {
+            HttpTraceConfig trace_config;
+            if (slow_request_ms != nullptr) {
+                trace_config.slow_threshold = std::chrono::milliseconds(std::stoul(slow_request_ms));
+            }
+            if (trace_sample != nullptr) {
+                trace_config.sample_every = static_cast<uint32_t>(std::stoul(trace_sample));
+            }
+            server->enable_tracing(trace_config);
+        }
+
+        // 设置了证书与私钥时以HTTPS提供服务
+        const char *tls_cert = getenv("HTTP_TLS_CERT");
+        const char *tls_key = getenv("HTTP_TLS_KEY");
+        if (tls_cert != nullptr && tls_key != nullptr) {
+            server->enable_tls(tls_cert, tls_key);
+        }
+
+        std::atomic<bool> handed_over(false);
+        std::thread handoff_thread;
+        if (handoff) {
+            handoff->listen();
+            handoff->confirm();
+            handoff_thread = std::thread([&]() {
+                handed_over = handoff->hand_over(server->get_listen_fd(), HANDOFF_CONFIRM_TIMEOUT);
+            });
+        }
+
         LOG_INFO("Press Ctrl+C to stop the server");
-        
+
         // 进入事件循环
-        while (true) {
-            server.listen_loop();
+        while (g_stop_signal == 0 && !handed_over) {
+            server->listen_loop();
+        }
+
+        if (handoff) {
+            handoff->cancel();
+            handoff_thread.join();
+        }
+        if (g_stop_signal != 0) {
+            LOG_INFO("Received signal %d, shutting down...", static_cast<int>(g_stop_signal));
         }
-        
+        server->drain(DRAIN_TIMEOUT);
+        server->stop();
     } catch (const TcpRuntimeException& e) {
         LOG_ERR("Server error: %s", e.what());
         return 1;
     }
-    
+
     return 0;
-}
\ No newline at end of file
+}
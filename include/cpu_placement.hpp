@@ -0,0 +1,45 @@
+#ifndef CPU_PLACEMENT_HPP
+#define CPU_PLACEMENT_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief reactor与工作线程的CPU绑定规划，以及可用CPU数的探测
+ *
+ * 可用CPU数取sched_getaffinity允许的CPU数与cgroup CPU配额（v2的cpu.max，v1的cfs_quota）中较小者，
+ * 容器内限额为2核时不会按宿主机的核数创建线程。
+ * 线程绑定后在本线程上分配的内存按Linux的首次访问策略落在本地NUMA节点，
+ * 因此各线程独占的数据结构（如工作线程的任务队列）应在绑定之后由该线程自己分配。
+ */
+class CpuPlacement {
+public:
+    int32_t reactor_cpu = -1;         // 事件循环线程绑定的CPU，-1为不绑定
+    std::vector<int32_t> worker_cpus; // 工作线程依次绑定的CPU，线程数多于CPU数时轮流复用；为空时不绑定
+
+    // 按可用CPU自动规划：reactor占用第一个可用CPU，工作线程各占一个其余的CPU，与reactor同一NUMA节点的排在前面；
+    // 工作线程数为可用CPU数减一，只有一个可用CPU时reactor与唯一的工作线程共用它
+    static CpuPlacement automatic();
+    // 解析"auto"或"<reactor_cpu>:<worker_cpulist>"，如"0:1-3,6"
+    // @exception 格式非法或含有不允许使用的CPU时抛出TcpRuntimeException
+    static CpuPlacement parse(const std::string& spec);
+
+    // 解析内核cpulist格式，如"0-3,6"
+    // @exception 格式非法时抛出TcpRuntimeException
+    static std::vector<int32_t> parse_cpu_list(const std::string& list);
+    // 当前进程允许运行的CPU，升序
+    static std::vector<int32_t> get_allowed_cpus();
+    // cgroup限制的CPU配额（以CPU数计，可为小数），未限制时返回0
+    static double get_cgroup_cpu_limit();
+    // 允许的CPU数与cgroup配额向上取整中的较小者，至少为1
+    static size_t get_usable_cpu_count();
+    // CPU所属的NUMA节点，无法确定时返回0
+    static int32_t get_cpu_node(int32_t cpu);
+    // 把调用线程绑定到cpu
+    // @exception 绑定失败时抛出TcpRuntimeException
+    static void pin_current_thread(int32_t cpu);
+};
+
+#endif // CPU_PLACEMENT_HPP
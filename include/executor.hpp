@@ -0,0 +1,126 @@
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using ExecutorTask = std::function<void()>;
+
+/**
+ * @brief 任务执行器接口，HttpServer通过该接口把请求交给工作线程
+ *
+ * submit()不得阻塞；队列已满时返回false且task保持原样，由调用方决定如何处理（就地执行、拒绝服务等）
+ */
+class Executor {
+public:
+    virtual ~Executor() = default;
+
+    virtual bool submit(ExecutorTask&& task) = 0;
+    // 停止接收新任务，处理完已入队的任务后回收全部线程
+    virtual void stop() = 0;
+    virtual size_t get_thread_count() const = 0;
+};
+
+/**
+ * @brief 有界无锁任务队列（Vyukov MPMC环形队列）
+ *
+ * 每个槽位带一个序号，生产者与消费者各自通过CAS推进下标，无需互斥锁；
+ * 工作线程从自己的队列取任务，空闲时从其他线程的队列窃取，两者走同一个pop路径。
+ */
+class BoundedTaskQueue {
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        ExecutorTask task;
+    };
+
+    // 生产与消费下标分处不同缓存行，避免伪共享
+    alignas(64) std::atomic<size_t> enqueue_pos{0};
+    alignas(64) std::atomic<size_t> dequeue_pos{0};
+    alignas(64) std::unique_ptr<Cell[]> cells;
+    size_t mask;
+
+public:
+    explicit BoundedTaskQueue(size_t capacity);
+
+    bool push(ExecutorTask&& task);
+    bool pop(ExecutorTask& task);
+    bool empty() const;
+};
+
+/**
+ * @brief 基于futex的EventCount，用于空闲工作线程的廉价休眠与唤醒
+ *
+ * 等待方先prepare_wait()取得当前纪元，再次确认确实无任务后commit_wait()；
+ * 通知方只在存在等待者时才递增纪元并发起futex唤醒，忙碌时提交任务不产生系统调用。
+ */
+class EventCount {
+private:
+    alignas(64) std::atomic<uint32_t> epoch{0};
+    std::atomic<uint32_t> waiters{0};
+
+public:
+    uint32_t prepare_wait();
+    void cancel_wait();
+    void commit_wait(uint32_t key);
+    void notify_one();
+    void notify_all();
+};
+
+/**
+ * @brief 工作窃取线程池
+ *
+ * 每个工作线程持有一个有界无锁队列，submit()以轮转方式选择目标队列，
+ * 目标已满时尝试其他队列，全部满时返回false。
+ * 工作线程优先处理自己的队列，空闲时依次窃取其他队列的任务，仍无任务则经EventCount休眠。
+ * stop()回收工作线程后，由调用线程执行队列中剩余的任务，submit()返回true的任务总会被执行。
+ * 指定了CPU时工作线程先绑定再分配自己的队列，队列内存落在该CPU的NUMA节点上；全部队列就绪后才开始取任务。
+ */
+class WorkStealingExecutor : public Executor {
+private:
+    struct Worker {
+        std::unique_ptr<BoundedTaskQueue> queue; // 由工作线程自己分配
+        std::thread thread;
+    };
+
+    constexpr static uint32_t SPIN_ROUNDS = 64; // 休眠前的自旋轮数
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> next_worker{0};
+    std::atomic<bool> stop_flag{false};
+    std::atomic<size_t> submitting{0}; // 进行中的submit()调用数，stop()等其归零后再回收线程
+    EventCount event_count;
+
+    // 启动阶段等待所有工作线程分配好队列
+    std::mutex ready_mutex;
+    std::condition_variable ready_cond;
+    size_t ready_count = 0;
+
+    bool find_task(size_t self, ExecutorTask& task);
+    void worker_main(size_t self, size_t queue_capacity, int32_t cpu);
+    void worker_loop(size_t self);
+
+public:
+    constexpr static size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+    // thread_count为0时按可用CPU数确定；cpus非空时第i个线程绑定到cpus[i % cpus.size()]，见CpuPlacement
+    explicit WorkStealingExecutor(size_t thread_count = 0, size_t queue_capacity = DEFAULT_QUEUE_CAPACITY,
+        const std::vector<int32_t>& cpus = {});
+    ~WorkStealingExecutor() override;
+
+    bool submit(ExecutorTask&& task) override;
+    void stop() override;
+    size_t get_thread_count() const override;
+
+    // 可用CPU数，考虑进程的CPU亲和性与cgroup配额，见CpuPlacement::get_usable_cpu_count()
+    static size_t default_thread_count();
+};
+
+#endif // EXECUTOR_HPP
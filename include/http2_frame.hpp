@@ -0,0 +1,82 @@
+#ifndef HTTP2_FRAME_HPP
+#define HTTP2_FRAME_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+// 帧类型，RFC 7540 6
+enum Http2FrameType : uint8_t {
+    HTTP2_FRAME_DATA = 0x0,
+    HTTP2_FRAME_HEADERS = 0x1,
+    HTTP2_FRAME_PRIORITY = 0x2,
+    HTTP2_FRAME_RST_STREAM = 0x3,
+    HTTP2_FRAME_SETTINGS = 0x4,
+    HTTP2_FRAME_PUSH_PROMISE = 0x5,
+    HTTP2_FRAME_PING = 0x6,
+    HTTP2_FRAME_GOAWAY = 0x7,
+    HTTP2_FRAME_WINDOW_UPDATE = 0x8,
+    HTTP2_FRAME_CONTINUATION = 0x9,
+};
+
+enum Http2FrameFlag : uint8_t {
+    HTTP2_FLAG_END_STREAM = 0x1,  // DATA与HEADERS
+    HTTP2_FLAG_ACK = 0x1,         // SETTINGS与PING
+    HTTP2_FLAG_END_HEADERS = 0x4,
+    HTTP2_FLAG_PADDED = 0x8,
+    HTTP2_FLAG_PRIORITY = 0x20,
+};
+
+enum Http2SettingId : uint16_t {
+    HTTP2_SETTINGS_HEADER_TABLE_SIZE = 0x1,
+    HTTP2_SETTINGS_ENABLE_PUSH = 0x2,
+    HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS = 0x3,
+    HTTP2_SETTINGS_INITIAL_WINDOW_SIZE = 0x4,
+    HTTP2_SETTINGS_MAX_FRAME_SIZE = 0x5,
+    HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE = 0x6,
+};
+
+// RST_STREAM与GOAWAY携带的错误码，RFC 7540 7
+enum Http2ErrorCode : uint32_t {
+    HTTP2_ERR_NO_ERROR = 0x0,
+    HTTP2_ERR_PROTOCOL = 0x1,
+    HTTP2_ERR_INTERNAL = 0x2,
+    HTTP2_ERR_FLOW_CONTROL = 0x3,
+    HTTP2_ERR_STREAM_CLOSED = 0x5,
+    HTTP2_ERR_FRAME_SIZE = 0x6,
+    HTTP2_ERR_REFUSED_STREAM = 0x7,
+    HTTP2_ERR_CANCEL = 0x8,
+    HTTP2_ERR_COMPRESSION = 0x9,
+    HTTP2_ERR_ENHANCE_YOUR_CALM = 0xb,
+};
+
+// 协议错误；stream_id为0时是连接错误，需发送GOAWAY后关闭连接，否则只需以RST_STREAM重置该流
+class Http2Exception : public std::runtime_error {
+protected:
+    Http2ErrorCode error_code;
+    uint32_t stream_id;
+public:
+    Http2Exception(const std::string& message, Http2ErrorCode error_code, uint32_t stream_id = 0) :
+        std::runtime_error(message), error_code(error_code), stream_id(stream_id) {}
+
+    Http2ErrorCode get_error_code() const { return error_code; }
+    uint32_t get_stream_id() const { return stream_id; }
+};
+
+// 9字节的帧头
+struct Http2FrameHeader {
+    static constexpr size_t SIZE = 9;
+
+    uint32_t length = 0;   // 负载长度，24位
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint32_t stream_id = 0; // 31位，保留位被忽略
+
+    // 从至少SIZE字节的数据解析
+    static Http2FrameHeader parse(const char *data);
+    // 追加到out末尾
+    void serialize(std::string& out) const;
+};
+
+#endif // HTTP2_FRAME_HPP
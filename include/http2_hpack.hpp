@@ -0,0 +1,84 @@
+#ifndef HTTP2_HPACK_HPP
+#define HTTP2_HPACK_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+
+#include "http2_frame.hpp"
+
+struct HpackHeader {
+    std::string name;
+    std::string value;
+};
+
+/**
+ * @brief HPACK索引表（RFC 7541 2.3）：1~61为静态表，其后依次为动态表中由新到旧的条目
+ *
+ * 编码端与解码端各持有一份，两端按相同的规则插入与逐出，因此只要帧按编码顺序发出，表内容就保持一致。
+ */
+class HpackTable {
+private:
+    std::deque<HpackHeader> entries; // 队首为最新插入的条目
+    size_t size = 0;                 // 按RFC计算的占用：名字与值的长度加32
+    size_t max_size = DEFAULT_SIZE;
+
+    void evict(size_t limit);
+
+public:
+    static constexpr size_t DEFAULT_SIZE = 4096;
+    static constexpr size_t ENTRY_OVERHEAD = 32;
+    static constexpr size_t STATIC_COUNT = 61;
+
+    // 按索引取条目，索引越界时返回nullptr
+    const HpackHeader *get(size_t index) const;
+    // 返回名字与值都匹配的索引，没有时返回0；name_index为只有名字匹配的索引，没有时为0
+    size_t find(const std::string& name, const std::string& value, size_t& name_index) const;
+    // 插入新条目，放不下时逐出旧条目，条目本身超过容量时清空动态表
+    void add(HpackHeader header);
+    void set_max_size(size_t max_size);
+    size_t get_max_size() const;
+};
+
+/**
+ * @brief 头部块解码器，每个连接一个，按头部块到达的顺序调用
+ */
+class HpackDecoder {
+private:
+    HpackTable table;
+    size_t settings_table_size = HpackTable::DEFAULT_SIZE; // 本端SETTINGS_HEADER_TABLE_SIZE，对端更新的上限
+
+public:
+    // 解码后头部列表的上限（按RFC计算，每项另加32字节），防止以少量索引展开出大量数据
+    static constexpr size_t MAX_HEADER_LIST_SIZE = 64 * 1024;
+
+    // 解码一个完整的头部块（HEADERS与其后CONTINUATION的片段拼接）
+    // @exception 格式错误、索引越界或哈夫曼编码非法时抛出Http2Exception(HTTP2_ERR_COMPRESSION)，
+    //            头部列表超过上限时抛出Http2Exception(HTTP2_ERR_ENHANCE_YOUR_CALM)
+    std::vector<HpackHeader> decode(const std::string& block);
+};
+
+/**
+ * @brief 头部块编码器，每个连接一个，编码顺序必须与头部块的发送顺序一致
+ *
+ * 完全匹配的字段以索引发送；值在响应间大多相同的字段（如content-type、cache-control）
+ * 以增量索引方式加入动态表，每个响应都不同的字段（如content-length、etag）不加入，避免挤出有用的条目。
+ * 字符串在哈夫曼编码更短时使用哈夫曼编码。
+ */
+class HpackEncoder {
+private:
+    HpackTable table;
+    bool size_update_pending = false;
+
+    static bool should_index(const std::string& name);
+
+public:
+    // 应用对端的SETTINGS_HEADER_TABLE_SIZE，不超过默认容量；下一个头部块开头会携带动态表大小更新
+    void set_max_table_size(size_t size);
+    // 编码后追加到out末尾，名字须为小写
+    void encode(const std::vector<HpackHeader>& headers, std::string& out);
+};
+
+#endif // HTTP2_HPACK_HPP
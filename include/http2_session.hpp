@@ -0,0 +1,132 @@
+#ifndef HTTP2_SESSION_HPP
+#define HTTP2_SESSION_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+
+#include "http2_frame.hpp"
+#include "http2_hpack.hpp"
+#include "http_transfer.hpp"
+
+// 收到的一个完整请求，头部已转换为等价的HTTP/1.1请求头，由HttpRequest按原有方式解析
+struct Http2Request {
+    uint32_t stream_id;
+    std::string head;
+};
+
+/**
+ * @brief 单个连接上的HTTP/2（h2c）协议状态，不直接读写socket，调用方需保证串行访问
+ *
+ * 输入侧：feed()解析连接缓冲区中的完整帧，处理SETTINGS、PING、WINDOW_UPDATE等控制帧，
+ * 把每个请求的头部块转换为HTTP/1.1请求头交给调用方，各流的请求可以并发处理。
+ * 输出侧：处理函数生成的仍是HTTP/1.1格式的HttpTransfer，submit_response()取出其中的响应头，
+ * 以HPACK编码为HEADERS帧；响应体按流与连接的发送窗口切分为DATA帧，帧头作为内存段，
+ * 帧内容直接引用原响应的内存段或文件段，文件内容仍按所选策略零拷贝发送。
+ * next_output()以轮转方式在各流之间交错组织下一批帧，避免一个大文件挡住同一连接上的其他资源。
+ */
+class Http2Session {
+private:
+    struct Stream {
+        int64_t send_window = 0;      // 流的发送窗口，可因对端调小初始窗口而为负
+        bool remote_closed = false;   // 对端已发送END_STREAM
+        bool responded = false;       // 响应已交付
+        bool headers_sent = false;
+        bool blocked = false;         // 流窗口耗尽，等待WINDOW_UPDATE后重新加入轮转
+        std::vector<HpackHeader> response_headers;
+        std::unique_ptr<HttpTransfer> body;
+    };
+
+    std::unordered_map<uint32_t, Stream> streams; // 尚未发送完响应的流
+    std::deque<uint32_t> ready;                    // 有响应待发送且流窗口未耗尽的流，按轮转顺序排列
+    std::string control;                           // 待发送的控制帧
+
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+
+    bool preface_received = false;
+    bool settings_received = false;
+    uint32_t last_stream_id = 0;       // 对端开启的最大流标识
+    uint32_t continuation_stream = 0;  // 头部块尚未结束的流，期间只允许该流的CONTINUATION
+    bool continuation_end_stream = false;
+    std::string header_block;
+
+    int64_t send_window = DEFAULT_WINDOW_SIZE; // 连接级发送窗口
+    uint32_t peer_initial_window = DEFAULT_WINDOW_SIZE;
+    uint32_t peer_max_frame_size = DEFAULT_MAX_FRAME_SIZE;
+
+    bool going_away = false;      // 本端已发送GOAWAY
+    bool peer_going_away = false; // 对端已发送GOAWAY
+    size_t completed = 0;         // 自上次take_completed()以来结束的已交付响应数
+
+    void append_frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload);
+    void append_window_update(uint32_t stream_id, uint32_t increment);
+    void reset_stream(uint32_t stream_id, Http2ErrorCode error_code);
+    void finish_stream(uint32_t stream_id);
+    void unblock_stream(uint32_t stream_id, Stream& stream);
+
+    void handle_frame(const Http2FrameHeader& header, const char *payload, std::vector<Http2Request>& requests);
+    void handle_data(const Http2FrameHeader& header, const char *payload);
+    void handle_headers(const Http2FrameHeader& header, const char *payload, std::vector<Http2Request>& requests);
+    void handle_continuation(const Http2FrameHeader& header, const char *payload, std::vector<Http2Request>& requests);
+    void handle_settings(const Http2FrameHeader& header, const char *payload);
+    void handle_window_update(const Http2FrameHeader& header, const char *payload);
+    void handle_rst_stream(const Http2FrameHeader& header, const char *payload);
+    void apply_settings(const char *payload, size_t length);
+    void end_headers(uint32_t stream_id, bool end_stream, std::vector<Http2Request>& requests);
+
+    static std::string build_request_head(const std::vector<HpackHeader>& headers, uint32_t stream_id);
+    static bool parse_response_head(const std::string& head, std::vector<HpackHeader>& headers);
+    void write_headers(uint32_t stream_id, Stream& stream, bool end_stream, HttpTransfer& out);
+
+public:
+    static constexpr const char *CLIENT_PREFACE = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+    static constexpr size_t CLIENT_PREFACE_SIZE = 24;
+    static constexpr uint32_t DEFAULT_WINDOW_SIZE = 65535;
+    static constexpr uint32_t MAX_WINDOW_SIZE = 0x7fffffff;
+    static constexpr uint32_t DEFAULT_MAX_FRAME_SIZE = 16384; // 本端接受的最大帧负载
+    static constexpr uint32_t MAX_CONCURRENT_STREAMS = 100;
+    // 单个头部块（含CONTINUATION）编码后的上限
+    static constexpr size_t MAX_HEADER_BLOCK_SIZE = 64 * 1024;
+    // 单次next_output()组织的数据量，限制一个连接在每次EPOLLOUT中占用reactor的时间
+    static constexpr size_t OUTPUT_BATCH_SIZE = 256 * 1024;
+
+    // 排入本端的SETTINGS帧，它必须是连接上的第一个HTTP/2帧
+    Http2Session();
+
+    Http2Session(const Http2Session&) = delete;
+    Http2Session& operator=(const Http2Session&) = delete;
+
+    // 判断输入是否为prior knowledge方式的客户端连接前言；输入只是前言的前缀时返回true且complete为false
+    static bool match_preface(const std::string& input, bool& complete);
+
+    // 经HTTP/1.1 Upgrade切换：应用HTTP2-Settings中的设置，原请求成为已半关闭的流1
+    // @exception HTTP2-Settings无法解码时抛出Http2Exception
+    void upgrade(const std::string& http2_settings);
+
+    // 消费input中的完整帧，新收到的请求追加到requests；流错误在内部以RST_STREAM处理
+    // @exception 连接错误时抛出Http2Exception，调用方应调用go_away()
+    void feed(std::string& input, std::vector<Http2Request>& requests);
+    // 排入GOAWAY并丢弃所有流，此后不再处理输入
+    void go_away(Http2ErrorCode error_code);
+
+    // 把HTTP/1.1格式的响应挂到流上，流已被重置或会话已结束时返回false
+    bool submit_response(uint32_t stream_id, std::unique_ptr<HttpTransfer> response);
+
+    // 组织下一批待发送的帧，没有可发送的数据时返回nullptr
+    std::unique_ptr<HttpTransfer> next_output();
+    bool has_output() const;
+    // 会话已结束且全部帧已取出，调用方发送完最后一批后应关闭连接
+    bool is_finished() const;
+
+    // 返回并清零自上次调用以来结束（发完或被重置）的已交付响应数
+    size_t take_completed();
+    // 已交付但尚未结束的响应数
+    size_t get_pending_responses() const;
+};
+
+#endif // HTTP2_SESSION_HPP
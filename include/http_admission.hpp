@@ -0,0 +1,76 @@
+#ifndef HTTP_ADMISSION_HPP
+#define HTTP_ADMISSION_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <array>
+#include <chrono>
+
+// 请求准入与排队等待的统计数据，等待时长单位为微秒
+struct HttpAdmissionStats {
+    uint64_t admitted = 0;      // 进入工作队列的请求数
+    uint64_t rejected = 0;      // 排队请求数达到上限、以503拒绝的请求数
+    uint64_t expired = 0;       // 排队超过等待时限、以503回复的请求数
+    uint64_t pauses = 0;        // reactor因积压暂停读取与accept的次数
+    size_t queued = 0;          // 当前排队中的请求数
+    uint64_t max_wait_us = 0;   // 最长排队等待
+    uint64_t p50_wait_us = 0;   // 排队等待的中位数（按2的幂分桶估计的上界）
+    uint64_t p99_wait_us = 0;
+    double mean_wait_us = 0;
+};
+
+/**
+ * @brief 工作队列的准入控制：限制排队中的请求数，统计排队等待时长，并给出reactor暂停与恢复读取的时机
+ *
+ * 请求提交前调用try_admit()占用一个排队名额，工作线程开始处理时调用begin()归还名额并检查等待时限。
+ * 排队数达到上限的3/4时reactor暂停读取新数据与accept，回落到一半以下时恢复，两条水位线之间留出回差，
+ * 避免在上限附近反复切换；上限本身只在暂停之前已读入的请求（如HTTP/2的一批流）上起作用。
+ */
+class HttpAdmissionControl {
+public:
+    static constexpr size_t DEFAULT_MAX_QUEUED = 1024;
+    static constexpr std::chrono::milliseconds DEFAULT_MAX_QUEUE_WAIT{2000};
+    // 503响应中建议客户端重试的间隔
+    static constexpr uint32_t RETRY_AFTER_SECONDS = 1;
+
+private:
+    // 第i个桶统计等待时长在[2^i, 2^(i+1))微秒内的请求，最后一个桶收纳更长的等待
+    static constexpr size_t WAIT_BUCKETS = 32;
+
+    std::atomic<size_t> max_queued{DEFAULT_MAX_QUEUED};
+    std::atomic<int64_t> max_queue_wait_us{
+        std::chrono::duration_cast<std::chrono::microseconds>(DEFAULT_MAX_QUEUE_WAIT).count()};
+
+    std::atomic<size_t> queued{0};
+    std::atomic<uint64_t> admitted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> expired{0};
+    std::atomic<uint64_t> pauses{0};
+    std::atomic<uint64_t> total_wait_us{0};
+    std::atomic<uint64_t> max_wait_us{0};
+    std::array<std::atomic<uint64_t>, WAIT_BUCKETS> wait_buckets{};
+
+    uint64_t wait_percentile(const std::array<uint64_t, WAIT_BUCKETS>& counts, uint64_t total, double ratio) const;
+
+public:
+    // max_queued为0时不限制排队数，max_queue_wait为0时不限制排队时长
+    void configure(size_t max_queued, std::chrono::milliseconds max_queue_wait);
+
+    // 占用一个排队名额，排队数已达上限时返回false并计入拒绝
+    bool try_admit();
+    // 已占用名额的请求未能进入队列时归还名额并计入拒绝
+    void cancel();
+    // 工作线程开始处理请求时调用，返回false表示排队时间已超过时限，应回复503
+    bool begin(std::chrono::steady_clock::time_point enqueued);
+
+    // 排队数达到高水位，reactor应暂停读取
+    bool should_pause() const;
+    // 排队数已回落到低水位
+    bool should_resume() const;
+    void record_pause();
+
+    HttpAdmissionStats get_stats() const;
+};
+
+#endif // HTTP_ADMISSION_HPP
@@ -0,0 +1,63 @@
+#ifndef HTTP_BODY_FRAMING_HPP
+#define HTTP_BODY_FRAMING_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// 消息体的分帧方式
+enum HttpBodyMode {
+    HTTP_BODY_LENGTH,  // Content-Length定长
+    HTTP_BODY_CHUNKED, // Transfer-Encoding: chunked
+    HTTP_BODY_CLOSE,   // 以连接关闭结束，只用于响应
+};
+
+/**
+ * @brief 跟踪消息体的分帧，区分可原样转存、转发的数据与需要解析的分帧字节
+ *
+ * 调用方交替推进：get_data_remaining()非0时，其后这么多字节都是数据，可不经检查直接写入文件或splice转发，
+ * 随后调用consume_data()；为0时把读入的字节交给feed()，解析分块长度行、分块结尾的CRLF与trailer。
+ * 分块编码本身不被去除，转发方可以把全部字节原样发出，只借助本类确定消息体在哪里结束。
+ */
+class HttpBodyFraming {
+private:
+    enum State {
+        STATE_DATA,       // 定长数据或分块数据
+        STATE_CHUNK_SIZE, // 等待分块长度行
+        STATE_CHUNK_END,  // 分块数据之后的CRLF
+        STATE_TRAILER,    // 最后一个分块之后的trailer，以空行结束
+        STATE_DONE,
+    };
+
+    HttpBodyMode mode;
+    State state = STATE_DATA;
+    uint64_t remaining = 0; // 当前数据段中尚未经过的字节数
+    uint64_t declared = 0;  // 已声明的数据总长
+    std::string line;       // 尚未收齐的分帧行
+
+    void parse_line();
+
+public:
+    // 分块长度行与trailer行的长度上限
+    constexpr static size_t MAX_LINE_SIZE = 4096;
+
+    // length只对HTTP_BODY_LENGTH有意义
+    explicit HttpBodyFraming(HttpBodyMode mode, uint64_t length = 0);
+
+    // 当前可不经解析直接经过的数据字节数，以关闭结束的消息体为UINT64_MAX
+    uint64_t get_data_remaining() const;
+    void consume_data(uint64_t length);
+    // 解析分帧字节，在进入数据段或消息体结束时停下，返回消耗的字节数
+    // @exception 分帧非法时抛出HttpRequestException（400）
+    size_t feed(const char *data, size_t length);
+    // 数据来源已结束：以关闭结束的消息体到此完整
+    // @exception 其余方式说明消息体被截断，抛出TcpRuntimeException
+    void finish();
+
+    bool is_done() const;
+    HttpBodyMode get_mode() const;
+    // 已声明的数据总长，即Content-Length或已解析的各分块长度之和
+    uint64_t get_declared() const;
+};
+
+#endif // HTTP_BODY_FRAMING_HPP
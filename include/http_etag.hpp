@@ -0,0 +1,65 @@
+#ifndef HTTP_ETAG_HPP
+#define HTTP_ETAG_HPP
+
+extern "C" {
+#include <sys/stat.h>
+}
+
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+// ETag的生成方式
+enum HttpEtagMode {
+    HTTP_ETAG_FILE_META,    // 基于inode、大小与mtime，无需读取文件
+    HTTP_ETAG_CONTENT_HASH, // 基于文件内容哈希，多机部署时ETag一致；哈希结果按mtime缓存
+};
+
+// 一个文件当前的校验器，用于条件请求
+struct HttpValidators {
+    std::string etag;          // 带引号的强ETag，例如 "1a2b-400-17f0c3e2d"
+    std::string last_modified; // HTTP-date格式的Last-Modified
+    time_t mtime;              // 秒级mtime，用于与If-Modified-Since比较
+};
+
+/**
+ * @brief ETag与Last-Modified生成器，以及条件请求相关的解析工具
+ */
+class HttpEtagGenerator {
+private:
+    struct HashEntry {
+        off_t size;
+        struct timespec mtime;
+        uint64_t hash;
+    };
+
+    constexpr static size_t MAX_HASH_ENTRIES = 4096;
+
+    std::atomic<HttpEtagMode> mode;
+    std::mutex hash_mutex;
+    std::unordered_map<std::string, HashEntry> hashes; // 内容哈希缓存，按路径索引
+
+    uint64_t content_hash(const std::string& full_path, const struct stat& file_stat);
+
+public:
+    explicit HttpEtagGenerator(HttpEtagMode mode = HTTP_ETAG_FILE_META) : mode(mode) {}
+
+    void set_mode(HttpEtagMode mode);
+    HttpValidators make_validators(const std::string& full_path, const struct stat& file_stat);
+
+    // 64位FNV-1a，可分块累加，首块传入FNV_OFFSET_BASIS
+    constexpr static uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ULL;
+    static uint64_t fnv1a(uint64_t hash, const char *data, size_t length);
+    // 基于内容哈希的强ETag，格式与HTTP_ETAG_CONTENT_HASH模式一致
+    static std::string make_content_etag(off_t size, uint64_t hash);
+
+    static std::string format_http_date(time_t t);
+    static bool parse_http_date(const std::string& date, time_t& t);
+    // 判断If-None-Match / If-Range中的ETag列表是否匹配，weak为true时忽略W/前缀
+    static bool etag_matches(const std::string& header, const std::string& etag, bool weak);
+};
+
+#endif // HTTP_ETAG_HPP
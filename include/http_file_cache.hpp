@@ -0,0 +1,107 @@
+#ifndef HTTP_FILE_CACHE_HPP
+#define HTTP_FILE_CACHE_HPP
+
+extern "C" {
+#include <sys/types.h>
+#include <time.h>
+}
+
+#include <cstdint>
+#include <string>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "http_etag.hpp"
+
+// 热点文件缓存中的一项：预先渲染好的200响应头与完整文件内容
+// 条目一经放入缓存即不再修改，以shared_ptr形式共享给发送方，发送期间无需持锁
+struct HttpCacheEntry {
+    std::string full_path;  // 规格化后的文件路径，用于mtime校验
+    off_t size;             // 文件大小
+    struct timespec mtime;  // 载入时的文件修改时间
+    std::string mime_type;  // 文件MIME类型，Range请求切片时使用
+    bool compressible;      // 是否存在gzip协商的可能，命中时需先检查压缩版本
+    HttpValidators validators; // ETag与Last-Modified，条件请求命中缓存时直接比较
+    std::string headers;    // 预渲染的 "HTTP/1.1 200 OK" 响应头（含结尾空行）
+    std::string body;       // 文件内容
+};
+
+// 缓存命中率等统计数据
+struct HttpCacheStats {
+    uint64_t hits = 0;       // 命中次数
+    uint64_t misses = 0;     // 未命中次数（含过期）
+    uint64_t stale = 0;      // 因mtime/size变化而失效的次数
+    uint64_t admissions = 0; // 准入次数
+    uint64_t rejections = 0; // 因访问频率不足被拒绝准入的次数
+    uint64_t evictions = 0;  // 淘汰次数
+    size_t entries = 0;      // 当前条目数
+    size_t bytes = 0;        // 当前占用字节数
+
+    double hit_ratio() const
+    {
+        uint64_t total = hits + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+    }
+};
+
+/**
+ * @brief 按容量限制的小文件响应缓存
+ *
+ * 淘汰使用LRU，准入使用TinyLFU：用Count-Min Sketch近似统计每个key的近期访问频率，
+ * 只有当新条目的频率高于将被淘汰的条目时才允许替换，避免一次性访问的冷文件把热点冲掉。
+ * 计数器在采样数达到阈值后整体减半，使频率统计随时间老化。
+ *
+ * 所有接口线程安全，reactor线程与工作线程可同时调用。
+ */
+class HttpFileCache {
+private:
+    struct Node {
+        std::shared_ptr<const HttpCacheEntry> entry;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    // Count-Min Sketch，4行，每个计数器饱和于15
+    constexpr static uint32_t SKETCH_DEPTH = 4;
+    constexpr static uint8_t SKETCH_MAX_COUNT = 15;
+
+    size_t capacity;    // 总容量（字节，包含响应头）
+    off_t max_file_size; // 可缓存文件的大小上限
+
+    mutable std::mutex cache_mutex;
+    std::unordered_map<std::string, Node> entries;
+    std::list<std::string> lru_list; // 头部为最近使用
+    size_t used_bytes = 0;
+
+    std::vector<uint8_t> sketch;
+    size_t sketch_mask;
+    uint32_t sketch_samples = 0;
+    uint32_t sketch_reset_threshold;
+
+    HttpCacheStats stats;
+
+    static size_t entry_cost(const HttpCacheEntry& entry);
+    size_t sketch_index(size_t hash, uint32_t row) const;
+    void sketch_increment(const std::string& key);
+    uint8_t sketch_estimate(const std::string& key) const;
+    void remove_locked(std::unordered_map<std::string, Node>::iterator it);
+
+public:
+    constexpr static size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+    constexpr static off_t DEFAULT_MAX_FILE_SIZE = 64 * 1024;
+
+    HttpFileCache(size_t capacity = DEFAULT_CAPACITY, off_t max_file_size = DEFAULT_MAX_FILE_SIZE);
+
+    // 查找缓存并记录一次访问；文件mtime或大小已变化时条目失效，视为未命中
+    std::shared_ptr<const HttpCacheEntry> lookup(const std::string& key);
+    // 尝试放入缓存，返回是否被准入
+    bool admit(const std::string& key, std::shared_ptr<const HttpCacheEntry> entry);
+    void invalidate(const std::string& key);
+
+    off_t get_max_file_size() const;
+    HttpCacheStats get_stats() const;
+};
+
+#endif // HTTP_FILE_CACHE_HPP
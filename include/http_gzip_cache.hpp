@@ -0,0 +1,116 @@
+#ifndef HTTP_GZIP_CACHE_HPP
+#define HTTP_GZIP_CACHE_HPP
+
+extern "C" {
+#include <sys/types.h>
+#include <time.h>
+}
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+
+// 某个源文件的gzip压缩版本，连同预渲染的响应头一起缓存
+struct HttpGzipVariant {
+    std::string full_path;  // 源文件路径
+    off_t source_size;      // 压缩时源文件的大小
+    struct timespec mtime;  // 压缩时源文件的修改时间
+    bool beneficial;        // 压缩后是否确实变小，否则应直接发送原文件
+    std::string headers;    // 预渲染的 "HTTP/1.1 200 OK" + Content-Encoding: gzip 响应头
+    std::string body;       // gzip数据
+};
+
+// 压缩协商统计，bytes_saved为相对原文件节省的线上字节数
+struct HttpGzipStats {
+    uint64_t compressed_responses = 0;    // 从压缩缓存发出的响应数
+    uint64_t precompressed_responses = 0; // 直接发送.gz兄弟文件的响应数
+    uint64_t bytes_saved = 0;             // 累计节省的字节数
+    uint64_t compress_jobs = 0;           // 后台完成的压缩任务数
+    size_t entries = 0;
+    size_t bytes = 0;
+};
+
+/**
+ * @brief 有容量上限的压缩变体缓存，附带一个后台压缩线程
+ *
+ * 工作线程发现某个可压缩文件尚无压缩版本时调用schedule()，
+ * 本次先以原文件回复，由后台线程用zlib压缩一次后放入缓存，后续请求即可命中。
+ * 缓存按源文件mtime校验，淘汰策略为LRU。
+ */
+class HttpGzipCache {
+private:
+    struct Node {
+        std::shared_ptr<const HttpGzipVariant> variant;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    struct CompressJob {
+        std::string full_path;
+        std::string mime_type;
+        std::string extra_headers;
+        off_t size;
+        struct timespec mtime;
+    };
+
+    constexpr static size_t MAX_PENDING_JOBS = 64;
+
+    size_t capacity;
+    off_t max_file_size;
+
+    mutable std::mutex cache_mutex;
+    std::unordered_map<std::string, Node> entries;
+    std::list<std::string> lru_list;
+    size_t used_bytes = 0;
+
+    // 后台压缩线程
+    std::mutex job_mutex;
+    std::condition_variable job_cv;
+    std::queue<CompressJob> jobs;
+    std::unordered_set<std::string> pending_paths;
+    std::atomic<bool> stop_flag{false};
+    std::thread compress_thread;
+
+    std::atomic<uint64_t> compressed_responses{0};
+    std::atomic<uint64_t> precompressed_responses{0};
+    std::atomic<uint64_t> bytes_saved{0};
+    std::atomic<uint64_t> compress_jobs{0};
+
+    void insert(std::shared_ptr<const HttpGzipVariant> variant);
+    void compress_loop();
+    void run_job(const CompressJob& job);
+
+public:
+    constexpr static size_t DEFAULT_CAPACITY = 32 * 1024 * 1024;
+    constexpr static off_t DEFAULT_MAX_FILE_SIZE = 4 * 1024 * 1024;
+    constexpr static int32_t COMPRESS_LEVEL = 6;
+
+    HttpGzipCache(size_t capacity = DEFAULT_CAPACITY, off_t max_file_size = DEFAULT_MAX_FILE_SIZE);
+    ~HttpGzipCache();
+
+    // 按源文件路径与mtime查找压缩版本
+    std::shared_ptr<const HttpGzipVariant> lookup(const std::string& full_path, const struct timespec& mtime);
+    // 调度后台压缩，队列已满或已在压缩中时忽略；extra_headers会原样写入预渲染的响应头
+    void schedule(const std::string& full_path, std::string_view mime_type, std::string_view extra_headers,
+        off_t size, const struct timespec& mtime);
+
+    void record_compressed(off_t identity_size, size_t encoded_size);
+    void record_precompressed(off_t identity_size, off_t encoded_size);
+
+    void stop();
+    HttpGzipStats get_stats() const;
+
+    static bool is_compressible(std::string_view mime_type);
+    // 使用zlib将数据压缩为gzip格式
+    static std::string gzip_compress(const std::string& data, int32_t level = COMPRESS_LEVEL);
+};
+
+#endif // HTTP_GZIP_CACHE_HPP
@@ -0,0 +1,66 @@
+#ifndef HTTP_HEADER_BUILDER_HPP
+#define HTTP_HEADER_BUILDER_HPP
+
+extern "C" {
+#include <sys/types.h>
+}
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+/**
+ * @brief 在定长缓冲区中拼接HTTP/1.1响应头，拼接过程不分配内存
+ *
+ * 缓冲区内嵌在对象中，通常作为HttpTransfer的成员随响应一起分配，渲染完成后直接作为内存段发送。
+ * 整数以std::to_chars写入，状态文本与MIME类型来自编译期常量表，以string_view返回。
+ */
+class HttpHeaderBuilder {
+public:
+    static constexpr size_t CAPACITY = 1024;
+
+private:
+    char buffer[CAPACITY];
+    size_t length = 0;
+
+    [[noreturn]] static void throw_overflow();
+    // 依次拷贝各段，调用方已确认容量足够
+    void copy(std::string_view text)
+    {
+        memcpy(this->buffer + this->length, text.data(), text.size());
+        this->length += text.size();
+    }
+
+public:
+    // 追加原始文本；逐段拼接的热路径，定义在头文件中以便内联
+    // @exception 超出缓冲区容量时抛出TcpRuntimeException
+    HttpHeaderBuilder& append(std::string_view text)
+    {
+        if (text.size() > CAPACITY - this->length) {
+            throw_overflow();
+        }
+        copy(text);
+        return *this;
+    }
+    HttpHeaderBuilder& append(int64_t number);
+
+    // 状态行，例如 "HTTP/1.1 200 OK"
+    HttpHeaderBuilder& status(uint32_t code);
+    HttpHeaderBuilder& add(std::string_view name, std::string_view value);
+    HttpHeaderBuilder& add(std::string_view name, int64_t value);
+    // Content-Range: bytes start-end/total
+    HttpHeaderBuilder& add_content_range(off_t start, off_t end, off_t total);
+    // 结束响应头的空行
+    HttpHeaderBuilder& finish();
+
+    void clear();
+    std::string_view view() const;
+
+    // 未收录的状态码返回空串
+    static std::string_view get_status_text(uint32_t code);
+    // 按扩展名查编译期生成的完美哈希表，未知扩展名返回application/octet-stream
+    static std::string_view get_mime_type(std::string_view filepath);
+};
+
+#endif // HTTP_HEADER_BUILDER_HPP
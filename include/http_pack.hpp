@@ -0,0 +1,88 @@
+#ifndef HTTP_PACK_HPP
+#define HTTP_PACK_HPP
+
+extern "C" {
+#include <sys/types.h>
+}
+
+#include <cstdint>
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <memory>
+
+#include "tcp_public.hpp"
+#include "http_transfer.hpp"
+
+// 归档中的一个文件，字符串字段直接指向映射区，有效期与归档相同
+struct HttpPackEntry {
+    std::string_view path;          // 以/开头的请求路径，如 /css/site.css
+    std::string_view mime_type;
+    std::string_view etag;          // 基于内容哈希的强ETag
+    std::string_view last_modified; // 打包时源文件mtime的HTTP-date
+    time_t mtime;
+    off_t offset;                   // 文件内容在归档中的位置
+    off_t size;
+    off_t gzip_offset;              // 预压缩版本的位置，没有时gzip_size为0
+    off_t gzip_size;
+};
+
+// 打包结果统计
+struct HttpPackBuildStats {
+    size_t files = 0;
+    uint64_t bytes = 0;       // 原始内容总字节数
+    size_t gzip_files = 0;    // 附带预压缩版本的文件数
+    uint64_t gzip_bytes = 0;  // 预压缩版本总字节数
+};
+
+/**
+ * @brief 只读的静态资源归档：发布时把web根目录打包为单个文件，服务时整体mmap
+ *
+ * 归档依次存放文件头、各文件内容（及可选的gzip预压缩版本）、按路径排序的定长索引与字符串表，
+ * 索引中预先记录了MIME类型、ETag与Last-Modified。打开时只需一次open与mmap并校验文件头，
+ * 与文件数无关；请求按路径在索引上二分查找，不再访问文件系统、不做路径规范化。
+ * 小文件直接以映射区作为内存段发送，大文件在归档fd上按偏移sendfile。
+ * 整数均为本机字节序，归档应在同一架构上生成与使用。
+ */
+class HttpPack {
+private:
+    struct FileHeader;
+    struct IndexRecord;
+
+    std::shared_ptr<HttpFile> file; // 归档唯一的fd，供大文件的sendfile共享
+    const char *base = nullptr;     // 整个归档的只读映射
+    size_t length = 0;
+    const IndexRecord *records = nullptr;
+    uint32_t record_count = 0;
+    const char *strings = nullptr;
+    size_t strings_size = 0;
+
+    std::string_view get_string(uint32_t offset, uint32_t size) const;
+
+public:
+    constexpr static uint32_t VERSION = 1;
+    // 超过该大小的原始内容才尝试附带gzip版本，过小的文件压缩收益抵不上gzip头尾
+    constexpr static off_t MIN_GZIP_SIZE = 256;
+    constexpr static int32_t GZIP_LEVEL = 9;
+
+    // @exception 文件无法打开或映射、格式或版本不符时抛出TcpRuntimeException
+    explicit HttpPack(const std::string& pack_path);
+    ~HttpPack();
+
+    HttpPack(const HttpPack&) = delete;
+    HttpPack& operator=(const HttpPack&) = delete;
+
+    // 按请求路径精确查找，索引记录越界（归档损坏）时视为不存在
+    bool lookup(std::string_view path, HttpPackEntry& entry) const;
+    // 归档中offset处数据的映射地址，调用方需保证区间来自lookup()返回的条目
+    const char *get_data(off_t offset) const;
+    const std::shared_ptr<HttpFile>& get_file() const;
+    size_t get_entry_count() const;
+
+    // 把source_dir下的全部普通文件打包到pack_path；先写临时文件再rename，正在使用旧归档的进程不受影响
+    // @exception 读取源文件或写入归档失败时抛出TcpRuntimeException
+    static HttpPackBuildStats build(const std::string& source_dir, const std::string& pack_path);
+};
+
+#endif // HTTP_PACK_HPP
@@ -0,0 +1,112 @@
+#ifndef HTTP_PROXY_HPP
+#define HTTP_PROXY_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "http_request.hpp"
+#include "http_transfer.hpp"
+#include "tcp_socket_options.hpp"
+
+// 上游服务器地址，host为IPv4点分地址
+struct HttpUpstreamAddress {
+    std::string host;
+    uint16_t port = 0;
+};
+
+struct HttpProxyConfig {
+    std::chrono::milliseconds connect_timeout{1000};
+    std::chrono::milliseconds response_timeout{30000}; // 发出请求后等待响应头的时限
+    size_t max_idle_per_upstream = 32;                  // 每个上游保留的空闲连接数上限
+    uint32_t max_failures = 3;                          // 连续失败达到该次数后暂时摘除上游
+    std::chrono::milliseconds retry_interval{5000};     // 摘除后每隔该时长放行一个试探请求
+    // 同时在工作线程上等待上游响应头的请求数上限，超出时回复503；
+    // 为0时HttpServer按工作线程数减一（至少为1）设定，直接使用HttpProxy时表示不限
+    size_t max_in_flight = 0;
+    // 上游连接的选项，默认只关闭Nagle：请求头与小响应都是一次写出，避免与延迟确认相互等待
+    TcpSocketOptions socket_options{true};
+};
+
+struct HttpProxyStats {
+    uint64_t requests = 0;  // 转发的请求数
+    uint64_t reused = 0;    // 复用空闲连接的请求数
+    uint64_t connects = 0;  // 新建的上游连接数
+    uint64_t failures = 0;  // 连接、发送或等待响应头失败的次数
+    uint64_t retries = 0;   // 复用的连接已被上游关闭、改用新连接重发的次数
+    uint64_t rejected = 0;  // 在途请求已达max_in_flight而回复503的请求数
+    size_t idle = 0;        // 当前池中的空闲连接数
+    size_t unhealthy = 0;   // 当前被摘除的上游数
+};
+
+/**
+ * @brief 反向代理：按路径前缀把请求转发到上游服务器组
+ *
+ * 每个前缀对应一组上游，请求交给在途请求数最少的健康上游，数量相同时轮流选择；
+ * 连续失败达到max_failures的上游被摘除，每隔retry_interval放行一个试探请求，成功后恢复。
+ * 每个上游维护keep-alive空闲连接池，复用时省去TCP握手，取出时先检查连接是否已被上游关闭。
+ *
+ * forward()在工作线程上执行请求阶段：以非阻塞socket配合poll超时建立连接、发出改写后的请求头并等待响应头，
+ * 连接或复用失败时换用其他上游重试，等待期间（最长response_timeout）占住所在的工作线程，
+ * 因此同时处于这一阶段的请求数以max_in_flight为限，超出的请求回复503，其余工作线程仍可处理本地请求；
+ * 响应体作为流段交给reactor，在明文连接上经管道从上游splice到客户端，
+ * 不经过用户态，也不占用工作线程。响应体转发完毕后连接回到空闲池，异常中断时关闭。
+ * 目前只转发没有请求体的请求，上游地址需为IPv4。
+ */
+class HttpProxy {
+private:
+    struct Upstream;
+    class UpstreamStream;
+
+    struct Route {
+        std::string prefix;
+        std::vector<std::shared_ptr<Upstream>> upstreams;
+        std::atomic<size_t> next{0}; // 在途请求数相同时轮流选择的起点
+    };
+
+    HttpProxyConfig config;
+    std::vector<std::unique_ptr<Route>> routes; // 按前缀长度降序，先匹配最长的前缀
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> reused{0};
+    std::atomic<uint64_t> connects{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<size_t> in_flight{0}; // 正在forward()中等待上游的请求数
+
+    const Route *find_route(const std::string& path) const;
+    bool is_available(Upstream& upstream, std::chrono::steady_clock::time_point now);
+    std::shared_ptr<Upstream> pick(const Route& route, const std::vector<const Upstream *>& tried);
+    void record_result(Upstream& upstream, bool success);
+    int32_t take_idle(Upstream& upstream);
+    int32_t connect_upstream(const Upstream& upstream);
+    // head_only为true时请求是HEAD，上游的响应没有响应体
+    std::unique_ptr<HttpTransfer> exchange(const std::shared_ptr<Upstream>& upstream, const std::string& head,
+        bool head_only);
+
+public:
+    explicit HttpProxy(const HttpProxyConfig& config = HttpProxyConfig());
+    ~HttpProxy();
+
+    HttpProxy(const HttpProxy&) = delete;
+    HttpProxy& operator=(const HttpProxy&) = delete;
+
+    // 需在开始转发之前调用；同一前缀重复添加时合并上游
+    // @exception 上游地址不是合法的IPv4地址或列表为空时抛出TcpRuntimeException
+    void add_route(const std::string& prefix, const std::vector<HttpUpstreamAddress>& upstreams);
+    bool matches(const std::string& path) const;
+
+    // 在工作线程上转发请求（request.head须为原始请求头），返回含改写后响应头与响应体流段的传输任务
+    // @exception 没有可用上游或上游出错时抛出HttpRequestException（502），等待超时时为504，
+    //            在途请求已达max_in_flight时为503
+    std::unique_ptr<HttpTransfer> forward(const HttpRequest& request);
+
+    HttpProxyStats get_stats() const;
+};
+
+#endif // HTTP_PROXY_HPP
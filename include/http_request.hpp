@@ -3,14 +3,29 @@
 
 #include <cstdint>
 #include <string>
+#include <string_view>
+#include <stdexcept>
+#include <vector>
 #include <filesystem>
 
+#include "http_trace.hpp"
+
 enum HttpErrCode {
     HTTP_ERR_OK = 200,
+    HTTP_ERR_CREATED = 201,
+    HTTP_ERR_NO_CONTENT = 204,
+    HTTP_ERR_NOT_MODIFIED = 304,
     HTTP_ERR_BAD_REQUEST = 400,
     HTTP_ERR_FORBIDDEN = 403,
     HTTP_ERR_NOT_FOUND = 404,
+    HTTP_ERR_METHOD_NOT_ALLOWED = 405,
+    HTTP_ERR_LENGTH_REQUIRED = 411,
+    HTTP_ERR_CONTENT_TOO_LARGE = 413,
+    HTTP_ERR_RANGE_NOT_SATISFIABLE = 416,
     HTTP_ERR_INTERNAL_SERVER_ERROR = 500,
+    HTTP_ERR_BAD_GATEWAY = 502,
+    HTTP_ERR_SERVICE_UNAVAILABLE = 503,
+    HTTP_ERR_GATEWAY_TIMEOUT = 504,
 };
 
 enum HttpRequestType {
@@ -39,28 +54,59 @@ class HttpRequestException : public std::runtime_error {
 protected:
     uint32_t err_code;
 
-    std::string get_err_text() const;
 public:
     HttpRequestException(const std::string& message, uint32_t err_code = 400) :
         std::runtime_error(message), err_code(err_code) {}
-    
-    std::string get_err_resp() const;
+
+    uint32_t get_err_code() const;
+    // 返回预渲染的完整错误响应，不含异常消息；未收录的错误码按500回复
+    std::string_view get_err_resp() const;
 };
 
 class HttpRequest {
 protected:
-    static std::string extract_path(const std::string &req);
+    std::string extract_path(const std::string &req);
+    void parse_body_framing(const std::string& request_data);
     void parse_range_header(const std::string& request_data);
+    void parse_accept_encoding(const std::string& request_data);
+    static std::string get_header(const std::string& request_data, const std::string& name);
 public:
     int32_t client_fd;
+    uint32_t stream_id = 0; // HTTP/2流标识，HTTP/1.1请求为0
 
-    HttpRequestType type; // 请求类型
+    HttpRequestType type = HTTP_REQUEST_GET; // 请求类型，目前只接受GET、HEAD、PUT与POST
     std::string filepath; // 文件路径，此时尚未规格化，需要消息处理逻辑进行进一步处理
 
     bool is_range_request; // 是否为Range请求
     std::string range_header; // Range请求数据
 
+    bool accept_gzip; // 客户端是否接受gzip编码
+
+    // 条件请求头，未携带时为空
+    std::string if_none_match;
+    std::string if_modified_since;
+    std::string if_range;
+
+    // 请求以Upgrade: h2c切换到HTTP/2，http2_settings为HTTP2-Settings的值
+    bool upgrade_h2c = false;
+    std::string http2_settings;
+
+    // 请求体的分帧方式，只对上传请求有意义；两者都未携带时content_length为-1
+    int64_t content_length = -1;
+    bool chunked = false;          // Transfer-Encoding: chunked
+    bool expect_continue = false;  // Expect: 100-continue，客户端等待中间响应后才发送请求体
+
+    // 原始请求头，只在请求需要转发到上游时保留，见HttpProxy
+    std::string head;
+
+    // 各阶段的时间戳，只在服务器启用跟踪时记录，见HttpTracer
+    HttpTrace trace;
+
+    // PUT与POST把请求体写入filepath，见HttpUpload
+    bool is_upload() const;
+
     std::vector<HttpRange> parse_ranges(off_t file_size);
+    static std::vector<HttpRange> coalesce_ranges(std::vector<HttpRange> ranges);
     HttpRequest(int32_t fd, const std::string& request_data);
 };
 
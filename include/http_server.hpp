@@ -5,14 +5,27 @@
 #include "tcp_server.hpp"
 #include <string>
 #include <unordered_map>
-#include <thread>
-#include <mutex>
-#include <queue>
-#include <condition_variable>
+#include <memory>
 #include <atomic>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <chrono>
 #include <filesystem>
 
 #include "http_request.hpp"
+#include "http_file_cache.hpp"
+#include "http_gzip_cache.hpp"
+#include "http_etag.hpp"
+#include "http_transfer.hpp"
+#include "http2_session.hpp"
+#include "executor.hpp"
+#include "http_admission.hpp"
+#include "http_shaper.hpp"
+#include "http_pack.hpp"
+#include "http_upload.hpp"
+#include "http_proxy.hpp"
+#include "http_trace.hpp"
 
 /**
  * @brief HTTP服务器类，继承自TcpServer，用于处理HTTP请求，支持工作线程池机制
@@ -24,33 +37,245 @@ class HttpServer : public TcpServer {
 private:
     std::filesystem::path web_root; // 网站根目录
     
-    // 工作线程相关数据结构
-    std::atomic<bool> stop_flag{false};
-    std::vector<std::thread> worker_threads;
-    std::queue<HttpRequest> request_queue;
-    std::mutex queue_mutex;
-    std::condition_variable queue_cv;
-    static constexpr size_t MAX_WORKER_THREADS = 4;
+    // 工作线程池，默认为按CPU数确定线程数的工作窃取线程池
+    std::unique_ptr<Executor> executor;
+    // 单个请求合并后允许的最大range分段数，防止大量小分段的滥用请求
+    static constexpr size_t MAX_RANGE_PARTS = 16;
+
+    // multipart/byteranges响应的分段规划：每段的分段头与结尾，响应头直接写入传输任务
+    struct MultipartPlan {
+        std::vector<std::string> part_headers;
+        std::string closing;
+    };
+
+    // 单个连接缓冲的未解析数据上限，超过仍未收齐请求头时按错误请求处理
+    static constexpr size_t MAX_INPUT_SIZE = UINT16_MAX;
+    static constexpr size_t RECV_BUFFER_SIZE = 16 * 1024;
+
+    /*
+        连接状态与所有权
+
+        客户端fd以EPOLLONESHOT注册，每次事件后自动解除关注，由当前所有者处理完毕后重新关注：
+        - reactor读入数据并逐个解析缓冲区中的完整请求，缓存命中的直接回复；
+        - 未命中时把连接移交给工作线程（worker_owned），此时不再关注EPOLLIN，
+          reactor既不会重复读取解析，也不会关闭连接；
+        - 工作线程交付响应后交还连接，按需重新关注EPOLLIN与EPOLLOUT；
+        - 期间需要关闭连接时只记录close_pending，由工作线程交还时完成关闭。
+        PUT/POST的请求体由当前所有者接收（upload）：reactor在EPOLLIN时从socket接收，
+        工作线程取出上传请求时只消耗已缓冲的部分，其余在交还连接后由reactor继续；收齐之前不再解析后续请求。
+        启用流量整形时，socket可写的连接先进入reactor的调度队列（flow.scheduled），期间不关注EPOLLOUT，
+        由每轮事件处理之后的差额轮询按额度与令牌推进发送。
+        反向代理的响应体从上游连接转发，上游暂无数据时队首的传输等待上游可读：此时不关注客户端的EPOLLOUT，
+        改为以EPOLLONESHOT关注上游fd（relays），上游可读时按客户端可写处理；以其他方式恢复发送之前先移出epoll，
+        保证归还到连接池中的上游连接不会再产生事件。
+        工作队列积压时reactor不再读取新数据（paused），连接只关注EPOLLRDHUP与待发送的EPOLLOUT，
+        请求留在内核接收缓冲区中，由TCP流量控制把压力传回客户端，队列回落后由工作线程统一恢复关注EPOLLIN。
+        待发送的响应按交付顺序排队，由reactor在socket可写时推进队首。
 
+        切换到HTTP/2（h2c）后各流相互独立：reactor持续读取帧，未命中缓存的流逐个交给工作线程，
+        连接不再移交，只以worker_streams计数正在处理的流，关闭同样推迟到最后一个流处理完毕。
+        响应交给h2会话按流量控制切分为帧，由reactor经h2_output逐批发出；
+        Upgrade的101响应仍在transfers中，先于所有HTTP/2帧发出。
+    */
+    struct HttpConnection {
+        std::mutex mutex;
+        std::deque<std::unique_ptr<HttpTransfer>> transfers;
+        std::string input;          // 已读入但尚未解析的数据，可能包含多个管线化请求
+        bool worker_owned = false;  // 连接正由工作线程处理
+        bool close_pending = false; // 关闭被推迟到工作线程交还连接时
+        bool closed = false;
+        bool paused = false;        // 因工作队列积压暂停读取
+        std::unique_ptr<TlsSession> tls; // 启用TLS时的会话，只在reactor线程上读写
+        bool tls_want_write = false;     // 握手需等待socket可写
+        std::unique_ptr<Http2Session> h2;          // 切换到HTTP/2后的协议状态
+        std::unique_ptr<HttpTransfer> h2_output;   // 正在发送的一批HTTP/2帧
+        size_t worker_streams = 0;                 // 正由工作线程处理的HTTP/2流数
+        HttpFlow flow;                             // 流量整形的调度状态
+        std::unique_ptr<HttpUpload> upload;        // 正在接收的请求体
+        bool discard_input = false;                // 上传被拒绝或失败，丢弃后续输入直到错误响应发出后关闭
+        int64_t accepted = 0;                      // 启用跟踪时连接被accept的时间戳
+        int64_t first_byte = 0;                    // 缓冲区中最早的未解析数据读入的时间戳
+    };
+
+    // 令牌不足、等待到期后重新调度的连接
+    struct ThrottledFlow {
+        std::chrono::steady_clock::time_point wake;
+        int32_t client_fd;
+        std::weak_ptr<HttpConnection> connection;
+    };
+
+    std::mutex connections_mutex;
+    std::unordered_map<int32_t, std::shared_ptr<HttpConnection>> connections;
+    std::atomic<size_t> active_transfers{0};
+    // 工作队列的准入控制与排队等待统计
+    HttpAdmissionControl admission;
+    // 暂停读取的连接，队列回落后统一恢复；以weak_ptr区分fd被新连接复用的情况
+    std::mutex paused_mutex;
+    std::vector<std::pair<int32_t, std::weak_ptr<HttpConnection>>> paused_connections;
+    std::atomic<bool> reading_paused{false};
+    // 流量整形，为空时不整形，socket可写时直接发送；调度队列只在reactor线程上访问
+    std::unique_ptr<HttpShaper> shaper;
+    std::deque<std::pair<int32_t, std::weak_ptr<HttpConnection>>> ready_flows;
+    std::vector<ThrottledFlow> throttled_flows;
+    // 为空时以明文提供服务
+    std::unique_ptr<TlsContext> tls_context;
+    // 优雅退出：draining期间不再accept，空闲连接逐个关闭；stopped保证stop()只执行一次
+    static constexpr int32_t DRAIN_POLL_INTERVAL = 50; // ms
+    std::atomic<bool> draining{false};
+    std::atomic<bool> stopped{false};
+
+    // 小文件热点缓存，命中时由reactor线程直接以单次writev回复
+    HttpFileCache file_cache;
+    // 文本类资源的gzip压缩版本缓存，附带后台压缩线程
+    HttpGzipCache gzip_cache;
+    // ETag与Last-Modified生成
+    HttpEtagGenerator etag_generator;
+    // 文件内容的发送方式
+    std::atomic<HttpFileStrategy> file_strategy{HTTP_FILE_AUTO};
+    // 非空时以打包归档代替web_root提供服务，不再访问文件系统
+    std::shared_ptr<const HttpPack> pack;
+    // 单个请求体的大小上限，为0时不接受上传
+    uint64_t max_upload_size = 0;
+    // 反向代理，为空时不转发；relays记录等待可读的上游fd及其所属的客户端与响应体来源
+    std::unique_ptr<HttpProxy> proxy;
+    std::mutex relays_mutex;
+    std::unordered_map<int32_t, std::pair<int32_t, std::weak_ptr<HttpStreamSource>>> relays;
+    // 请求的分阶段跟踪，为空时不记录时间戳；汇总只在reactor线程上进行
+    std::unique_ptr<HttpTracer> tracer;
+
+    void setup();
     std::filesystem::path validate_file(const std::string& target_path);
-    std::string get_mime_type(const std::string& filepath);
+    std::filesystem::path validate_upload_path(const std::string& target_path);
+
+    std::shared_ptr<HttpConnection> find_connection(int32_t client_fd);
+    static bool has_output(const HttpConnection& connection);
+    void rearm_connection(int32_t client_fd, HttpConnection& connection);
+    void watch_relay(int32_t client_fd, const std::shared_ptr<HttpStreamSource>& source);
+    void unwatch_relay(const HttpTransfer& transfer);
+    bool resume_relay(int32_t fd);
+    bool is_proxied(const HttpRequest& request) const;
+    void close_connection(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+    size_t close_idle_connections();
+    bool advance_handshake(int32_t client_fd, HttpConnection& connection);
+    bool read_input(int32_t client_fd, HttpConnection& connection);
+    static bool next_request(HttpConnection& connection, std::string& header, int64_t& first_byte);
+    void begin_trace(HttpRequest& request, const HttpConnection& connection, int64_t first_byte);
+    void trace_progress(int32_t client_fd, HttpTransfer& transfer, bool finished);
+    void serve_buffered_requests(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+    void dispatch_request(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request);
+    void shed_request(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection, uint32_t stream_id);
+    bool pause_reading(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+    void resume_reading();
+    bool next_or_hand_back(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection, std::string& header,
+        int64_t& first_byte);
 
-    void reply_error(int32_t client_fd, const HttpRequestException& e) noexcept;
+    HttpUploadStatus begin_upload(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+        const HttpRequest& request);
+    HttpUploadStatus continue_upload(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+
+    bool upgrade_to_h2c(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection, HttpRequest& request);
+    void serve_h2_streams(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+    void process_stream(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request, bool expired);
+
+    void submit_transfer(int32_t client_fd, std::unique_ptr<HttpTransfer> transfer, uint32_t stream_id = 0);
+    // 交付请求的响应，请求被跟踪时附带其时间戳，HEAD请求只交付响应头
+    void submit_transfer(const HttpRequest& request, std::unique_ptr<HttpTransfer> transfer);
+    bool pump_transfers(int32_t client_fd, HttpConnection& connection, size_t& budget);
+    bool pump_h2_output(int32_t client_fd, HttpConnection& connection, size_t& budget);
+    bool flush_output(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection);
+    bool run_flow(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+        std::chrono::steady_clock::time_point now);
+
+    void reply_error(int32_t client_fd, const HttpRequestException& e, uint32_t stream_id = 0) noexcept;
+
+    static void add_validator_headers(HttpHeaderBuilder& header, const HttpValidators& validators, bool gzip = false);
+    bool reply_not_modified(const HttpRequest& req, const HttpValidators& validators, bool compressible);
+    static bool range_still_valid(const HttpRequest& req, const HttpValidators& validators);
+
+    std::vector<HttpRange> resolve_ranges(HttpRequest& req, off_t file_size);
+    static void build_range_headers(HttpHeaderBuilder& header, const HttpRange& range, std::string_view mime_type,
+        off_t file_size, const HttpValidators& validators);
+    static MultipartPlan plan_multipart(HttpHeaderBuilder& header, const std::vector<HttpRange>& ranges,
+        std::string_view mime_type, off_t file_size, const HttpValidators& validators);
+
+    std::shared_ptr<const HttpCacheEntry> load_cache_entry(const HttpRequest& req,
+        const std::string& full_path, const struct stat& file_stat, const HttpValidators& validators);
+    void send_cached_response(HttpRequest& req, const std::shared_ptr<const HttpCacheEntry>& entry);
+    bool reply_from_cache(HttpRequest& req);
+    bool reply_from_pack(HttpRequest& req, bool inline_only);
+
+    void send_gzip_variant(const HttpRequest& req, const std::shared_ptr<const HttpGzipVariant>& variant);
+    bool try_send_gzip(HttpRequest& req, const std::string& full_path, const struct stat& file_stat,
+        std::string_view mime_type, const HttpValidators& validators);
 
     void handle_range_request(HttpRequest&& request);
     void handle_full_file_request(HttpRequest&& request);
     void handle_request(HttpRequest&& request);
 
-    void process_requests();
+    void serve_request(HttpRequest&& request);
+    void process_request(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request, bool expired);
 public:
-    HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root = "./html");
+    // worker_count为0时按可用CPU数确定工作线程数
+    HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root = "./html",
+        size_t worker_count = 0);
+    // 使用自定义的执行器处理请求
+    HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root,
+        std::unique_ptr<Executor> executor);
+    // 在已处于监听状态的socket上提供服务，用于从旧进程交接监听socket的热重启，见ListenHandoff
+    explicit HttpServer(int32_t listen_fd, const std::string& web_root = "./html", size_t worker_count = 0);
+    HttpServer(int32_t listen_fd, const std::string& web_root, std::unique_ptr<Executor> executor);
     ~HttpServer();
 
     void deal_client_msg(int32_t client_fd) override;
     void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override;
+    void deal_client_writable(int32_t client_fd) override;
+    void deal_client_close(int32_t client_fd) override;
+    void deal_client_hangup(int32_t client_fd) override;
+    uint32_t get_client_events() const override;
+    void deal_loop_end() override;
+    int32_t get_loop_timeout() override;
     
-    // 添加停止方法
+    // 停止工作线程与后台压缩线程并输出统计，可重复调用；之后不应再调用listen_loop()
     void stop();
+    // 优雅退出，在事件循环线程上代替listen_loop()调用：停止accept后继续处理事件，
+    // 在途的请求处理完、响应发送完后关闭连接，空闲的keep-alive连接直接关闭；
+    // 全部连接关闭时返回true，超时返回false，剩余连接留待析构时关闭
+    bool drain(std::chrono::milliseconds timeout);
+
+    void set_etag_mode(HttpEtagMode mode);
+    void set_file_strategy(HttpFileStrategy strategy);
+    // 启用HTTPS，需在进入事件循环之前调用；enable_ktls为true时尝试把加密卸载到内核以保留sendfile零拷贝
+    // @exception 证书或私钥加载失败时抛出TcpRuntimeException
+    void enable_tls(const std::string& cert_file, const std::string& key_file, bool enable_ktls = true);
+    // 排队中的请求数上限与排队等待时限，超出时回复503；max_queued为0时不限制，积压时也不暂停读取
+    void set_admission_limits(size_t max_queued, std::chrono::milliseconds max_queue_wait);
+    // 按连接与客户端IP限速，并以差额轮询在连接间分配发送额度，需在进入事件循环之前调用
+    void enable_shaping(const HttpShapingConfig& config = HttpShapingConfig());
+    // 以HttpPack::build()生成的归档代替web_root提供服务，需在进入事件循环之前调用
+    // @exception 归档无法打开或格式不符时抛出TcpRuntimeException
+    void serve_pack(const std::string& pack_path);
+    // 接受PUT/POST上传，请求体写入web_root下的对应路径，已存在的文件被整体替换；需在进入事件循环之前调用
+    // 未启用时上传请求回复405，HTTP/2上的上传同样回复405
+    void enable_uploads(uint64_t max_size = HttpUpload::DEFAULT_MAX_SIZE);
+    // 把以prefix开头的路径转发到upstreams，需在进入事件循环之前调用；首次调用时以config启用反向代理，
+    // 之后的config被忽略。转发的请求不经过缓存，带请求体的请求回复405，HTTP/2上的请求回复502；
+    // 等待上游响应头时占住工作线程，同时等待的请求数默认不超过工作线程数减一，超出的回复503
+    // @exception 上游地址非法时抛出TcpRuntimeException
+    void add_proxy_route(const std::string& prefix, const std::vector<HttpUpstreamAddress>& upstreams,
+        const HttpProxyConfig& config = HttpProxyConfig());
+
+    // 记录每个请求的阶段时间戳并汇总各阶段的延迟分布，总耗时超过阈值或被抽中的请求输出分阶段耗时；
+    // 需在进入事件循环之前调用。HTTP/2流、上传与错误响应不跟踪
+    void enable_tracing(const HttpTraceConfig& config = HttpTraceConfig());
+
+    HttpCacheStats get_cache_stats() const;
+    HttpGzipStats get_gzip_stats() const;
+    HttpAdmissionStats get_admission_stats() const;
+    HttpShapingStats get_shaping_stats() const;
+    HttpProxyStats get_proxy_stats() const;
+    HttpTraceStats get_trace_stats() const;
+    // 尚未发送完毕的响应数
+    size_t get_active_transfers() const;
 };
 
 #endif // HTTP_SERVER_HPP
\ No newline at end of file
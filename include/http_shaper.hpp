@@ -0,0 +1,122 @@
+#ifndef HTTP_SHAPER_HPP
+#define HTTP_SHAPER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+// 响应的流量类别，按MIME类型划分，各类别有独立的调度额度与限速
+enum HttpTrafficClass {
+    HTTP_TRAFFIC_INTERACTIVE, // 页面、脚本、样式等文本资源，以及错误页、304等小响应
+    HTTP_TRAFFIC_IMAGE,       // 图片
+    HTTP_TRAFFIC_MEDIA,       // 音视频
+    HTTP_TRAFFIC_BULK,        // 压缩包、PDF、二进制流等下载
+    HTTP_TRAFFIC_CLASS_COUNT,
+};
+
+// 单个流量类别的调度参数
+struct HttpTrafficPolicy {
+    size_t quantum;   // 每轮调度累加的发送额度（字节），决定该类别在轮询中的权重
+    uint64_t rate;    // 单连接限速（字节/秒），0为不限
+    size_t burst;     // 单连接令牌桶容量（字节），0时取rate的1/10，且不小于HttpTokenBucket::MIN_GRANT
+};
+
+struct HttpShapingConfig {
+    // 文本类额度最大，小响应通常在一轮内发完；大文件下载每轮只推进一小块
+    std::array<HttpTrafficPolicy, HTTP_TRAFFIC_CLASS_COUNT> classes = {{
+        {256 * 1024, 0, 0},
+        {128 * 1024, 0, 0},
+        {64 * 1024, 0, 0},
+        {64 * 1024, 0, 0},
+    }};
+    uint64_t client_rate = 0; // 同一客户端IP所有连接合计的限速（字节/秒），0为不限
+    size_t client_burst = 0;
+};
+
+// 调度统计，bytes按流量类别累计
+struct HttpShapingStats {
+    uint64_t rounds = 0;    // 执行过的轮询次数
+    uint64_t throttled = 0; // 因令牌不足而等待的次数
+    std::array<uint64_t, HTTP_TRAFFIC_CLASS_COUNT> bytes = {};
+};
+
+/**
+ * @brief 令牌桶，按rate匀速补充令牌，最多积攒burst个；rate为0时不限速
+ */
+class HttpTokenBucket {
+private:
+    uint64_t rate = 0;
+    size_t burst = 0;
+    double tokens = 0;
+    std::chrono::steady_clock::time_point last_refill;
+
+public:
+    // 令牌不足时至少攒够该数量再发送，避免限速连接以极小的分块频繁发送
+    constexpr static size_t MIN_GRANT = 16 * 1024;
+
+    HttpTokenBucket(uint64_t rate = 0, size_t burst = 0);
+
+    // 由不限速改为限速时桶是满的，否则保留已有的令牌
+    void configure(uint64_t rate, size_t burst);
+    bool unlimited() const;
+    // 补充令牌后返回可用数量，不限速时返回SIZE_MAX
+    size_t available(std::chrono::steady_clock::time_point now);
+    void consume(size_t bytes);
+    // 攒够MIN_GRANT个令牌还需等待的时长
+    std::chrono::nanoseconds wait_time(std::chrono::steady_clock::time_point now) const;
+};
+
+// 单个连接的调度状态，只在reactor线程上访问
+struct HttpFlow {
+    size_t deficit = 0;               // 差额轮询中尚未用完的额度
+    HttpTrafficClass traffic_class = HTTP_TRAFFIC_CLASS_COUNT; // bucket当前按哪个类别配置，初始未配置
+    HttpTokenBucket bucket;           // 单连接限速
+    std::shared_ptr<HttpTokenBucket> client_bucket; // 同一客户端IP的连接共享，未限速时为空
+    bool scheduled = false;           // 已在调度队列或限速等待中，期间不关注EPOLLOUT
+};
+
+/**
+ * @brief 响应发送的流量整形：按连接与客户端IP的令牌桶限速，并以差额轮询（DRR）分配发送额度
+ *
+ * reactor每轮为每个有数据待发送的连接累加其流量类别的额度，在额度与令牌允许的范围内推进发送；
+ * 额度用完的连接排到队尾，数据发完时清零额度。大文件下载因此每轮只前进一小块，
+ * 与之并发的小响应不必排在整段大文件之后。
+ */
+class HttpShaper {
+private:
+    HttpShapingConfig config;
+
+    std::mutex clients_mutex;
+    std::unordered_map<uint32_t, std::weak_ptr<HttpTokenBucket>> clients; // 按客户端IP索引
+    size_t sweep_at = 1024; // 表项数达到该值时清理已无连接的IP
+
+    std::atomic<uint64_t> rounds{0};
+    std::atomic<uint64_t> throttled{0};
+    std::array<std::atomic<uint64_t>, HTTP_TRAFFIC_CLASS_COUNT> bytes{};
+
+public:
+    explicit HttpShaper(const HttpShapingConfig& config);
+
+    static HttpTrafficClass classify(std::string_view mime_type);
+    static const char *get_class_name(HttpTrafficClass traffic_class);
+
+    // 新连接建立时关联其客户端IP的共享令牌桶，可在任意线程调用
+    void attach(HttpFlow& flow, uint32_t client_ip);
+    // 本轮允许发送的字节数：累加额度后再受令牌限制；令牌不足时返回0且不累加额度
+    size_t grant(HttpFlow& flow, HttpTrafficClass traffic_class, std::chrono::steady_clock::time_point now);
+    // 扣除实际发送的字节；drained表示连接已无待发送数据，按DRR的规则清零额度
+    void charge(HttpFlow& flow, size_t sent, bool drained);
+    // 令牌不足的连接需等待的时长
+    std::chrono::nanoseconds wait_time(const HttpFlow& flow, std::chrono::steady_clock::time_point now) const;
+    void record_round();
+
+    HttpShapingStats get_stats() const;
+};
+
+#endif // HTTP_SHAPER_HPP
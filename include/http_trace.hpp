@@ -0,0 +1,142 @@
+#ifndef HTTP_TRACE_HPP
+#define HTTP_TRACE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// 请求处理过程中依次记录的时间点
+enum HttpTracePhase {
+    HTTP_PHASE_ACCEPT,       // 连接被accept
+    HTTP_PHASE_FIRST_BYTE,   // 读到请求的第一批数据
+    HTTP_PHASE_PARSED,       // 请求头解析完毕
+    HTTP_PHASE_DEQUEUED,     // 工作线程从队列取出请求，reactor直接回复或管线化的后续请求不记录
+    HTTP_PHASE_HEADERS_SENT, // 响应开头的内存段（响应头）全部写入socket
+    HTTP_PHASE_BODY_DONE,    // 响应全部写入socket
+    HTTP_PHASE_COUNT,
+};
+
+// 相邻时间点之间的阶段，各自统计延迟分布
+enum HttpTraceSpan {
+    HTTP_SPAN_READ,   // FIRST_BYTE -> PARSED：收齐请求头与解析
+    HTTP_SPAN_QUEUE,  // PARSED -> DEQUEUED：在工作队列中排队
+    HTTP_SPAN_HANDLE, // DEQUEUED -> HEADERS_SENT：校验路径、打开文件、生成响应头并发出
+    HTTP_SPAN_SEND,   // HEADERS_SENT -> BODY_DONE：发送响应体
+    HTTP_SPAN_TOTAL,  // FIRST_BYTE -> BODY_DONE
+    HTTP_SPAN_COUNT,
+};
+
+/**
+ * @brief 单个请求各阶段的时间戳
+ *
+ * 时间戳取自单调时钟的原始计数：x86上支持不变TSC时直接读TSC，单次约为clock_gettime的一半，
+ * 否则为steady_clock的纳秒数；换算为时长时经to_nanoseconds()。值为0表示该时间点未记录。
+ */
+struct HttpTrace {
+    std::array<int64_t, HTTP_PHASE_COUNT> stamps{};
+    std::string target; // 请求路径，交给传输任务时填入，用于慢请求日志
+
+    // 由calibrate()在进程内首次启用跟踪时确定，之后只读
+    static inline bool use_tsc = false;
+    static inline double ns_per_tick = 1.0;
+
+    // 检查CPU是否支持不变TSC并测量其频率，只执行一次；需在记录任何时间戳之前调用
+    static void calibrate();
+    static int64_t to_nanoseconds(int64_t ticks);
+
+    static int64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (use_tsc) {
+            return static_cast<int64_t>(__rdtsc());
+        }
+#endif
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    void mark(HttpTracePhase phase, int64_t stamp = now())
+    {
+        this->stamps[phase] = stamp;
+    }
+    bool has(HttpTracePhase phase) const
+    {
+        return this->stamps[phase] != 0;
+    }
+    // 请求是否在被跟踪，未启用跟踪时的请求不记录任何时间点
+    bool active() const
+    {
+        return this->has(HTTP_PHASE_PARSED);
+    }
+    // 阶段的时长（原始计数），缺失的时间点视同其前一个已记录的时间点，因此未经过的阶段时长为0
+    int64_t span(HttpTraceSpan span) const;
+};
+
+struct HttpTraceConfig {
+    // 总耗时达到该时长的请求输出分阶段耗时，为0时不按耗时输出
+    std::chrono::milliseconds slow_threshold{500};
+    // 每sample_every个请求抽样输出一个，为0时不抽样
+    uint32_t sample_every = 0;
+};
+
+// 单个阶段的延迟分布，单位为微秒，分位数为按2的幂分桶估计的上界
+struct HttpSpanStats {
+    uint64_t p50_us = 0;
+    uint64_t p99_us = 0;
+    uint64_t max_us = 0;
+    double mean_us = 0;
+};
+
+struct HttpTraceStats {
+    uint64_t traced = 0;  // 完成跟踪的请求数
+    uint64_t slow = 0;    // 达到慢请求阈值的请求数
+    uint64_t sampled = 0; // 抽样输出的请求数
+    std::array<HttpSpanStats, HTTP_SPAN_COUNT> spans{};
+};
+
+/**
+ * @brief 汇总请求的分阶段延迟，输出慢请求与抽样请求的分阶段耗时
+ *
+ * record()只在reactor线程上调用，各计数只有一个写者，以relaxed读写代替原子加，
+ * 每个请求的记录开销只有几次普通的内存读写；get_stats()可在任意线程调用，读到的是近似的快照。
+ */
+class HttpTracer {
+private:
+    // 第i个桶统计时长在[2^i, 2^(i+1))微秒内的请求，最后一个桶收纳更长的时长
+    static constexpr size_t SPAN_BUCKETS = 32;
+
+    struct Histogram {
+        std::array<std::atomic<uint64_t>, SPAN_BUCKETS> buckets{};
+        std::atomic<uint64_t> total_us{0};
+        std::atomic<uint64_t> max_us{0};
+    };
+
+    HttpTraceConfig config;
+
+    std::atomic<uint64_t> traced{0};
+    std::atomic<uint64_t> slow{0};
+    std::atomic<uint64_t> sampled{0};
+    uint32_t sample_countdown = 0;
+    std::array<Histogram, HTTP_SPAN_COUNT> histograms;
+
+    void log_breakdown(const char *kind, int32_t client_fd, const HttpTrace& trace) const;
+    static HttpSpanStats summarize(const Histogram& histogram);
+
+public:
+    explicit HttpTracer(const HttpTraceConfig& config = HttpTraceConfig());
+
+    HttpTracer(const HttpTracer&) = delete;
+    HttpTracer& operator=(const HttpTracer&) = delete;
+
+    // 响应发送完毕时调用，计入各阶段分布，按需输出分阶段耗时
+    void record(int32_t client_fd, const HttpTrace& trace);
+    HttpTraceStats get_stats() const;
+};
+
+#endif // HTTP_TRACE_HPP
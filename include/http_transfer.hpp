@@ -0,0 +1,198 @@
+#ifndef HTTP_TRANSFER_HPP
+#define HTTP_TRANSFER_HPP
+
+extern "C" {
+#include <sys/types.h>
+}
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <vector>
+
+#include "tcp_tls.hpp"
+#include "http_header_builder.hpp"
+#include "http_shaper.hpp"
+#include "http_body_framing.hpp"
+#include "http_trace.hpp"
+
+// 文件段的发送方式
+enum HttpFileStrategy {
+    HTTP_FILE_AUTO,     // 按区间大小自动选择：小区间mmap，其余sendfile
+    HTTP_FILE_SENDFILE, // sendfile零拷贝，文件页直接送入socket
+    HTTP_FILE_SPLICE,   // 经管道两次splice，管道满时可先行读入下一块
+    HTTP_FILE_MMAP,     // mmap后作为内存段，与响应头等聚合为一次writev，省去小文件的额外系统调用
+};
+
+/**
+ * @brief 以只读方式打开的文件，供传输中的文件段共享，最后一个引用释放时关闭
+ */
+class HttpFile {
+private:
+    int32_t fd = -1;
+
+public:
+    // @exception 打开失败时抛出TcpRuntimeException
+    explicit HttpFile(const std::string& path);
+    ~HttpFile();
+
+    HttpFile(const HttpFile&) = delete;
+    HttpFile& operator=(const HttpFile&) = delete;
+
+    int32_t get_fd() const;
+
+    // 提示内核将顺序读取该区间，并同步预读起始窗口，使reactor上的发送尽量命中页缓存
+    // 预读会阻塞至读请求提交，应在工作线程调用
+    void advise_sequential(off_t offset, off_t length, size_t window);
+    // 异步预读一个窗口，不等待读取完成
+    void prefetch(off_t offset, size_t length);
+};
+
+/**
+ * @brief 长度事先未知的响应体来源，如反向代理的上游连接
+ *
+ * 发送方按分帧把来源中的数据原样转发，直至消息体结束；来源暂无数据时发送暂停，
+ * 由调用方等待get_fd()可读后继续。最后一个引用释放时，由实现决定归还还是关闭来源。
+ */
+class HttpStreamSource {
+public:
+    virtual ~HttpStreamSource() = default;
+
+    virtual int32_t get_fd() const = 0;
+    virtual HttpBodyFraming& get_framing() = 0;
+    // 来源在消息体之后仍有多余的数据，不能再复用
+    virtual void set_broken() = 0;
+};
+
+// 响应中的一段数据：内存段（data非空）、文件段（file非空）或流段（stream非空）
+struct HttpTransferSegment {
+    std::shared_ptr<const void> owner; // 内存段所指数据的持有者，如缓存条目或响应头字符串
+    const char *data = nullptr;
+    std::shared_ptr<HttpFile> file;
+    HttpFileStrategy strategy = HTTP_FILE_SENDFILE; // 文件段的发送方式，只会是SENDFILE或SPLICE
+    off_t offset = 0;                  // 文件段的当前读取位置
+    off_t length = 0;                  // 剩余待发送的字节数
+    off_t prefetched_end = 0;          // 已提示预读到的位置
+    std::shared_ptr<HttpStreamSource> stream; // 流段的来源，其length始终为0，由分帧判断是否结束
+};
+
+/**
+ * @brief 可续传的响应发送任务，归属于连接
+ *
+ * 工作线程只负责校验请求并生成响应头，把响应组织为内存段与文件段后交给reactor；
+ * reactor在socket可写时调用resume()推进发送：相邻的内存段聚合为一次writev，文件段分块sendfile，
+ * 发送缓冲区写满时保留进度，等待下一次EPOLLOUT，因此慢速客户端不会占住工作线程。
+ * 文件段按HttpFileStrategy选择发送方式，较大的区间在发送过程中按窗口提前提示预读。
+ * 流段的数据段在明文连接上经管道从来源splice到socket，分帧字节按小块读入后转发；来源暂无数据时resume()返回false，
+ * 此时调用方应等待get_waiting_source()可读，而不是socket可写。
+ */
+class HttpTransfer {
+private:
+    std::vector<HttpTransferSegment> segments;
+    size_t current = 0;      // 当前待发送的段
+    off_t bytes_sent = 0;
+    bool close_after = false; // 发送完毕后关闭连接
+    HttpTrafficClass traffic_class = HTTP_TRAFFIC_INTERACTIVE; // 启用流量整形时据此选择调度额度与限速
+    bool cork = false;       // 发送期间对socket设置TCP_CORK
+    bool corked = false;     // 已设置TCP_CORK，发送完毕时解除
+
+    int32_t pipe_fds[2] = {-1, -1}; // splice用的管道，首次需要时创建
+    size_t pipe_pending = 0;        // 已读入管道、尚未送入socket的字节数
+
+    std::string staged;      // TLS未卸载到内核时，从文件读出、等待加密发送的数据
+    size_t staged_pos = 0;
+    bool waiting_source = false; // 上一次resume()因流段来源暂无数据而停下
+
+    HttpTrace trace;         // 所属请求的阶段时间戳，未跟踪时为空
+    off_t head_length = 0;   // 开头内存段的长度，发送到此即视为响应头已发出
+
+    HttpHeaderBuilder header; // 内嵌的响应头缓冲区，随本对象一起分配
+
+    void skip_empty_segments();
+    void prefetch_ahead(HttpTransferSegment& segment);
+    bool send_buffers(int32_t socket_fd, size_t& budget);
+    bool send_file(int32_t socket_fd, size_t& budget);
+    bool splice_file(int32_t socket_fd, size_t& budget);
+    bool write_buffer_tls(TlsSession& tls, size_t& budget);
+    bool send_file_tls(TlsSession& tls, size_t& budget);
+    bool write_staged_tls(TlsSession& tls, size_t& budget);
+    bool drain_pipe(int32_t socket_fd, size_t& budget, bool more);
+    bool send_staged(int32_t socket_fd, size_t& budget);
+    bool read_stream(HttpStreamSource& source, size_t length);
+    bool relay_stream(int32_t socket_fd, size_t& budget);
+    bool relay_stream_tls(TlsSession& tls, size_t& budget);
+
+public:
+    constexpr static size_t MAX_IOV_COUNT = 16;
+    constexpr static size_t SENDFILE_CHUNK_SIZE = 256 * 1024;
+    constexpr static size_t SPLICE_CHUNK_SIZE = 64 * 1024; // 默认管道容量
+    constexpr static size_t TLS_CHUNK_SIZE = 16 * 1024;    // 单个TLS记录的最大明文长度
+    // 流段读取分帧字节时每次从来源读入的字节数，一同读入的数据随之以内存转发
+    constexpr static size_t STREAM_READ_SIZE = 4096;
+    // 单次resume()最多发送的字节数，避免一个快速连接独占reactor
+    constexpr static size_t DEFAULT_RESUME_BUDGET = 1024 * 1024;
+    // AUTO策略下不超过该大小的区间使用mmap
+    constexpr static off_t MMAP_MAX_SIZE = 256 * 1024;
+    // 顺序预读的窗口大小，超过该大小的区间在发送前提示顺序读取
+    constexpr static size_t READAHEAD_WINDOW = 1024 * 1024;
+
+    HttpTransfer() = default;
+    ~HttpTransfer();
+
+    HttpTransfer(const HttpTransfer&) = delete;
+    HttpTransfer& operator=(const HttpTransfer&) = delete;
+
+    // 返回清空后的内嵌响应头缓冲区，渲染完成后调用add_header()
+    HttpHeaderBuilder& begin_header();
+    // 把内嵌缓冲区中的响应头作为内存段加入；它引用本对象，只能作为响应开头的段
+    void add_header();
+    void add_buffer(std::string data);
+    // 引用由owner持有的内存，不做拷贝
+    void add_buffer(std::shared_ptr<const void> owner, const char *data, size_t length);
+    // 加入流段，其后不应再有其他段
+    void add_stream(std::shared_ptr<HttpStreamSource> source);
+    // 加入文件区间；MMAP策略会在此处完成映射，较大的区间会在此处同步预读起始窗口，应在工作线程调用
+    // @exception 映射失败时抛出TcpRuntimeException
+    void add_file(std::shared_ptr<HttpFile> file, off_t offset, off_t length,
+        HttpFileStrategy strategy = HTTP_FILE_AUTO);
+
+    static HttpFileStrategy resolve_strategy(HttpFileStrategy strategy, off_t length);
+    static const char *get_strategy_name(HttpFileStrategy strategy);
+
+    void set_close_after(bool close_after);
+    bool get_close_after() const;
+    void set_traffic_class(HttpTrafficClass traffic_class);
+    HttpTrafficClass get_traffic_class() const;
+    // 明文发送期间设置TCP_CORK、发完解除，需在所有段加入之后调用；
+    // 只对含文件段的响应生效，纯内存段本就一次writev发出，流段等待来源时不能积攒数据
+    void set_cork(bool cork);
+    // 附带请求的阶段时间戳，需在所有段加入之后调用；之后由发送方记录响应头与响应体发出的时间点
+    void set_trace(HttpTrace trace);
+    // 未跟踪时返回空
+    HttpTrace *get_trace();
+    bool is_head_sent() const;
+
+    // 以下用于把响应改写为HTTP/2帧，只能在发送开始之前调用
+    // 取出开头内存段中的HTTP/1.1响应头（至空行为止），没有完整的响应头时返回false且不做修改
+    bool take_head(std::string& head);
+    // 把开头至多length字节的数据追加到target末尾，只复制段的描述，内存段与文件段都不拷贝数据
+    off_t move_front(HttpTransfer& target, off_t length);
+    // 尚未发送的字节数
+    off_t get_remaining() const;
+    // 只保留响应头，丢弃其后的响应体，用于HEAD请求；没有完整的响应头时返回false且不做修改
+    bool discard_body();
+
+    // 在socket可写时推进发送，全部发送完毕时返回true；
+    // 发送缓冲区已满或本次预算用尽时返回false，调用方应等待下一次EPOLLOUT后再次调用
+    // @exception 连接异常、文件在发送过程中被截断或流段来源出错时抛出TcpRuntimeException
+    bool resume(int32_t socket_fd, size_t budget = DEFAULT_RESUME_BUDGET);
+    // 经TLS会话发送：内存段逐记录SSL_write；文件段在kTLS下以SSL_sendfile零拷贝发送，否则读出后在用户态加密
+    bool resume(TlsSession& tls, size_t budget = DEFAULT_RESUME_BUDGET);
+    bool done() const;
+    off_t get_bytes_sent() const;
+    // 上一次resume()因流段来源暂无数据而停下时返回该来源，否则返回空
+    std::shared_ptr<HttpStreamSource> get_waiting_source() const;
+};
+
+#endif // HTTP_TRANSFER_HPP
@@ -0,0 +1,76 @@
+#ifndef HTTP_UPLOAD_HPP
+#define HTTP_UPLOAD_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <filesystem>
+
+#include "tcp_public.hpp"
+#include "tcp_tls.hpp"
+#include "http_body_framing.hpp"
+
+// 一次接收的结果
+enum HttpUploadStatus {
+    HTTP_UPLOAD_AGAIN,  // 请求体尚未收齐，等待socket可读后继续
+    HTTP_UPLOAD_DONE,   // 请求体已完整写入临时文件，缓冲区中剩余的是下一个请求
+    HTTP_UPLOAD_CLOSED, // 对端在请求体收齐之前关闭了连接
+};
+
+/**
+ * @brief 流式接收PUT/POST请求体并写入文件
+ *
+ * 请求体先写入目标目录下的临时文件，收齐后rename到目标路径，读者只会看到旧文件或完整的新文件；
+ * 中途失败或连接断开时删除临时文件。已随请求头读入缓冲区的数据直接写入文件，
+ * 其余数据在明文连接上经管道两次splice从socket送入文件，不经过用户态，也不在内存中缓存整个请求体；
+ * TLS连接的数据须在用户态解密，按块读出后写入。
+ * 支持Content-Length与chunked两种分帧，chunked的长度行与trailer按小块读入缓冲区解析，分块数据仍走splice。
+ */
+class HttpUpload {
+private:
+    std::filesystem::path target_path;
+    std::string temp_path;
+    int32_t file_fd = -1;
+    int32_t pipe_fds[2] = {-1, -1}; // splice用的管道，首次需要时创建
+    HttpBodyFraming framing;
+    uint64_t received = 0;          // 已写入的请求体字节数，不含分块编码
+    uint64_t max_size;
+    bool committed = false;
+
+    void write_file(const char *data, size_t length);
+    void write_data(const char *data, size_t length);
+    ssize_t splice_body(int32_t client_fd);
+    ssize_t read_body_tls(TlsSession& tls);
+    static ssize_t read_line_data(int32_t client_fd, TlsSession *tls, std::string& input);
+
+public:
+    constexpr static uint64_t DEFAULT_MAX_SIZE = 4ULL * 1024 * 1024 * 1024;
+    constexpr static size_t SPLICE_CHUNK_SIZE = 64 * 1024; // 默认管道容量
+    // 单次receive()在明文连接上至多接收的字节数
+    constexpr static uint64_t RECEIVE_BUDGET = 4 * 1024 * 1024;
+    // 读取长度行时每次从socket读入的字节数，一同读入的分块数据随后从缓冲区写入文件
+    constexpr static size_t LINE_READ_SIZE = 256;
+
+    // content_length为-1时按chunked接收；在target_path所在目录创建临时文件
+    // @exception 请求体超出max_size时抛出HttpRequestException（413），临时文件创建失败时抛出TcpRuntimeException
+    HttpUpload(const std::filesystem::path& target_path, int64_t content_length, uint64_t max_size);
+    ~HttpUpload();
+
+    HttpUpload(const HttpUpload&) = delete;
+    HttpUpload& operator=(const HttpUpload&) = delete;
+
+    // 只消耗input中已缓冲的数据，不读取socket；请求体之后的数据留在input中
+    // @exception 分块编码非法时抛出HttpRequestException（400），超出上限时抛出HttpRequestException（413），
+    // 写入失败时抛出TcpRuntimeException
+    HttpUploadStatus consume(std::string& input);
+    // 先消耗已缓冲的数据，再从socket读取直到收齐或暂无数据可读；tls为空时以splice接收
+    // @exception 同consume()，读取socket出错时抛出TcpRuntimeException
+    HttpUploadStatus receive(int32_t client_fd, std::string& input, TlsSession *tls);
+    // 把临时文件rename到目标路径，返回目标此前是否不存在
+    // @exception rename失败时抛出TcpRuntimeException
+    bool commit();
+
+    uint64_t get_received() const;
+};
+
+#endif // HTTP_UPLOAD_HPP
@@ -0,0 +1,51 @@
+#ifndef TCP_ADDRESS_HPP
+#define TCP_ADDRESS_HPP
+
+extern "C" {
+#include <sys/socket.h>
+}
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief TcpServer与TcpClient的监听或连接地址：IPv4的TCP地址，或Unix域流式socket的路径
+ *
+ * 同一主机上的客户端经Unix域socket通信时不经过回环网卡的TCP协议栈，收发接口、分帧与回调都不变。
+ * Unix域地址以'@'开头时为Linux的抽象命名空间，不在文件系统中创建文件，最后一个引用关闭时自动消失。
+ */
+class TcpAddress {
+private:
+    sockaddr_storage storage = {};
+    socklen_t length = 0;
+
+public:
+    TcpAddress() = default;
+
+    // @exception host不是合法的IPv4地址时抛出TcpRuntimeException
+    static TcpAddress inet(const std::string& host, uint16_t port);
+    // path以'@'开头时为抽象命名空间中的名字
+    // @exception 路径为空或超过sun_path长度时抛出TcpRuntimeException
+    static TcpAddress local(const std::string& path);
+    // 解析"unix:<path>"、"unix:@<name>"或"<host>:<port>"
+    // @exception 格式非法时抛出TcpRuntimeException
+    static TcpAddress parse(const std::string& spec);
+    // 由getsockname()等得到的地址构造
+    // @exception 不是AF_INET或AF_UNIX时抛出TcpRuntimeException
+    static TcpAddress from_sockaddr(const sockaddr *addr, socklen_t length);
+
+    int32_t get_family() const;
+    bool is_local() const;
+    // 抽象命名空间中的Unix域地址
+    bool is_abstract() const;
+    const sockaddr *get_sockaddr() const;
+    socklen_t get_length() const;
+    // IPv4地址的点分文本，Unix域地址的路径（抽象命名空间以'@'开头）
+    std::string get_host() const;
+    // Unix域地址为0
+    uint16_t get_port() const;
+    // 与parse()的格式一致
+    std::string to_string() const;
+};
+
+#endif // TCP_ADDRESS_HPP
@@ -5,6 +5,8 @@
 #include <string>
 
 #include "tcp_public.hpp"
+#include "tcp_address.hpp"
+#include "tcp_socket_options.hpp"
 
 class TcpClient {
 private:
@@ -13,6 +15,10 @@ private:
     int32_t conn_fd;
 public:
     TcpClient(const std::string& server_addr, uint16_t port);
+    // connect之前按options设置socket，设置失败的选项忽略
+    TcpClient(const std::string& server_addr, uint16_t port, const TcpSocketOptions& options);
+    // 连接IPv4地址或Unix域socket，Unix域socket不设置options中的TCP选项
+    explicit TcpClient(const TcpAddress& address, const TcpSocketOptions& options = TcpSocketOptions());
     ~TcpClient();
 
     int32_t get_fd() const;
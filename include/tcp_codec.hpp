@@ -0,0 +1,570 @@
+#ifndef TCP_CODEC_HPP
+#define TCP_CODEC_HPP
+
+extern "C" {
+#include <sys/socket.h>
+}
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <array>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <type_traits>
+#include <algorithm>
+
+#include "tcp_public.hpp"
+#include "tcp_server.hpp"
+
+/*
+    分帧协议的类型化消息编解码
+
+    帧格式：2字节帧总长（网络序，含自身）| 2字节消息类型ID（网络序）| 各字段依次编码；
+    整数与枚举按网络序定长编码，bool占1字节，字符串为2字节长度（网络序）加内容，std::array逐个元素编码。
+
+    消息声明为带字段列表的结构体：
+
+        struct LoginRequest {
+            static constexpr uint16_t TYPE_ID = 1;
+            uint32_t user_id = 0;
+            std::string_view name;
+            using Fields = TcpFields<&LoginRequest::user_id, &LoginRequest::name>;
+        };
+
+    编解码都是constexpr的模板函数，直接读写调用方给出的帧缓冲区，没有中间对象和内存分配；
+    std::string_view字段解码后指向帧缓冲区内部，不做拷贝，只在缓冲区有效期间可用，需要保留时请声明为std::string。
+*/
+
+constexpr size_t TCP_FRAME_HEADER_SIZE = 2 * sizeof(uint16_t);
+constexpr size_t TCP_FRAME_MAX_SIZE = UINT16_MAX;
+
+// 单个字段的编解码，按字段类型特化
+template <typename T, typename Enable = void>
+struct TcpFieldCodec;
+
+// 整数与枚举按其无符号的同宽类型移位
+template <typename T, bool = std::is_enum_v<T>>
+struct TcpRawType {
+    using Type = std::make_unsigned_t<T>;
+};
+
+template <typename T>
+struct TcpRawType<T, true> {
+    using Type = std::make_unsigned_t<std::underlying_type_t<T>>;
+};
+
+// 编译期求值时逐字节读写，运行时走memcpy与字节序交换，由编译器合并为单条访存
+constexpr bool tcp_constant_evaluated()
+{
+    return __builtin_is_constant_evaluated();
+}
+
+template <typename Raw>
+inline Raw tcp_byte_swap(Raw raw)
+{
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(Raw) == 2) {
+        return __builtin_bswap16(raw);
+    } else if constexpr (sizeof(Raw) == 4) {
+        return __builtin_bswap32(raw);
+    } else if constexpr (sizeof(Raw) == 8) {
+        return __builtin_bswap64(raw);
+    }
+#endif
+    return raw;
+}
+
+// 整数与枚举：网络序定长
+template <typename T>
+struct TcpFieldCodec<T, std::enable_if_t<(std::is_integral_v<T> || std::is_enum_v<T>) && !std::is_same_v<T, bool>>> {
+    using Raw = typename TcpRawType<T>::Type;
+
+    static constexpr size_t size(const T&)
+    {
+        return sizeof(T);
+    }
+
+    static constexpr char *encode(char *out, const T& value)
+    {
+        Raw raw = static_cast<Raw>(value);
+        if (!tcp_constant_evaluated()) {
+            raw = tcp_byte_swap(raw);
+            memcpy(out, &raw, sizeof(T));
+            return out + sizeof(T);
+        }
+        for (size_t i = sizeof(T); i > 0; i--) {
+            out[i - 1] = static_cast<char>(raw & 0xFF);
+            raw = static_cast<Raw>(raw >> 8);
+        }
+        return out + sizeof(T);
+    }
+
+    static constexpr bool decode(const char *& in, const char *end, T& value)
+    {
+        if (static_cast<size_t>(end - in) < sizeof(T)) {
+            return false;
+        }
+        Raw raw = 0;
+        if (!tcp_constant_evaluated()) {
+            memcpy(&raw, in, sizeof(T));
+            raw = tcp_byte_swap(raw);
+        } else {
+            for (size_t i = 0; i < sizeof(T); i++) {
+                raw = static_cast<Raw>((raw << 8) | static_cast<unsigned char>(in[i]));
+            }
+        }
+        value = static_cast<T>(raw);
+        in += sizeof(T);
+        return true;
+    }
+};
+
+template <>
+struct TcpFieldCodec<bool> {
+    static constexpr size_t size(const bool&)
+    {
+        return 1;
+    }
+
+    static constexpr char *encode(char *out, const bool& value)
+    {
+        *out = value ? 1 : 0;
+        return out + 1;
+    }
+
+    static constexpr bool decode(const char *& in, const char *end, bool& value)
+    {
+        if (in == end || static_cast<unsigned char>(*in) > 1) {
+            return false;
+        }
+        value = *in != 0;
+        in++;
+        return true;
+    }
+};
+
+// 字符串：2字节长度加内容，超过UINT16_MAX的部分不能编码，由帧长检查拒绝
+template <typename T>
+struct TcpFieldCodec<T, std::enable_if_t<std::is_same_v<T, std::string_view> || std::is_same_v<T, std::string>>> {
+    static constexpr size_t size(const T& value)
+    {
+        return sizeof(uint16_t) + value.size();
+    }
+
+    static constexpr char *encode(char *out, const T& value)
+    {
+        out = TcpFieldCodec<uint16_t>::encode(out, static_cast<uint16_t>(value.size()));
+        if (!tcp_constant_evaluated()) {
+            if (!value.empty()) {
+                memcpy(out, value.data(), value.size());
+            }
+            return out + value.size();
+        }
+        for (size_t i = 0; i < value.size(); i++) {
+            out[i] = value[i];
+        }
+        return out + value.size();
+    }
+
+    static constexpr bool decode(const char *& in, const char *end, T& value)
+    {
+        uint16_t length = 0;
+        if (!TcpFieldCodec<uint16_t>::decode(in, end, length) || static_cast<size_t>(end - in) < length) {
+            return false;
+        }
+        value = T(in, length);
+        in += length;
+        return true;
+    }
+};
+
+template <typename T, size_t N>
+struct TcpFieldCodec<std::array<T, N>> {
+    static constexpr size_t size(const std::array<T, N>& value)
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < N; i++) {
+            total += TcpFieldCodec<T>::size(value[i]);
+        }
+        return total;
+    }
+
+    static constexpr char *encode(char *out, const std::array<T, N>& value)
+    {
+        for (size_t i = 0; i < N; i++) {
+            out = TcpFieldCodec<T>::encode(out, value[i]);
+        }
+        return out;
+    }
+
+    static constexpr bool decode(const char *& in, const char *end, std::array<T, N>& value)
+    {
+        for (size_t i = 0; i < N; i++) {
+            if (!TcpFieldCodec<T>::decode(in, end, value[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <typename T>
+struct TcpMemberTraits;
+
+template <typename C, typename T>
+struct TcpMemberTraits<T C::*> {
+    using Value = T;
+};
+
+// 消息的字段列表，按声明顺序编码
+template <auto... Members>
+struct TcpFields {
+    template <typename M>
+    static constexpr size_t size(const M& message)
+    {
+        return (static_cast<size_t>(0) + ... +
+            TcpFieldCodec<typename TcpMemberTraits<decltype(Members)>::Value>::size(message.*Members));
+    }
+
+    template <typename M>
+    static constexpr char *encode(char *out, const M& message)
+    {
+        ((out = TcpFieldCodec<typename TcpMemberTraits<decltype(Members)>::Value>::encode(out, message.*Members)), ...);
+        return out;
+    }
+
+    template <typename M>
+    static constexpr bool decode(const char *& in, const char *end, M& message)
+    {
+        return (TcpFieldCodec<typename TcpMemberTraits<decltype(Members)>::Value>::decode(in, end, message.*Members) &&
+            ...);
+    }
+};
+
+// 帧头中的帧总长，调用方需保证至少有TCP_FRAME_HEADER_SIZE字节
+constexpr uint16_t tcp_frame_length(const char *frame)
+{
+    return static_cast<uint16_t>((static_cast<unsigned char>(frame[0]) << 8) | static_cast<unsigned char>(frame[1]));
+}
+
+// 帧头中的消息类型ID
+constexpr uint16_t tcp_frame_type(const char *frame)
+{
+    return static_cast<uint16_t>((static_cast<unsigned char>(frame[2]) << 8) | static_cast<unsigned char>(frame[3]));
+}
+
+// 编码后的帧长度
+template <typename M>
+constexpr size_t tcp_encoded_size(const M& message)
+{
+    return TCP_FRAME_HEADER_SIZE + M::Fields::size(message);
+}
+
+// 把message编码为一帧写入out，返回帧长度；超出capacity或TCP_FRAME_MAX_SIZE时返回0，不写入任何数据
+template <typename M>
+constexpr size_t tcp_encode(const M& message, char *out, size_t capacity)
+{
+    size_t length = tcp_encoded_size(message);
+    if (length > capacity || length > TCP_FRAME_MAX_SIZE) {
+        return 0;
+    }
+    out = TcpFieldCodec<uint16_t>::encode(out, static_cast<uint16_t>(length));
+    out = TcpFieldCodec<uint16_t>::encode(out, M::TYPE_ID);
+    M::Fields::encode(out, message);
+    return length;
+}
+
+// 从一个完整的帧解码message；帧长与length不符、类型ID不符、字段截断或有多余字节时返回false
+template <typename M>
+constexpr bool tcp_decode(const char *frame, size_t length, M& message)
+{
+    if (length < TCP_FRAME_HEADER_SIZE || tcp_frame_length(frame) != length || tcp_frame_type(frame) != M::TYPE_ID) {
+        return false;
+    }
+    const char *in = frame + TCP_FRAME_HEADER_SIZE;
+    const char *end = frame + length;
+    return M::Fields::decode(in, end, message) && in == end;
+}
+
+class TcpFramePool;
+
+/**
+ * @brief 从TcpFramePool取出的帧缓冲区，容量为一个最大帧，析构时归还
+ */
+class TcpFrameBuffer {
+private:
+    TcpFramePool *pool = nullptr;
+    std::unique_ptr<char[]> buffer;
+
+public:
+    constexpr static size_t CAPACITY = TCP_FRAME_MAX_SIZE;
+
+    TcpFrameBuffer() = default;
+    TcpFrameBuffer(TcpFramePool *pool, std::unique_ptr<char[]> buffer) : pool(pool), buffer(std::move(buffer)) {}
+    TcpFrameBuffer(TcpFrameBuffer&&) = default;
+    TcpFrameBuffer& operator=(TcpFrameBuffer&& other);
+    ~TcpFrameBuffer();
+
+    char *data() const
+    {
+        return this->buffer.get();
+    }
+
+    explicit operator bool() const
+    {
+        return this->buffer != nullptr;
+    }
+};
+
+/**
+ * @brief 帧缓冲区的空闲链表，避免每次收发都分配64KB；非线程安全，在事件循环线程使用
+ */
+class TcpFramePool {
+private:
+    std::vector<std::unique_ptr<char[]>> free_buffers;
+    size_t max_free;
+
+public:
+    explicit TcpFramePool(size_t max_free = 64) : max_free(max_free) {}
+
+    TcpFrameBuffer acquire()
+    {
+        if (this->free_buffers.empty()) {
+            return TcpFrameBuffer(this, std::make_unique<char[]>(TcpFrameBuffer::CAPACITY));
+        }
+        std::unique_ptr<char[]> buffer = std::move(this->free_buffers.back());
+        this->free_buffers.pop_back();
+        return TcpFrameBuffer(this, std::move(buffer));
+    }
+
+    void release(std::unique_ptr<char[]> buffer)
+    {
+        if (this->free_buffers.size() < this->max_free) {
+            this->free_buffers.push_back(std::move(buffer));
+        }
+    }
+
+    size_t get_free_count() const
+    {
+        return this->free_buffers.size();
+    }
+};
+
+inline TcpFrameBuffer& TcpFrameBuffer::operator=(TcpFrameBuffer&& other)
+{
+    if (this != &other) {
+        if (this->buffer && this->pool != nullptr) {
+            this->pool->release(std::move(this->buffer));
+        }
+        this->pool = other.pool;
+        this->buffer = std::move(other.buffer);
+    }
+    return *this;
+}
+
+inline TcpFrameBuffer::~TcpFrameBuffer()
+{
+    if (this->buffer && this->pool != nullptr) {
+        this->pool->release(std::move(this->buffer));
+    }
+}
+
+template <typename Derived>
+struct TcpHandlerEntry {
+    uint16_t type_id;
+    bool (*handler)(Derived&, int32_t, const char *, size_t); // 解码失败时返回false
+};
+
+template <typename Derived, typename M>
+bool tcp_invoke_handler(Derived& server, int32_t client_fd, const char *frame, size_t length)
+{
+    M message{};
+    if (!tcp_decode(frame, length, message)) {
+        return false;
+    }
+    server.on_message(client_fd, message);
+    return true;
+}
+
+// 按类型ID排序的处理函数表，在编译期生成
+template <typename Derived, typename... Messages>
+constexpr std::array<TcpHandlerEntry<Derived>, sizeof...(Messages)> tcp_make_handlers()
+{
+    std::array<TcpHandlerEntry<Derived>, sizeof...(Messages)> handlers = {
+        TcpHandlerEntry<Derived>{ Messages::TYPE_ID, &tcp_invoke_handler<Derived, Messages> }... };
+    for (size_t i = 1; i < handlers.size(); i++) {
+        for (size_t j = i; j > 0 && handlers[j].type_id < handlers[j - 1].type_id; j--) {
+            TcpHandlerEntry<Derived> entry = handlers[j];
+            handlers[j] = handlers[j - 1];
+            handlers[j - 1] = entry;
+        }
+    }
+    return handlers;
+}
+
+template <typename Entry, size_t N>
+constexpr bool tcp_unique_type_ids(const std::array<Entry, N>& handlers)
+{
+    for (size_t i = 1; i < N; i++) {
+        if (handlers[i].type_id == handlers[i - 1].type_id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 按消息类型ID分发类型化消息的服务器
+ *
+ * Derived为每个Messages中的消息类型实现公有的void on_message(int32_t client_fd, const M& message)；
+ * 处理函数表在编译期按类型ID排序生成，类型ID重复时编译失败。
+ * 每个连接在有未处理完的数据时持有一个池中的帧缓冲区，完整的帧就地解码后立即分发，处理函数返回后缓冲区即可复用，
+ * 因此消息中的std::string_view字段只在on_message()期间有效。
+ * 帧长非法、类型未知或解码失败时调用deal_bad_frame()，默认记录日志并关闭连接。
+ * 处理函数在事件循环线程执行，send_message()也只能在事件循环线程调用。
+ */
+template <typename Derived, typename... Messages>
+class TcpMessageServer : public TcpServer {
+private:
+    using HandlerEntry = TcpHandlerEntry<Derived>;
+
+    struct FrameInput {
+        TcpFrameBuffer buffer;
+        size_t filled = 0;
+    };
+
+    static constexpr std::array<HandlerEntry, sizeof...(Messages)> HANDLERS = tcp_make_handlers<Derived, Messages...>();
+    static_assert(sizeof...(Messages) > 0, "TcpMessageServer needs at least one message type");
+    static_assert(tcp_unique_type_ids(HANDLERS), "duplicate message TYPE_ID in TcpMessageServer");
+
+    TcpFramePool pool; // 须先于inputs构造，inputs中的缓冲区析构时归还到这里
+    std::unordered_map<int32_t, FrameInput> inputs;
+
+    // 分发input中所有完整的帧，剩余的不完整帧移到缓冲区开头；连接在处理过程中被关闭时返回false
+    bool dispatch_frames(int32_t client_fd, FrameInput& input)
+    {
+        size_t offset = 0;
+        while (input.filled - offset >= TCP_FRAME_HEADER_SIZE) {
+            const char *frame = input.buffer.data() + offset;
+            size_t length = tcp_frame_length(frame);
+            if (length < TCP_FRAME_HEADER_SIZE) {
+                this->deal_bad_frame(client_fd, tcp_frame_type(frame));
+                return false;
+            }
+            if (input.filled - offset < length) {
+                break;
+            }
+
+            uint16_t type_id = tcp_frame_type(frame);
+            auto entry = std::lower_bound(HANDLERS.begin(), HANDLERS.end(), type_id,
+                [](const HandlerEntry& handler, uint16_t id) { return handler.type_id < id; });
+            if (entry == HANDLERS.end() || entry->type_id != type_id ||
+                !entry->handler(static_cast<Derived&>(*this), client_fd, frame, length)) {
+                this->deal_bad_frame(client_fd, type_id);
+                return false;
+            }
+            if (this->inputs.find(client_fd) == this->inputs.end()) {
+                return false;
+            }
+            offset += length;
+        }
+
+        if (offset > 0) {
+            memmove(input.buffer.data(), input.buffer.data() + offset, input.filled - offset);
+            input.filled -= offset;
+        }
+        return true;
+    }
+
+protected:
+    // 帧长非法、类型未知或解码失败时调用，默认关闭连接
+    virtual void deal_bad_frame(int32_t client_fd, uint16_t type_id)
+    {
+        LOG_ERR("bad frame of type %hu from client %d, closing", type_id, client_fd);
+        this->close_client(client_fd);
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        auto it = this->inputs.find(client_fd);
+        if (it == this->inputs.end()) {
+            it = this->inputs.emplace(client_fd, FrameInput()).first;
+        }
+        // 处理函数可能关闭连接并移除inputs中的条目，处理期间由本函数持有
+        FrameInput input = std::move(it->second);
+        if (!input.buffer) {
+            input.buffer = this->pool.acquire();
+        }
+
+        ssize_t len = recv(client_fd, input.buffer.data() + input.filled, TcpFrameBuffer::CAPACITY - input.filled,
+            MSG_DONTWAIT);
+        if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            this->close_client(client_fd);
+            return;
+        }
+        if (len > 0) {
+            input.filled += static_cast<size_t>(len);
+        }
+        if (!dispatch_frames(client_fd, input)) {
+            // deal_bad_frame()未关闭连接时丢弃已收到的数据
+            auto current = this->inputs.find(client_fd);
+            if (current != this->inputs.end()) {
+                current->second = FrameInput();
+            }
+            return;
+        }
+
+        // 没有残留数据时归还缓冲区，空闲连接不占用内存
+        if (input.filled == 0) {
+            input.buffer = TcpFrameBuffer();
+        }
+        this->inputs[client_fd] = std::move(input);
+    }
+
+    void deal_client_close(int32_t client_fd) override
+    {
+        this->inputs.erase(client_fd);
+        TcpServer::deal_client_close(client_fd);
+    }
+
+public:
+    using TcpServer::TcpServer;
+
+    // 编码后发送一条消息，在事件循环线程调用
+    // @exception 消息超过最大帧长时抛出TcpRuntimeException
+    template <typename M>
+    void send_message(int32_t client_fd, const M& message)
+    {
+        TcpFrameBuffer buffer = this->pool.acquire();
+        size_t length = tcp_encode(message, buffer.data(), TcpFrameBuffer::CAPACITY);
+        if (length == 0) {
+            throw TcpRuntimeException("message of type " + std::to_string(M::TYPE_ID) + " exceeds the frame size",
+                __FILENAME__, __LINE__);
+        }
+        send_data_nonblock(client_fd, buffer.data(), static_cast<uint16_t>(length));
+    }
+
+    // 编码一次后发布到topic的全部订阅者，见TcpServer::publish()，在事件循环线程调用
+    // @exception 消息超过最大帧长时抛出TcpRuntimeException
+    template <typename M>
+    size_t publish_message(const std::string& topic, const M& message)
+    {
+        std::string frame(tcp_encoded_size(message), '\0');
+        if (tcp_encode(message, frame.data(), frame.size()) == 0) {
+            throw TcpRuntimeException("message of type " + std::to_string(M::TYPE_ID) + " exceeds the frame size",
+                __FILENAME__, __LINE__);
+        }
+        return this->publish(topic, std::make_shared<const std::string>(std::move(frame)));
+    }
+
+    const TcpFramePool& get_frame_pool() const
+    {
+        return this->pool;
+    }
+};
+
+#endif // TCP_CODEC_HPP
@@ -0,0 +1,50 @@
+#ifndef TCP_HANDOFF_HPP
+#define TCP_HANDOFF_HPP
+
+#include <cstdint>
+#include <string>
+#include <atomic>
+
+#include "tcp_public.hpp"
+
+/*
+    监听socket的进程间交接，用于不中断服务的重启
+
+    旧进程调用listen()后在Unix socket上等待，由hand_over()阻塞等待新进程；
+    新进程启动时先以receive()经SCM_RIGHTS取得监听fd，用它构造服务器并listen()接替Unix socket路径，
+    最后confirm()通知旧进程，旧进程随后停止accept并优雅退出。
+    内核中的全连接队列随fd一起交接，交接期间到达的连接留在队列中等新进程accept，不会被重置；
+    新进程在确认之前失败时旧进程照常服务，并重新占用Unix socket路径等待下一次交接。
+*/
+class ListenHandoff {
+private:
+    std::string socket_path;
+    int32_t server_fd = -1;   // 旧进程一侧：等待交接请求的Unix socket
+    int32_t channel_fd = -1;  // 新进程一侧：与旧进程的连接，确认后关闭
+    bool path_owned = false;  // socket_path当前指向本进程的server_fd，析构时删除
+    std::atomic<bool> cancelled{false};
+
+public:
+    explicit ListenHandoff(const std::string& socket_path);
+    ~ListenHandoff();
+
+    ListenHandoff(const ListenHandoff&) = delete;
+    ListenHandoff& operator=(const ListenHandoff&) = delete;
+
+    // 新进程：连接旧进程并接收其监听fd，没有旧进程在等待时返回-1
+    // @exception 已连上旧进程但未能在timeout_ms内收到fd时抛出TcpRuntimeException
+    int32_t receive(int32_t timeout_ms);
+    // 新进程：确认已接管监听fd，旧进程收到后停止accept
+    void confirm();
+
+    // 在socket_path上等待交接请求，路径上已有的socket文件（旧进程的或残留的）会被替换
+    // @exception 创建或绑定Unix socket失败时抛出TcpRuntimeException
+    void listen();
+    // 旧进程：阻塞直到把listen_fd交给新进程且新进程在confirm_timeout_ms内确认（返回true），
+    // 或被cancel()打断（返回false）；未确认的交接不算数，继续等待下一个新进程
+    bool hand_over(int32_t listen_fd, int32_t confirm_timeout_ms);
+    // 打断阻塞中的hand_over()，可在任意线程调用
+    void cancel();
+};
+
+#endif // TCP_HANDOFF_HPP
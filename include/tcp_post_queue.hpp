@@ -0,0 +1,40 @@
+#ifndef TCP_POST_QUEUE_HPP
+#define TCP_POST_QUEUE_HPP
+
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <string>
+
+/**
+ * @brief 多生产者单消费者的无锁无界队列（Vyukov MPSC链表队列），TcpServer::post_send()以此把帧交给事件循环线程
+ *
+ * push()只有一次原子交换，任意线程可并发调用且不会阻塞；pop()只能由唯一的消费线程调用。
+ * 生产者交换尾指针之后、链接前驱节点之前的瞬间，队列中的节点暂时不可见：pop()返回false而empty()仍为false，
+ * 消费方需要稍后再取。
+ */
+class TcpPostQueue {
+private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        uint64_t conn_id = 0;
+        std::shared_ptr<const std::string> frame;
+    };
+
+    alignas(64) std::atomic<Node *> tail; // 生产者交换的一端
+    alignas(64) Node *head;               // 消费者独占，总是指向已取出的哑节点
+
+public:
+    TcpPostQueue();
+    ~TcpPostQueue();
+    TcpPostQueue(const TcpPostQueue&) = delete;
+    TcpPostQueue& operator=(const TcpPostQueue&) = delete;
+
+    void push(uint64_t conn_id, std::shared_ptr<const std::string> frame);
+    // 队列为空或队首节点尚未链接完成时返回false
+    bool pop(uint64_t& conn_id, std::shared_ptr<const std::string>& frame);
+    // 消费线程调用，包含尚未链接完成的节点
+    bool empty() const;
+};
+
+#endif // TCP_POST_QUEUE_HPP
@@ -1,6 +1,10 @@
 #ifndef TCP_PUBLIC_HPP
 #define TCP_PUBLIC_HPP
 
+extern "C" {
+#include <sys/uio.h>
+}
+
 #include <cstdint>
 #include <cstdarg>
 #include <cstdio>
@@ -56,7 +60,12 @@ void send_data_nonblock(int32_t socket_fd, const char *buf, uint16_t send_size);
 
 std::string recv_with_eof(int32_t socket_fd, size_t max_size, const std::string& eof_str);
 
+std::string read_file_content(const std::string& file_path, off_t size);
+
+void sendv_nonblock(int32_t socket_fd, struct iovec *iov, int32_t iov_count);
+
 void sendfile_nonblock(int32_t socket_fd, const std::string& file_path, off_t offset, off_t length);
+void sendfile_nonblock(int32_t socket_fd, int32_t file_fd, off_t offset, off_t length);
 
 void send_data_epoll(int32_t socket_fd, const char *buf, uint16_t send_size);
 
@@ -6,10 +6,79 @@ extern "C" {
 }
 
 #include <cstdint>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 #include "tcp_public.hpp"
+#include "tcp_address.hpp"
+#include "tcp_socket_options.hpp"
+#include "tcp_post_queue.hpp"
+
+// 低延迟模式的参数，见TcpServer::enable_busy_poll()
+struct TcpBusyPollConfig {
+    std::chrono::microseconds spin_budget{200}; // 每轮阻塞等待之前，以超时0反复轮询epoll的最长时长
+    uint32_t socket_busy_poll_us = 50;          // 客户端socket的SO_BUSY_POLL，阻塞读时由内核轮询网卡队列，0为不设置
+    bool prefer_busy_poll = true;               // SO_PREFER_BUSY_POLL，负载高时收包优先交给忙轮询而非软中断
+    uint16_t busy_poll_budget = 0;              // 单次忙轮询最多处理的包数（SO_BUSY_POLL_BUDGET与epoll参数），0为内核默认
+    uint32_t epoll_busy_poll_us = 0;            // epoll实例的内核忙轮询时长（EPIOCSPARAMS，Linux 6.9起），0为不设置
+};
+
+// 低延迟模式的统计：spin_us为自旋额外占用的CPU时间，spin_hits为因此省去的阻塞与唤醒次数
+struct TcpBusyPollStats {
+    uint64_t spin_polls = 0;     // 超时为0的epoll_wait次数
+    uint64_t spin_hits = 0;      // 在自旋期间等到事件的轮数
+    uint64_t blocking_waits = 0; // 自旋预算用尽后转为阻塞等待的轮数
+    uint64_t spin_us = 0;        // 累计自旋时长
+    bool socket_busy_poll = false; // 客户端socket的忙轮询选项已生效
+    bool epoll_busy_poll = false;  // epoll实例的内核忙轮询已生效
+
+    // 等到事件的轮次中由自旋等到的比例
+    double spin_hit_ratio() const
+    {
+        uint64_t total = spin_hits + blocking_waits;
+        return total == 0 ? 0.0 : static_cast<double>(spin_hits) / static_cast<double>(total);
+    }
+};
+
+// 发布的帧，编码一次后由各订阅者的发送队列共享引用，内容为完整的一帧，原样发出
+using TcpSharedFrame = std::shared_ptr<const std::string>;
+
+inline TcpSharedFrame make_shared_frame(const char *data, size_t length)
+{
+    return std::make_shared<const std::string>(data, length);
+}
+
+// 订阅者跟不上发布速度时，对该主题新帧的处理，见TcpServer::set_topic_config()
+enum TcpSlowSubscriberPolicy {
+    TCP_SLOW_DROP_OLDEST, // 队列满时丢弃最早的未发送帧
+    TCP_SLOW_DISCONNECT,  // 队列满时断开该订阅者
+    TCP_SLOW_CONFLATE,    // 队列中已有该主题未发送的帧时原位替换为最新帧，队列满时丢弃最早的帧
+};
+
+struct TcpTopicConfig {
+    TcpSlowSubscriberPolicy policy = TCP_SLOW_DROP_OLDEST;
+    size_t max_queued = 1024; // 订阅者排队未发送的帧数上限，不含已发出一部分的帧
+};
+
+// 发布订阅与跨线程发送的累计统计
+struct TcpFanoutStats {
+    uint64_t published = 0;    // 有订阅者的publish()次数
+    uint64_t enqueued = 0;     // 加入订阅者发送队列的帧数
+    uint64_t conflated = 0;    // 原位替换了旧帧的帧数
+    uint64_t dropped = 0;      // 因队列满丢弃的帧数
+    uint64_t disconnected = 0; // 因队列满断开的订阅者数
+    uint64_t posted = 0;       // 由post_send()加入发送队列的帧数
+    uint64_t orphaned = 0;     // post_send()的目标连接已关闭而丢弃的帧数
+};
 
 /*
     支持epoll多路并发的TCP服务器类
@@ -24,17 +93,120 @@ private:
     int32_t epoll_fd = -1;
     int32_t listen_fd = -1;
 
-    std::string listen_addr;
-    uint16_t listen_port;
+    TcpAddress listen_address;
+    std::string listen_addr;      // IPv4地址的文本，或Unix域socket的路径
+    uint16_t listen_port;         // Unix域socket为0
+    bool unlink_on_close = false; // 本对象在文件系统中创建了Unix域socket文件，关闭监听时删除
+
+    std::atomic<std::thread::id> loop_thread; // 调用listen_loop()的线程
+    std::atomic<int32_t> loop_cpu{-1};        // 事件循环线程绑定的CPU，-1为不绑定
+    std::thread::id pinned_thread;            // 已绑定到loop_cpu的线程，只在事件循环线程上访问
+    std::mutex accept_mutex;      // 保护listen_fd的暂停与关闭，两者可能在不同线程发生
+    bool accept_stopped = false;  // 已调用stop_accepting()，listen_fd已关闭
+
+    TcpSocketOptions socket_options; // 新连接accept后设置的选项，见set_socket_options()
+    bool socket_options_failed = false; // 已记录过连接选项设置失败的日志，只记录一次
+
+    bool busy_poll = false;       // 已调用enable_busy_poll()
+    TcpBusyPollConfig busy_poll_config;
+    // 以下统计只由事件循环线程写入，其他线程可随时读取
+    std::atomic<uint64_t> spin_polls{0};
+    std::atomic<uint64_t> spin_hits{0};
+    std::atomic<uint64_t> blocking_waits{0};
+    std::atomic<uint64_t> spin_us{0};
+    std::atomic<bool> socket_busy_poll{false};
+    bool socket_busy_poll_tried = false; // 已对首个连接尝试过设置忙轮询选项
+    bool epoll_busy_poll = false;
+
+    struct FanoutTopic;
+    struct QueuedFrame {
+        TcpSharedFrame frame;
+        const FanoutTopic *topic;
+    };
+    // 订阅者的发送队列，只在事件循环线程访问
+    struct FanoutOutput {
+        int32_t fd = -1;
+        TcpSharedFrame sending;           // 已发出一部分的帧
+        size_t sending_offset = 0;
+        std::deque<QueuedFrame> pending;  // 未发出任何字节的帧，可被丢弃或替换
+        uint64_t pending_head = 0;        // pending.front()的序号，每出队一帧加一
+        std::vector<FanoutTopic *> topics;
+        bool dirty = false;               // 已在dirty_outputs中等待本轮末尾发送
+        bool waiting_writable = false;    // 内核发送缓冲区已满，已关注EPOLLOUT
+    };
+    struct FanoutSubscription {
+        FanoutOutput *output;
+        uint64_t conflate_seq = UINT64_MAX; // 本主题在该订阅者队列中最新一帧的序号，用于原位替换
+    };
+    struct FanoutTopic {
+        TcpTopicConfig config;
+        std::vector<FanoutSubscription> subscriptions;
+    };
+    // unordered_map的元素地址在插入与rehash后不变，订阅关系之间直接以指针互相引用
+    std::unordered_map<std::string, FanoutTopic> topics;
+    std::unordered_map<int32_t, FanoutOutput> outputs;
+    std::vector<int32_t> dirty_outputs;
+    TcpFanoutStats fanout_stats;
+
+    // 跨线程发送：其他线程把帧放入post_queue后经eventfd唤醒事件循环，由事件循环线程写入发送队列
+    int32_t wakeup_fd = -1;
+    std::atomic<bool> wakeup_pending{false}; // 已写eventfd且事件循环尚未处理，之后的post_send()不必再写
+    TcpPostQueue post_queue;
+    std::unordered_map<int32_t, uint64_t> conn_ids; // 客户端fd到连接ID，只在事件循环线程访问
+    uint64_t next_conn_seq = 0;
 
     void accept_new_client(int32_t listen_fd);
+    // 自旋轮询epoll至多spin_budget，无事件时阻塞等待剩余的超时，返回事件数
+    int32_t busy_wait(struct epoll_event *events, int32_t timeout);
+    // 按busy_poll_config设置客户端socket的忙轮询选项
+    void set_socket_busy_poll(int32_t client_fd);
+    // 把frame加入订阅者的发送队列，按主题的策略处理队列已满的情况；需要断开该订阅者或发送出错时返回false
+    bool enqueue_frame(FanoutTopic& topic, FanoutSubscription& subscription, const TcpSharedFrame& frame);
+    // 尽量写出output中排队的帧，写到内核缓冲区满为止；连接出错时返回false
+    bool write_output(FanoutOutput& output);
+    // 发送本轮publish()排队的帧，缓冲区满的订阅者改为等待EPOLLOUT
+    void flush_outputs();
+    // EPOLLOUT到来时继续发送，队列写空后取消关注EPOLLOUT
+    void deal_output_writable(int32_t client_fd);
+    // 连接关闭时移除其全部订阅与发送队列
+    void remove_output(int32_t client_fd);
+    // 创建唤醒事件循环的eventfd并加入epoll，失败时关闭已创建的fd后抛出异常
+    void init_wakeup();
+    void wake_loop();
+    // 取出post_queue中全部的帧，加入各连接的发送队列
+    void drain_posts();
 
 protected:
     void close_client(int32_t client_fd);
+    // 修改客户端socket在epoll中关注的事件（如增减EPOLLOUT），可在任意线程调用
+    void modify_client_events(int32_t client_fd, uint32_t events);
+    // 把客户端以外的fd（如上游连接）加入epoll，已加入时修改其关注的事件，可在任意线程调用；
+    // 其事件与客户端一样分发到deal_client_msg()等函数，由子类自行区分，fd关闭时自动移出epoll
+    void watch_fd(int32_t fd, uint32_t events);
+    // 把watch_fd()加入的fd移出epoll，fd不在epoll中时忽略
+    void unwatch_fd(int32_t fd);
+    // 当前线程是否为事件循环线程
+    bool is_loop_thread() const;
+    // 暂停或恢复accept新连接，可在任意线程调用；暂停期间新连接留在内核的全连接队列中
+    // 已调用stop_accepting()时不做任何处理
+    void set_accept_paused(bool paused);
     // 子类请覆盖该函数，编写解析客户端消息的逻辑
     virtual void deal_client_msg(int32_t client_fd);
-    // 子类请覆盖该函数，编写有新客户端连入时，需要做的额外处理逻辑
+    // 子类请覆盖该函数，编写有新客户端连入时，需要做的额外处理逻辑；
+    // Unix域连接的client_addr只有sin_family为AF_UNIX，地址与端口均为0
     virtual void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr);
+    // 客户端socket关注了EPOLLOUT且变为可写时调用，子类可在此继续未完成的发送
+    virtual void deal_client_writable(int32_t client_fd);
+    // 客户端socket关闭前调用，子类可在此释放与连接关联的状态
+    virtual void deal_client_close(int32_t client_fd);
+    // 对端关闭或连接异常时调用，默认立即关闭；连接仍被其他线程使用时，子类可推迟关闭
+    virtual void deal_client_hangup(int32_t client_fd);
+    // 新连接加入epoll时关注的事件，默认为水平触发的EPOLLIN | EPOLLRDHUP
+    virtual uint32_t get_client_events() const;
+    // 每轮事件处理完毕后在事件循环线程调用，子类可在此推进需要跨事件调度的工作
+    virtual void deal_loop_end();
+    // 本轮epoll_wait的超时（ms），默认为EPOLL_TIMEOUT；子类有到期的调度工作时可缩短
+    virtual int32_t get_loop_timeout();
 
 public:
     constexpr static uint32_t MAX_ACCEPT_SIZE = 5; // listen_fd的最大accept量
@@ -43,10 +215,65 @@ public:
     constexpr static uint32_t EPOLL_TIMEOUT = 2000; // ms
 
     TcpServer(const std::string &listen_addr, uint16_t listen_port);
+    // 监听IPv4地址或Unix域socket；Unix域路径上已有的socket文件视为上次未清理的残留，先删除再绑定
+    explicit TcpServer(const TcpAddress &listen_address);
+    // 接管已处于监听状态的socket（如由旧进程交接而来），地址与端口从socket中读取
+    // @exception 不是IPv4或Unix域的监听socket时抛出TcpRuntimeException，此时不关闭listen_fd
+    explicit TcpServer(int32_t listen_fd);
     ~TcpServer();
 
     const std::string& get_listen_addr() const;
     uint16_t get_listen_port() const;
+    const TcpAddress& get_listen_address() const;
+    // 已调用stop_accepting()时返回-1
+    int32_t get_listen_fd() const;
+
+    // 停止accept并关闭本进程的listen_fd，已建立的连接不受影响，在事件循环线程调用；
+    // 监听socket已交接给其他进程时，其全连接队列由对方继续accept
+    void stop_accepting();
+
+    // 之后调用listen_loop()的线程在首次进入时绑定到cpu，-1为不绑定；绑定失败时记录日志，线程保持不绑定
+    void set_loop_cpu(int32_t cpu);
+    // 设置监听socket的选项，之后accept的连接也按其设置，需在进入事件循环之前调用；设置失败时记录日志后继续；
+    // 监听Unix域socket时TCP选项没有意义，不做设置
+    void set_socket_options(const TcpSocketOptions& options);
+    const TcpSocketOptions& get_socket_options() const;
+    // 低延迟模式，需在进入事件循环之前调用：每轮先以超时0自旋轮询epoll，预算内无事件才阻塞等待，
+    // 省去空闲时的唤醒延迟，代价是自旋期间占满一个CPU，宜配合set_loop_cpu()独占核心；
+    // TCP新连接设置SO_BUSY_POLL等选项，epoll实例在内核支持时启用忙轮询，不支持或权限不足时记录日志后跳过
+    void enable_busy_poll(const TcpBusyPollConfig& config = TcpBusyPollConfig());
+    TcpBusyPollStats get_busy_poll_stats() const;
+
+    /*
+        主题发布订阅，以下函数只能在事件循环线程调用（如deal_client_msg()、deal_loop_end()中）
+
+        publish()的帧只编码一次，以共享引用加入每个订阅者的发送队列，在本轮事件处理末尾统一发送，
+        同一订阅者在一轮中排队的多帧合并为一次sendmsg；内核缓冲区满时剩余的帧留在队列中，等待EPOLLOUT后继续。
+        订阅者的EPOLLOUT由发送队列管理，子类自行关注EPOLLOUT的连接不宜同时订阅；
+        已订阅的连接也不应再以send_data_nonblock()等函数直接发送，以免与排队的帧交错。
+    */
+    // 设置主题的慢订阅者策略，未设置的主题使用TcpTopicConfig的默认值
+    void set_topic_config(const std::string& topic, const TcpTopicConfig& config);
+    void subscribe(int32_t client_fd, const std::string& topic);
+    void unsubscribe(int32_t client_fd, const std::string& topic);
+    // 发布一帧到topic的全部订阅者，返回加入队列的订阅者数；队列满且策略为断开、或发送出错的订阅者在返回前关闭
+    size_t publish(const std::string& topic, const TcpSharedFrame& frame);
+    size_t publish(const std::string& topic, const char *data, size_t length);
+    // client_fd排队未发送的帧数，不含已发出一部分的帧
+    size_t get_queued_frames(int32_t client_fd) const;
+    const TcpFanoutStats& get_fanout_stats() const;
+
+    /*
+        跨线程发送：任意线程以post_send()把整帧交给事件循环线程发送，帧放入无锁队列后经eventfd唤醒事件循环，
+        所有写socket的操作都在事件循环线程进行，不与close_client()及其他发送者竞争，多个线程的帧也不会相互交错。
+        连接以连接ID标识，ID包含fd与一个递增序号，连接关闭后fd被新连接复用时，发给旧ID的帧被丢弃而不会发给新连接。
+        post_send()的帧不受主题策略的丢弃与替换，也没有数量上限，生产者需自行控制速率，可参考get_queued_frames()。
+    */
+    // client_fd的连接ID，在事件循环线程调用（如deal_new_client()中），不是已连接的客户端时返回0
+    uint64_t get_conn_id(int32_t client_fd) const;
+    // 可在任意线程调用，不阻塞；连接已关闭时帧在事件循环线程被丢弃
+    void post_send(uint64_t conn_id, const TcpSharedFrame& frame);
+    void post_send(uint64_t conn_id, const char *data, size_t length);
 
     void listen_loop();
 };
@@ -0,0 +1,42 @@
+#ifndef TCP_SOCKET_OPTIONS_HPP
+#define TCP_SOCKET_OPTIONS_HPP
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief 在监听、accept与connect时设置的TCP选项
+ *
+ * 默认构造的对象不设置任何选项，各项均保持内核默认值；latency()与throughput()为两组预设，见bench_socket_options。
+ * 设置失败（如内核不支持）不影响连接，apply_*()返回false，由调用方决定是否记录日志。
+ * 服务端的Fast Open还需要net.ipv4.tcp_fastopen打开服务端位（值含2），否则TCP_FASTOPEN设置成功但不生效。
+ */
+struct TcpSocketOptions {
+    bool nodelay = false;          // TCP_NODELAY，关闭Nagle，小报文立即发出
+    bool cork = false;             // 发送一个响应期间设置TCP_CORK、发完解除，响应头与各文件分块之间不发出未满的报文
+    int32_t defer_accept = 0;      // TCP_DEFER_ACCEPT（秒），连接上有数据到达才唤醒accept，0为不设置
+    int32_t fastopen_queue = 0;    // 监听socket的TCP_FASTOPEN队列长度，0为不设置
+    bool fastopen_connect = false; // 客户端TCP_FASTOPEN_CONNECT，有cookie时首个请求随SYN发出
+    int32_t send_buffer = 0;       // SO_SNDBUF，设置后该socket不再自动调整，受net.core.wmem_max限制；0为不设置
+    int32_t recv_buffer = 0;       // SO_RCVBUF，同上，受net.core.rmem_max限制，需在握手之前设置才能影响窗口扩大因子
+    int32_t notsent_lowat = 0;     // TCP_NOTSENT_LOWAT，未发出的数据低于该值才报告可写，0为不设置
+
+    // 小请求小响应：关闭Nagle，启用Fast Open，限制未发出数据使新响应不排在大量旧数据之后
+    static TcpSocketOptions latency();
+    // 大响应：合并报文、数据到达再accept，并放大收发缓冲区
+    static TcpSocketOptions throughput();
+    // 解析预设名"latency"、"throughput"或"default"
+    // @exception 名称未知时抛出TcpRuntimeException
+    static TcpSocketOptions parse(const std::string& name);
+
+    // 监听socket上的选项：defer_accept、fastopen_queue与收发缓冲区（accept出的连接继承缓冲区大小）
+    bool apply_listen(int32_t listen_fd) const;
+    // accept出的连接上的选项：nodelay、notsent_lowat与收发缓冲区
+    bool apply_accepted(int32_t client_fd) const;
+    // 客户端socket的选项，须在connect之前调用：nodelay、fastopen_connect、notsent_lowat与收发缓冲区
+    bool apply_connect(int32_t fd) const;
+    // 对发送中的socket设置或解除TCP_CORK，解除时立即发出积攒的数据
+    static bool set_cork(int32_t fd, bool on);
+};
+
+#endif // TCP_SOCKET_OPTIONS_HPP
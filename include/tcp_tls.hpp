@@ -0,0 +1,81 @@
+#ifndef TCP_TLS_HPP
+#define TCP_TLS_HPP
+
+extern "C" {
+#include <sys/types.h>
+}
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+typedef struct ssl_st SSL;
+typedef struct ssl_ctx_st SSL_CTX;
+
+// 非阻塞TLS操作的结果
+enum TlsStatus {
+    TLS_OK,
+    TLS_WANT_READ,  // 需等待socket可读后重试
+    TLS_WANT_WRITE, // 需等待socket可写后重试
+    TLS_CLOSED,     // 对端已关闭TLS会话
+};
+
+/**
+ * @brief 服务端TLS配置，持有证书与私钥，供所有连接共享
+ *
+ * 握手由OpenSSL完成；enable_ktls为true时在握手后尝试把对称密钥交给内核（kTLS），
+ * 成功后加密在内核中进行，文件内容仍可经sendfile零拷贝发送；内核不支持时自动回退为用户态加密。
+ */
+class TlsContext {
+private:
+    SSL_CTX *ctx = nullptr;
+
+public:
+    // @exception 证书或私钥加载失败时抛出TcpRuntimeException
+    TlsContext(const std::string& cert_file, const std::string& key_file, bool enable_ktls = true);
+    ~TlsContext();
+
+    TlsContext(const TlsContext&) = delete;
+    TlsContext& operator=(const TlsContext&) = delete;
+
+    SSL_CTX *get() const;
+};
+
+/**
+ * @brief 单个连接上的服务端TLS会话，运行在非阻塞socket上
+ *
+ * 各函数返回值大于0时为处理的字节数，否则由status给出需等待的事件；不可恢复的错误抛出TcpRuntimeException。
+ * 非阻塞重试时须以相同的参数再次调用（已开启部分写与可移动写缓冲）。
+ */
+class TlsSession {
+private:
+    SSL *ssl = nullptr;
+    bool established = false;
+    bool ktls_send = false;
+
+    TlsStatus error_status(int rc);
+
+public:
+    TlsSession(const TlsContext& context, int32_t socket_fd);
+    ~TlsSession();
+
+    TlsSession(const TlsSession&) = delete;
+    TlsSession& operator=(const TlsSession&) = delete;
+
+    // 推进握手，完成时返回TLS_OK
+    TlsStatus handshake();
+    bool is_established() const;
+    // 发送方向是否已卸载到内核
+    bool is_ktls_send() const;
+
+    ssize_t read(char *buf, size_t length, TlsStatus& status);
+    ssize_t write(const char *buf, size_t length, TlsStatus& status);
+    // 仅在is_ktls_send()为true时可用，由内核完成加密与零拷贝发送
+    ssize_t sendfile(int32_t file_fd, off_t offset, size_t length, TlsStatus& status);
+    // 尽力发送close_notify，不等待对端回应
+    void shutdown() noexcept;
+
+    static std::string get_error_string();
+};
+
+#endif // TCP_TLS_HPP
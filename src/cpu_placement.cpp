@@ -0,0 +1,233 @@
+extern "C" {
+#include <pthread.h>
+#include <sched.h>
+}
+
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+
+#include "tcp_public.hpp"
+#include "cpu_placement.hpp"
+
+static const std::filesystem::path CGROUP_ROOT = "/sys/fs/cgroup";
+
+// 读取cgroup v2目录下的cpu.max（"max 100000"或"<quota> <period>"），未限制或不存在时返回0
+static double read_cpu_max(const std::filesystem::path& dir)
+{
+    std::ifstream file(dir / "cpu.max");
+    std::string quota;
+    int64_t period = 0;
+    if (!(file >> quota >> period) || quota == "max" || period <= 0) {
+        return 0;
+    }
+    return static_cast<double>(std::stoll(quota)) / static_cast<double>(period);
+}
+
+// 读取cgroup v1目录下的cpu.cfs_quota_us与cpu.cfs_period_us，配额为-1或不存在时返回0
+static double read_cfs_quota(const std::filesystem::path& dir)
+{
+    int64_t quota = -1;
+    int64_t period = 0;
+    std::ifstream quota_file(dir / "cpu.cfs_quota_us");
+    std::ifstream period_file(dir / "cpu.cfs_period_us");
+    if (!(quota_file >> quota) || !(period_file >> period) || quota <= 0 || period <= 0) {
+        return 0;
+    }
+    return static_cast<double>(quota) / static_cast<double>(period);
+}
+
+// 从进程所在的cgroup逐级向上取最严格的配额；容器内/proc/self/cgroup的路径可能在挂载点下不存在，
+// 此时挂载点本身即为容器的cgroup
+static double min_limit_upwards(const std::filesystem::path& mount, const std::string& relative,
+    double (*reader)(const std::filesystem::path&))
+{
+    double limit = 0;
+    std::filesystem::path dir = mount / std::filesystem::path(relative).relative_path();
+    if (!std::filesystem::exists(dir)) {
+        dir = mount;
+    }
+    for (;;) {
+        double current = reader(dir);
+        if (current > 0 && (limit == 0 || current < limit)) {
+            limit = current;
+        }
+        if (dir == mount || !dir.has_parent_path() || dir.parent_path() == dir) {
+            break;
+        }
+        dir = dir.parent_path();
+    }
+    return limit;
+}
+
+std::vector<int32_t> CpuPlacement::parse_cpu_list(const std::string& list)
+{
+    std::vector<int32_t> cpus;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (item.empty()) {
+            continue;
+        }
+        try {
+            size_t dash = item.find('-');
+            int32_t first = std::stoi(item.substr(0, dash));
+            int32_t last = dash == std::string::npos ? first : std::stoi(item.substr(dash + 1));
+            if (first < 0 || last < first || last >= CPU_SETSIZE) {
+                throw std::out_of_range(item);
+            }
+            for (int32_t cpu = first; cpu <= last; cpu++) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::logic_error&) {
+            throw TcpRuntimeException("invalid cpu list: " + list, __FILENAME__, __LINE__);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::vector<int32_t> CpuPlacement::get_allowed_cpus()
+{
+    std::vector<int32_t> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) < 0) {
+        return cpus;
+    }
+    for (int32_t cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// /proc/self/cgroup每行为"<id>:<controllers>:<path>"，v2的id为0且controllers为空
+double CpuPlacement::get_cgroup_cpu_limit()
+{
+    std::ifstream file("/proc/self/cgroup");
+    std::string line;
+    double limit = 0;
+    while (std::getline(file, line)) {
+        size_t first = line.find(':');
+        size_t second = line.find(':', first + 1);
+        if (first == std::string::npos || second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+
+        double current = 0;
+        if (controllers.empty()) {
+            current = min_limit_upwards(CGROUP_ROOT, path, read_cpu_max);
+        } else {
+            std::stringstream stream(controllers);
+            std::string controller;
+            bool has_cpu = false;
+            while (std::getline(stream, controller, ',')) {
+                has_cpu |= controller == "cpu";
+            }
+            if (has_cpu) {
+                current = min_limit_upwards(CGROUP_ROOT / controllers, path, read_cfs_quota);
+            }
+        }
+        if (current > 0 && (limit == 0 || current < limit)) {
+            limit = current;
+        }
+    }
+    return limit;
+}
+
+size_t CpuPlacement::get_usable_cpu_count()
+{
+    size_t count = get_allowed_cpus().size();
+    double limit = get_cgroup_cpu_limit();
+    if (limit > 0) {
+        count = std::min(count, static_cast<size_t>(std::ceil(limit)));
+    }
+    return std::max<size_t>(count, 1);
+}
+
+// sysfs中CPU目录下的nodeN链接指向其所属节点
+int32_t CpuPlacement::get_cpu_node(int32_t cpu)
+{
+    std::error_code ec;
+    std::filesystem::directory_iterator it("/sys/devices/system/cpu/cpu" + std::to_string(cpu), ec);
+    for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+            std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return std::stoi(name.substr(4));
+        }
+    }
+    return 0;
+}
+
+void CpuPlacement::pin_current_thread(int32_t cpu)
+{
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        throw TcpRuntimeException("invalid cpu " + std::to_string(cpu), __FILENAME__, __LINE__);
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int32_t ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (ret != 0) {
+        errno = ret;
+        throw TcpRuntimeException("pin thread to cpu " + std::to_string(cpu) + " failed", __FILENAME__, __LINE__);
+    }
+}
+
+CpuPlacement CpuPlacement::automatic()
+{
+    CpuPlacement placement;
+    std::vector<int32_t> allowed = get_allowed_cpus();
+    if (allowed.empty()) {
+        return placement;
+    }
+    allowed.resize(std::min(allowed.size(), get_usable_cpu_count()));
+
+    placement.reactor_cpu = allowed.front();
+    if (allowed.size() == 1) {
+        placement.worker_cpus = allowed;
+        return placement;
+    }
+
+    int32_t reactor_node = get_cpu_node(placement.reactor_cpu);
+    placement.worker_cpus.assign(allowed.begin() + 1, allowed.end());
+    std::stable_partition(placement.worker_cpus.begin(), placement.worker_cpus.end(),
+        [reactor_node](int32_t cpu) { return get_cpu_node(cpu) == reactor_node; });
+    return placement;
+}
+
+CpuPlacement CpuPlacement::parse(const std::string& spec)
+{
+    if (spec == "auto") {
+        return automatic();
+    }
+
+    size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        throw TcpRuntimeException("invalid cpu placement: " + spec, __FILENAME__, __LINE__);
+    }
+    std::vector<int32_t> reactor = parse_cpu_list(spec.substr(0, colon));
+    CpuPlacement placement;
+    placement.worker_cpus = parse_cpu_list(spec.substr(colon + 1));
+    if (reactor.size() != 1 || placement.worker_cpus.empty()) {
+        throw TcpRuntimeException("invalid cpu placement: " + spec, __FILENAME__, __LINE__);
+    }
+    placement.reactor_cpu = reactor.front();
+
+    std::vector<int32_t> allowed = get_allowed_cpus();
+    auto is_allowed = [&allowed](int32_t cpu) { return std::binary_search(allowed.begin(), allowed.end(), cpu); };
+    if (!is_allowed(placement.reactor_cpu) ||
+        !std::all_of(placement.worker_cpus.begin(), placement.worker_cpus.end(), is_allowed)) {
+        throw TcpRuntimeException("cpu placement uses cpus outside the affinity mask: " + spec,
+            __FILENAME__, __LINE__);
+    }
+    return placement;
+}
@@ -0,0 +1,290 @@
+extern "C" {
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sched.h>
+}
+
+#include <climits>
+
+#include "tcp_public.hpp"
+#include "executor.hpp"
+#include "cpu_placement.hpp"
+
+// === BoundedTaskQueue ===
+
+BoundedTaskQueue::BoundedTaskQueue(size_t capacity)
+{
+    // 容量向上取整为2的幂，以掩码代替取模
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    this->cells.reset(new Cell[size]);
+    this->mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+        this->cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool BoundedTaskQueue::push(ExecutorTask&& task)
+{
+    size_t pos = this->enqueue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = this->cells[pos & this->mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            // 槽位空闲，尝试占用
+            if (this->enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.task = std::move(task);
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // 队列已满
+        } else {
+            pos = this->enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool BoundedTaskQueue::pop(ExecutorTask& task)
+{
+    size_t pos = this->dequeue_pos.load(std::memory_order_relaxed);
+    for (;;) {
+        Cell& cell = this->cells[pos & this->mask];
+        size_t seq = cell.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (this->dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                task = std::move(cell.task);
+                cell.task = nullptr;
+                cell.sequence.store(pos + this->mask + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false; // 队列为空
+        } else {
+            pos = this->dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool BoundedTaskQueue::empty() const
+{
+    return this->dequeue_pos.load(std::memory_order_acquire) >= this->enqueue_pos.load(std::memory_order_acquire);
+}
+
+// === EventCount ===
+
+static void futex_wait(std::atomic<uint32_t> *addr, uint32_t expected)
+{
+    static_cast<void>(syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0));
+}
+
+static void futex_wake(std::atomic<uint32_t> *addr, int32_t count)
+{
+    static_cast<void>(syscall(SYS_futex, reinterpret_cast<uint32_t *>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0));
+}
+
+uint32_t EventCount::prepare_wait()
+{
+    this->waiters.fetch_add(1, std::memory_order_seq_cst);
+    return this->epoch.load(std::memory_order_seq_cst);
+}
+
+void EventCount::cancel_wait()
+{
+    this->waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void EventCount::commit_wait(uint32_t key)
+{
+    // 纪元在prepare_wait之后已变化时，futex会立即返回，不会错过通知
+    futex_wait(&this->epoch, key);
+    this->waiters.fetch_sub(1, std::memory_order_seq_cst);
+}
+
+void EventCount::notify_one()
+{
+    // 与等待方的waiters递增构成Dekker式同步：任务入队必须先于此处读取waiters
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waiters.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    this->epoch.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&this->epoch, 1);
+}
+
+void EventCount::notify_all()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (this->waiters.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    this->epoch.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(&this->epoch, INT_MAX);
+}
+
+// === WorkStealingExecutor ===
+
+size_t WorkStealingExecutor::default_thread_count()
+{
+    return CpuPlacement::get_usable_cpu_count();
+}
+
+WorkStealingExecutor::WorkStealingExecutor(size_t thread_count, size_t queue_capacity, const std::vector<int32_t>& cpus)
+{
+    if (thread_count == 0) {
+        thread_count = default_thread_count();
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        this->workers.emplace_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; i++) {
+        int32_t cpu = cpus.empty() ? -1 : cpus[i % cpus.size()];
+        this->workers[i]->thread = std::thread(&WorkStealingExecutor::worker_main, this, i, queue_capacity, cpu);
+    }
+    // 所有队列就绪后才能提交任务
+    {
+        std::unique_lock<std::mutex> lock(this->ready_mutex);
+        this->ready_cond.wait(lock, [this]() { return this->ready_count == this->workers.size(); });
+    }
+
+    LOG_INFO("work stealing executor started with %zu threads%s", thread_count, cpus.empty() ? "" : ", pinned");
+}
+
+// 绑定CPU后分配本线程的队列，等待所有队列就绪后进入主循环，窃取时才不会访问到尚未分配的队列
+void WorkStealingExecutor::worker_main(size_t self, size_t queue_capacity, int32_t cpu)
+{
+    if (cpu >= 0) {
+        try {
+            CpuPlacement::pin_current_thread(cpu);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("worker %zu keeps floating: %s", self, e.what());
+        }
+    }
+    this->workers[self]->queue = std::make_unique<BoundedTaskQueue>(queue_capacity);
+
+    {
+        std::unique_lock<std::mutex> lock(this->ready_mutex);
+        this->ready_count++;
+        this->ready_cond.notify_all();
+        this->ready_cond.wait(lock, [this]() { return this->ready_count == this->workers.size(); });
+    }
+    worker_loop(self);
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    stop();
+}
+
+// 先登记为进行中再检查stop_flag，与stop()构成Dekker式同步：stop()置位后等待进行中的提交全部完成，
+// 通过检查的任务都会在stop()排空队列之前入队
+bool WorkStealingExecutor::submit(ExecutorTask&& task)
+{
+    this->submitting.fetch_add(1, std::memory_order_seq_cst);
+    if (this->stop_flag.load(std::memory_order_seq_cst)) {
+        this->submitting.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    bool pushed = false;
+    size_t count = this->workers.size();
+    size_t start = this->next_worker.fetch_add(1, std::memory_order_relaxed);
+    for (size_t i = 0; i < count && !pushed; i++) {
+        pushed = this->workers[(start + i) % count]->queue->push(std::move(task));
+    }
+    this->submitting.fetch_sub(1, std::memory_order_release);
+    if (pushed) {
+        this->event_count.notify_one();
+    }
+    return pushed;
+}
+
+static void run_task(ExecutorTask& task)
+{
+    try {
+        task();
+    } catch (const std::exception& e) {
+        LOG_ERR("executor task failed: %s", e.what());
+    }
+    task = nullptr;
+}
+
+// 先取自己的队列，再从相邻的队列开始依次窃取
+bool WorkStealingExecutor::find_task(size_t self, ExecutorTask& task)
+{
+    size_t count = this->workers.size();
+    for (size_t i = 0; i < count; i++) {
+        if (this->workers[(self + i) % count]->queue->pop(task)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingExecutor::worker_loop(size_t self)
+{
+    ExecutorTask task;
+    for (;;) {
+        bool found = false;
+        for (uint32_t spin = 0; spin < SPIN_ROUNDS && !found; spin++) {
+            found = find_task(self, task);
+            if (!found) {
+                sched_yield();
+            }
+        }
+
+        if (!found) {
+            uint32_t key = this->event_count.prepare_wait();
+            // 登记为等待者之后再确认一次，避免与submit之间的通知丢失
+            found = find_task(self, task);
+            if (found) {
+                this->event_count.cancel_wait();
+            } else if (this->stop_flag.load()) {
+                this->event_count.cancel_wait();
+                break;
+            } else {
+                this->event_count.commit_wait(key);
+                continue;
+            }
+        }
+
+        run_task(task);
+    }
+}
+
+void WorkStealingExecutor::stop()
+{
+    if (this->stop_flag.exchange(true, std::memory_order_seq_cst)) {
+        return;
+    }
+    while (this->submitting.load(std::memory_order_acquire) > 0) {
+        sched_yield();
+    }
+    this->event_count.notify_all();
+
+    for (auto& worker : this->workers) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+
+    // 工作线程看到stop_flag时可能有任务刚刚入队，退出后由调用线程执行，已接受的任务不会丢失
+    ExecutorTask task;
+    for (size_t i = 0; i < this->workers.size(); i++) {
+        while (this->workers[i]->queue->pop(task)) {
+            run_task(task);
+        }
+    }
+}
+
+size_t WorkStealingExecutor::get_thread_count() const
+{
+    return this->workers.size();
+}
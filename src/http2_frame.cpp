@@ -0,0 +1,29 @@
+#include "http2_frame.hpp"
+
+Http2FrameHeader Http2FrameHeader::parse(const char *data)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    Http2FrameHeader header;
+    header.length = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+    header.type = p[3];
+    header.flags = p[4];
+    header.stream_id = ((static_cast<uint32_t>(p[5]) << 24) | (static_cast<uint32_t>(p[6]) << 16) |
+        (static_cast<uint32_t>(p[7]) << 8) | p[8]) & 0x7fffffff;
+    return header;
+}
+
+void Http2FrameHeader::serialize(std::string& out) const
+{
+    char buf[SIZE] = {
+        static_cast<char>((this->length >> 16) & 0xff),
+        static_cast<char>((this->length >> 8) & 0xff),
+        static_cast<char>(this->length & 0xff),
+        static_cast<char>(this->type),
+        static_cast<char>(this->flags),
+        static_cast<char>((this->stream_id >> 24) & 0x7f),
+        static_cast<char>((this->stream_id >> 16) & 0xff),
+        static_cast<char>((this->stream_id >> 8) & 0xff),
+        static_cast<char>(this->stream_id & 0xff),
+    };
+    out.append(buf, SIZE);
+}
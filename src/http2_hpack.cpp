@@ -0,0 +1,458 @@
+#include <algorithm>
+
+#include "http2_hpack.hpp"
+
+// RFC 7541 附录A
+static const HpackHeader STATIC_TABLE[HpackTable::STATIC_COUNT] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+struct HuffmanCode {
+    uint32_t code;
+    uint8_t bits;
+};
+
+// RFC 7541 附录B，下标为符号，256为EOS
+static const HuffmanCode HUFFMAN_CODES[257] = {
+    {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28}, {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+    {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28}, {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+    {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28}, {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+    {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28}, {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+    {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12}, {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+    {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11}, {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+    {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6}, {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+    {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8}, {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+    {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7}, {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+    {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7}, {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+    {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7}, {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+    {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13}, {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+    {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5}, {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+    {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7}, {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+    {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5}, {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+    {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15}, {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+    {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20}, {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+    {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23}, {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+    {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23}, {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+    {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23}, {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+    {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22}, {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+    {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24}, {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+    {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21}, {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+    {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22}, {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+    {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19}, {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+    {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27}, {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+    {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27}, {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+    {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26}, {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+    {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21}, {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+    {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25}, {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+    {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26}, {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+    {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27}, {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+    {0x3fffffff, 30},
+};
+
+// 规范哈夫曼码：同一长度的码字连续递增，按长度记录首个码字即可逐位解码
+struct HuffmanDecodeTable {
+    static constexpr uint8_t MAX_BITS = 30;
+
+    uint32_t first_code[MAX_BITS + 1] = {0};
+    uint16_t first_index[MAX_BITS + 1] = {0};
+    uint16_t count[MAX_BITS + 1] = {0};
+    uint16_t symbols[257] = {0};
+
+    HuffmanDecodeTable()
+    {
+        for (uint16_t i = 0; i < 257; i++) {
+            symbols[i] = i;
+        }
+        std::sort(std::begin(symbols), std::end(symbols), [](uint16_t a, uint16_t b) {
+            const HuffmanCode& x = HUFFMAN_CODES[a];
+            const HuffmanCode& y = HUFFMAN_CODES[b];
+            return x.bits != y.bits ? x.bits < y.bits : x.code < y.code;
+        });
+        for (uint16_t i = 257; i-- > 0; ) {
+            const HuffmanCode& code = HUFFMAN_CODES[symbols[i]];
+            first_code[code.bits] = code.code;
+            first_index[code.bits] = i;
+            count[code.bits]++;
+        }
+    }
+};
+
+static std::string huffman_decode(const uint8_t *data, size_t length)
+{
+    static const HuffmanDecodeTable table;
+
+    std::string out;
+    out.reserve(length * 8 / 5);
+    uint32_t code = 0;
+    uint8_t bits = 0;
+    for (size_t i = 0; i < length; i++) {
+        for (int shift = 7; shift >= 0; shift--) {
+            code = (code << 1) | ((data[i] >> shift) & 1);
+            bits++;
+            if (bits > HuffmanDecodeTable::MAX_BITS) {
+                throw Http2Exception("invalid huffman code", HTTP2_ERR_COMPRESSION);
+            }
+            if (code >= table.first_code[bits] && code - table.first_code[bits] < table.count[bits]) {
+                uint16_t symbol = table.symbols[table.first_index[bits] + code - table.first_code[bits]];
+                if (symbol == 256) {
+                    throw Http2Exception("EOS in huffman string", HTTP2_ERR_COMPRESSION);
+                }
+                out.push_back(static_cast<char>(symbol));
+                code = 0;
+                bits = 0;
+            }
+        }
+    }
+
+    // 末尾的填充须为EOS码字的前缀（全1），且不超过7位
+    if (bits > 7 || code != (1u << bits) - 1) {
+        throw Http2Exception("invalid huffman padding", HTTP2_ERR_COMPRESSION);
+    }
+    return out;
+}
+
+static size_t huffman_length(const std::string& str)
+{
+    size_t bits = 0;
+    for (unsigned char c : str) {
+        bits += HUFFMAN_CODES[c].bits;
+    }
+    return (bits + 7) / 8;
+}
+
+static void huffman_encode(const std::string& str, std::string& out)
+{
+    uint64_t pending = 0;
+    uint8_t bits = 0;
+    for (unsigned char c : str) {
+        const HuffmanCode& code = HUFFMAN_CODES[c];
+        pending = (pending << code.bits) | code.code;
+        bits += code.bits;
+        while (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<char>((pending >> bits) & 0xff));
+        }
+        pending &= (1ull << bits) - 1;
+    }
+    if (bits > 0) {
+        out.push_back(static_cast<char>(((pending << (8 - bits)) | ((1u << (8 - bits)) - 1)) & 0xff));
+    }
+}
+
+// 整数编码（RFC 7541 5.1），flags为首字节中前缀之外的高位
+static void encode_integer(uint64_t value, uint8_t prefix_bits, uint8_t flags, std::string& out)
+{
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out.push_back(static_cast<char>(flags | value));
+        return;
+    }
+    out.push_back(static_cast<char>(flags | max_prefix));
+    value -= max_prefix;
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+static uint64_t decode_integer(const uint8_t *&pos, const uint8_t *end, uint8_t prefix_bits)
+{
+    if (pos >= end) {
+        throw Http2Exception("truncated integer", HTTP2_ERR_COMPRESSION);
+    }
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    uint64_t value = *pos++ & max_prefix;
+    if (value < max_prefix) {
+        return value;
+    }
+
+    for (uint32_t shift = 0; ; shift += 7) {
+        // 头部中的整数不会超过32位，更长的编码视为攻击
+        if (pos >= end || shift > 28) {
+            throw Http2Exception("invalid integer", HTTP2_ERR_COMPRESSION);
+        }
+        uint8_t byte = *pos++;
+        value += static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+// 字符串编码（RFC 7541 5.2），哈夫曼编码更短时使用
+static void encode_string(const std::string& str, std::string& out)
+{
+    size_t huffman_size = huffman_length(str);
+    if (huffman_size < str.size()) {
+        encode_integer(huffman_size, 7, 0x80, out);
+        huffman_encode(str, out);
+        return;
+    }
+    encode_integer(str.size(), 7, 0x00, out);
+    out += str;
+}
+
+static std::string decode_string(const uint8_t *&pos, const uint8_t *end)
+{
+    if (pos >= end) {
+        throw Http2Exception("truncated string", HTTP2_ERR_COMPRESSION);
+    }
+    bool huffman = (*pos & 0x80) != 0;
+    uint64_t length = decode_integer(pos, end, 7);
+    if (length > static_cast<uint64_t>(end - pos)) {
+        throw Http2Exception("truncated string", HTTP2_ERR_COMPRESSION);
+    }
+
+    const uint8_t *data = pos;
+    pos += length;
+    if (huffman) {
+        return huffman_decode(data, length);
+    }
+    return std::string(reinterpret_cast<const char *>(data), length);
+}
+
+// === HpackTable ===
+
+const HpackHeader *HpackTable::get(size_t index) const
+{
+    if (index == 0) {
+        return nullptr;
+    }
+    if (index <= STATIC_COUNT) {
+        return &STATIC_TABLE[index - 1];
+    }
+    index -= STATIC_COUNT + 1;
+    return index < this->entries.size() ? &this->entries[index] : nullptr;
+}
+
+size_t HpackTable::find(const std::string& name, const std::string& value, size_t& name_index) const
+{
+    name_index = 0;
+    for (size_t i = 0; i < STATIC_COUNT; i++) {
+        if (STATIC_TABLE[i].name != name) {
+            continue;
+        }
+        if (STATIC_TABLE[i].value == value) {
+            return i + 1;
+        }
+        if (name_index == 0) {
+            name_index = i + 1;
+        }
+    }
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        if (this->entries[i].name != name) {
+            continue;
+        }
+        if (this->entries[i].value == value) {
+            return STATIC_COUNT + 1 + i;
+        }
+        if (name_index == 0) {
+            name_index = STATIC_COUNT + 1 + i;
+        }
+    }
+    return 0;
+}
+
+void HpackTable::evict(size_t limit)
+{
+    while (this->size > limit) {
+        const HpackHeader& oldest = this->entries.back();
+        this->size -= oldest.name.size() + oldest.value.size() + ENTRY_OVERHEAD;
+        this->entries.pop_back();
+    }
+}
+
+void HpackTable::add(HpackHeader header)
+{
+    size_t entry_size = header.name.size() + header.value.size() + ENTRY_OVERHEAD;
+    if (entry_size > this->max_size) {
+        evict(0);
+        return;
+    }
+    evict(this->max_size - entry_size);
+    this->size += entry_size;
+    this->entries.push_front(std::move(header));
+}
+
+void HpackTable::set_max_size(size_t max_size)
+{
+    this->max_size = max_size;
+    evict(max_size);
+}
+
+size_t HpackTable::get_max_size() const
+{
+    return this->max_size;
+}
+
+// === HpackDecoder ===
+
+std::vector<HpackHeader> HpackDecoder::decode(const std::string& block)
+{
+    std::vector<HpackHeader> headers;
+    size_t list_size = 0;
+    const uint8_t *pos = reinterpret_cast<const uint8_t *>(block.data());
+    const uint8_t *end = pos + block.size();
+
+    auto append = [&](HpackHeader header) {
+        list_size += header.name.size() + header.value.size() + HpackTable::ENTRY_OVERHEAD;
+        if (list_size > MAX_HEADER_LIST_SIZE) {
+            throw Http2Exception("header list too large", HTTP2_ERR_ENHANCE_YOUR_CALM);
+        }
+        headers.push_back(std::move(header));
+    };
+
+    while (pos < end) {
+        uint8_t first = *pos;
+        if (first & 0x80) {
+            // 索引字段
+            const HpackHeader *entry = this->table.get(decode_integer(pos, end, 7));
+            if (entry == nullptr) {
+                throw Http2Exception("header index out of range", HTTP2_ERR_COMPRESSION);
+            }
+            append(*entry);
+            continue;
+        }
+
+        if ((first & 0xe0) == 0x20) {
+            // 动态表大小更新只能出现在头部块开头
+            uint64_t size = decode_integer(pos, end, 5);
+            if (!headers.empty() || size > this->settings_table_size) {
+                throw Http2Exception("invalid table size update", HTTP2_ERR_COMPRESSION);
+            }
+            this->table.set_max_size(size);
+            continue;
+        }
+
+        // 字面量：带增量索引（01）、不索引（0000）与永不索引（0001）
+        bool indexing = (first & 0xc0) == 0x40;
+        uint64_t name_index = decode_integer(pos, end, indexing ? 6 : 4);
+        HpackHeader header;
+        if (name_index == 0) {
+            header.name = decode_string(pos, end);
+        } else {
+            const HpackHeader *entry = this->table.get(name_index);
+            if (entry == nullptr) {
+                throw Http2Exception("header name index out of range", HTTP2_ERR_COMPRESSION);
+            }
+            header.name = entry->name;
+        }
+        header.value = decode_string(pos, end);
+
+        if (indexing) {
+            this->table.add(header);
+        }
+        append(std::move(header));
+    }
+    return headers;
+}
+
+// === HpackEncoder ===
+
+bool HpackEncoder::should_index(const std::string& name)
+{
+    return name == "content-type" || name == "cache-control" || name == "vary" ||
+        name == "content-encoding" || name == "accept-ranges" || name == "server";
+}
+
+void HpackEncoder::set_max_table_size(size_t size)
+{
+    size = std::min(size, HpackTable::DEFAULT_SIZE);
+    if (size != this->table.get_max_size()) {
+        this->table.set_max_size(size);
+        this->size_update_pending = true;
+    }
+}
+
+void HpackEncoder::encode(const std::vector<HpackHeader>& headers, std::string& out)
+{
+    if (this->size_update_pending) {
+        encode_integer(this->table.get_max_size(), 5, 0x20, out);
+        this->size_update_pending = false;
+    }
+
+    for (const HpackHeader& header : headers) {
+        size_t name_index = 0;
+        size_t index = this->table.find(header.name, header.value, name_index);
+        if (index != 0) {
+            encode_integer(index, 7, 0x80, out);
+            continue;
+        }
+
+        bool indexing = should_index(header.name);
+        if (indexing) {
+            encode_integer(name_index, 6, 0x40, out);
+        } else {
+            encode_integer(name_index, 4, 0x00, out);
+        }
+        if (name_index == 0) {
+            encode_string(header.name, out);
+        }
+        encode_string(header.value, out);
+
+        if (indexing) {
+            this->table.add(header);
+        }
+    }
+}
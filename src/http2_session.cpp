@@ -0,0 +1,740 @@
+#include <algorithm>
+#include <cctype>
+
+#include "tcp_public.hpp"
+#include "http2_session.hpp"
+
+static uint32_t read_uint32(const char *data)
+{
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(data);
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static void append_uint32(std::string& out, uint32_t value)
+{
+    out.push_back(static_cast<char>((value >> 24) & 0xff));
+    out.push_back(static_cast<char>((value >> 16) & 0xff));
+    out.push_back(static_cast<char>((value >> 8) & 0xff));
+    out.push_back(static_cast<char>(value & 0xff));
+}
+
+static void append_setting(std::string& out, Http2SettingId id, uint32_t value)
+{
+    out.push_back(static_cast<char>((id >> 8) & 0xff));
+    out.push_back(static_cast<char>(id & 0xff));
+    append_uint32(out, value);
+}
+
+// 去掉PADDED标志带来的填充，payload与length指向实际内容
+static void strip_padding(const Http2FrameHeader& header, const char *&payload, size_t& length)
+{
+    length = header.length;
+    if ((header.flags & HTTP2_FLAG_PADDED) == 0) {
+        return;
+    }
+    if (length < 1 || static_cast<uint8_t>(payload[0]) > length - 1) {
+        throw Http2Exception("invalid padding", HTTP2_ERR_PROTOCOL);
+    }
+    length -= 1 + static_cast<uint8_t>(payload[0]);
+    payload++;
+}
+
+// HTTP2-Settings使用不带填充的base64url编码
+static bool decode_base64url(const std::string& input, std::string& output)
+{
+    uint32_t pending = 0;
+    int bits = 0;
+    for (char c : input) {
+        uint32_t value = 0;
+        if (c >= 'A' && c <= 'Z') {
+            value = static_cast<uint32_t>(c - 'A');
+        } else if (c >= 'a' && c <= 'z') {
+            value = static_cast<uint32_t>(c - 'a' + 26);
+        } else if (c >= '0' && c <= '9') {
+            value = static_cast<uint32_t>(c - '0' + 52);
+        } else if (c == '-' || c == '+') {
+            value = 62;
+        } else if (c == '_' || c == '/') {
+            value = 63;
+        } else if (c == '=') {
+            break;
+        } else {
+            return false;
+        }
+        pending = (pending << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            output.push_back(static_cast<char>((pending >> bits) & 0xff));
+        }
+    }
+    return true;
+}
+
+Http2Session::Http2Session()
+{
+    std::string settings;
+    append_setting(settings, HTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, MAX_CONCURRENT_STREAMS);
+    append_setting(settings, HTTP2_SETTINGS_MAX_HEADER_LIST_SIZE, HpackDecoder::MAX_HEADER_LIST_SIZE);
+    append_frame(HTTP2_FRAME_SETTINGS, 0, 0, settings);
+}
+
+bool Http2Session::match_preface(const std::string& input, bool& complete)
+{
+    size_t length = std::min(input.size(), CLIENT_PREFACE_SIZE);
+    if (length == 0 || input.compare(0, length, CLIENT_PREFACE, length) != 0) {
+        return false;
+    }
+    complete = length == CLIENT_PREFACE_SIZE;
+    return true;
+}
+
+void Http2Session::upgrade(const std::string& http2_settings)
+{
+    std::string payload;
+    if (!decode_base64url(http2_settings, payload) || payload.size() % 6 != 0) {
+        throw Http2Exception("invalid HTTP2-Settings", HTTP2_ERR_PROTOCOL);
+    }
+    apply_settings(payload.data(), payload.size());
+
+    // Upgrade请求本身不再有请求体，流1从半关闭状态开始
+    Stream& stream = this->streams[1];
+    stream.send_window = this->peer_initial_window;
+    stream.remote_closed = true;
+    this->last_stream_id = 1;
+}
+
+void Http2Session::append_frame(uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+{
+    Http2FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = type;
+    header.flags = flags;
+    header.stream_id = stream_id;
+    header.serialize(this->control);
+    this->control += payload;
+}
+
+void Http2Session::append_window_update(uint32_t stream_id, uint32_t increment)
+{
+    std::string payload;
+    append_uint32(payload, increment);
+    append_frame(HTTP2_FRAME_WINDOW_UPDATE, 0, stream_id, payload);
+}
+
+void Http2Session::reset_stream(uint32_t stream_id, Http2ErrorCode error_code)
+{
+    std::string payload;
+    append_uint32(payload, error_code);
+    append_frame(HTTP2_FRAME_RST_STREAM, 0, stream_id, payload);
+    finish_stream(stream_id);
+}
+
+// 流结束后移除；ready中残留的标识在轮转时跳过
+void Http2Session::finish_stream(uint32_t stream_id)
+{
+    auto it = this->streams.find(stream_id);
+    if (it == this->streams.end()) {
+        return;
+    }
+    if (it->second.responded) {
+        this->completed++;
+    }
+    this->streams.erase(it);
+}
+
+void Http2Session::unblock_stream(uint32_t stream_id, Stream& stream)
+{
+    if (stream.blocked && stream.send_window > 0) {
+        stream.blocked = false;
+        this->ready.push_back(stream_id);
+    }
+}
+
+void Http2Session::feed(std::string& input, std::vector<Http2Request>& requests)
+{
+    if (this->going_away) {
+        input.clear();
+        return;
+    }
+
+    size_t pos = 0;
+    if (!this->preface_received) {
+        size_t length = std::min(input.size(), CLIENT_PREFACE_SIZE);
+        if (input.compare(0, length, CLIENT_PREFACE, length) != 0) {
+            throw Http2Exception("invalid connection preface", HTTP2_ERR_PROTOCOL);
+        }
+        if (length < CLIENT_PREFACE_SIZE) {
+            return;
+        }
+        this->preface_received = true;
+        pos = CLIENT_PREFACE_SIZE;
+    }
+
+    while (!this->going_away && input.size() - pos >= Http2FrameHeader::SIZE) {
+        Http2FrameHeader header = Http2FrameHeader::parse(input.data() + pos);
+        if (header.length > DEFAULT_MAX_FRAME_SIZE) {
+            throw Http2Exception("frame too large", HTTP2_ERR_FRAME_SIZE);
+        }
+        if (input.size() - pos - Http2FrameHeader::SIZE < header.length) {
+            break;
+        }
+
+        const char *payload = input.data() + pos + Http2FrameHeader::SIZE;
+        try {
+            handle_frame(header, payload, requests);
+        } catch (const Http2Exception& e) {
+            if (e.get_stream_id() == 0) {
+                throw;
+            }
+            LOG_DEBUG("HTTP/2 stream %u reset: %s", e.get_stream_id(), e.what());
+            reset_stream(e.get_stream_id(), e.get_error_code());
+        }
+        pos += Http2FrameHeader::SIZE + header.length;
+    }
+    input.erase(0, pos);
+}
+
+void Http2Session::handle_frame(const Http2FrameHeader& header, const char *payload,
+    std::vector<Http2Request>& requests)
+{
+    if (!this->settings_received && header.type != HTTP2_FRAME_SETTINGS) {
+        throw Http2Exception("first frame is not SETTINGS", HTTP2_ERR_PROTOCOL);
+    }
+    if (this->continuation_stream != 0 &&
+        (header.type != HTTP2_FRAME_CONTINUATION || header.stream_id != this->continuation_stream)) {
+        throw Http2Exception("header block interrupted", HTTP2_ERR_PROTOCOL);
+    }
+
+    switch (header.type) {
+        case HTTP2_FRAME_DATA:
+            handle_data(header, payload);
+            break;
+        case HTTP2_FRAME_HEADERS:
+            handle_headers(header, payload, requests);
+            break;
+        case HTTP2_FRAME_CONTINUATION:
+            handle_continuation(header, payload, requests);
+            break;
+        case HTTP2_FRAME_SETTINGS:
+            handle_settings(header, payload);
+            break;
+        case HTTP2_FRAME_WINDOW_UPDATE:
+            handle_window_update(header, payload);
+            break;
+        case HTTP2_FRAME_RST_STREAM:
+            handle_rst_stream(header, payload);
+            break;
+        case HTTP2_FRAME_PRIORITY:
+            // 不按优先级调度，各流平等轮转
+            if (header.stream_id == 0) {
+                throw Http2Exception("PRIORITY on stream 0", HTTP2_ERR_PROTOCOL);
+            }
+            if (header.length != 5) {
+                throw Http2Exception("invalid PRIORITY size", HTTP2_ERR_FRAME_SIZE, header.stream_id);
+            }
+            break;
+        case HTTP2_FRAME_PING:
+            if (header.stream_id != 0) {
+                throw Http2Exception("PING on a stream", HTTP2_ERR_PROTOCOL);
+            }
+            if (header.length != 8) {
+                throw Http2Exception("invalid PING size", HTTP2_ERR_FRAME_SIZE);
+            }
+            if ((header.flags & HTTP2_FLAG_ACK) == 0) {
+                append_frame(HTTP2_FRAME_PING, HTTP2_FLAG_ACK, 0, std::string(payload, header.length));
+            }
+            break;
+        case HTTP2_FRAME_GOAWAY:
+            if (header.stream_id != 0) {
+                throw Http2Exception("GOAWAY on a stream", HTTP2_ERR_PROTOCOL);
+            }
+            if (header.length < 8) {
+                throw Http2Exception("invalid GOAWAY size", HTTP2_ERR_FRAME_SIZE);
+            }
+            // 已开启的流照常完成，全部结束后关闭连接
+            this->peer_going_away = true;
+            LOG_DEBUG("HTTP/2 peer is going away, error code %u", read_uint32(payload + 4));
+            break;
+        case HTTP2_FRAME_PUSH_PROMISE:
+            throw Http2Exception("PUSH_PROMISE from client", HTTP2_ERR_PROTOCOL);
+        default:
+            // 未知类型的帧须忽略
+            break;
+    }
+}
+
+// 本端不接收请求体，收到的数据立即归还流量控制额度
+void Http2Session::handle_data(const Http2FrameHeader& header, const char *payload)
+{
+    if (header.stream_id == 0) {
+        throw Http2Exception("DATA on stream 0", HTTP2_ERR_PROTOCOL);
+    }
+    if (header.stream_id > this->last_stream_id) {
+        throw Http2Exception("DATA on idle stream", HTTP2_ERR_PROTOCOL);
+    }
+
+    size_t length = 0;
+    strip_padding(header, payload, length);
+    if (header.length > 0) {
+        append_window_update(0, header.length);
+    }
+
+    auto it = this->streams.find(header.stream_id);
+    if (it == this->streams.end() || it->second.remote_closed) {
+        throw Http2Exception("DATA on closed stream", HTTP2_ERR_STREAM_CLOSED, header.stream_id);
+    }
+    if (header.flags & HTTP2_FLAG_END_STREAM) {
+        it->second.remote_closed = true;
+    } else if (header.length > 0) {
+        append_window_update(header.stream_id, header.length);
+    }
+}
+
+void Http2Session::handle_headers(const Http2FrameHeader& header, const char *payload,
+    std::vector<Http2Request>& requests)
+{
+    if (header.stream_id == 0 || header.stream_id % 2 == 0) {
+        throw Http2Exception("invalid stream identifier", HTTP2_ERR_PROTOCOL);
+    }
+
+    size_t length = 0;
+    strip_padding(header, payload, length);
+    if (header.flags & HTTP2_FLAG_PRIORITY) {
+        if (length < 5) {
+            throw Http2Exception("invalid HEADERS size", HTTP2_ERR_FRAME_SIZE);
+        }
+        payload += 5;
+        length -= 5;
+    }
+
+    bool end_stream = (header.flags & HTTP2_FLAG_END_STREAM) != 0;
+    this->header_block.assign(payload, length);
+    if ((header.flags & HTTP2_FLAG_END_HEADERS) == 0) {
+        this->continuation_stream = header.stream_id;
+        this->continuation_end_stream = end_stream;
+        return;
+    }
+    end_headers(header.stream_id, end_stream, requests);
+}
+
+void Http2Session::handle_continuation(const Http2FrameHeader& header, const char *payload,
+    std::vector<Http2Request>& requests)
+{
+    if (this->continuation_stream == 0) {
+        throw Http2Exception("unexpected CONTINUATION", HTTP2_ERR_PROTOCOL);
+    }
+    this->header_block.append(payload, header.length);
+    if (this->header_block.size() > MAX_HEADER_BLOCK_SIZE) {
+        throw Http2Exception("header block too large", HTTP2_ERR_ENHANCE_YOUR_CALM);
+    }
+    if (header.flags & HTTP2_FLAG_END_HEADERS) {
+        end_headers(header.stream_id, this->continuation_end_stream, requests);
+    }
+}
+
+// 头部块收齐后解码；解码失败会破坏HPACK状态，属于连接错误，其余校验失败只重置该流
+void Http2Session::end_headers(uint32_t stream_id, bool end_stream, std::vector<Http2Request>& requests)
+{
+    std::string block = std::move(this->header_block);
+    this->header_block.clear();
+    this->continuation_stream = 0;
+    std::vector<HpackHeader> headers = this->decoder.decode(block);
+
+    if (stream_id <= this->last_stream_id) {
+        // 已开启的流上的第二个头部块只能是携带END_STREAM的trailer，内容忽略
+        auto it = this->streams.find(stream_id);
+        if (it == this->streams.end() || it->second.remote_closed) {
+            throw Http2Exception("HEADERS on closed stream", HTTP2_ERR_STREAM_CLOSED);
+        }
+        if (!end_stream) {
+            throw Http2Exception("trailers without END_STREAM", HTTP2_ERR_PROTOCOL, stream_id);
+        }
+        it->second.remote_closed = true;
+        return;
+    }
+
+    this->last_stream_id = stream_id;
+    if (this->streams.size() >= MAX_CONCURRENT_STREAMS) {
+        throw Http2Exception("too many concurrent streams", HTTP2_ERR_REFUSED_STREAM, stream_id);
+    }
+    std::string head = build_request_head(headers, stream_id);
+
+    Stream& stream = this->streams[stream_id];
+    stream.send_window = this->peer_initial_window;
+    stream.remote_closed = end_stream;
+    requests.push_back({ stream_id, std::move(head) });
+}
+
+void Http2Session::handle_settings(const Http2FrameHeader& header, const char *payload)
+{
+    if (header.stream_id != 0) {
+        throw Http2Exception("SETTINGS on a stream", HTTP2_ERR_PROTOCOL);
+    }
+    if (header.flags & HTTP2_FLAG_ACK) {
+        if (header.length != 0) {
+            throw Http2Exception("SETTINGS ack with payload", HTTP2_ERR_FRAME_SIZE);
+        }
+        return;
+    }
+    if (header.length % 6 != 0) {
+        throw Http2Exception("invalid SETTINGS size", HTTP2_ERR_FRAME_SIZE);
+    }
+
+    apply_settings(payload, header.length);
+    this->settings_received = true;
+    append_frame(HTTP2_FRAME_SETTINGS, HTTP2_FLAG_ACK, 0, "");
+}
+
+void Http2Session::apply_settings(const char *payload, size_t length)
+{
+    for (size_t pos = 0; pos + 6 <= length; pos += 6) {
+        uint16_t id = static_cast<uint16_t>((static_cast<uint8_t>(payload[pos]) << 8) |
+            static_cast<uint8_t>(payload[pos + 1]));
+        uint32_t value = read_uint32(payload + pos + 2);
+
+        switch (id) {
+            case HTTP2_SETTINGS_HEADER_TABLE_SIZE:
+                this->encoder.set_max_table_size(value);
+                break;
+            case HTTP2_SETTINGS_ENABLE_PUSH:
+                if (value > 1) {
+                    throw Http2Exception("invalid ENABLE_PUSH", HTTP2_ERR_PROTOCOL);
+                }
+                break;
+            case HTTP2_SETTINGS_INITIAL_WINDOW_SIZE: {
+                if (value > MAX_WINDOW_SIZE) {
+                    throw Http2Exception("invalid INITIAL_WINDOW_SIZE", HTTP2_ERR_FLOW_CONTROL);
+                }
+                // 初始窗口的变化作用于所有已开启的流
+                int64_t delta = static_cast<int64_t>(value) - this->peer_initial_window;
+                for (auto& [stream_id, stream] : this->streams) {
+                    stream.send_window += delta;
+                    if (stream.send_window > MAX_WINDOW_SIZE) {
+                        throw Http2Exception("stream window overflow", HTTP2_ERR_FLOW_CONTROL);
+                    }
+                    unblock_stream(stream_id, stream);
+                }
+                this->peer_initial_window = value;
+                break;
+            }
+            case HTTP2_SETTINGS_MAX_FRAME_SIZE:
+                if (value < DEFAULT_MAX_FRAME_SIZE || value > 0xffffff) {
+                    throw Http2Exception("invalid MAX_FRAME_SIZE", HTTP2_ERR_PROTOCOL);
+                }
+                this->peer_max_frame_size = value;
+                break;
+            default:
+                // 本端不推送，其余设置不影响发送
+                break;
+        }
+    }
+}
+
+void Http2Session::handle_window_update(const Http2FrameHeader& header, const char *payload)
+{
+    if (header.length != 4) {
+        throw Http2Exception("invalid WINDOW_UPDATE size", HTTP2_ERR_FRAME_SIZE);
+    }
+    uint32_t increment = read_uint32(payload) & 0x7fffffff;
+    if (increment == 0) {
+        throw Http2Exception("zero window increment", HTTP2_ERR_PROTOCOL, header.stream_id);
+    }
+
+    if (header.stream_id == 0) {
+        this->send_window += increment;
+        if (this->send_window > MAX_WINDOW_SIZE) {
+            throw Http2Exception("connection window overflow", HTTP2_ERR_FLOW_CONTROL);
+        }
+        return;
+    }
+
+    // 已结束的流可能仍会收到WINDOW_UPDATE，忽略即可
+    auto it = this->streams.find(header.stream_id);
+    if (it == this->streams.end()) {
+        return;
+    }
+    it->second.send_window += increment;
+    if (it->second.send_window > MAX_WINDOW_SIZE) {
+        throw Http2Exception("stream window overflow", HTTP2_ERR_FLOW_CONTROL, header.stream_id);
+    }
+    unblock_stream(header.stream_id, it->second);
+}
+
+void Http2Session::handle_rst_stream(const Http2FrameHeader& header, const char *payload)
+{
+    if (header.length != 4) {
+        throw Http2Exception("invalid RST_STREAM size", HTTP2_ERR_FRAME_SIZE);
+    }
+    if (header.stream_id == 0 || header.stream_id > this->last_stream_id) {
+        throw Http2Exception("RST_STREAM on idle stream", HTTP2_ERR_PROTOCOL);
+    }
+    LOG_DEBUG("HTTP/2 stream %u reset by peer, error code %u", header.stream_id, read_uint32(payload));
+    finish_stream(header.stream_id);
+}
+
+// 把请求头部转换为HTTP/1.1请求头；字段值中的CR、LF会改变转换结果，按RFC 7540 10.3视为格式错误
+std::string Http2Session::build_request_head(const std::vector<HpackHeader>& headers, uint32_t stream_id)
+{
+    std::string method;
+    std::string path;
+    std::string authority;
+    std::string fields;
+    bool regular_seen = false;
+
+    for (const HpackHeader& header : headers) {
+        bool valid = !header.name.empty() &&
+            std::none_of(header.name.begin(), header.name.end(), [](char c) {
+                return std::isupper(static_cast<unsigned char>(c)) || c == '\r' || c == '\n' || c == '\0';
+            }) &&
+            header.value.find_first_of(std::string("\r\n\0", 3)) == std::string::npos;
+        if (!valid) {
+            throw Http2Exception("malformed header field", HTTP2_ERR_PROTOCOL, stream_id);
+        }
+
+        if (header.name[0] == ':') {
+            std::string *target = nullptr;
+            if (header.name == ":method") {
+                target = &method;
+            } else if (header.name == ":path") {
+                target = &path;
+            } else if (header.name == ":authority") {
+                target = &authority;
+            } else if (header.name != ":scheme") {
+                throw Http2Exception("unknown pseudo header", HTTP2_ERR_PROTOCOL, stream_id);
+            }
+            if (regular_seen || (target != nullptr && !target->empty())) {
+                throw Http2Exception("misplaced pseudo header", HTTP2_ERR_PROTOCOL, stream_id);
+            }
+            if (target != nullptr) {
+                *target = header.value;
+            }
+            continue;
+        }
+
+        regular_seen = true;
+        if (header.name == "connection" || header.name == "keep-alive" || header.name == "proxy-connection" ||
+            header.name == "transfer-encoding" || header.name == "upgrade" ||
+            (header.name == "te" && header.value != "trailers")) {
+            throw Http2Exception("connection-specific header", HTTP2_ERR_PROTOCOL, stream_id);
+        }
+        if (header.name == "host" && !authority.empty()) {
+            continue;
+        }
+        fields += header.name + ": " + header.value + "\r\n";
+    }
+
+    if (method.empty() || path.empty()) {
+        throw Http2Exception("missing pseudo header", HTTP2_ERR_PROTOCOL, stream_id);
+    }
+    return method + " " + path + " HTTP/1.1\r\n" +
+        (authority.empty() ? "" : "Host: " + authority + "\r\n") + fields + "\r\n";
+}
+
+// 解析HTTP/1.1响应头为HTTP/2头部：状态码转为:status，字段名转为小写，去掉逐跳字段
+bool Http2Session::parse_response_head(const std::string& head, std::vector<HpackHeader>& headers)
+{
+    size_t line_end = head.find("\r\n");
+    size_t space = head.find(' ');
+    if (head.compare(0, 5, "HTTP/") != 0 || space == std::string::npos || space + 4 > line_end) {
+        return false;
+    }
+    headers.push_back({ ":status", head.substr(space + 1, 3) });
+
+    for (size_t start = line_end + 2; start < head.size(); ) {
+        size_t end = head.find("\r\n", start);
+        if (end == std::string::npos || end == start) {
+            break;
+        }
+        size_t colon = head.find(':', start);
+        if (colon == std::string::npos || colon > end) {
+            return false;
+        }
+
+        std::string name = head.substr(start, colon - start);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        size_t value_start = head.find_first_not_of(" \t", colon + 1);
+        std::string value = value_start < end ? head.substr(value_start, end - value_start) : "";
+        start = end + 2;
+
+        if (name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+            name == "transfer-encoding" || name == "upgrade") {
+            continue;
+        }
+        headers.push_back({ std::move(name), std::move(value) });
+    }
+    return true;
+}
+
+bool Http2Session::submit_response(uint32_t stream_id, std::unique_ptr<HttpTransfer> response)
+{
+    auto it = this->streams.find(stream_id);
+    if (this->going_away || it == this->streams.end() || it->second.responded) {
+        return false;
+    }
+
+    Stream& stream = it->second;
+    std::string head;
+    if (!response->take_head(head) || !parse_response_head(head, stream.response_headers)) {
+        LOG_ERR("HTTP/2 stream %u got a malformed response", stream_id);
+        reset_stream(stream_id, HTTP2_ERR_INTERNAL);
+        return false;
+    }
+    stream.body = std::move(response);
+    stream.responded = true;
+    this->ready.push_back(stream_id);
+    return true;
+}
+
+// HPACK编码后按对端的最大帧大小切分为HEADERS与CONTINUATION
+void Http2Session::write_headers(uint32_t stream_id, Stream& stream, bool end_stream, HttpTransfer& out)
+{
+    std::string block;
+    this->encoder.encode(stream.response_headers, block);
+    stream.response_headers.clear();
+
+    std::string frames;
+    size_t pos = 0;
+    do {
+        size_t length = std::min(block.size() - pos, static_cast<size_t>(this->peer_max_frame_size));
+        Http2FrameHeader header;
+        header.length = static_cast<uint32_t>(length);
+        header.type = pos == 0 ? HTTP2_FRAME_HEADERS : HTTP2_FRAME_CONTINUATION;
+        header.flags = (pos + length == block.size() ? HTTP2_FLAG_END_HEADERS : 0) |
+            (pos == 0 && end_stream ? HTTP2_FLAG_END_STREAM : 0);
+        header.stream_id = stream_id;
+        header.serialize(frames);
+        frames.append(block, pos, length);
+        pos += length;
+    } while (pos < block.size());
+
+    out.add_buffer(std::move(frames));
+    stream.headers_sent = true;
+}
+
+std::unique_ptr<HttpTransfer> Http2Session::next_output()
+{
+    auto out = std::make_unique<HttpTransfer>();
+    size_t batch = 0;
+    if (!this->control.empty()) {
+        batch += this->control.size();
+        out->add_buffer(std::move(this->control));
+        this->control.clear();
+    }
+
+    // 每轮依次给每个流至多一个DATA帧，直到本批已满或所有流都受窗口限制
+    bool progress = true;
+    while (progress && batch < OUTPUT_BATCH_SIZE) {
+        progress = false;
+        for (size_t count = this->ready.size(); count > 0 && batch < OUTPUT_BATCH_SIZE; count--) {
+            uint32_t stream_id = this->ready.front();
+            this->ready.pop_front();
+            auto it = this->streams.find(stream_id);
+            if (it == this->streams.end() || it->second.blocked) {
+                continue;
+            }
+
+            Stream& stream = it->second;
+            off_t remaining = stream.body->get_remaining();
+            if (!stream.headers_sent) {
+                write_headers(stream_id, stream, remaining == 0, *out);
+                progress = true;
+            }
+
+            int64_t length = std::min({ static_cast<int64_t>(remaining),
+                static_cast<int64_t>(this->peer_max_frame_size), stream.send_window, this->send_window });
+            if (length > 0) {
+                Http2FrameHeader header;
+                header.length = static_cast<uint32_t>(length);
+                header.type = HTTP2_FRAME_DATA;
+                header.flags = length == remaining ? HTTP2_FLAG_END_STREAM : 0;
+                header.stream_id = stream_id;
+                std::string frame_header;
+                header.serialize(frame_header);
+                out->add_buffer(std::move(frame_header));
+                // 帧内容直接引用响应的内存段或文件段
+                stream.body->move_front(*out, static_cast<off_t>(length));
+
+                stream.send_window -= length;
+                this->send_window -= length;
+                remaining -= static_cast<off_t>(length);
+                batch += Http2FrameHeader::SIZE + static_cast<size_t>(length);
+                progress = true;
+            }
+
+            if (remaining == 0) {
+                finish_stream(stream_id);
+            } else if (stream.send_window <= 0) {
+                stream.blocked = true;
+            } else {
+                this->ready.push_back(stream_id);
+            }
+        }
+    }
+
+    if (out->done()) {
+        return nullptr;
+    }
+    return out;
+}
+
+bool Http2Session::has_output() const
+{
+    if (!this->control.empty()) {
+        return true;
+    }
+    for (uint32_t stream_id : this->ready) {
+        auto it = this->streams.find(stream_id);
+        if (it != this->streams.end() && !it->second.blocked &&
+            (!it->second.headers_sent || this->send_window > 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Http2Session::go_away(Http2ErrorCode error_code)
+{
+    if (this->going_away) {
+        return;
+    }
+    std::string payload;
+    append_uint32(payload, this->last_stream_id);
+    append_uint32(payload, error_code);
+    append_frame(HTTP2_FRAME_GOAWAY, 0, 0, payload);
+
+    for (const auto& [stream_id, stream] : this->streams) {
+        if (stream.responded) {
+            this->completed++;
+        }
+    }
+    this->streams.clear();
+    this->ready.clear();
+    this->going_away = true;
+}
+
+bool Http2Session::is_finished() const
+{
+    return this->control.empty() && (this->going_away || (this->peer_going_away && this->streams.empty()));
+}
+
+size_t Http2Session::take_completed()
+{
+    size_t count = this->completed;
+    this->completed = 0;
+    return count;
+}
+
+size_t Http2Session::get_pending_responses() const
+{
+    size_t count = 0;
+    for (const auto& [stream_id, stream] : this->streams) {
+        if (stream.responded) {
+            count++;
+        }
+    }
+    return count;
+}
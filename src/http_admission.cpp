@@ -0,0 +1,120 @@
+#include "http_admission.hpp"
+
+void HttpAdmissionControl::configure(size_t max_queued, std::chrono::milliseconds max_queue_wait)
+{
+    this->max_queued = max_queued;
+    this->max_queue_wait_us = std::chrono::duration_cast<std::chrono::microseconds>(max_queue_wait).count();
+}
+
+bool HttpAdmissionControl::try_admit()
+{
+    size_t limit = this->max_queued.load(std::memory_order_relaxed);
+    size_t current = this->queued.load();
+    do {
+        if (limit != 0 && current >= limit) {
+            this->rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!this->queued.compare_exchange_weak(current, current + 1));
+    return true;
+}
+
+void HttpAdmissionControl::cancel()
+{
+    this->queued.fetch_sub(1);
+    this->rejected.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 排队数的增减与读取使用顺序一致的内存序：reactor登记暂停后再检查排队数，工作线程归还名额后再检查暂停标志，
+// 两者至少有一方能看到对方的修改，不会出现暂停后无人恢复的情况
+bool HttpAdmissionControl::begin(std::chrono::steady_clock::time_point enqueued)
+{
+    this->queued.fetch_sub(1);
+
+    int64_t waited = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - enqueued).count();
+    uint64_t wait_us = waited > 0 ? static_cast<uint64_t>(waited) : 0;
+
+    size_t bucket = 0;
+    while (bucket + 1 < WAIT_BUCKETS && (wait_us >> (bucket + 1)) != 0) {
+        bucket++;
+    }
+    this->wait_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    this->total_wait_us.fetch_add(wait_us, std::memory_order_relaxed);
+    uint64_t longest = this->max_wait_us.load(std::memory_order_relaxed);
+    while (wait_us > longest && !this->max_wait_us.compare_exchange_weak(longest, wait_us,
+        std::memory_order_relaxed)) {
+    }
+
+    int64_t deadline = this->max_queue_wait_us.load(std::memory_order_relaxed);
+    if (deadline > 0 && waited > deadline) {
+        this->expired.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    this->admitted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool HttpAdmissionControl::should_pause() const
+{
+    size_t limit = this->max_queued.load(std::memory_order_relaxed);
+    if (limit == 0) {
+        return false;
+    }
+    size_t high = limit - limit / 4;
+    return this->queued.load() >= high;
+}
+
+bool HttpAdmissionControl::should_resume() const
+{
+    size_t limit = this->max_queued.load(std::memory_order_relaxed);
+    return this->queued.load() <= limit / 2;
+}
+
+void HttpAdmissionControl::record_pause()
+{
+    this->pauses.fetch_add(1, std::memory_order_relaxed);
+}
+
+// 返回累计占比首次达到ratio的桶的上界
+uint64_t HttpAdmissionControl::wait_percentile(const std::array<uint64_t, WAIT_BUCKETS>& counts, uint64_t total,
+    double ratio) const
+{
+    if (total == 0) {
+        return 0;
+    }
+    uint64_t target = static_cast<uint64_t>(static_cast<double>(total) * ratio);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < WAIT_BUCKETS; i++) {
+        seen += counts[i];
+        if (seen > target || seen == total) {
+            return (uint64_t(1) << (i + 1)) - 1;
+        }
+    }
+    return this->max_wait_us.load(std::memory_order_relaxed);
+}
+
+HttpAdmissionStats HttpAdmissionControl::get_stats() const
+{
+    HttpAdmissionStats stats;
+    stats.admitted = this->admitted.load(std::memory_order_relaxed);
+    stats.rejected = this->rejected.load(std::memory_order_relaxed);
+    stats.expired = this->expired.load(std::memory_order_relaxed);
+    stats.pauses = this->pauses.load(std::memory_order_relaxed);
+    stats.queued = this->queued.load(std::memory_order_relaxed);
+    stats.max_wait_us = this->max_wait_us.load(std::memory_order_relaxed);
+
+    std::array<uint64_t, WAIT_BUCKETS> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < WAIT_BUCKETS; i++) {
+        counts[i] = this->wait_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total > 0) {
+        stats.mean_wait_us = static_cast<double>(this->total_wait_us.load(std::memory_order_relaxed)) /
+            static_cast<double>(total);
+    }
+    stats.p50_wait_us = wait_percentile(counts, total, 0.5);
+    stats.p99_wait_us = wait_percentile(counts, total, 0.99);
+    return stats;
+}
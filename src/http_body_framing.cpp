@@ -0,0 +1,122 @@
+#include <charconv>
+#include <string_view>
+
+#include "tcp_public.hpp"
+#include "http_body_framing.hpp"
+#include "http_request.hpp"
+
+HttpBodyFraming::HttpBodyFraming(HttpBodyMode mode, uint64_t length) : mode(mode)
+{
+    switch (mode) {
+        case HTTP_BODY_LENGTH:
+            this->remaining = length;
+            this->declared = length;
+            this->state = length == 0 ? STATE_DONE : STATE_DATA;
+            break;
+        case HTTP_BODY_CHUNKED:
+            this->state = STATE_CHUNK_SIZE;
+            break;
+        case HTTP_BODY_CLOSE:
+            this->remaining = UINT64_MAX;
+            break;
+    }
+}
+
+uint64_t HttpBodyFraming::get_data_remaining() const
+{
+    return this->state == STATE_DATA ? this->remaining : 0;
+}
+
+void HttpBodyFraming::consume_data(uint64_t length)
+{
+    if (this->mode == HTTP_BODY_CLOSE) {
+        return;
+    }
+    this->remaining -= length;
+    if (this->remaining == 0) {
+        this->state = this->mode == HTTP_BODY_LENGTH ? STATE_DONE : STATE_CHUNK_END;
+    }
+}
+
+// 处理一行完整的分块长度、分块结尾或trailer，行内容不含CRLF
+void HttpBodyFraming::parse_line()
+{
+    if (this->state == STATE_CHUNK_END) {
+        if (!this->line.empty()) {
+            throw HttpRequestException("missing CRLF after chunk data", HTTP_ERR_BAD_REQUEST);
+        }
+        this->state = STATE_CHUNK_SIZE;
+        return;
+    }
+    if (this->state == STATE_TRAILER) {
+        // trailer字段不影响消息体的内容，直接忽略
+        if (this->line.empty()) {
+            this->state = STATE_DONE;
+        }
+        return;
+    }
+
+    // 分块长度为十六进制，其后可能带有以分号开始的扩展
+    std::string_view size_text = std::string_view(this->line).substr(0, this->line.find(';'));
+    while (!size_text.empty() && (size_text.back() == ' ' || size_text.back() == '\t')) {
+        size_text.remove_suffix(1);
+    }
+    uint64_t size = 0;
+    std::from_chars_result result = std::from_chars(size_text.data(), size_text.data() + size_text.size(), size, 16);
+    if (size_text.empty() || result.ec != std::errc() || result.ptr != size_text.data() + size_text.size() ||
+        size > UINT64_MAX - this->declared) {
+        throw HttpRequestException("invalid chunk size: " + this->line, HTTP_ERR_BAD_REQUEST);
+    }
+
+    this->declared += size;
+    this->remaining = size;
+    this->state = size == 0 ? STATE_TRAILER : STATE_DATA;
+}
+
+size_t HttpBodyFraming::feed(const char *data, size_t length)
+{
+    size_t pos = 0;
+    while (pos < length && this->state != STATE_DATA && this->state != STATE_DONE) {
+        char c = data[pos++];
+        if (c != '\n') {
+            if (this->line.size() >= MAX_LINE_SIZE) {
+                throw HttpRequestException("chunk line too long", HTTP_ERR_BAD_REQUEST);
+            }
+            this->line.push_back(c);
+            continue;
+        }
+        if (this->line.empty() || this->line.back() != '\r') {
+            throw HttpRequestException("chunk line not terminated by CRLF", HTTP_ERR_BAD_REQUEST);
+        }
+        this->line.pop_back();
+        parse_line();
+        this->line.clear();
+    }
+    return pos;
+}
+
+void HttpBodyFraming::finish()
+{
+    if (this->mode == HTTP_BODY_CLOSE) {
+        this->state = STATE_DONE;
+        return;
+    }
+    if (this->state != STATE_DONE) {
+        throw TcpRuntimeException("message body is truncated", __FILENAME__, __LINE__);
+    }
+}
+
+bool HttpBodyFraming::is_done() const
+{
+    return this->state == STATE_DONE;
+}
+
+HttpBodyMode HttpBodyFraming::get_mode() const
+{
+    return this->mode;
+}
+
+uint64_t HttpBodyFraming::get_declared() const
+{
+    return this->declared;
+}
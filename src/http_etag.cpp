@@ -0,0 +1,135 @@
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+}
+
+#include <sstream>
+
+#include "tcp_public.hpp"
+#include "http_etag.hpp"
+
+void HttpEtagGenerator::set_mode(HttpEtagMode mode)
+{
+    this->mode = mode;
+}
+
+// 以FNV-1a计算文件内容的64位哈希，同一文件在mtime和大小不变时只计算一次
+uint64_t HttpEtagGenerator::content_hash(const std::string& full_path, const struct stat& file_stat)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->hash_mutex);
+        auto it = this->hashes.find(full_path);
+        if (it != this->hashes.end() && it->second.size == file_stat.st_size &&
+            it->second.mtime.tv_sec == file_stat.st_mtim.tv_sec &&
+            it->second.mtime.tv_nsec == file_stat.st_mtim.tv_nsec) {
+            return it->second.hash;
+        }
+    }
+
+    int file_fd = open(full_path.c_str(), O_RDONLY);
+    if (file_fd < 0) {
+        throw TcpRuntimeException("Open file failed", __FILENAME__, __LINE__);
+    }
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    char buf[64 * 1024];
+    for (;;) {
+        ssize_t len = read(file_fd, buf, sizeof(buf));
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len < 0) {
+            close(file_fd);
+            throw TcpRuntimeException("Read file failed", __FILENAME__, __LINE__);
+        }
+        if (len == 0) {
+            break;
+        }
+        hash = fnv1a(hash, buf, static_cast<size_t>(len));
+    }
+    close(file_fd);
+
+    std::lock_guard<std::mutex> lock(this->hash_mutex);
+    if (this->hashes.size() >= MAX_HASH_ENTRIES) {
+        this->hashes.clear(); // 简单限制规模，清空后按需重新计算
+    }
+    this->hashes[full_path] = HashEntry{file_stat.st_size, file_stat.st_mtim, hash};
+    return hash;
+}
+
+uint64_t HttpEtagGenerator::fnv1a(uint64_t hash, const char *data, size_t length)
+{
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::string HttpEtagGenerator::make_content_etag(off_t size, uint64_t hash)
+{
+    char etag[64] = {0};
+    snprintf(etag, sizeof(etag), "\"%lx-%016lx\"", static_cast<unsigned long>(size), static_cast<unsigned long>(hash));
+    return etag;
+}
+
+HttpValidators HttpEtagGenerator::make_validators(const std::string& full_path, const struct stat& file_stat)
+{
+    if (this->mode == HTTP_ETAG_CONTENT_HASH) {
+        return HttpValidators{make_content_etag(file_stat.st_size, content_hash(full_path, file_stat)),
+            format_http_date(file_stat.st_mtim.tv_sec), file_stat.st_mtim.tv_sec};
+    }
+
+    char etag[64] = {0};
+    uint64_t mtime_ns = static_cast<uint64_t>(file_stat.st_mtim.tv_sec) * 1000000000ULL +
+        static_cast<uint64_t>(file_stat.st_mtim.tv_nsec);
+    snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx\"",
+        static_cast<unsigned long>(file_stat.st_ino),
+        static_cast<unsigned long>(file_stat.st_size),
+        static_cast<unsigned long>(mtime_ns));
+    return HttpValidators{etag, format_http_date(file_stat.st_mtim.tv_sec), file_stat.st_mtim.tv_sec};
+}
+
+// e.g. Sun, 06 Nov 1994 08:49:37 GMT
+std::string HttpEtagGenerator::format_http_date(time_t t)
+{
+    struct tm tm_buf;
+    char buf[64] = {0};
+    gmtime_r(&t, &tm_buf);
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_buf);
+    return std::string(buf);
+}
+
+bool HttpEtagGenerator::parse_http_date(const std::string& date, time_t& t)
+{
+    struct tm tm_buf = {};
+    const char *end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &tm_buf);
+    if (end == nullptr) {
+        return false;
+    }
+    t = timegm(&tm_buf);
+    return true;
+}
+
+bool HttpEtagGenerator::etag_matches(const std::string& header, const std::string& etag, bool weak)
+{
+    std::stringstream ss(header);
+    std::string candidate;
+    while (std::getline(ss, candidate, ',')) {
+        candidate.erase(0, candidate.find_first_not_of(' '));
+        candidate.erase(candidate.find_last_not_of(' ') + 1);
+        if (candidate == "*") {
+            return true;
+        }
+        if (candidate.compare(0, 2, "W/") == 0) {
+            if (!weak) {
+                continue; // 强比较时弱ETag永不匹配
+            }
+            candidate = candidate.substr(2);
+        }
+        if (candidate == etag) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,179 @@
+extern "C" {
+#include <sys/stat.h>
+}
+
+#include <algorithm>
+#include <functional>
+
+#include "tcp_public.hpp"
+#include "http_file_cache.hpp"
+
+HttpFileCache::HttpFileCache(size_t capacity, off_t max_file_size) :
+    capacity(capacity), max_file_size(max_file_size)
+{
+    // sketch宽度按容量可容纳的条目数估算，取2的幂便于用掩码取模
+    size_t width = 1024;
+    while (width < capacity / 1024 && width < (1u << 20)) {
+        width <<= 1;
+    }
+    this->sketch.assign(width * SKETCH_DEPTH, 0);
+    this->sketch_mask = width - 1;
+    this->sketch_reset_threshold = static_cast<uint32_t>(width * 10);
+}
+
+size_t HttpFileCache::entry_cost(const HttpCacheEntry& entry)
+{
+    return entry.headers.size() + entry.body.size() + entry.full_path.size() + sizeof(HttpCacheEntry);
+}
+
+size_t HttpFileCache::sketch_index(size_t hash, uint32_t row) const
+{
+    // 每行使用不同的种子对hash再混合一次，近似得到相互独立的哈希函数
+    static constexpr uint64_t SEEDS[SKETCH_DEPTH] = {
+        0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL, 0xcbf29ce484222325ULL
+    };
+    uint64_t h = (static_cast<uint64_t>(hash) + SEEDS[row]) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 32;
+    return row * (this->sketch_mask + 1) + (h & this->sketch_mask);
+}
+
+void HttpFileCache::sketch_increment(const std::string& key)
+{
+    size_t hash = std::hash<std::string>{}(key);
+    for (uint32_t row = 0; row < SKETCH_DEPTH; row++) {
+        uint8_t& counter = this->sketch[sketch_index(hash, row)];
+        if (counter < SKETCH_MAX_COUNT) {
+            counter++;
+        }
+    }
+
+    // 老化：采样数达到阈值后全体计数减半
+    if (++this->sketch_samples >= this->sketch_reset_threshold) {
+        for (auto& counter : this->sketch) {
+            counter >>= 1;
+        }
+        this->sketch_samples /= 2;
+    }
+}
+
+uint8_t HttpFileCache::sketch_estimate(const std::string& key) const
+{
+    size_t hash = std::hash<std::string>{}(key);
+    uint8_t estimate = SKETCH_MAX_COUNT;
+    for (uint32_t row = 0; row < SKETCH_DEPTH; row++) {
+        estimate = std::min(estimate, this->sketch[sketch_index(hash, row)]);
+    }
+    return estimate;
+}
+
+void HttpFileCache::remove_locked(std::unordered_map<std::string, Node>::iterator it)
+{
+    this->used_bytes -= entry_cost(*it->second.entry);
+    this->lru_list.erase(it->second.lru_it);
+    this->entries.erase(it);
+}
+
+std::shared_ptr<const HttpCacheEntry> HttpFileCache::lookup(const std::string& key)
+{
+    std::shared_ptr<const HttpCacheEntry> entry;
+    {
+        std::lock_guard<std::mutex> lock(this->cache_mutex);
+        sketch_increment(key);
+
+        auto it = this->entries.find(key);
+        if (it == this->entries.end()) {
+            this->stats.misses++;
+            return nullptr;
+        }
+        entry = it->second.entry;
+    }
+
+    // stat不持锁进行，文件已被修改或删除时使条目失效
+    struct stat file_stat;
+    if (stat(entry->full_path.c_str(), &file_stat) < 0 ||
+        file_stat.st_size != entry->size ||
+        file_stat.st_mtim.tv_sec != entry->mtime.tv_sec ||
+        file_stat.st_mtim.tv_nsec != entry->mtime.tv_nsec) {
+        std::lock_guard<std::mutex> lock(this->cache_mutex);
+        auto it = this->entries.find(key);
+        if (it != this->entries.end() && it->second.entry == entry) {
+            remove_locked(it);
+        }
+        this->stats.stale++;
+        this->stats.misses++;
+        LOG_DEBUG("cache entry %s is stale", key.c_str());
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    auto it = this->entries.find(key);
+    if (it != this->entries.end()) {
+        this->lru_list.splice(this->lru_list.begin(), this->lru_list, it->second.lru_it);
+    }
+    this->stats.hits++;
+    return entry;
+}
+
+bool HttpFileCache::admit(const std::string& key, std::shared_ptr<const HttpCacheEntry> entry)
+{
+    size_t cost = entry_cost(*entry);
+    if (entry->size > this->max_file_size || cost > this->capacity) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+
+    // 已存在的条目直接替换（通常是文件被修改后的重新载入）
+    auto existing = this->entries.find(key);
+    if (existing != this->entries.end()) {
+        remove_locked(existing);
+    }
+
+    // 先确定需要淘汰哪些条目，只要有一个牺牲者比候选者更热，就拒绝准入
+    uint8_t candidate_freq = sketch_estimate(key);
+    size_t freed = 0;
+    size_t victim_count = 0;
+    for (auto it = this->lru_list.rbegin();
+         it != this->lru_list.rend() && this->used_bytes - freed + cost > this->capacity; ++it) {
+        if (sketch_estimate(*it) >= candidate_freq) {
+            this->stats.rejections++;
+            return false;
+        }
+        freed += entry_cost(*this->entries[*it].entry);
+        victim_count++;
+    }
+
+    for (size_t i = 0; i < victim_count; i++) {
+        remove_locked(this->entries.find(this->lru_list.back()));
+        this->stats.evictions++;
+    }
+
+    this->lru_list.push_front(key);
+    this->entries.emplace(key, Node{std::move(entry), this->lru_list.begin()});
+    this->used_bytes += cost;
+    this->stats.admissions++;
+    return true;
+}
+
+void HttpFileCache::invalidate(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    auto it = this->entries.find(key);
+    if (it != this->entries.end()) {
+        remove_locked(it);
+    }
+}
+
+off_t HttpFileCache::get_max_file_size() const
+{
+    return this->max_file_size;
+}
+
+HttpCacheStats HttpFileCache::get_stats() const
+{
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    HttpCacheStats result = this->stats;
+    result.entries = this->entries.size();
+    result.bytes = this->used_bytes;
+    return result;
+}
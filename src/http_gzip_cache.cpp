@@ -0,0 +1,215 @@
+extern "C" {
+#include <sys/stat.h>
+#include <zlib.h>
+}
+
+#include "tcp_public.hpp"
+#include "http_gzip_cache.hpp"
+#include "http_header_builder.hpp"
+
+HttpGzipCache::HttpGzipCache(size_t capacity, off_t max_file_size) :
+    capacity(capacity), max_file_size(max_file_size)
+{
+    this->compress_thread = std::thread(&HttpGzipCache::compress_loop, this);
+}
+
+HttpGzipCache::~HttpGzipCache()
+{
+    stop();
+}
+
+void HttpGzipCache::stop()
+{
+    this->stop_flag.store(true);
+    this->job_cv.notify_all();
+    if (this->compress_thread.joinable()) {
+        this->compress_thread.join();
+    }
+}
+
+// 文本类资源才值得压缩，图片、音视频、压缩包等本身已经压缩过
+bool HttpGzipCache::is_compressible(std::string_view mime_type)
+{
+    return mime_type.compare(0, 5, "text/") == 0 ||
+        mime_type == "application/javascript" ||
+        mime_type == "application/json" ||
+        mime_type == "application/xml" ||
+        mime_type == "image/svg+xml";
+}
+
+std::string HttpGzipCache::gzip_compress(const std::string& data, int32_t level)
+{
+    z_stream stream = {};
+    // windowBits加16表示输出gzip头尾而非zlib格式
+    if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        throw TcpRuntimeException("deflateInit2 failed", __FILENAME__, __LINE__);
+    }
+
+    std::string output(deflateBound(&stream, data.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+    stream.avail_in = static_cast<uInt>(data.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    int rc = deflate(&stream, Z_FINISH);
+    deflateEnd(&stream);
+    if (rc != Z_STREAM_END) {
+        throw TcpRuntimeException("deflate failed, rc=" + std::to_string(rc), __FILENAME__, __LINE__);
+    }
+
+    output.resize(stream.total_out);
+    return output;
+}
+
+std::shared_ptr<const HttpGzipVariant> HttpGzipCache::lookup(const std::string& full_path,
+    const struct timespec& mtime)
+{
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    auto it = this->entries.find(full_path);
+    if (it == this->entries.end()) {
+        return nullptr;
+    }
+
+    const HttpGzipVariant& variant = *it->second.variant;
+    if (variant.mtime.tv_sec != mtime.tv_sec || variant.mtime.tv_nsec != mtime.tv_nsec) {
+        return nullptr; // 源文件已变化，等待重新压缩后覆盖
+    }
+    this->lru_list.splice(this->lru_list.begin(), this->lru_list, it->second.lru_it);
+    return it->second.variant;
+}
+
+void HttpGzipCache::insert(std::shared_ptr<const HttpGzipVariant> variant)
+{
+    size_t cost = variant->headers.size() + variant->body.size() + variant->full_path.size();
+    if (cost > this->capacity) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    auto existing = this->entries.find(variant->full_path);
+    if (existing != this->entries.end()) {
+        const HttpGzipVariant& old = *existing->second.variant;
+        this->used_bytes -= old.headers.size() + old.body.size() + old.full_path.size();
+        this->lru_list.erase(existing->second.lru_it);
+        this->entries.erase(existing);
+    }
+
+    while (this->used_bytes + cost > this->capacity && !this->lru_list.empty()) {
+        auto victim = this->entries.find(this->lru_list.back());
+        const HttpGzipVariant& old = *victim->second.variant;
+        this->used_bytes -= old.headers.size() + old.body.size() + old.full_path.size();
+        this->lru_list.pop_back();
+        this->entries.erase(victim);
+    }
+
+    this->lru_list.push_front(variant->full_path);
+    this->entries.emplace(variant->full_path, Node{variant, this->lru_list.begin()});
+    this->used_bytes += cost;
+}
+
+void HttpGzipCache::schedule(const std::string& full_path, std::string_view mime_type,
+    std::string_view extra_headers, off_t size, const struct timespec& mtime)
+{
+    if (size > this->max_file_size) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->job_mutex);
+        if (this->jobs.size() >= MAX_PENDING_JOBS || this->pending_paths.count(full_path) != 0) {
+            return;
+        }
+        this->pending_paths.insert(full_path);
+        this->jobs.push(CompressJob{full_path, std::string(mime_type), std::string(extra_headers), size, mtime});
+    }
+    this->job_cv.notify_one();
+}
+
+void HttpGzipCache::run_job(const CompressJob& job)
+{
+    std::string content = read_file_content(job.full_path, job.size);
+
+    // 读取期间文件被修改则放弃，下次请求会重新调度
+    struct stat file_stat;
+    if (stat(job.full_path.c_str(), &file_stat) < 0 || file_stat.st_size != job.size ||
+        file_stat.st_mtim.tv_sec != job.mtime.tv_sec || file_stat.st_mtim.tv_nsec != job.mtime.tv_nsec) {
+        return;
+    }
+
+    auto variant = std::make_shared<HttpGzipVariant>();
+    variant->full_path = job.full_path;
+    variant->source_size = job.size;
+    variant->mtime = job.mtime;
+    variant->body = gzip_compress(content);
+    variant->beneficial = variant->body.size() < content.size();
+    if (!variant->beneficial) {
+        variant->body.clear(); // 只保留标记，避免占用缓存空间
+    }
+    HttpHeaderBuilder header;
+    header.status(200)
+        .add("Content-Type", job.mime_type)
+        .add("Content-Encoding", "gzip")
+        .add("Content-Length", static_cast<int64_t>(variant->body.size()))
+        .add("Vary", "Accept-Encoding")
+        .append(job.extra_headers)
+        .add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+    variant->headers = std::string(header.view());
+
+    LOG_DEBUG("compressed %s: %ld -> %zu bytes", job.full_path.c_str(), job.size, variant->body.size());
+    insert(std::move(variant));
+    this->compress_jobs++;
+}
+
+void HttpGzipCache::compress_loop()
+{
+    while (!this->stop_flag.load()) {
+        std::unique_lock<std::mutex> lock(this->job_mutex);
+        this->job_cv.wait(lock, [this] { return !this->jobs.empty() || this->stop_flag.load(); });
+        if (this->stop_flag.load()) {
+            break;
+        }
+
+        CompressJob job = std::move(this->jobs.front());
+        this->jobs.pop();
+        lock.unlock();
+
+        try {
+            run_job(job);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("compress %s failed: %s", job.full_path.c_str(), e.what());
+        }
+
+        lock.lock();
+        this->pending_paths.erase(job.full_path);
+    }
+}
+
+void HttpGzipCache::record_compressed(off_t identity_size, size_t encoded_size)
+{
+    this->compressed_responses++;
+    this->bytes_saved += static_cast<uint64_t>(identity_size) - encoded_size;
+}
+
+void HttpGzipCache::record_precompressed(off_t identity_size, off_t encoded_size)
+{
+    this->precompressed_responses++;
+    if (encoded_size < identity_size) {
+        this->bytes_saved += static_cast<uint64_t>(identity_size - encoded_size);
+    }
+}
+
+HttpGzipStats HttpGzipCache::get_stats() const
+{
+    HttpGzipStats stats;
+    stats.compressed_responses = this->compressed_responses.load();
+    stats.precompressed_responses = this->precompressed_responses.load();
+    stats.bytes_saved = this->bytes_saved.load();
+    stats.compress_jobs = this->compress_jobs.load();
+
+    std::lock_guard<std::mutex> lock(this->cache_mutex);
+    stats.entries = this->entries.size();
+    stats.bytes = this->used_bytes;
+    return stats;
+}
@@ -0,0 +1,189 @@
+#include <array>
+#include <charconv>
+
+#include "tcp_public.hpp"
+#include "http_header_builder.hpp"
+
+struct HttpStatusLine {
+    uint32_t code;
+    std::string_view line; // 完整的状态行，原因短语从"HTTP/1.1 xxx "之后开始
+};
+
+static constexpr size_t STATUS_PREFIX_SIZE = sizeof("HTTP/1.1 200 ") - 1;
+
+static constexpr HttpStatusLine STATUS_LINES[] = {
+    {101, "HTTP/1.1 101 Switching Protocols\r\n"},
+    {200, "HTTP/1.1 200 OK\r\n"},
+    {201, "HTTP/1.1 201 Created\r\n"},
+    {204, "HTTP/1.1 204 No Content\r\n"},
+    {206, "HTTP/1.1 206 Partial Content\r\n"},
+    {304, "HTTP/1.1 304 Not Modified\r\n"},
+    {400, "HTTP/1.1 400 Bad Request\r\n"},
+    {403, "HTTP/1.1 403 Forbidden\r\n"},
+    {404, "HTTP/1.1 404 Not Found\r\n"},
+    {405, "HTTP/1.1 405 Method Not Allowed\r\n"},
+    {411, "HTTP/1.1 411 Length Required\r\n"},
+    {413, "HTTP/1.1 413 Content Too Large\r\n"},
+    {416, "HTTP/1.1 416 Range Not Satisfiable\r\n"},
+    {500, "HTTP/1.1 500 Internal Server Error\r\n"},
+    {502, "HTTP/1.1 502 Bad Gateway\r\n"},
+    {503, "HTTP/1.1 503 Service Unavailable\r\n"},
+    {504, "HTTP/1.1 504 Gateway Timeout\r\n"},
+};
+
+struct HttpMimeType {
+    std::string_view extension; // 不含点号
+    std::string_view mime_type;
+};
+
+static constexpr HttpMimeType MIME_TYPES[] = {
+    {"html", "text/html"},
+    {"css", "text/css"},
+    {"js", "application/javascript"},
+    {"png", "image/png"},
+    {"jpg", "image/jpeg"},
+    {"gif", "image/gif"},
+    {"ico", "image/x-icon"},
+    {"svg", "image/svg+xml"},
+    {"json", "application/json"},
+    {"xml", "application/xml"},
+    {"pdf", "application/pdf"},
+    {"zip", "application/zip"},
+    {"mp4", "video/mp4"},
+    {"mkv", "video/x-matroska"},
+    {"mpeg", "video/mpeg"},
+    {"avi", "video/x-msvideo"},
+    {"webm", "video/webm"},
+    {"mp3", "audio/mpeg"},
+    {"wav", "audio/wav"},
+    {"txt", "text/plain"},
+    {"flac", "audio/flac"},
+};
+
+static constexpr size_t MIME_TYPE_COUNT = sizeof(MIME_TYPES) / sizeof(MIME_TYPES[0]);
+static constexpr size_t MIME_SLOT_COUNT = 64;
+
+static constexpr uint32_t mime_hash(std::string_view extension, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+    for (char c : extension) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+// 槽位中存放条目下标加1，0表示空槽
+struct HttpMimeIndex {
+    bool perfect;
+    uint32_t seed;
+    std::array<uint8_t, MIME_SLOT_COUNT> slots;
+};
+
+// 编译期搜索一个使所有扩展名互不冲突的种子，查表时只需一次哈希与一次比较
+static constexpr HttpMimeIndex build_mime_index()
+{
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+        HttpMimeIndex index = {true, seed, {}};
+        for (size_t i = 0; i < MIME_TYPE_COUNT && index.perfect; i++) {
+            uint8_t& slot = index.slots[mime_hash(MIME_TYPES[i].extension, seed) % MIME_SLOT_COUNT];
+            index.perfect = slot == 0;
+            slot = static_cast<uint8_t>(i + 1);
+        }
+        if (index.perfect) {
+            return index;
+        }
+    }
+    return HttpMimeIndex{false, 0, {}};
+}
+
+static constexpr HttpMimeIndex MIME_INDEX = build_mime_index();
+static_assert(MIME_INDEX.perfect, "no collision-free seed for the MIME table, enlarge MIME_SLOT_COUNT");
+
+void HttpHeaderBuilder::throw_overflow()
+{
+    throw TcpRuntimeException("response header exceeds the header buffer", __FILENAME__, __LINE__);
+}
+
+HttpHeaderBuilder& HttpHeaderBuilder::append(int64_t number)
+{
+    std::to_chars_result result = std::to_chars(this->buffer + this->length, this->buffer + CAPACITY, number);
+    if (result.ec != std::errc()) {
+        throw_overflow();
+    }
+    this->length = static_cast<size_t>(result.ptr - this->buffer);
+    return *this;
+}
+
+HttpHeaderBuilder& HttpHeaderBuilder::status(uint32_t code)
+{
+    for (const HttpStatusLine& status : STATUS_LINES) {
+        if (status.code == code) {
+            return append(status.line);
+        }
+    }
+    return append("HTTP/1.1 ").append(static_cast<int64_t>(code)).append(" \r\n");
+}
+
+// 一次检查容量后整行拷贝
+HttpHeaderBuilder& HttpHeaderBuilder::add(std::string_view name, std::string_view value)
+{
+    if (name.size() + value.size() + 4 > CAPACITY - this->length) {
+        throw_overflow();
+    }
+    copy(name);
+    copy(": ");
+    copy(value);
+    copy("\r\n");
+    return *this;
+}
+
+HttpHeaderBuilder& HttpHeaderBuilder::add(std::string_view name, int64_t value)
+{
+    return append(name).append(": ").append(value).append("\r\n");
+}
+
+HttpHeaderBuilder& HttpHeaderBuilder::add_content_range(off_t start, off_t end, off_t total)
+{
+    return append("Content-Range: bytes ").append(static_cast<int64_t>(start)).append("-")
+        .append(static_cast<int64_t>(end)).append("/").append(static_cast<int64_t>(total)).append("\r\n");
+}
+
+HttpHeaderBuilder& HttpHeaderBuilder::finish()
+{
+    return append("\r\n");
+}
+
+void HttpHeaderBuilder::clear()
+{
+    this->length = 0;
+}
+
+std::string_view HttpHeaderBuilder::view() const
+{
+    return std::string_view(this->buffer, this->length);
+}
+
+std::string_view HttpHeaderBuilder::get_status_text(uint32_t code)
+{
+    for (const HttpStatusLine& status : STATUS_LINES) {
+        if (status.code == code) {
+            std::string_view text = status.line.substr(STATUS_PREFIX_SIZE);
+            return text.substr(0, text.size() - 2);
+        }
+    }
+    return "";
+}
+
+std::string_view HttpHeaderBuilder::get_mime_type(std::string_view filepath)
+{
+    // 从文件路径获取文件扩展名
+    size_t dot_pos = filepath.find_last_of('.');
+    if (dot_pos != std::string_view::npos) {
+        std::string_view extension = filepath.substr(dot_pos + 1);
+        uint8_t slot = MIME_INDEX.slots[mime_hash(extension, MIME_INDEX.seed) % MIME_SLOT_COUNT];
+        if (slot != 0 && MIME_TYPES[slot - 1].extension == extension) {
+            return MIME_TYPES[slot - 1].mime_type;
+        }
+    }
+    return "application/octet-stream"; // 默认二进制流
+}
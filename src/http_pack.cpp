@@ -0,0 +1,236 @@
+extern "C" {
+#include <sys/mman.h>
+#include <sys/stat.h>
+}
+
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "http_pack.hpp"
+#include "http_etag.hpp"
+#include "http_gzip_cache.hpp"
+#include "http_header_builder.hpp"
+
+// 归档开头的定长文件头
+struct HttpPack::FileHeader {
+    char magic[8];           // "HTTPPACK"
+    uint32_t version;
+    uint32_t byte_order;     // 写入BYTE_ORDER_MARK，读出不等时说明归档来自字节序不同的机器
+    uint64_t index_offset;   // 索引记录数组的位置，按IndexRecord对齐
+    uint64_t strings_offset; // 字符串表的位置
+    uint64_t strings_size;
+    uint32_t record_count;
+    uint32_t reserved;
+};
+
+// 定长索引记录，按path升序排列；字符串以（偏移，长度）引用字符串表
+struct HttpPack::IndexRecord {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t gzip_offset;
+    uint64_t gzip_size;
+    int64_t mtime;
+    uint32_t path_offset;
+    uint32_t path_size;
+    uint32_t mime_offset;
+    uint32_t mime_size;
+    uint32_t etag_offset;
+    uint32_t etag_size;
+    uint32_t date_offset;
+    uint32_t date_size;
+};
+
+static constexpr char PACK_MAGIC[8] = {'H', 'T', 'T', 'P', 'P', 'A', 'C', 'K'};
+static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+// 区间[offset, offset + size)是否落在total之内，避免加法溢出
+static bool in_bounds(uint64_t offset, uint64_t size, uint64_t total)
+{
+    return offset <= total && size <= total - offset;
+}
+
+HttpPack::HttpPack(const std::string& pack_path) : file(std::make_shared<HttpFile>(pack_path))
+{
+    struct stat file_stat;
+    if (fstat(this->file->get_fd(), &file_stat) < 0) {
+        throw TcpRuntimeException("fstat failed: " + pack_path, __FILENAME__, __LINE__);
+    }
+    if (file_stat.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        throw TcpRuntimeException("pack file is too small: " + pack_path, __FILENAME__, __LINE__);
+    }
+
+    size_t size = static_cast<size_t>(file_stat.st_size);
+    void *map = mmap(nullptr, size, PROT_READ, MAP_SHARED, this->file->get_fd(), 0);
+    if (map == MAP_FAILED) {
+        throw TcpRuntimeException("mmap failed: " + pack_path, __FILENAME__, __LINE__);
+    }
+
+    // 只校验文件头，索引记录在查找时逐条检查，打开耗时与文件数无关
+    FileHeader header;
+    memcpy(&header, map, sizeof(header));
+    bool valid = memcmp(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC)) == 0 &&
+        header.version == VERSION && header.byte_order == BYTE_ORDER_MARK &&
+        header.index_offset % alignof(IndexRecord) == 0 &&
+        in_bounds(header.index_offset, static_cast<uint64_t>(header.record_count) * sizeof(IndexRecord), size) &&
+        in_bounds(header.strings_offset, header.strings_size, size);
+    if (!valid) {
+        munmap(map, size);
+        throw TcpRuntimeException("invalid pack file: " + pack_path, __FILENAME__, __LINE__);
+    }
+
+    this->base = static_cast<const char *>(map);
+    this->length = size;
+    this->records = reinterpret_cast<const IndexRecord *>(this->base + header.index_offset);
+    this->record_count = header.record_count;
+    this->strings = this->base + header.strings_offset;
+    this->strings_size = header.strings_size;
+}
+
+HttpPack::~HttpPack()
+{
+    munmap(const_cast<char *>(this->base), this->length);
+}
+
+std::string_view HttpPack::get_string(uint32_t offset, uint32_t size) const
+{
+    if (!in_bounds(offset, size, this->strings_size)) {
+        return std::string_view();
+    }
+    return std::string_view(this->strings + offset, size);
+}
+
+bool HttpPack::lookup(std::string_view path, HttpPackEntry& entry) const
+{
+    const IndexRecord *end = this->records + this->record_count;
+    const IndexRecord *it = std::lower_bound(this->records, end, path,
+        [this](const IndexRecord& record, std::string_view key) {
+            return get_string(record.path_offset, record.path_size) < key;
+        });
+    if (it == end || get_string(it->path_offset, it->path_size) != path) {
+        return false;
+    }
+    if (!in_bounds(it->offset, it->size, this->length) || !in_bounds(it->gzip_offset, it->gzip_size, this->length)) {
+        return false;
+    }
+
+    entry.path = get_string(it->path_offset, it->path_size);
+    entry.mime_type = get_string(it->mime_offset, it->mime_size);
+    entry.etag = get_string(it->etag_offset, it->etag_size);
+    entry.last_modified = get_string(it->date_offset, it->date_size);
+    entry.mtime = static_cast<time_t>(it->mtime);
+    entry.offset = static_cast<off_t>(it->offset);
+    entry.size = static_cast<off_t>(it->size);
+    entry.gzip_offset = static_cast<off_t>(it->gzip_offset);
+    entry.gzip_size = static_cast<off_t>(it->gzip_size);
+    return !entry.etag.empty();
+}
+
+const char *HttpPack::get_data(off_t offset) const
+{
+    return this->base + offset;
+}
+
+const std::shared_ptr<HttpFile>& HttpPack::get_file() const
+{
+    return this->file;
+}
+
+size_t HttpPack::get_entry_count() const
+{
+    return this->record_count;
+}
+
+HttpPackBuildStats HttpPack::build(const std::string& source_dir, const std::string& pack_path)
+{
+    // 请求路径与源文件，按请求路径排序后即为索引顺序
+    std::vector<std::pair<std::string, std::filesystem::path>> sources;
+    for (const auto& item : std::filesystem::recursive_directory_iterator(source_dir)) {
+        if (item.is_regular_file()) {
+            sources.emplace_back("/" + std::filesystem::relative(item.path(), source_dir).generic_string(), item.path());
+        }
+    }
+    std::sort(sources.begin(), sources.end());
+
+    std::string temp_path = pack_path + ".tmp";
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw TcpRuntimeException("cannot create " + temp_path, __FILENAME__, __LINE__);
+    }
+    FileHeader header = {};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    HttpPackBuildStats stats;
+    std::vector<IndexRecord> records;
+    std::string strings;
+    auto add_string = [&strings](std::string_view text, uint32_t& offset, uint32_t& size) {
+        offset = static_cast<uint32_t>(strings.size());
+        size = static_cast<uint32_t>(text.size());
+        strings.append(text);
+    };
+
+    for (const auto& [request_path, source_path] : sources) {
+        struct stat file_stat;
+        if (stat(source_path.c_str(), &file_stat) < 0) {
+            throw TcpRuntimeException("cannot stat " + source_path.string(), __FILENAME__, __LINE__);
+        }
+        std::string content = read_file_content(source_path.string(), file_stat.st_size);
+        std::string_view mime_type = HttpHeaderBuilder::get_mime_type(request_path);
+
+        IndexRecord record = {};
+        record.offset = static_cast<uint64_t>(out.tellp());
+        record.size = content.size();
+        record.mtime = file_stat.st_mtim.tv_sec;
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+
+        if (HttpGzipCache::is_compressible(mime_type) && file_stat.st_size >= MIN_GZIP_SIZE) {
+            std::string encoded = HttpGzipCache::gzip_compress(content, GZIP_LEVEL);
+            if (encoded.size() < content.size()) {
+                record.gzip_offset = static_cast<uint64_t>(out.tellp());
+                record.gzip_size = encoded.size();
+                out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+                stats.gzip_files++;
+                stats.gzip_bytes += encoded.size();
+            }
+        }
+
+        uint64_t hash = HttpEtagGenerator::fnv1a(HttpEtagGenerator::FNV_OFFSET_BASIS, content.data(), content.size());
+        add_string(request_path, record.path_offset, record.path_size);
+        add_string(mime_type, record.mime_offset, record.mime_size);
+        add_string(HttpEtagGenerator::make_content_etag(file_stat.st_size, hash), record.etag_offset, record.etag_size);
+        add_string(HttpEtagGenerator::format_http_date(file_stat.st_mtim.tv_sec), record.date_offset, record.date_size);
+        records.push_back(record);
+
+        stats.files++;
+        stats.bytes += content.size();
+    }
+
+    // 索引按记录对齐，映射后可直接作为数组访问
+    uint64_t position = static_cast<uint64_t>(out.tellp());
+    uint64_t padding = (alignof(IndexRecord) - position % alignof(IndexRecord)) % alignof(IndexRecord);
+    out.write(std::string(padding, '\0').data(), static_cast<std::streamsize>(padding));
+
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.index_offset = position + padding;
+    header.record_count = static_cast<uint32_t>(records.size());
+    out.write(reinterpret_cast<const char *>(records.data()),
+        static_cast<std::streamsize>(records.size() * sizeof(IndexRecord)));
+    header.strings_offset = static_cast<uint64_t>(out.tellp());
+    header.strings_size = strings.size();
+    out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        throw TcpRuntimeException("write failed: " + temp_path, __FILENAME__, __LINE__);
+    }
+    if (rename(temp_path.c_str(), pack_path.c_str()) < 0) {
+        throw TcpRuntimeException("cannot rename " + temp_path + " to " + pack_path, __FILENAME__, __LINE__);
+    }
+    return stats;
+}
@@ -0,0 +1,660 @@
+extern "C" {
+#include <unistd.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+}
+
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <string_view>
+
+#include "tcp_public.hpp"
+#include "http_proxy.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// 响应头的长度上限，超过时按上游出错处理
+static constexpr size_t MAX_RESPONSE_HEAD_SIZE = 64 * 1024;
+static constexpr size_t HEAD_READ_SIZE = 16 * 1024;
+
+// 逐跳头部只对单个连接有意义，不随请求或响应转发；请求体不被转发，其分帧头部一并去除
+static constexpr std::string_view REQUEST_HOP_HEADERS[] = {
+    "Connection", "Keep-Alive", "Proxy-Connection", "TE", "Upgrade", "HTTP2-Settings", "Expect",
+    "Transfer-Encoding", "Content-Length", "X-Forwarded-For",
+};
+static constexpr std::string_view RESPONSE_HOP_HEADERS[] = {
+    "Connection", "Keep-Alive", "Proxy-Connection", "TE", "Upgrade",
+};
+
+/**
+ * @brief 一个上游服务器：在途请求数、健康状态与空闲连接池
+ */
+struct HttpProxy::Upstream {
+    HttpUpstreamAddress address;
+    struct sockaddr_in sockaddr = {};
+    size_t max_idle = 0;
+    std::atomic<size_t> outstanding{0}; // 已选中、尚未转发完响应体的请求数
+
+    std::mutex mutex;
+    std::vector<int32_t> idle;   // 空闲连接，后进先出，优先复用最近用过的连接
+    uint32_t failures = 0;       // 连续失败次数
+    Clock::time_point retry_at;  // 摘除期间下一次放行试探请求的时间
+
+    ~Upstream()
+    {
+        for (int32_t fd : this->idle) {
+            close(fd);
+        }
+    }
+
+    // 请求结束后归还连接，不能复用或池已满时关闭
+    void release(int32_t fd, bool reusable)
+    {
+        if (reusable) {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (this->idle.size() < this->max_idle) {
+                this->idle.push_back(fd);
+                return;
+            }
+        }
+        close(fd);
+    }
+};
+
+/**
+ * @brief 转发中的上游响应体，作为流段的来源；释放时结束请求，按响应是否完整归还或关闭连接
+ */
+class HttpProxy::UpstreamStream : public HttpStreamSource {
+private:
+    std::shared_ptr<Upstream> upstream;
+    int32_t fd;
+    HttpBodyFraming framing;
+    bool reusable;
+
+public:
+    UpstreamStream(std::shared_ptr<Upstream> upstream, int32_t fd, HttpBodyFraming framing, bool reusable) :
+        upstream(std::move(upstream)), fd(fd), framing(std::move(framing)), reusable(reusable) {}
+
+    ~UpstreamStream() override
+    {
+        this->upstream->release(this->fd, this->reusable && this->framing.is_done());
+        this->upstream->outstanding--;
+    }
+
+    int32_t get_fd() const override
+    {
+        return this->fd;
+    }
+
+    HttpBodyFraming& get_framing() override
+    {
+        return this->framing;
+    }
+
+    void set_broken() override
+    {
+        this->reusable = false;
+    }
+};
+
+HttpProxy::HttpProxy(const HttpProxyConfig& config) : config(config)
+{
+}
+
+HttpProxy::~HttpProxy() = default;
+
+void HttpProxy::add_route(const std::string& prefix, const std::vector<HttpUpstreamAddress>& upstreams)
+{
+    if (upstreams.empty()) {
+        throw TcpRuntimeException("no upstream for proxy route " + prefix, __FILENAME__, __LINE__);
+    }
+
+    auto it = std::find_if(this->routes.begin(), this->routes.end(),
+        [&prefix](const std::unique_ptr<Route>& route) { return route->prefix == prefix; });
+    if (it == this->routes.end()) {
+        auto route = std::make_unique<Route>();
+        route->prefix = prefix;
+        it = this->routes.insert(this->routes.end(), std::move(route));
+    }
+
+    for (const HttpUpstreamAddress& address : upstreams) {
+        auto upstream = std::make_shared<Upstream>();
+        upstream->address = address;
+        upstream->max_idle = this->config.max_idle_per_upstream;
+        upstream->sockaddr.sin_family = AF_INET;
+        upstream->sockaddr.sin_port = htons(address.port);
+        if (inet_pton(AF_INET, address.host.c_str(), &upstream->sockaddr.sin_addr) != 1) {
+            throw TcpRuntimeException("invalid upstream address: " + address.host, __FILENAME__, __LINE__);
+        }
+        (*it)->upstreams.push_back(std::move(upstream));
+    }
+
+    std::stable_sort(this->routes.begin(), this->routes.end(),
+        [](const std::unique_ptr<Route>& a, const std::unique_ptr<Route>& b) {
+            return a->prefix.size() > b->prefix.size();
+        });
+}
+
+const HttpProxy::Route *HttpProxy::find_route(const std::string& path) const
+{
+    for (const auto& route : this->routes) {
+        if (path.compare(0, route->prefix.size(), route->prefix) == 0) {
+            return route.get();
+        }
+    }
+    return nullptr;
+}
+
+bool HttpProxy::matches(const std::string& path) const
+{
+    return find_route(path) != nullptr;
+}
+
+// 上游是否可接收请求；被摘除的上游到期后放行一个试探请求，并推迟下一次试探
+bool HttpProxy::is_available(Upstream& upstream, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(upstream.mutex);
+    if (upstream.failures < this->config.max_failures) {
+        return true;
+    }
+    if (now < upstream.retry_at) {
+        return false;
+    }
+    upstream.retry_at = now + this->config.retry_interval;
+    return true;
+}
+
+// 选出在途请求数最少的可用上游，跳过本次请求已试过的；数量相同时从轮转起点开始取第一个
+std::shared_ptr<HttpProxy::Upstream> HttpProxy::pick(const Route& route, const std::vector<const Upstream *>& tried)
+{
+    size_t count = route.upstreams.size();
+    size_t start = const_cast<Route&>(route).next.fetch_add(1, std::memory_order_relaxed);
+    Clock::time_point now = Clock::now();
+
+    // 先按负载排出候选顺序，再逐个检查可用性，避免为最终未选中的上游消耗试探机会
+    std::vector<std::pair<size_t, size_t>> candidates;
+    for (size_t i = 0; i < count; i++) {
+        size_t index = (start + i) % count;
+        const Upstream *upstream = route.upstreams[index].get();
+        if (std::find(tried.begin(), tried.end(), upstream) == tried.end()) {
+            candidates.emplace_back(upstream->outstanding.load(std::memory_order_relaxed), index);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    for (const auto& candidate : candidates) {
+        const std::shared_ptr<Upstream>& upstream = route.upstreams[candidate.second];
+        if (is_available(*upstream, now)) {
+            return upstream;
+        }
+    }
+    return nullptr;
+}
+
+void HttpProxy::record_result(Upstream& upstream, bool success)
+{
+    std::lock_guard<std::mutex> lock(upstream.mutex);
+    if (success) {
+        if (upstream.failures >= this->config.max_failures) {
+            LOG_INFO("upstream %s:%hu is healthy again", upstream.address.host.c_str(), upstream.address.port);
+        }
+        upstream.failures = 0;
+        return;
+    }
+
+    this->failures++;
+    upstream.failures++;
+    if (upstream.failures == this->config.max_failures) {
+        LOG_ERR("upstream %s:%hu marked unhealthy after %u failures", upstream.address.host.c_str(),
+            upstream.address.port, upstream.failures);
+    }
+    if (upstream.failures >= this->config.max_failures) {
+        upstream.retry_at = Clock::now() + this->config.retry_interval;
+    }
+}
+
+// 取出一个仍然可用的空闲连接，池为空时返回-1；已被上游关闭或有多余数据的连接直接关闭
+int32_t HttpProxy::take_idle(Upstream& upstream)
+{
+    for (;;) {
+        int32_t fd = -1;
+        {
+            std::lock_guard<std::mutex> lock(upstream.mutex);
+            if (upstream.idle.empty()) {
+                return -1;
+            }
+            fd = upstream.idle.back();
+            upstream.idle.pop_back();
+        }
+
+        char probe = 0;
+        ssize_t len = recv(fd, &probe, 1, MSG_PEEK | MSG_DONTWAIT);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return fd;
+        }
+        close(fd);
+    }
+}
+
+// 剩余的等待时间（ms），已超时时返回0
+static int32_t remaining_ms(Clock::time_point deadline)
+{
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+    return remaining > 0 ? static_cast<int32_t>(remaining) : 0;
+}
+
+// 等待fd就绪，超时时返回false
+static bool wait_fd(int32_t fd, int16_t events, Clock::time_point deadline)
+{
+    for (;;) {
+        struct pollfd pfd = { fd, events, 0 };
+        int32_t rc = poll(&pfd, 1, remaining_ms(deadline));
+        if (rc > 0) {
+            return true;
+        }
+        if (rc == 0) {
+            return false;
+        }
+        if (errno != EINTR) {
+            throw TcpRuntimeException("poll upstream failed", __FILENAME__, __LINE__);
+        }
+    }
+}
+
+// 以非阻塞connect建立连接，poll等待至超时后以SO_ERROR确认结果
+// @exception 连接失败时抛出HttpRequestException（502），超时时为504
+int32_t HttpProxy::connect_upstream(const Upstream& upstream)
+{
+    int32_t fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw HttpRequestException("create upstream socket failed", HTTP_ERR_BAD_GATEWAY);
+    }
+    static_cast<void>(this->config.socket_options.apply_connect(fd));
+
+    std::string where = upstream.address.host + ":" + std::to_string(upstream.address.port);
+    int32_t rc = connect(fd, reinterpret_cast<const struct sockaddr *>(&upstream.sockaddr), sizeof(upstream.sockaddr));
+    if (rc < 0 && errno != EINPROGRESS) {
+        close(fd);
+        throw HttpRequestException("connect to upstream " + where + " failed", HTTP_ERR_BAD_GATEWAY);
+    }
+    if (rc < 0) {
+        if (!wait_fd(fd, POLLOUT, Clock::now() + this->config.connect_timeout)) {
+            close(fd);
+            throw HttpRequestException("connect to upstream " + where + " timed out", HTTP_ERR_GATEWAY_TIMEOUT);
+        }
+        int32_t error = 0;
+        socklen_t length = sizeof(error);
+        if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0) {
+            close(fd);
+            throw HttpRequestException("connect to upstream " + where + " failed: " + strerror(error),
+                HTTP_ERR_BAD_GATEWAY);
+        }
+    }
+    this->connects++;
+    return fd;
+}
+
+// 发出全部数据，连接已被对端关闭时返回false
+// @exception 超时时抛出HttpRequestException（504）
+static bool send_head(int32_t fd, const std::string& data, Clock::time_point deadline)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t len = send(fd, data.data() + sent, data.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len >= 0) {
+            sent += static_cast<size_t>(len);
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            return false;
+        }
+        if (!wait_fd(fd, POLLOUT, deadline)) {
+            throw HttpRequestException("send request to upstream timed out", HTTP_ERR_GATEWAY_TIMEOUT);
+        }
+    }
+    return true;
+}
+
+// 读取直至buffer中有完整的响应头，返回响应头的长度（含空行）；没有收到任何数据连接就被关闭时返回0
+// @exception 超时时抛出HttpRequestException（504），其余错误为502
+static size_t read_head(int32_t fd, std::string& buffer, Clock::time_point deadline)
+{
+    size_t scanned = 0;
+    for (;;) {
+        size_t end = buffer.find("\r\n\r\n", scanned);
+        if (end != std::string::npos) {
+            return end + 4;
+        }
+        if (buffer.size() > MAX_RESPONSE_HEAD_SIZE) {
+            throw HttpRequestException("upstream response head too large", HTTP_ERR_BAD_GATEWAY);
+        }
+        scanned = buffer.size() >= 3 ? buffer.size() - 3 : 0;
+
+        size_t old_size = buffer.size();
+        buffer.resize(old_size + HEAD_READ_SIZE);
+        ssize_t len = recv(fd, &buffer[old_size], HEAD_READ_SIZE, MSG_DONTWAIT);
+        buffer.resize(old_size + static_cast<size_t>(std::max<ssize_t>(len, 0)));
+        if (len > 0) {
+            continue;
+        }
+        if (len == 0 || errno == ECONNRESET) {
+            if (old_size == 0) {
+                return 0;
+            }
+            throw HttpRequestException("upstream closed in response head", HTTP_ERR_BAD_GATEWAY);
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN && errno != EWOULDBLOCK) {
+            throw HttpRequestException("recv from upstream failed", HTTP_ERR_BAD_GATEWAY);
+        }
+        if (!wait_fd(fd, POLLIN, deadline)) {
+            throw HttpRequestException("upstream response timed out", HTTP_ERR_GATEWAY_TIMEOUT);
+        }
+    }
+}
+
+static bool is_header(std::string_view line, std::string_view name)
+{
+    return line.size() > name.size() && line[name.size()] == ':' &&
+        strncasecmp(line.data(), name.data(), name.size()) == 0;
+}
+
+static std::string_view header_value(std::string_view line)
+{
+    size_t start = line.find(':') + 1;
+    size_t value_start = line.find_first_not_of(" \t", start);
+    if (value_start == std::string_view::npos) {
+        return {};
+    }
+    size_t value_end = line.find_last_not_of(" \t");
+    return line.substr(value_start, value_end - value_start + 1);
+}
+
+// 逗号分隔的列表中是否含有token，不区分大小写
+static bool has_token(std::string_view list, std::string_view token)
+{
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = std::min(list.find(',', start), list.size());
+        std::string_view item = list.substr(start, end - start);
+        size_t first = item.find_first_not_of(" \t");
+        size_t last = item.find_last_not_of(" \t");
+        if (first != std::string_view::npos) {
+            item = item.substr(first, last - first + 1);
+            if (item.size() == token.size() && strncasecmp(item.data(), token.data(), token.size()) == 0) {
+                return true;
+            }
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+template <size_t N>
+static bool is_hop_header(std::string_view line, const std::string_view (&names)[N])
+{
+    return std::any_of(std::begin(names), std::end(names),
+        [line](std::string_view name) { return is_header(line, name); });
+}
+
+// 改写发往上游的请求头：以HTTP/1.1请求以便保持连接，去除逐跳头部，追加X-Forwarded-For
+static std::string build_upstream_head(const std::string& head, const std::string& client_ip)
+{
+    size_t line_end = head.find("\r\n");
+    std::string_view request_line = std::string_view(head).substr(0, line_end);
+    std::string result;
+    result.reserve(head.size() + 64);
+    if (request_line.size() >= 8 && request_line.substr(request_line.size() - 8) == "HTTP/1.0") {
+        request_line.remove_suffix(8);
+        result.append(request_line).append("HTTP/1.1\r\n");
+    } else {
+        result.append(request_line).append("\r\n");
+    }
+
+    std::string forwarded_for;
+    size_t start = line_end + 2;
+    while (start < head.size()) {
+        size_t end = head.find("\r\n", start);
+        if (end == std::string::npos || end == start) {
+            break;
+        }
+        std::string_view line = std::string_view(head).substr(start, end - start);
+        if (is_header(line, "X-Forwarded-For")) {
+            forwarded_for.append(header_value(line)).append(", ");
+        }
+        if (!is_hop_header(line, REQUEST_HOP_HEADERS)) {
+            result.append(line).append("\r\n");
+        }
+        start = end + 2;
+    }
+
+    result.append("X-Forwarded-For: ").append(forwarded_for).append(client_ip).append("\r\n");
+    result.append("Connection: keep-alive\r\n\r\n");
+    return result;
+}
+
+static std::string peer_ip(int32_t client_fd)
+{
+    struct sockaddr_in addr = {};
+    socklen_t length = sizeof(addr);
+    char text[INET_ADDRSTRLEN] = "unknown";
+    if (getpeername(client_fd, reinterpret_cast<struct sockaddr *>(&addr), &length) == 0 && addr.sin_family == AF_INET) {
+        inet_ntop(AF_INET, &addr.sin_addr, text, sizeof(text));
+    }
+    return text;
+}
+
+std::unique_ptr<HttpTransfer> HttpProxy::forward(const HttpRequest& request)
+{
+    const Route *route = find_route(request.filepath);
+    if (route == nullptr) {
+        throw HttpRequestException("no proxy route for " + request.filepath, HTTP_ERR_NOT_FOUND);
+    }
+    // 等待上游期间占住工作线程，在途请求达到上限时直接拒绝，避免代理请求占满线程池
+    if (this->in_flight.fetch_add(1) >= this->config.max_in_flight && this->config.max_in_flight != 0) {
+        this->in_flight--;
+        this->rejected++;
+        throw HttpRequestException("too many proxied requests in flight", HTTP_ERR_SERVICE_UNAVAILABLE);
+    }
+    struct InFlightGuard {
+        std::atomic<size_t>& count;
+        ~InFlightGuard() { count--; }
+    } guard{this->in_flight};
+
+    this->requests++;
+    std::string head = build_upstream_head(request.head, peer_ip(request.client_fd));
+
+    // 只转发没有请求体的请求，失败时可以安全地换一个上游重发
+    std::vector<const Upstream *> tried;
+    for (;;) {
+        std::shared_ptr<Upstream> upstream = pick(*route, tried);
+        if (!upstream) {
+            throw HttpRequestException("no available upstream for " + route->prefix, HTTP_ERR_BAD_GATEWAY);
+        }
+        tried.push_back(upstream.get());
+
+        upstream->outstanding++;
+        try {
+            std::unique_ptr<HttpTransfer> transfer = exchange(upstream, head, request.type == HTTP_REQUEST_HEAD);
+            record_result(*upstream, true);
+            return transfer;
+        } catch (const HttpRequestException& e) {
+            upstream->outstanding--;
+            record_result(*upstream, false);
+            LOG_ERR("proxy %s via %s:%hu failed: %s", request.filepath.c_str(), upstream->address.host.c_str(),
+                upstream->address.port, e.what());
+            if (tried.size() >= route->upstreams.size()) {
+                throw;
+            }
+        } catch (const TcpRuntimeException& e) {
+            upstream->outstanding--;
+            record_result(*upstream, false);
+            LOG_ERR(e.what());
+            if (tried.size() >= route->upstreams.size()) {
+                throw HttpRequestException("upstream error", HTTP_ERR_BAD_GATEWAY);
+            }
+        }
+    }
+}
+
+// 与选中的上游完成一次请求与响应头的交换；复用的连接在收到任何数据之前被关闭时，改用新连接重发一次
+std::unique_ptr<HttpTransfer> HttpProxy::exchange(const std::shared_ptr<Upstream>& upstream, const std::string& head,
+    bool head_only)
+{
+    std::string buffer;
+    size_t head_size = 0;
+    int32_t fd = -1;
+    bool pooled = false;
+    for (;;) {
+        fd = take_idle(*upstream);
+        pooled = fd >= 0;
+        if (!pooled) {
+            fd = connect_upstream(*upstream);
+        }
+
+        try {
+            Clock::time_point deadline = Clock::now() + this->config.response_timeout;
+            bool sent = send_head(fd, head, deadline);
+            head_size = sent ? read_head(fd, buffer, deadline) : 0;
+            // 1xx中间响应之后才是最终响应
+            while (head_size > 0 && buffer.compare(0, 10, "HTTP/1.1 1") == 0 && buffer.compare(9, 3, "101") != 0) {
+                buffer.erase(0, head_size);
+                head_size = read_head(fd, buffer, deadline);
+            }
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        if (head_size > 0) {
+            break;
+        }
+        close(fd);
+        if (!pooled) {
+            throw HttpRequestException("upstream closed without response", HTTP_ERR_BAD_GATEWAY);
+        }
+        this->retries++;
+    }
+    if (pooled) {
+        this->reused++;
+    }
+
+    // 解析状态行与决定响应体分帧的头部，此后出错时由这里关闭fd，成功时交给流段
+    std::string_view response_head = std::string_view(buffer).substr(0, head_size - 2);
+    size_t line_end = response_head.find("\r\n");
+    std::string_view status_line = response_head.substr(0, line_end);
+    if (status_line.size() < 12 || status_line.compare(0, 7, "HTTP/1.") != 0 ||
+        !std::all_of(status_line.begin() + 9, status_line.begin() + 12, [](char c) { return c >= '0' && c <= '9'; })) {
+        close(fd);
+        throw HttpRequestException("invalid upstream status line", HTTP_ERR_BAD_GATEWAY);
+    }
+    uint32_t status = static_cast<uint32_t>(std::stoul(std::string(status_line.substr(9, 3))));
+    if (status == 101) {
+        close(fd);
+        throw HttpRequestException("upstream protocol switch is not supported", HTTP_ERR_BAD_GATEWAY);
+    }
+    // HTTP/1.0的上游默认在响应后关闭连接
+    bool reusable = status_line.compare(0, 8, "HTTP/1.1") == 0;
+
+    std::string client_head = "HTTP/1.1";
+    client_head.append(status_line.substr(8)).append("\r\n");
+    std::string_view transfer_encoding;
+    std::string_view content_length;
+    bool has_content_length = false;
+    size_t start = line_end == std::string_view::npos ? response_head.size() : line_end + 2;
+    while (start < response_head.size()) {
+        size_t end = std::min(response_head.find("\r\n", start), response_head.size());
+        std::string_view line = response_head.substr(start, end - start);
+        if (is_header(line, "Connection")) {
+            reusable = reusable && !has_token(header_value(line), "close");
+        } else if (is_header(line, "Transfer-Encoding")) {
+            transfer_encoding = header_value(line);
+        } else if (is_header(line, "Content-Length")) {
+            content_length = header_value(line);
+            has_content_length = true;
+        }
+        if (!is_hop_header(line, RESPONSE_HOP_HEADERS)) {
+            client_head.append(line).append("\r\n");
+        }
+        start = end + 2;
+    }
+
+    HttpBodyMode mode = HTTP_BODY_CLOSE;
+    uint64_t length = 0;
+    // HEAD的响应与204、304一样没有响应体，其Content-Length只描述对应GET的响应
+    if (head_only || status == 204 || status == 304) {
+        mode = HTTP_BODY_LENGTH;
+    } else if (!transfer_encoding.empty()) {
+        // 只有以chunked结尾的编码才能确定消息体的结束位置，其余以关闭连接结束
+        mode = has_token(transfer_encoding, "chunked") ? HTTP_BODY_CHUNKED : HTTP_BODY_CLOSE;
+    } else if (has_content_length) {
+        if (content_length.empty() || content_length.size() > 18 ||
+            !std::all_of(content_length.begin(), content_length.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            close(fd);
+            throw HttpRequestException("invalid upstream Content-Length", HTTP_ERR_BAD_GATEWAY);
+        }
+        mode = HTTP_BODY_LENGTH;
+        length = std::stoull(std::string(content_length));
+    }
+    reusable = reusable && mode != HTTP_BODY_CLOSE;
+    client_head.append(mode == HTTP_BODY_CLOSE ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n");
+
+    // 随响应头一同读入的响应体按分帧推进，消息体之后多余的数据丢弃，连接不再复用
+    HttpBodyFraming framing(mode, length);
+    size_t pos = head_size;
+    try {
+        while (pos < buffer.size() && !framing.is_done()) {
+            uint64_t data = framing.get_data_remaining();
+            if (data > 0) {
+                size_t part = static_cast<size_t>(std::min<uint64_t>(data, buffer.size() - pos));
+                framing.consume_data(part);
+                pos += part;
+            } else {
+                pos += framing.feed(buffer.data() + pos, buffer.size() - pos);
+            }
+        }
+    } catch (const HttpRequestException& e) {
+        close(fd);
+        throw HttpRequestException(std::string("invalid upstream chunked body: ") + e.what(), HTTP_ERR_BAD_GATEWAY);
+    }
+    reusable = reusable && pos == buffer.size();
+    client_head.append(buffer, head_size, pos - head_size);
+
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->add_buffer(std::move(client_head));
+    transfer->set_close_after(mode == HTTP_BODY_CLOSE);
+    bool done = framing.is_done();
+    auto stream = std::make_shared<UpstreamStream>(upstream, fd, std::move(framing), reusable);
+    if (!done) {
+        transfer->add_stream(std::move(stream));
+    }
+    return transfer;
+}
+
+HttpProxyStats HttpProxy::get_stats() const
+{
+    HttpProxyStats stats;
+    stats.requests = this->requests.load(std::memory_order_relaxed);
+    stats.reused = this->reused.load(std::memory_order_relaxed);
+    stats.connects = this->connects.load(std::memory_order_relaxed);
+    stats.failures = this->failures.load(std::memory_order_relaxed);
+    stats.retries = this->retries.load(std::memory_order_relaxed);
+    stats.rejected = this->rejected.load(std::memory_order_relaxed);
+    for (const auto& route : this->routes) {
+        for (const auto& upstream : route->upstreams) {
+            std::lock_guard<std::mutex> lock(upstream->mutex);
+            stats.idle += upstream->idle.size();
+            stats.unhealthy += upstream->failures >= this->config.max_failures ? 1 : 0;
+        }
+    }
+    return stats;
+}
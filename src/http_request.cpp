@@ -1,57 +1,90 @@
+extern "C" {
+#include <strings.h>
+}
+
+#include <algorithm>
+#include <charconv>
 #include <string>
 #include <unordered_map>
 #include <regex>
 
 #include "tcp_public.hpp"
 #include "http_request.hpp"
+#include "http_header_builder.hpp"
+#include "http_admission.hpp"
+
+// 可能回复的错误码，对应的响应在首次使用时一次性渲染
+static constexpr HttpErrCode ERROR_CODES[] = {
+    HTTP_ERR_BAD_REQUEST,
+    HTTP_ERR_FORBIDDEN,
+    HTTP_ERR_NOT_FOUND,
+    HTTP_ERR_METHOD_NOT_ALLOWED,
+    HTTP_ERR_LENGTH_REQUIRED,
+    HTTP_ERR_CONTENT_TOO_LARGE,
+    HTTP_ERR_RANGE_NOT_SATISFIABLE,
+    HTTP_ERR_INTERNAL_SERVER_ERROR,
+    HTTP_ERR_BAD_GATEWAY,
+    HTTP_ERR_SERVICE_UNAVAILABLE,
+    HTTP_ERR_GATEWAY_TIMEOUT,
+};
 
-std::string HttpRequestException::get_err_text() const
+static std::string render_error(uint32_t code)
 {
-    // 使用unordered_map存储错误码和错误文本的映射关系
-    static const std::unordered_map<int, std::string> error_texts = {
-        {HTTP_ERR_BAD_REQUEST, "Bad Request"},
-        {HTTP_ERR_FORBIDDEN, "Forbidden"},
-        {HTTP_ERR_NOT_FOUND, "Not Found"},
-        {HTTP_ERR_INTERNAL_SERVER_ERROR, "Internal Server Error"}
-    };
-
-    // 查找错误码对应的文本
-    auto it = error_texts.find(this->err_code);
-    if (it != error_texts.end()) {
-        return it->second;
+    std::string title = std::to_string(code) + " " + std::string(HttpHeaderBuilder::get_status_text(code));
+    std::string html = "<html><head><title>" + title + "</title></head><body><h1>" + title + "</h1></body></html>";
+
+    HttpHeaderBuilder header;
+    header.status(code)
+        .add("Content-Type", "text/html")
+        .add("Content-Length", static_cast<int64_t>(html.size()))
+        .add("Connection", "close");
+    // 过载时提示客户端稍后重试
+    if (code == HTTP_ERR_SERVICE_UNAVAILABLE) {
+        header.add("Retry-After", static_cast<int64_t>(HttpAdmissionControl::RETRY_AFTER_SECONDS));
     }
-    
-    // 如果未找到对应错误码，返回默认值
-    return "Unknown Error";
+    header.finish();
+    return std::string(header.view()) + html;
 }
 
-// 处理异常时，使用本函数生成提示客户端出错的HTML报文
-std::string HttpRequestException::get_err_resp() const
+uint32_t HttpRequestException::get_err_code() const
 {
-    std::string html = 
-        "<html>"
-        "<head><title>" + std::to_string(this->err_code) + " " + get_err_text() + "</title></head>"
-        "<body><h1>" + std::to_string(this->err_code) + " " + get_err_text() + ": " + this->what() + "</h1></body>"
-        "</html>";
-    
-    std::string response = 
-        "HTTP/1.1 " + std::to_string(this->err_code) + " " + get_err_text() + "\r\n"
-        "Content-Type: text/html\r\n"
-        "Content-Length: " + std::to_string(html.size()) + "\r\n"
-        "Connection: close\r\n"
-        "\r\n" + html;
-    
-    return response;
+    return this->err_code;
 }
 
-// 使用正则表达式提取 HTTP 请求路径
+// 错误响应只取决于错误码，详细原因由调用方记录到日志，不回显给客户端
+std::string_view HttpRequestException::get_err_resp() const
+{
+    static const std::unordered_map<uint32_t, std::string> responses = [] {
+        std::unordered_map<uint32_t, std::string> rendered;
+        for (HttpErrCode code : ERROR_CODES) {
+            rendered.emplace(code, render_error(code));
+        }
+        return rendered;
+    }();
+
+    auto it = responses.find(this->err_code);
+    if (it == responses.end()) {
+        it = responses.find(HTTP_ERR_INTERNAL_SERVER_ERROR);
+    }
+    return it->second;
+}
+
+// 使用正则表达式提取 HTTP 请求方法与路径
 std::string HttpRequest::extract_path(const std::string &req)
 {
-    std::regex request_pattern(R"(GET\s+(.*?)\s+HTTP/1\.[01])");
+    std::regex request_pattern(R"((GET|HEAD|PUT|POST)\s+(.*?)\s+HTTP/1\.[01])");
     std::smatch match;
     
     if (std::regex_search(req, match, request_pattern)) {
-        std::string path = match[1].str();
+        std::string method = match[1].str();
+        if (method == "PUT") {
+            this->type = HTTP_REQUEST_PUT;
+        } else if (method == "POST") {
+            this->type = HTTP_REQUEST_POST;
+        } else {
+            this->type = method == "HEAD" ? HTTP_REQUEST_HEAD : HTTP_REQUEST_GET;
+        }
+        std::string path = match[2].str();
         if (path.empty()){
             path = "/";
         }
@@ -65,7 +98,34 @@ std::string HttpRequest::extract_path(const std::string &req)
     throw HttpRequestException("Invalid HTTP request path", 400);
 }
 
-// 解析Range头部的字符串为HttpRange结构体数组，需要提供文件大小
+// 解析Range中的字节偏移，只接受非空的十进制数字串，格式错误或溢出时返回false
+static bool parse_offset(const std::string& text, off_t& value)
+{
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() && result.ptr == text.data() + text.size();
+}
+
+// 解析Accept-Encoding中的q值，须为0到1之间的数；缺失或格式错误时按q=1处理
+static double parse_qvalue(const std::string& coding)
+{
+    size_t q_pos = coding.find("q=");
+    if (q_pos == std::string::npos) {
+        return 1;
+    }
+    std::string text = coding.substr(q_pos + 2);
+    text.erase(text.find_last_not_of(' ') + 1);
+    double q = 1;
+    std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), q);
+    if (text.empty() || result.ec != std::errc() || result.ptr != text.data() + text.size() || q < 0 || q > 1) {
+        return 1;
+    }
+    return q;
+}
+
+// 解析Range头部的字符串为HttpRange结构体数组，需要提供文件大小；格式错误的范围被忽略
 std::vector<HttpRange> HttpRequest::parse_ranges(off_t file_size)
 {
     std::vector<HttpRange> ranges;
@@ -96,11 +156,14 @@ std::vector<HttpRange> HttpRequest::parse_ranges(off_t file_size)
         std::string start_str = range_str.substr(0, dash_pos);
         std::string end_str = range_str.substr(dash_pos + 1);
         
-        off_t start, end;
+        off_t start = 0, end = 0;
         
         if (start_str.empty() && !end_str.empty()) {
             // 格式: -suffix_length (从文件末尾倒数指定字节数)
-            off_t suffix_length = std::stoll(end_str);
+            off_t suffix_length = 0;
+            if (!parse_offset(end_str, suffix_length)) {
+                continue; // 格式错误
+            }
             if (suffix_length > file_size) {
                 start = 0;
             } else {
@@ -109,15 +172,15 @@ std::vector<HttpRange> HttpRequest::parse_ranges(off_t file_size)
             end = file_size - 1;
         } else if (!start_str.empty() && end_str.empty()) {
             // 格式: start- (从指定位置到文件末尾)
-            start = std::stoll(start_str);
-            if (start >= file_size) {
-                continue; // 起始位置超出文件大小
+            if (!parse_offset(start_str, start) || start >= file_size) {
+                continue; // 格式错误或起始位置超出文件大小
             }
             end = file_size - 1;
         } else if (!start_str.empty() && !end_str.empty()) {
             // 格式: start-end
-            start = std::stoll(start_str);
-            end = std::stoll(end_str);
+            if (!parse_offset(start_str, start) || !parse_offset(end_str, end)) {
+                continue; // 格式错误
+            }
             
             if (start > end || start >= file_size) {
                 continue; // 无效范围
@@ -136,15 +199,30 @@ std::vector<HttpRange> HttpRequest::parse_ranges(off_t file_size)
     return ranges;
 }
 
-// 提取Range头部字符串
+// 将range按起始位置排序，并合并重叠或相邻的range
+std::vector<HttpRange> HttpRequest::coalesce_ranges(std::vector<HttpRange> ranges)
+{
+    std::sort(ranges.begin(), ranges.end(), [](const HttpRange& a, const HttpRange& b) {
+        return a.start < b.start;
+    });
+
+    std::vector<HttpRange> merged;
+    for (const HttpRange& range : ranges) {
+        if (!merged.empty() && range.start <= merged.back().end + 1) {
+            merged.back().end = std::max(merged.back().end, range.end);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    return merged;
+}
+
+// 提取Range头部字符串；按完整的头部名查找，If-Range等名称中带Range的头部不会被误认
 void HttpRequest::parse_range_header(const std::string& request_data)
 {
-    // 解析Range头部
-    std::regex range_pattern(R"(Range:\s*(.+?)\r\n)", std::regex_constants::icase);
-    std::smatch range_match;
-    
-    if (std::regex_search(request_data, range_match, range_pattern)) {
-        this->range_header = range_match[1].str();
+    std::string range = get_header(request_data, "Range");
+    if (!range.empty()) {
+        this->range_header = range;
         // 注意：此时我们还不知道文件大小，因此暂时不解析范围
         // 在实际处理请求时，需要根据文件大小再解析
         this->is_range_request = true;
@@ -152,10 +230,113 @@ void HttpRequest::parse_range_header(const std::string& request_data)
     }
 }
 
-HttpRequest::HttpRequest(int32_t fd, const std::string& request_data) : client_fd(fd), is_range_request(false)
+// 解析Accept-Encoding头部，判断客户端是否接受gzip（q=0表示明确拒绝）
+void HttpRequest::parse_accept_encoding(const std::string& request_data)
+{
+    std::regex encoding_pattern(R"(Accept-Encoding:\s*(.*?)\r\n)", std::regex_constants::icase);
+    std::smatch encoding_match;
+
+    if (!std::regex_search(request_data, encoding_match, encoding_pattern)) {
+        return;
+    }
+
+    std::stringstream ss(encoding_match[1].str());
+    std::string coding;
+    while (std::getline(ss, coding, ',')) {
+        // 拆分出编码名称与q值，例如 "gzip;q=0.8"
+        std::string name = coding.substr(0, coding.find(';'));
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+        if (name != "gzip" && name != "*") {
+            continue;
+        }
+
+        this->accept_gzip = parse_qvalue(coding) > 0;
+        if (name == "gzip") {
+            break; // 明确的gzip优先于通配符
+        }
+    }
+
+    LOG_DEBUG("Accept-Encoding: %s, gzip=%d", encoding_match[1].str().c_str(), this->accept_gzip);
+}
+
+// 按名称（不区分大小写）查找请求头，返回去除首尾空白的值；未找到时返回空串
+std::string HttpRequest::get_header(const std::string& request_data, const std::string& name)
+{
+    size_t line_start = request_data.find("\r\n");
+    while (line_start != std::string::npos) {
+        line_start += 2;
+        size_t line_end = request_data.find("\r\n", line_start);
+        if (line_end == std::string::npos || line_end == line_start) {
+            break; // 到达头部结束的空行
+        }
+
+        if (line_end - line_start > name.size() && request_data[line_start + name.size()] == ':' &&
+            strncasecmp(request_data.c_str() + line_start, name.c_str(), name.size()) == 0) {
+            size_t value_start = request_data.find_first_not_of(" \t", line_start + name.size() + 1);
+            if (value_start == std::string::npos || value_start >= line_end) {
+                return "";
+            }
+            size_t value_end = request_data.find_last_not_of(" \t", line_end - 1);
+            return request_data.substr(value_start, value_end - value_start + 1);
+        }
+        line_start = line_end;
+    }
+    return "";
+}
+
+// 解析请求体的分帧方式：Content-Length须为十进制数；Transfer-Encoding只支持chunked，
+// 与Content-Length同时出现时拒绝，避免前后端对请求边界理解不一致
+void HttpRequest::parse_body_framing(const std::string& request_data)
+{
+    std::string length = get_header(request_data, "Content-Length");
+    std::string encoding = get_header(request_data, "Transfer-Encoding");
+    if (!encoding.empty()) {
+        if (strcasecmp(encoding.c_str(), "chunked") != 0 || !length.empty()) {
+            throw HttpRequestException("unsupported Transfer-Encoding: " + encoding, HTTP_ERR_BAD_REQUEST);
+        }
+        this->chunked = true;
+    } else if (!length.empty()) {
+        if (length.size() > 18 || length.find_first_not_of("0123456789") != std::string::npos) {
+            throw HttpRequestException("invalid Content-Length: " + length, HTTP_ERR_BAD_REQUEST);
+        }
+        this->content_length = std::stoll(length);
+    }
+    this->expect_continue = strcasecmp(get_header(request_data, "Expect").c_str(), "100-continue") == 0;
+}
+
+bool HttpRequest::is_upload() const
+{
+    return this->type == HTTP_REQUEST_PUT || this->type == HTTP_REQUEST_POST;
+}
+
+HttpRequest::HttpRequest(int32_t fd, const std::string& request_data) :
+    client_fd(fd), is_range_request(false), accept_gzip(false)
 {
     this->filepath = HttpRequest::extract_path(request_data);
     LOG_INFO("HTTP request for: %s", this->filepath.c_str());
     
     this->parse_range_header(request_data);
+    this->parse_accept_encoding(request_data);
+    this->parse_body_framing(request_data);
+
+    this->if_none_match = get_header(request_data, "If-None-Match");
+    this->if_modified_since = get_header(request_data, "If-Modified-Since");
+    this->if_range = get_header(request_data, "If-Range");
+
+    // Upgrade为逗号分隔的协议列表，只在同时携带HTTP2-Settings时接受切换
+    this->http2_settings = get_header(request_data, "HTTP2-Settings");
+    std::string upgrade = get_header(request_data, "Upgrade");
+    size_t start = 0;
+    while (!this->http2_settings.empty() && start < upgrade.size()) {
+        size_t end = std::min(upgrade.find(',', start), upgrade.size());
+        size_t token_start = upgrade.find_first_not_of(" \t", start);
+        size_t token_end = upgrade.find_last_not_of(" \t", end - 1);
+        if (token_start < end && token_end - token_start == 2 &&
+            strncasecmp(upgrade.c_str() + token_start, "h2c", 3) == 0) {
+            this->upgrade_h2c = true;
+            break;
+        }
+        start = end + 1;
+    }
 }
@@ -3,10 +3,16 @@ extern "C" {
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
-#include <sys/sendfile.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
 }
 
+#include <csignal>
+#include <algorithm>
 #include <filesystem>
+#include <random>
 
 #include "http_server.hpp"
 
@@ -20,9 +26,14 @@ std::filesystem::path HttpServer::validate_file(const std::string& target_path)
     abs_target_path = web_root.string() + target_path;
     LOG_DEBUG("abs_target_path: %s", abs_target_path.string().c_str());
     
-    // 规范化路径（解析 .. 和 .）
-    std::filesystem::path normalized_path = std::filesystem::weakly_canonical(abs_target_path);
-    std::filesystem::path normalized_web_root = std::filesystem::weakly_canonical(web_root);
+    // 规范化路径（解析 .. 和 .）；路径无法解析（如文件名过长）时按文件不存在处理
+    std::error_code path_ec;
+    std::error_code root_ec;
+    std::filesystem::path normalized_path = std::filesystem::weakly_canonical(abs_target_path, path_ec);
+    std::filesystem::path normalized_web_root = std::filesystem::weakly_canonical(web_root, root_ec);
+    if (path_ec || root_ec) {
+        throw HttpRequestException("cannot resolve path", HTTP_ERR_NOT_FOUND);
+    }
     
     // 检查规范化后的路径是否以web_root开头
     auto web_root_str = normalized_web_root.string();
@@ -42,94 +53,1234 @@ std::filesystem::path HttpServer::validate_file(const std::string& target_path)
     if (access(target_str.c_str(), R_OK) != 0) {
         throw HttpRequestException("cannot access file", HTTP_ERR_NOT_FOUND);
     }
-    
-    return normalized_path;
+    
+    return normalized_path;
+}
+
+// 验证上传的目标路径，返回规范化后的完整路径；目标文件可以不存在，但所在目录必须存在
+// 在reactor线程上调用，文件系统错误（如文件名过长）一律转为错误响应，不能以filesystem_error抛出
+// @exception 路径无法解析、越出web_root或指向目录时抛出HttpRequestException（403），
+// 所在目录不存在时抛出HttpRequestException（404）
+std::filesystem::path HttpServer::validate_upload_path(const std::string& target_path)
+{
+    std::error_code path_ec;
+    std::error_code root_ec;
+    std::filesystem::path normalized_path = std::filesystem::weakly_canonical(web_root.string() + target_path, path_ec);
+    std::string web_root_str = std::filesystem::weakly_canonical(web_root, root_ec).string();
+    if (path_ec || root_ec) {
+        throw HttpRequestException("upload path cannot be resolved", HTTP_ERR_FORBIDDEN);
+    }
+    if (web_root_str.back() != std::filesystem::path::preferred_separator) {
+        web_root_str += std::filesystem::path::preferred_separator;
+    }
+    std::error_code ec;
+    if (normalized_path.string().find(web_root_str) != 0 || std::filesystem::is_directory(normalized_path, ec)) {
+        throw HttpRequestException("upload path is invalid", HTTP_ERR_FORBIDDEN);
+    }
+    if (!std::filesystem::is_directory(normalized_path.parent_path(), ec)) {
+        throw HttpRequestException("upload directory does not exist", HTTP_ERR_NOT_FOUND);
+    }
+    return normalized_path;
+}
+
+HttpServer::HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root,
+    size_t worker_count)
+    : HttpServer(listen_addr, listen_port, web_root, std::make_unique<WorkStealingExecutor>(worker_count))
+{
+}
+
+HttpServer::HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root,
+    std::unique_ptr<Executor> executor)
+    : TcpServer(listen_addr, listen_port), web_root(web_root), executor(std::move(executor))
+{
+    setup();
+}
+
+HttpServer::HttpServer(int32_t listen_fd, const std::string& web_root, size_t worker_count)
+    : HttpServer(listen_fd, web_root, std::make_unique<WorkStealingExecutor>(worker_count))
+{
+}
+
+HttpServer::HttpServer(int32_t listen_fd, const std::string& web_root, std::unique_ptr<Executor> executor)
+    : TcpServer(listen_fd), web_root(web_root), executor(std::move(executor))
+{
+    setup();
+}
+
+HttpServer::~HttpServer()
+{
+    stop();
+}
+
+void HttpServer::setup()
+{
+    // 校验web根目录是否存在
+    if (!std::filesystem::exists(web_root) || !std::filesystem::is_directory(web_root)) {
+        this->executor->stop();
+        throw std::runtime_error("web_root is not a valid directory");
+    }
+
+    // 文件内容由reactor以sendfile发出，而sendfile无法指定MSG_NOSIGNAL，
+    // 对端中途断开时会触发SIGPIPE，这里将其忽略，由EPIPE错误码处理
+    signal(SIGPIPE, SIG_IGN);
+
+    LOG_INFO("HTTP server started on %s:%hu, serving files from %s", get_listen_addr().c_str(), get_listen_port(),
+        web_root.c_str());
+}
+
+void HttpServer::stop()
+{
+    if (stopped.exchange(true)) {
+        return;
+    }
+
+    // 等待所有工作线程处理完已提交的请求后结束
+    executor->stop();
+
+    gzip_cache.stop();
+
+    HttpCacheStats stats = file_cache.get_stats();
+    LOG_INFO("file cache: hits=%lu misses=%lu hit_ratio=%.3f entries=%zu bytes=%zu",
+        stats.hits, stats.misses, stats.hit_ratio(), stats.entries, stats.bytes);
+    HttpGzipStats gzip_stats = gzip_cache.get_stats();
+    LOG_INFO("gzip: compressed=%lu precompressed=%lu bytes_saved=%lu",
+        gzip_stats.compressed_responses, gzip_stats.precompressed_responses, gzip_stats.bytes_saved);
+    HttpAdmissionStats admission_stats = admission.get_stats();
+    LOG_INFO("admission: admitted=%lu rejected=%lu expired=%lu pauses=%lu queue_wait_us mean=%.1f p50=%lu p99=%lu max=%lu",
+        admission_stats.admitted, admission_stats.rejected, admission_stats.expired, admission_stats.pauses,
+        admission_stats.mean_wait_us, admission_stats.p50_wait_us, admission_stats.p99_wait_us,
+        admission_stats.max_wait_us);
+    if (tracer) {
+        HttpTraceStats trace_stats = tracer->get_stats();
+        const HttpSpanStats& total = trace_stats.spans[HTTP_SPAN_TOTAL];
+        LOG_INFO("trace: requests=%lu slow=%lu sampled=%lu total_us mean=%.1f p50=%lu p99=%lu max=%lu",
+            trace_stats.traced, trace_stats.slow, trace_stats.sampled, total.mean_us, total.p50_us, total.p99_us,
+            total.max_us);
+    }
+}
+
+bool HttpServer::drain(std::chrono::milliseconds timeout)
+{
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    draining = true;
+    stop_accepting();
+    LOG_INFO("draining, wait up to %ld ms for in-flight requests", static_cast<long>(timeout.count()));
+
+    for (;;) {
+        size_t remaining = close_idle_connections();
+        if (remaining == 0) {
+            LOG_INFO("drain finished, all connections closed");
+            return true;
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            LOG_ERR("drain timed out with %zu connections still busy", remaining);
+            return false;
+        }
+        listen_loop();
+    }
+}
+
+HttpCacheStats HttpServer::get_cache_stats() const
+{
+    return file_cache.get_stats();
+}
+
+void HttpServer::set_etag_mode(HttpEtagMode mode)
+{
+    etag_generator.set_mode(mode);
+}
+
+void HttpServer::set_file_strategy(HttpFileStrategy strategy)
+{
+    file_strategy = strategy;
+    LOG_INFO("file transmission strategy: %s", HttpTransfer::get_strategy_name(strategy));
+}
+
+HttpGzipStats HttpServer::get_gzip_stats() const
+{
+    return gzip_cache.get_stats();
+}
+
+HttpAdmissionStats HttpServer::get_admission_stats() const
+{
+    return admission.get_stats();
+}
+
+void HttpServer::set_admission_limits(size_t max_queued, std::chrono::milliseconds max_queue_wait)
+{
+    admission.configure(max_queued, max_queue_wait);
+    LOG_INFO("admission limits: max_queued=%zu max_queue_wait=%ldms", max_queued,
+        static_cast<long>(max_queue_wait.count()));
+}
+
+void HttpServer::enable_shaping(const HttpShapingConfig& config)
+{
+    shaper = std::make_unique<HttpShaper>(config);
+    for (size_t i = 0; i < HTTP_TRAFFIC_CLASS_COUNT; i++) {
+        LOG_INFO("shaping %s: quantum=%zu rate=%lu", HttpShaper::get_class_name(static_cast<HttpTrafficClass>(i)),
+            config.classes[i].quantum, config.classes[i].rate);
+    }
+    LOG_INFO("shaping per client IP: rate=%lu", config.client_rate);
+}
+
+void HttpServer::serve_pack(const std::string& pack_path)
+{
+    pack = std::make_shared<const HttpPack>(pack_path);
+    LOG_INFO("serving %zu files from pack %s", pack->get_entry_count(), pack_path.c_str());
+}
+
+void HttpServer::enable_uploads(uint64_t max_size)
+{
+    max_upload_size = max_size;
+    LOG_INFO("uploads enabled, max_size=%lu", max_size);
+}
+
+HttpShapingStats HttpServer::get_shaping_stats() const
+{
+    return shaper ? shaper->get_stats() : HttpShapingStats();
+}
+
+void HttpServer::add_proxy_route(const std::string& prefix, const std::vector<HttpUpstreamAddress>& upstreams,
+    const HttpProxyConfig& config)
+{
+    if (!proxy) {
+        HttpProxyConfig proxy_config = config;
+        if (proxy_config.max_in_flight == 0) {
+            // 至少留一个工作线程处理本地请求
+            size_t threads = executor->get_thread_count();
+            proxy_config.max_in_flight = threads > 1 ? threads - 1 : 1;
+        }
+        proxy = std::make_unique<HttpProxy>(proxy_config);
+    }
+    proxy->add_route(prefix, upstreams);
+    LOG_INFO("proxy %s to %zu upstreams", prefix.c_str(), upstreams.size());
+}
+
+void HttpServer::enable_tracing(const HttpTraceConfig& config)
+{
+    tracer = std::make_unique<HttpTracer>(config);
+}
+
+HttpTraceStats HttpServer::get_trace_stats() const
+{
+    return tracer ? tracer->get_stats() : HttpTraceStats();
+}
+
+HttpProxyStats HttpServer::get_proxy_stats() const
+{
+    return proxy ? proxy->get_stats() : HttpProxyStats();
+}
+
+bool HttpServer::is_proxied(const HttpRequest& request) const
+{
+    return proxy && proxy->matches(request.filepath);
+}
+
+size_t HttpServer::get_active_transfers() const
+{
+    return active_transfers.load();
+}
+
+void HttpServer::enable_tls(const std::string& cert_file, const std::string& key_file, bool enable_ktls)
+{
+    tls_context = std::make_unique<TlsContext>(cert_file, key_file, enable_ktls);
+    LOG_INFO("TLS enabled with certificate %s, kTLS %s", cert_file.c_str(), enable_ktls ? "requested" : "disabled");
+}
+
+void HttpServer::deal_new_client(int32_t client_fd, const sockaddr_in& client_addr)
+{
+    auto connection = std::make_shared<HttpConnection>();
+    if (tracer) {
+        connection->accepted = HttpTrace::now();
+    }
+    if (tls_context) {
+        try {
+            connection->tls = std::make_unique<TlsSession>(*tls_context, client_fd);
+        } catch (const TcpRuntimeException& e) {
+            // 不能退回明文，直接断开
+            LOG_ERR("create TLS session for client %d failed: %s", client_fd, e.what());
+            close_client(client_fd);
+            return;
+        }
+    }
+
+    if (shaper) {
+        shaper->attach(connection->flow, client_addr.sin_addr.s_addr);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        connections[client_fd] = std::move(connection);
+    }
+    TcpServer::deal_new_client(client_fd, client_addr);
+}
+
+// 连接关闭前丢弃其上尚未发完的响应
+void HttpServer::deal_client_close(int32_t client_fd)
+{
+    std::shared_ptr<HttpConnection> connection;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        auto it = connections.find(client_fd);
+        if (it == connections.end()) {
+            return;
+        }
+        connection = std::move(it->second);
+        connections.erase(it);
+    }
+
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    connection->closed = true;
+    active_transfers -= connection->transfers.size();
+    connection->transfers.clear();
+    if (connection->h2) {
+        active_transfers -= connection->h2->get_pending_responses() + connection->h2->take_completed();
+        connection->h2.reset();
+        connection->h2_output.reset();
+    }
+    if (connection->tls) {
+        connection->tls->shutdown();
+    }
+}
+
+void HttpServer::deal_client_hangup(int32_t client_fd)
+{
+    // 上游在响应体结束时关闭连接，由转发读到EOF后结束响应
+    if (resume_relay(client_fd)) {
+        return;
+    }
+    std::shared_ptr<HttpConnection> connection = find_connection(client_fd);
+    if (!connection) {
+        close_client(client_fd);
+        return;
+    }
+    close_connection(client_fd, connection);
+}
+
+// 每次事件后由所有者显式重新关注，见HttpConnection的说明
+uint32_t HttpServer::get_client_events() const
+{
+    return EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+}
+
+std::shared_ptr<HttpServer::HttpConnection> HttpServer::find_connection(int32_t client_fd)
+{
+    std::lock_guard<std::mutex> lock(connections_mutex);
+    auto it = connections.find(client_fd);
+    return it == connections.end() ? nullptr : it->second;
+}
+
+// 连接上是否有等待socket可写的数据，调用方需持有connection.mutex
+bool HttpServer::has_output(const HttpConnection& connection)
+{
+    return !connection.transfers.empty() || connection.tls_want_write || connection.h2_output ||
+        (connection.h2 && connection.h2->has_output());
+}
+
+// 按连接当前的所有权与待发送数据重新关注事件，调用方需持有connection.mutex
+// 连接归工作线程且无数据待发送时保持不关注，由工作线程交还时再调用；暂停读取的连接不关注EPOLLIN，
+// 在流量整形调度队列中的连接不关注EPOLLOUT，等待上游数据的连接改为关注上游fd
+// @exception epoll_ctl失败时抛出TcpRuntimeException
+void HttpServer::rearm_connection(int32_t client_fd, HttpConnection& connection)
+{
+    if (connection.closed || connection.close_pending) {
+        return;
+    }
+
+    std::shared_ptr<HttpStreamSource> source;
+    if (!connection.transfers.empty()) {
+        source = connection.transfers.front()->get_waiting_source();
+    }
+    uint32_t events = EPOLLRDHUP | EPOLLONESHOT;
+    if (!connection.worker_owned && !connection.paused) {
+        events |= EPOLLIN;
+    }
+    if (has_output(connection) && !connection.flow.scheduled && !source) {
+        events |= EPOLLOUT;
+    }
+    if (source) {
+        watch_relay(client_fd, source);
+    }
+    // 暂停读取的连接仍关注EPOLLRDHUP，对端在暂停期间断开时及时回收
+    if ((events & (EPOLLIN | EPOLLOUT)) || connection.paused) {
+        modify_client_events(client_fd, events);
+    }
+}
+
+// 关注上游fd，可读时继续转发client_fd上等待它的响应
+// @exception epoll_ctl失败时抛出TcpRuntimeException
+void HttpServer::watch_relay(int32_t client_fd, const std::shared_ptr<HttpStreamSource>& source)
+{
+    {
+        std::lock_guard<std::mutex> lock(relays_mutex);
+        relays[source->get_fd()] = {client_fd, source};
+    }
+    watch_fd(source->get_fd(), EPOLLIN | EPOLLONESHOT);
+}
+
+// 传输在上游可读之前被其他事件推进时，先把仍在关注的上游fd移出epoll；
+// 此时来源仍由传输持有，fd不会已被关闭或复用
+// @exception epoll_ctl失败时抛出TcpRuntimeException
+void HttpServer::unwatch_relay(const HttpTransfer& transfer)
+{
+    std::shared_ptr<HttpStreamSource> source = transfer.get_waiting_source();
+    if (!source) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(relays_mutex);
+        auto it = relays.find(source->get_fd());
+        if (it == relays.end() || it->second.second.lock() != source) {
+            return;
+        }
+        relays.erase(it);
+    }
+    unwatch_fd(source->get_fd());
+}
+
+// fd是等待中的上游连接时继续转发其所属的响应，事件已由EPOLLONESHOT解除关注；否则返回false按客户端处理。
+// 记录已失效（连接关闭时来源随之关闭，fd可能已被新连接复用）时同样返回false
+bool HttpServer::resume_relay(int32_t fd)
+{
+    int32_t client_fd = -1;
+    std::shared_ptr<HttpStreamSource> source;
+    {
+        std::lock_guard<std::mutex> lock(relays_mutex);
+        auto it = relays.find(fd);
+        if (it == relays.end()) {
+            return false;
+        }
+        client_fd = it->second.first;
+        source = it->second.second.lock();
+        relays.erase(it);
+    }
+    if (!source || source->get_fd() != fd) {
+        return false;
+    }
+    deal_client_writable(client_fd);
+    return true;
+}
+
+// 关闭没有在途请求与待发送数据的连接，返回仍在忙的连接数；在reactor线程上调用
+// 缓冲区中有未收齐的请求、因积压暂停读取的连接也视为在忙，等请求处理完毕后再关闭
+size_t HttpServer::close_idle_connections()
+{
+    std::vector<std::pair<int32_t, std::shared_ptr<HttpConnection>>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(connections_mutex);
+        snapshot.assign(connections.begin(), connections.end());
+    }
+
+    size_t busy = 0;
+    for (auto& [client_fd, connection] : snapshot) {
+        bool idle = false;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            idle = !connection->closed && !connection->worker_owned && connection->worker_streams == 0 &&
+                !connection->paused && !connection->flow.scheduled && connection->input.empty() && !connection->upload &&
+                !has_output(*connection) && (!connection->h2 || connection->h2->get_pending_responses() == 0);
+        }
+        if (idle) {
+            close_client(client_fd);
+        } else {
+            busy++;
+        }
+    }
+    return busy;
+}
+
+// reactor线程上关闭连接；连接正归工作线程所有或仍有HTTP/2流在工作线程处理时推迟关闭，
+// 避免与工作线程的读写竞争，也避免fd被新连接复用后收到旧连接的响应
+void HttpServer::close_connection(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed) {
+            return;
+        }
+        if (connection->worker_owned || connection->worker_streams > 0) {
+            connection->close_pending = true;
+            return;
+        }
+    }
+    close_client(client_fd);
+}
+
+// 推进TLS握手，返回false表示对端已关闭；调用方需持有connection.mutex
+// @exception 握手失败时抛出TcpRuntimeException
+bool HttpServer::advance_handshake(int32_t client_fd, HttpConnection& connection)
+{
+    TlsStatus status = connection.tls->handshake();
+    connection.tls_want_write = status == TLS_WANT_WRITE;
+    if (status == TLS_OK) {
+        LOG_DEBUG("TLS established on client %d, kTLS send %s", client_fd,
+            connection.tls->is_ktls_send() ? "on" : "off");
+    }
+    return status != TLS_CLOSED;
+}
+
+// 读入socket中当前可读的全部数据，返回false表示对端已关闭；调用方需持有connection.mutex
+// @exception 读取出错时抛出TcpRuntimeException，缓冲数据超过上限仍未收齐请求头时抛出HttpRequestException
+bool HttpServer::read_input(int32_t client_fd, HttpConnection& connection)
+{
+    char buf[RECV_BUFFER_SIZE];
+    bool was_empty = connection.input.empty();
+    while (connection.input.size() < MAX_INPUT_SIZE) {
+        if (connection.tls) {
+            TlsStatus status = TLS_OK;
+            ssize_t len = connection.tls->read(buf, sizeof(buf), status);
+            if (len > 0) {
+                connection.input.append(buf, static_cast<size_t>(len));
+                continue;
+            }
+            if (status == TLS_CLOSED) {
+                return false;
+            }
+            break;
+        }
+
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            connection.input.append(buf, static_cast<size_t>(len));
+            continue;
+        }
+        if (len == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        }
+        throw TcpRuntimeException("recv error", __FILENAME__, __LINE__);
+    }
+
+    if (connection.discard_input) {
+        connection.input.clear();
+        return true;
+    }
+    if (tracer && was_empty && !connection.input.empty()) {
+        connection.first_byte = HttpTrace::now();
+    }
+    // HTTP/2的输入是二进制帧，由会话按帧大小上限校验
+    if (!connection.h2 && connection.input.size() >= MAX_INPUT_SIZE &&
+        connection.input.find("\r\n\r\n") == std::string::npos) {
+        connection.input.clear();
+        throw HttpRequestException("request header too large", HTTP_ERR_BAD_REQUEST);
+    }
+    return true;
+}
+
+// 从缓冲区取出一个完整的请求头，first_byte返回其数据读入的时间戳，调用方需持有connection.mutex；
+// 管线化的后续请求与之一同读入，沿用同一时间戳
+bool HttpServer::next_request(HttpConnection& connection, std::string& header, int64_t& first_byte)
+{
+    size_t end = connection.input.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        return false;
+    }
+    header = connection.input.substr(0, end + 4);
+    connection.input.erase(0, end + 4);
+    first_byte = connection.first_byte;
+    if (connection.input.empty()) {
+        connection.first_byte = 0;
+    }
+    return true;
+}
+
+// 请求头解析完毕后开始跟踪，未启用跟踪时不读时钟
+void HttpServer::begin_trace(HttpRequest& request, const HttpConnection& connection, int64_t first_byte)
+{
+    if (!tracer) {
+        return;
+    }
+    int64_t now = HttpTrace::now();
+    request.trace.mark(HTTP_PHASE_ACCEPT, connection.accepted);
+    request.trace.mark(HTTP_PHASE_FIRST_BYTE, first_byte != 0 ? first_byte : now);
+    request.trace.mark(HTTP_PHASE_PARSED, now);
+}
+
+// 发送推进后记录响应头与响应体发出的时间点，响应发完时计入汇总；在reactor线程上调用
+void HttpServer::trace_progress(int32_t client_fd, HttpTransfer& transfer, bool finished)
+{
+    HttpTrace *trace = transfer.get_trace();
+    if (!trace || (!finished && (trace->has(HTTP_PHASE_HEADERS_SENT) || !transfer.is_head_sent()))) {
+        return;
+    }
+    int64_t now = HttpTrace::now();
+    if (!trace->has(HTTP_PHASE_HEADERS_SENT)) {
+        trace->mark(HTTP_PHASE_HEADERS_SENT, now);
+    }
+    if (finished) {
+        trace->mark(HTTP_PHASE_BODY_DONE, now);
+        tracer->record(client_fd, *trace);
+    }
+}
+
+// 按顺序推进连接上排队的响应，至多发送budget字节并从中扣除已发送的部分，调用方需持有connection.mutex；
+// 返回false表示响应要求发送后关闭连接
+// @exception 发送失败时抛出TcpRuntimeException
+bool HttpServer::pump_transfers(int32_t client_fd, HttpConnection& connection, size_t& budget)
+{
+    // 握手完成之前不能发送应用数据
+    if (connection.tls && !connection.tls->is_established()) {
+        return true;
+    }
+
+    while (!connection.transfers.empty() && budget > 0) {
+        HttpTransfer& transfer = *connection.transfers.front();
+        unwatch_relay(transfer);
+        off_t before = transfer.get_bytes_sent();
+        bool finished = connection.tls ? transfer.resume(*connection.tls, budget) : transfer.resume(client_fd, budget);
+        budget -= std::min(budget, static_cast<size_t>(transfer.get_bytes_sent() - before));
+        if (tracer) {
+            trace_progress(client_fd, transfer, finished);
+        }
+        if (!finished) {
+            break;
+        }
+
+        bool close_after = transfer.get_close_after();
+        connection.transfers.pop_front();
+        active_transfers--;
+        if (close_after) {
+            return false;
+        }
+    }
+
+    // Upgrade的101响应发出之后才能发送HTTP/2帧
+    if (connection.h2 && connection.transfers.empty()) {
+        return pump_h2_output(client_fd, connection, budget);
+    }
+    return true;
+}
+
+// 逐批组织并发送HTTP/2帧，至多发送budget字节，返回false表示会话已结束，应关闭连接；
+// 调用方需持有connection.mutex。h2c只在明文连接上启用，因此直接写socket
+// @exception 发送失败时抛出TcpRuntimeException
+bool HttpServer::pump_h2_output(int32_t client_fd, HttpConnection& connection, size_t& budget)
+{
+    while (budget > 0) {
+        if (!connection.h2_output) {
+            connection.h2_output = connection.h2->next_output();
+            active_transfers -= connection.h2->take_completed();
+            if (!connection.h2_output) {
+                break;
+            }
+        }
+
+        off_t before = connection.h2_output->get_bytes_sent();
+        bool finished = connection.h2_output->resume(client_fd, budget);
+        budget -= std::min(budget, static_cast<size_t>(connection.h2_output->get_bytes_sent() - before));
+        if (!finished) {
+            return true;
+        }
+        connection.h2_output.reset();
+    }
+    return connection.h2_output || !connection.h2->is_finished();
+}
+
+// reactor线程上推进连接的发送，调用方需持有connection->mutex，返回false表示应关闭连接：
+// 未启用流量整形时直接发送一个resume预算的数据；启用时只把连接放入调度队列，由本轮事件处理之后的轮询发送
+// @exception 发送失败时抛出TcpRuntimeException
+bool HttpServer::flush_output(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    if (!shaper) {
+        size_t budget = HttpTransfer::DEFAULT_RESUME_BUDGET;
+        return pump_transfers(client_fd, *connection, budget);
+    }
+    if (!connection->flow.scheduled && has_output(*connection)) {
+        connection->flow.scheduled = true;
+        ready_flows.emplace_back(client_fd, connection);
+    }
+    return true;
+}
+
+// 为一个调度队列中的连接推进一次发送，返回false表示应关闭连接：
+// 令牌不足时移入等待列表；额度用完而数据未发完时排到队尾，socket写满或数据发完时退出调度，按需重新关注EPOLLOUT
+bool HttpServer::run_flow(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+    std::chrono::steady_clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(connection->mutex);
+    if (connection->closed) {
+        return true;
+    }
+
+    HttpFlow& flow = connection->flow;
+    HttpTrafficClass traffic_class = connection->transfers.empty() ? HTTP_TRAFFIC_INTERACTIVE :
+        connection->transfers.front()->get_traffic_class();
+    size_t granted = shaper->grant(flow, traffic_class, now);
+    if (granted == 0) {
+        throttled_flows.push_back({now + shaper->wait_time(flow, now), client_fd, connection});
+        return true;
+    }
+
+    size_t budget = granted;
+    bool keep_alive = true;
+    try {
+        keep_alive = pump_transfers(client_fd, *connection, budget);
+    } catch (const TcpRuntimeException& e) {
+        LOG_ERR("send response to client %d failed: %s", client_fd, e.what());
+        keep_alive = false;
+    }
+    bool pending = has_output(*connection);
+    shaper->charge(flow, granted - budget, !pending);
+    if (!keep_alive) {
+        return false;
+    }
+
+    if (pending && budget == 0) {
+        ready_flows.emplace_back(client_fd, connection);
+        return true;
+    }
+    flow.scheduled = false;
+    try {
+        rearm_connection(client_fd, *connection);
+    } catch (const TcpRuntimeException& e) {
+        LOG_ERR("rearm client %d failed: %s", client_fd, e.what());
+        return false;
+    }
+    return true;
+}
+
+// 每轮事件处理之后执行一轮差额轮询：令牌已攒够的连接先回到就绪队列，队列中的每个连接各发送一次
+void HttpServer::deal_loop_end()
+{
+    if (!shaper || (ready_flows.empty() && throttled_flows.empty())) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < throttled_flows.size(); ) {
+        if (throttled_flows[i].wake <= now) {
+            ready_flows.emplace_back(throttled_flows[i].client_fd, std::move(throttled_flows[i].connection));
+            throttled_flows[i] = std::move(throttled_flows.back());
+            throttled_flows.pop_back();
+        } else {
+            i++;
+        }
+    }
+
+    shaper->record_round();
+    for (size_t count = ready_flows.size(); count > 0; count--) {
+        auto [client_fd, weak_connection] = std::move(ready_flows.front());
+        ready_flows.pop_front();
+        std::shared_ptr<HttpConnection> connection = weak_connection.lock();
+        if (connection && !run_flow(client_fd, connection, now)) {
+            close_connection(client_fd, connection);
+        }
+    }
+}
+
+// 就绪队列非空时不等待，仅有限速等待的连接时等到最早的一个到期
+int32_t HttpServer::get_loop_timeout()
+{
+    if (!ready_flows.empty()) {
+        return 0;
+    }
+    // 排空期间连接在事件之外也会变为空闲（如工作线程交还后无数据待发），需及时检查
+    int32_t limit = draining ? DRAIN_POLL_INTERVAL : static_cast<int32_t>(EPOLL_TIMEOUT);
+    if (throttled_flows.empty()) {
+        return limit;
+    }
+
+    auto earliest = throttled_flows.front().wake;
+    for (const ThrottledFlow& throttled : throttled_flows) {
+        earliest = std::min(earliest, throttled.wake);
+    }
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(earliest - std::chrono::steady_clock::now()).count();
+    return static_cast<int32_t>(std::clamp<int64_t>(wait, 0, limit));
+}
+
+// 把响应交给连接：reactor线程上立即尝试发送（启用流量整形时进入调度队列），小响应通常一次即可发完，
+// 事件由调用方稍后重新关注；工作线程上只入队并关注EPOLLOUT，实际发送由reactor完成，工作线程不会被慢速客户端占住
+// stream_id非0时响应属于HTTP/2流，交给h2会话转换为帧
+void HttpServer::submit_transfer(int32_t client_fd, std::unique_ptr<HttpTransfer> transfer, uint32_t stream_id)
+{
+    std::shared_ptr<HttpConnection> connection = find_connection(client_fd);
+    if (!connection) {
+        LOG_DEBUG("client %d is closed before its response is ready", client_fd);
+        return;
+    }
+
+    bool keep_alive = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed) {
+            return;
+        }
+        if (connection->h2 && stream_id != 0) {
+            if (connection->h2->submit_response(stream_id, std::move(transfer))) {
+                active_transfers++;
+            }
+        } else if (connection->h2) {
+            // 已切换到HTTP/2的连接上无法再发送HTTP/1.1响应，连接级错误只能断开
+            LOG_ERR("connection-level error on HTTP/2 client %d", client_fd);
+            keep_alive = false;
+        } else {
+            if (get_socket_options().cork && !connection->tls) {
+                transfer->set_cork(true);
+            }
+            connection->transfers.push_back(std::move(transfer));
+            active_transfers++;
+        }
+
+        try {
+            if (keep_alive && is_loop_thread()) {
+                keep_alive = flush_output(client_fd, connection);
+            } else if (keep_alive) {
+                rearm_connection(client_fd, *connection);
+            }
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("send response to client %d failed: %s", client_fd, e.what());
+            keep_alive = false;
+        }
+    }
+
+    if (!keep_alive) {
+        close_connection(client_fd, connection);
+    }
+}
+
+void HttpServer::submit_transfer(const HttpRequest& request, std::unique_ptr<HttpTransfer> transfer)
+{
+    // HEAD与GET走同一条路径生成响应，在交付前去掉响应体，Content-Length等头部保持不变
+    if (request.type == HTTP_REQUEST_HEAD) {
+        transfer->discard_body();
+    }
+    if (request.trace.active()) {
+        HttpTrace trace = request.trace;
+        trace.target = request.filepath;
+        transfer->set_trace(std::move(trace));
+    }
+    submit_transfer(request.client_fd, std::move(transfer), request.stream_id);
+}
+
+void HttpServer::deal_client_writable(int32_t client_fd)
+{
+    std::shared_ptr<HttpConnection> connection = find_connection(client_fd);
+    if (!connection) {
+        return;
+    }
+
+    bool keep_alive = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        try {
+            if (connection->tls && !connection->tls->is_established()) {
+                keep_alive = advance_handshake(client_fd, *connection);
+            }
+            if (keep_alive) {
+                keep_alive = flush_output(client_fd, connection);
+            }
+            if (keep_alive) {
+                rearm_connection(client_fd, *connection);
+            }
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("send response to client %d failed: %s", client_fd, e.what());
+            keep_alive = false;
+        }
+    }
+
+    if (!keep_alive) {
+        close_connection(client_fd, connection);
+    }
+}
+
+void HttpServer::reply_error(int32_t client_fd, const HttpRequestException& e, uint32_t stream_id) noexcept
+{
+    // 错误响应携带Connection: close，发送完毕后关闭连接；HTTP/2流上的错误只结束该流
+    try {
+        LOG_DEBUG("reply %u to client %d: %s", e.get_err_code(), client_fd, e.what());
+        std::string_view response = e.get_err_resp();
+        auto transfer = std::make_unique<HttpTransfer>();
+        transfer->add_buffer(nullptr, response.data(), response.size());
+        transfer->set_close_after(stream_id == 0);
+        submit_transfer(client_fd, std::move(transfer), stream_id);
+    } catch (const std::exception& ex) {
+        LOG_ERR("reply error to client %d failed: %s", client_fd, ex.what());
+    }
+}
+
+// 写入ETag与Last-Modified响应头；gzip版本的ETag在结尾引号前加-gz后缀，与原文件区分
+void HttpServer::add_validator_headers(HttpHeaderBuilder& header, const HttpValidators& validators, bool gzip)
+{
+    std::string_view etag = validators.etag;
+    if (gzip) {
+        header.append("ETag: ").append(etag.substr(0, etag.size() - 1)).append("-gz\"\r\n");
+    } else {
+        header.add("ETag", etag);
+    }
+    header.add("Last-Modified", validators.last_modified);
+}
+
+// 评估If-None-Match与If-Modified-Since，资源未变化时回复304并返回true
+// 按RFC 7232，携带If-None-Match时忽略If-Modified-Since
+bool HttpServer::reply_not_modified(const HttpRequest& req, const HttpValidators& validators, bool compressible)
+{
+    bool not_modified = false;
+    bool gzip_matched = false;
+    if (!req.if_none_match.empty()) {
+        not_modified = HttpEtagGenerator::etag_matches(req.if_none_match, validators.etag, true);
+        if (!not_modified && compressible) {
+            std::string gzip_etag = validators.etag;
+            gzip_etag.insert(gzip_etag.size() - 1, "-gz");
+            gzip_matched = HttpEtagGenerator::etag_matches(req.if_none_match, gzip_etag, true);
+            not_modified = gzip_matched;
+        }
+    } else if (!req.if_modified_since.empty()) {
+        time_t since = 0;
+        not_modified = HttpEtagGenerator::parse_http_date(req.if_modified_since, since) && validators.mtime <= since;
+    }
+
+    if (!not_modified) {
+        return false;
+    }
+
+    auto transfer = std::make_unique<HttpTransfer>();
+    HttpHeaderBuilder& header = transfer->begin_header();
+    header.status(304);
+    add_validator_headers(header, validators, gzip_matched);
+    if (compressible) {
+        header.add("Vary", "Accept-Encoding");
+    }
+    header.add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+    transfer->add_header();
+    submit_transfer(req, std::move(transfer));
+    LOG_DEBUG("Request %s on client %d not modified", req.filepath.c_str(), req.client_fd);
+    return true;
+}
+
+// If-Range：ETag需强匹配，日期需与Last-Modified一致，否则应忽略Range发送完整文件
+bool HttpServer::range_still_valid(const HttpRequest& req, const HttpValidators& validators)
+{
+    if (req.if_range.empty()) {
+        return true;
+    }
+    if (req.if_range[0] == '"' || req.if_range.compare(0, 2, "W/") == 0) {
+        return HttpEtagGenerator::etag_matches(req.if_range, validators.etag, false);
+    }
+
+    time_t date = 0;
+    return HttpEtagGenerator::parse_http_date(req.if_range, date) && date == validators.mtime;
+}
+
+// 解析、合并并校验请求中的range，返回值至少包含一个有效range
+std::vector<HttpRange> HttpServer::resolve_ranges(HttpRequest& req, off_t file_size)
+{
+    std::vector<HttpRange> ranges = HttpRequest::coalesce_ranges(req.parse_ranges(file_size));
+    if (ranges.empty()) {
+        throw HttpRequestException("invalid range format", HTTP_ERR_BAD_REQUEST);
+    }
+    if (ranges.size() > MAX_RANGE_PARTS) {
+        throw HttpRequestException("too many ranges", HTTP_ERR_RANGE_NOT_SATISFIABLE);
+    }
+
+    for (const HttpRange& range : ranges) {
+        if (!range.valid || range.start < 0 || range.end >= file_size || range.start > range.end) {
+            throw HttpRequestException("invalid range", HTTP_ERR_BAD_REQUEST);
+        }
+    }
+    return ranges;
+}
+
+void HttpServer::build_range_headers(HttpHeaderBuilder& header, const HttpRange& range, std::string_view mime_type,
+    off_t file_size, const HttpValidators& validators)
+{
+    header.status(206)
+        .add("Content-Type", mime_type)
+        .add_content_range(range.start, range.end, file_size)
+        .add("Content-Length", range.end - range.start + 1);
+    add_validator_headers(header, validators);
+    header.add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+}
+
+// 为多个range生成multipart/byteranges响应：随机边界、每段的分段头以及结尾，
+// 响应头中的Content-Length已计入全部分段头、分段内容与结尾
+HttpServer::MultipartPlan HttpServer::plan_multipart(HttpHeaderBuilder& header, const std::vector<HttpRange>& ranges,
+    std::string_view mime_type, off_t file_size, const HttpValidators& validators)
+{
+    thread_local std::mt19937_64 generator(std::random_device{}());
+    char boundary[32] = {0};
+    snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(generator()));
+
+    MultipartPlan plan;
+    off_t content_length = 0;
+    for (const HttpRange& range : ranges) {
+        plan.part_headers.emplace_back(
+            "\r\n--" + std::string(boundary) + "\r\n"
+            "Content-Type: " + std::string(mime_type) + "\r\n"
+            "Content-Range: bytes " + std::to_string(range.start) + "-" + std::to_string(range.end) + "/" + std::to_string(file_size) + "\r\n"
+            "\r\n");
+        content_length += static_cast<off_t>(plan.part_headers.back().size()) + (range.end - range.start + 1);
+    }
+    plan.closing = "\r\n--" + std::string(boundary) + "--\r\n";
+    content_length += static_cast<off_t>(plan.closing.size());
+
+    header.status(206)
+        .append("Content-Type: multipart/byteranges; boundary=").append(boundary).append("\r\n")
+        .add("Content-Length", content_length);
+    add_validator_headers(header, validators);
+    header.add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+    return plan;
+}
+
+// 读入小文件，预渲染200响应头，并尝试放入热点缓存
+// 无论是否被准入，返回的条目都可直接用于本次发送
+std::shared_ptr<const HttpCacheEntry> HttpServer::load_cache_entry(const HttpRequest& req,
+    const std::string& full_path, const struct stat& file_stat, const HttpValidators& validators)
+{
+    auto entry = std::make_shared<HttpCacheEntry>();
+    entry->full_path = full_path;
+    entry->size = file_stat.st_size;
+    entry->mtime = file_stat.st_mtim;
+    entry->mime_type = HttpHeaderBuilder::get_mime_type(req.filepath);
+    entry->compressible = HttpGzipCache::is_compressible(entry->mime_type);
+    entry->validators = validators;
+    entry->body = read_file_content(full_path, file_stat.st_size);
+    HttpHeaderBuilder header;
+    header.status(200)
+        .add("Content-Type", entry->mime_type)
+        .add("Content-Length", file_stat.st_size);
+    if (entry->compressible) {
+        header.add("Vary", "Accept-Encoding");
+    }
+    add_validator_headers(header, validators);
+    header.add("Cache-Control", "public")
+        .add("Connection", "keep-alive")
+        .finish();
+    entry->headers = std::string(header.view());
+
+    // 读取期间文件可能被修改，此时不放入缓存，下次访问时重新载入
+    struct stat check_stat;
+    if (stat(full_path.c_str(), &check_stat) == 0 &&
+        check_stat.st_mtim.tv_sec == file_stat.st_mtim.tv_sec &&
+        check_stat.st_mtim.tv_nsec == file_stat.st_mtim.tv_nsec &&
+        check_stat.st_size == file_stat.st_size) {
+        file_cache.admit(req.filepath, entry);
+    }
+    return entry;
+}
+
+// 发送内存中的响应，各段直接引用缓存条目，通常以单次writev发出；Range请求直接对缓存的文件内容切片
+void HttpServer::send_cached_response(HttpRequest& req, const std::shared_ptr<const HttpCacheEntry>& entry)
+{
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->set_traffic_class(HttpShaper::classify(entry->mime_type));
+    if (!req.is_range_request) {
+        transfer->add_buffer(entry, entry->headers.data(), entry->headers.size());
+        transfer->add_buffer(entry, entry->body.data(), entry->body.size());
+        submit_transfer(req, std::move(transfer));
+        return;
+    }
+
+    std::vector<HttpRange> ranges = resolve_ranges(req, entry->size);
+    if (ranges.size() == 1) {
+        const HttpRange& range = ranges[0];
+        build_range_headers(transfer->begin_header(), range, entry->mime_type, entry->size, entry->validators);
+        transfer->add_header();
+        transfer->add_buffer(entry, entry->body.data() + range.start, static_cast<size_t>(range.end - range.start + 1));
+        submit_transfer(req, std::move(transfer));
+        return;
+    }
+
+    // 多个range：响应头、各分段头与切片、结尾依次排列，发送时聚合为writev
+    MultipartPlan plan = plan_multipart(transfer->begin_header(), ranges, entry->mime_type, entry->size,
+        entry->validators);
+    transfer->add_header();
+    for (size_t i = 0; i < ranges.size(); i++) {
+        transfer->add_buffer(std::move(plan.part_headers[i]));
+        transfer->add_buffer(entry, entry->body.data() + ranges[i].start,
+            static_cast<size_t>(ranges[i].end - ranges[i].start + 1));
+    }
+    transfer->add_buffer(std::move(plan.closing));
+    submit_transfer(req, std::move(transfer));
+}
+
+// reactor线程上的快速路径：命中热点缓存时直接回复，不再进入工作队列
+// 以归档提供服务时由归档回复，只有需要sendfile的大文件进入工作队列
+bool HttpServer::reply_from_cache(HttpRequest& req)
+{
+    if (pack) {
+        return reply_from_pack(req, true);
+    }
+
+    std::shared_ptr<const HttpCacheEntry> entry = file_cache.lookup(req.filepath);
+    if (!entry) {
+        return false;
+    }
+
+    if (reply_not_modified(req, entry->validators, entry->compressible)) {
+        return true;
+    }
+    if (req.is_range_request && !range_still_valid(req, entry->validators)) {
+        req.is_range_request = false;
+    }
+
+    // 客户端接受gzip时优先发送压缩版本；压缩版本尚未就绪则交给工作线程协商
+    if (req.accept_gzip && !req.is_range_request && entry->compressible) {
+        std::shared_ptr<const HttpGzipVariant> variant = gzip_cache.lookup(entry->full_path, entry->mtime);
+        if (!variant) {
+            return false;
+        }
+        if (variant->beneficial) {
+            send_gzip_variant(req, variant);
+            return true;
+        }
+    }
+
+    send_cached_response(req, entry);
+    LOG_DEBUG("Request %s on client %d served from cache", req.filepath.c_str(), req.client_fd);
+    return true;
 }
 
-HttpServer::HttpServer(const std::string &listen_addr, uint16_t listen_port, const std::string& web_root) 
-    : TcpServer(listen_addr, listen_port), web_root(web_root)
+// 按归档索引回复，文件内容直接引用归档：不超过MMAP_MAX_SIZE的区间作为映射区内存段，与响应头聚合为一次writev，
+// 更大的区间在归档fd上按偏移发送；inline_only时不处理需要文件段的响应并返回false，由工作线程处理
+// @exception 归档中没有该路径时抛出HttpRequestException（404），range非法时抛出HttpRequestException
+bool HttpServer::reply_from_pack(HttpRequest& req, bool inline_only)
 {
-    // 校验web根目录是否存在
-    if (!std::filesystem::exists(web_root) || !std::filesystem::is_directory(web_root)) {
-        throw std::runtime_error("web_root is not a valid directory");
+    HttpPackEntry entry;
+    if (!pack->lookup(req.filepath, entry)) {
+        throw HttpRequestException("not found in pack", HTTP_ERR_NOT_FOUND);
     }
-    
-    // 启动工作线程
-    for (size_t i = 0; i < MAX_WORKER_THREADS; ++i) {
-        worker_threads.emplace_back(&HttpServer::process_requests, this);
+
+    HttpValidators validators{std::string(entry.etag), std::string(entry.last_modified), entry.mtime};
+    bool has_gzip = entry.gzip_size > 0;
+    if (reply_not_modified(req, validators, has_gzip)) {
+        return true;
+    }
+    if (req.is_range_request && !range_still_valid(req, validators)) {
+        req.is_range_request = false;
     }
 
-    LOG_INFO("HTTP server started on %s:%hu, serving files from %s", listen_addr.c_str(), listen_port, web_root.c_str());
-}
+    std::vector<HttpRange> ranges;
+    if (req.is_range_request) {
+        ranges = resolve_ranges(req, entry.size);
+    }
+    bool gzip = req.accept_gzip && !req.is_range_request && has_gzip;
+    off_t body_offset = gzip ? entry.gzip_offset : entry.offset;
+    off_t body_size = gzip ? entry.gzip_size : entry.size;
 
-HttpServer::~HttpServer()
-{
-    stop();
-}
+    bool needs_file = ranges.empty() && body_size > HttpTransfer::MMAP_MAX_SIZE;
+    for (const HttpRange& range : ranges) {
+        needs_file |= range.end - range.start + 1 > HttpTransfer::MMAP_MAX_SIZE;
+    }
+    if (needs_file && inline_only) {
+        return false;
+    }
 
-void HttpServer::stop()
-{
-    stop_flag.store(true);
-    queue_cv.notify_all();
-    
-    // 等待所有工作线程结束
-    for (auto& thread : worker_threads) {
-        if (thread.joinable()) {
-            thread.join();
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->set_traffic_class(HttpShaper::classify(entry.mime_type));
+    auto add_body = [&](off_t offset, off_t length) {
+        if (length <= HttpTransfer::MMAP_MAX_SIZE) {
+            transfer->add_buffer(pack, pack->get_data(offset), static_cast<size_t>(length));
+        } else {
+            transfer->add_file(pack->get_file(), offset, length, file_strategy.load());
+        }
+    };
+
+    if (ranges.empty()) {
+        HttpHeaderBuilder& header = transfer->begin_header();
+        header.status(200)
+            .add("Content-Type", entry.mime_type);
+        if (gzip) {
+            header.add("Content-Encoding", "gzip");
+        }
+        header.add("Content-Length", body_size);
+        if (has_gzip) {
+            header.add("Vary", "Accept-Encoding");
+        }
+        add_validator_headers(header, validators, gzip);
+        header.add("Cache-Control", "public")
+            .add("Connection", "keep-alive")
+            .finish();
+        transfer->add_header();
+        add_body(body_offset, body_size);
+    } else if (ranges.size() == 1) {
+        const HttpRange& range = ranges[0];
+        build_range_headers(transfer->begin_header(), range, entry.mime_type, entry.size, validators);
+        transfer->add_header();
+        add_body(entry.offset + range.start, range.end - range.start + 1);
+    } else {
+        MultipartPlan plan = plan_multipart(transfer->begin_header(), ranges, entry.mime_type, entry.size, validators);
+        transfer->add_header();
+        for (size_t i = 0; i < ranges.size(); i++) {
+            transfer->add_buffer(std::move(plan.part_headers[i]));
+            add_body(entry.offset + ranges[i].start, ranges[i].end - ranges[i].start + 1);
         }
+        transfer->add_buffer(std::move(plan.closing));
     }
+
+    submit_transfer(req, std::move(transfer));
+    if (gzip) {
+        gzip_cache.record_precompressed(entry.size, entry.gzip_size);
+    }
+    LOG_DEBUG("Request %s on client %d served from pack", req.filepath.c_str(), req.client_fd);
+    return true;
 }
 
-void HttpServer::deal_new_client(int32_t client_fd, const sockaddr_in& client_addr)
+void HttpServer::send_gzip_variant(const HttpRequest& req, const std::shared_ptr<const HttpGzipVariant>& variant)
 {
-    // 暂时使用基类版本
-    TcpServer::deal_new_client(client_fd, client_addr);
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->add_buffer(variant, variant->headers.data(), variant->headers.size());
+    transfer->add_buffer(variant, variant->body.data(), variant->body.size());
+    submit_transfer(req, std::move(transfer));
+    gzip_cache.record_compressed(variant->source_size, variant->body.size());
 }
 
-std::string HttpServer::get_mime_type(const std::string& filepath)
-{
-    static std::unordered_map<std::string, std::string> mime_types = {
-        {".html", "text/html"},
-        {".css", "text/css"},
-        {".js", "application/javascript"},
-        {".png", "image/png"},
-        {".jpg", "image/jpeg"},
-        {".gif", "image/gif"},
-        {".ico", "image/x-icon"},
-        {".svg", "image/svg+xml"},
-        {".json", "application/json"},
-        {".xml", "application/xml"},
-        {".pdf", "application/pdf"},
-        {".zip", "application/zip"},
-        {".mp4", "video/mp4"},
-        {".mkv", "video/x-matroska"},
-        {".mpeg", "video/mpeg"},
-        {".avi", "video/x-msvideo"},
-        {".webm", "video/webm"},
-        {".mp3", "audio/mpeg"},
-        {".wav", "audio/wav"},
-        {".txt", "text/plain"},
-        {".flac", "audio/flac"},
-    };
+// 压缩协商：优先发送不旧于源文件的.gz兄弟文件，其次使用后台压缩好的缓存版本；
+// 两者都不可用时调度一次后台压缩，并返回false由调用方发送原文件
+bool HttpServer::try_send_gzip(HttpRequest& req, const std::string& full_path, const struct stat& file_stat,
+    std::string_view mime_type, const HttpValidators& validators)
+{
+    if (!req.accept_gzip || req.is_range_request || !HttpGzipCache::is_compressible(mime_type)) {
+        return false;
+    }
 
-    // 从文件路径获取文件扩展名
-    size_t dot_pos = filepath.find_last_of('.');
-    if (dot_pos != std::string::npos) {
-        std::string extension = filepath.substr(dot_pos);
-        auto it = mime_types.find(extension);
-        if (it != mime_types.end()) {
-            return it->second;
-        }
+    std::string gz_path = full_path + ".gz";
+    struct stat gz_stat;
+    if (stat(gz_path.c_str(), &gz_stat) == 0 && S_ISREG(gz_stat.st_mode) &&
+        (gz_stat.st_mtim.tv_sec > file_stat.st_mtim.tv_sec ||
+        (gz_stat.st_mtim.tv_sec == file_stat.st_mtim.tv_sec && gz_stat.st_mtim.tv_nsec >= file_stat.st_mtim.tv_nsec))) {
+        auto transfer = std::make_unique<HttpTransfer>();
+        transfer->set_traffic_class(HttpShaper::classify(mime_type));
+        HttpHeaderBuilder& header = transfer->begin_header();
+        header.status(200)
+            .add("Content-Type", mime_type)
+            .add("Content-Encoding", "gzip")
+            .add("Content-Length", gz_stat.st_size)
+            .add("Vary", "Accept-Encoding");
+        add_validator_headers(header, validators, true);
+        header.add("Cache-Control", "public")
+            .add("Connection", "keep-alive")
+            .finish();
+        transfer->add_header();
+        transfer->add_file(std::make_shared<HttpFile>(gz_path), 0, gz_stat.st_size, file_strategy.load());
+        submit_transfer(req, std::move(transfer));
+        gzip_cache.record_precompressed(file_stat.st_size, gz_stat.st_size);
+        return true;
     }
-    return "application/octet-stream"; // 默认二进制流
-}
 
-void HttpServer::reply_error(int32_t client_fd, const HttpRequestException& e) noexcept
-{
-    // 发送错误信息
-    std::string err_resp = e.get_err_resp();
-    uint16_t err_size = static_cast<uint16_t>(err_resp.length());
-    send_data_nonblock(client_fd, err_resp.c_str(), err_size);
+    std::shared_ptr<const HttpGzipVariant> variant = gzip_cache.lookup(full_path, file_stat.st_mtim);
+    if (!variant) {
+        HttpHeaderBuilder extra_headers;
+        add_validator_headers(extra_headers, validators, true);
+        gzip_cache.schedule(full_path, mime_type, extra_headers.view(), file_stat.st_size, file_stat.st_mtim);
+        return false;
+    }
+    if (!variant->beneficial) {
+        return false;
+    }
+
+    send_gzip_variant(req, variant);
+    return true;
 }
 
 // 处理Range请求
@@ -149,44 +1300,57 @@ void HttpServer::handle_range_request(HttpRequest&& request)
             throw HttpRequestException("cannot access file", HTTP_ERR_NOT_FOUND);
         }
 
-        // 解析Range请求
-        std::vector<HttpRange> ranges = req.parse_ranges(file_stat.st_size);
-        
-        if (ranges.empty()) {
-            throw HttpRequestException("invalid range format", HTTP_ERR_BAD_REQUEST);
+        std::string_view mime_type = HttpHeaderBuilder::get_mime_type(req.filepath);
+        HttpValidators validators = etag_generator.make_validators(full_path, file_stat);
+        if (reply_not_modified(req, validators, HttpGzipCache::is_compressible(mime_type))) {
+            return;
         }
 
-        // 目前只处理第一个range
-        HttpRange range = ranges[0];
-        
-        // 检查range有效性
-        if (!range.valid || range.start < 0 || range.end >= file_stat.st_size || range.start > range.end) {
-            throw HttpRequestException("invalid range", HTTP_ERR_BAD_REQUEST);
+        // If-Range不匹配，说明客户端持有的部分内容已过期，改为发送完整文件
+        if (!range_still_valid(req, validators)) {
+            req.is_range_request = false;
+            handle_full_file_request(std::move(req));
+            return;
         }
 
-        off_t content_length = range.end - range.start + 1;
-        
-        std::string headers = 
-            "HTTP/1.1 206 Partial Content\r\n"
-            "Content-Type: " + get_mime_type(req.filepath) + "\r\n"
-            "Content-Range: bytes " + std::to_string(range.start) + "-" + std::to_string(range.end) + "/" + std::to_string(file_stat.st_size) + "\r\n"
-            "Content-Length: " + std::to_string(content_length) + "\r\n"
-            "Cache-Control: public\r\n"
-            "Connection: keep-alive\r\n"
-            "\r\n";
-        
-        // 发送 HTTP 响应头
-        uint16_t header_size = static_cast<uint16_t>(headers.length());
-        send_data_nonblock(req.client_fd, headers.c_str(), header_size);
-        
-        // 使用 sendfile_nonblock 发送文件内容的指定范围
-        sendfile_nonblock(req.client_fd, full_path, range.start, content_length);
+        // 小文件载入内存后直接切片发送
+        if (file_stat.st_size <= file_cache.get_max_file_size()) {
+            send_cached_response(req, load_cache_entry(req, full_path, file_stat, validators));
+            return;
+        }
+
+        // 解析Range请求，重叠或相邻的range已被合并
+        std::vector<HttpRange> ranges = resolve_ranges(req, file_stat.st_size);
+
+        // 工作线程只打开文件并生成响应头，文件内容由reactor在socket可写时按所选策略分块发出
+        auto file = std::make_shared<HttpFile>(full_path);
+        auto transfer = std::make_unique<HttpTransfer>();
+        transfer->set_traffic_class(HttpShaper::classify(mime_type));
+
+        if (ranges.size() == 1) {
+            const HttpRange& range = ranges[0];
+            build_range_headers(transfer->begin_header(), range, mime_type, file_stat.st_size, validators);
+            transfer->add_header();
+            transfer->add_file(file, range.start, range.end - range.start + 1, file_strategy.load());
+            submit_transfer(req, std::move(transfer));
+            return;
+        }
+
+        // 多个range：分段头作为内存段（第一段与响应头合并发出），分段内容以sendfile零拷贝发送
+        MultipartPlan plan = plan_multipart(transfer->begin_header(), ranges, mime_type, file_stat.st_size, validators);
+        transfer->add_header();
+        for (size_t i = 0; i < ranges.size(); i++) {
+            transfer->add_buffer(std::move(plan.part_headers[i]));
+            transfer->add_file(file, ranges[i].start, ranges[i].end - ranges[i].start + 1, file_strategy.load());
+        }
+        transfer->add_buffer(std::move(plan.closing));
+        submit_transfer(req, std::move(transfer));
     } catch (HttpRequestException& e) {
-        reply_error(req.client_fd, e);
+        reply_error(req.client_fd, e, req.stream_id);
     } catch (TcpRuntimeException& e) {
         reply_error(req.client_fd,
             HttpRequestException("TcpRuntimeException:" + std::string(e.what()),
-            HTTP_ERR_INTERNAL_SERVER_ERROR));
+            HTTP_ERR_INTERNAL_SERVER_ERROR), req.stream_id);
     }
 }
 
@@ -206,32 +1370,61 @@ void HttpServer::handle_full_file_request(HttpRequest&& request)
             LOG_ERR("cannot access file: %s", full_path.c_str());
             throw HttpRequestException("cannot access file", HTTP_ERR_NOT_FOUND);
         }
-        std::string headers = 
-            "HTTP/1.1 200 OK\r\n"
-            "Content-Type: " + get_mime_type(req.filepath) + "\r\n"
-            "Content-Length: " + std::to_string(file_stat.st_size) + "\r\n"
-            "Cache-Control: public\r\n"
-            "Connection: keep-alive\r\n"
-            "\r\n";
-        
-        // 发送 HTTP 响应头
-        uint16_t header_size = static_cast<uint16_t>(headers.length());
-        send_data_nonblock(req.client_fd, headers.c_str(), header_size);
-        
-        // 使用 sendfile_nonblock 发送文件内容
-        sendfile_nonblock(req.client_fd, full_path, 0, file_stat.st_size);
+
+        std::string_view mime_type = HttpHeaderBuilder::get_mime_type(req.filepath);
+        HttpValidators validators = etag_generator.make_validators(full_path, file_stat);
+        if (reply_not_modified(req, validators, HttpGzipCache::is_compressible(mime_type))) {
+            return;
+        }
+
+        // 客户端接受gzip且有可用的压缩版本时，直接发送压缩版本
+        if (try_send_gzip(req, full_path, file_stat, mime_type, validators)) {
+            return;
+        }
+
+        // 小文件载入内存并尝试放入热点缓存，随后以单次writev发出
+        if (file_stat.st_size <= file_cache.get_max_file_size()) {
+            send_cached_response(req, load_cache_entry(req, full_path, file_stat, validators));
+            return;
+        }
+
+        // 工作线程只打开文件并生成响应头，文件内容由reactor在socket可写时按所选策略分块发出
+        auto transfer = std::make_unique<HttpTransfer>();
+        transfer->set_traffic_class(HttpShaper::classify(mime_type));
+        HttpHeaderBuilder& header = transfer->begin_header();
+        header.status(200)
+            .add("Content-Type", mime_type)
+            .add("Content-Length", file_stat.st_size);
+        if (HttpGzipCache::is_compressible(mime_type)) {
+            header.add("Vary", "Accept-Encoding");
+        }
+        add_validator_headers(header, validators);
+        header.add("Cache-Control", "public")
+            .add("Connection", "keep-alive")
+            .finish();
+        transfer->add_header();
+        transfer->add_file(std::make_shared<HttpFile>(full_path), 0, file_stat.st_size, file_strategy.load());
+        submit_transfer(req, std::move(transfer));
     } catch (HttpRequestException& e) {
-        reply_error(req.client_fd, e);
+        reply_error(req.client_fd, e, req.stream_id);
     } catch (TcpRuntimeException& e) {
         reply_error(req.client_fd,
             HttpRequestException("TcpRuntimeException:" + std::string(e.what()),
-            HTTP_ERR_INTERNAL_SERVER_ERROR));
+            HTTP_ERR_INTERNAL_SERVER_ERROR), req.stream_id);
     }
 }
 
 // 在此处根据请求类型，转交对应类别的处理函数
 void HttpServer::handle_request(HttpRequest&& request) { 
+    if (!request.head.empty()) {
+        submit_transfer(request, proxy->forward(request));
+        return;
+    }
     HttpRequest req = request;
+    if (pack) {
+        reply_from_pack(req, false);
+        return;
+    }
     if (req.is_range_request) {
         handle_range_request(std::move(req));
         return;
@@ -240,53 +1433,560 @@ void HttpServer::handle_request(HttpRequest&& request) {
     handle_full_file_request(std::move(req));
 }
 
-// 工作线程的处理函数
-void HttpServer::process_requests() {
-    while (!stop_flag.load()) {
-        std::unique_lock<std::mutex> lock(queue_mutex);
-        queue_cv.wait(lock, [this] { return !request_queue.empty() || stop_flag.load(); });
-        
-        if (stop_flag.load() && request_queue.empty()) {
-            break;
+// 处理单个请求，所有异常在此转为错误响应
+void HttpServer::serve_request(HttpRequest&& request)
+{
+    int32_t client_fd = request.client_fd;
+    uint32_t stream_id = request.stream_id;
+    std::string filepath = request.filepath;
+
+    try {
+        handle_request(std::move(request));
+
+        LOG_INFO("Request %s on client %d handed over to the reactor", filepath.c_str(), client_fd);
+    } catch (const HttpRequestException& e) {
+        reply_error(client_fd, e, stream_id);
+    } catch (const TcpRuntimeException& e) {
+        reply_error(client_fd,
+            HttpRequestException("while preparing response\n" + std::string(e.what()), HTTP_ERR_INTERNAL_SERVER_ERROR),
+            stream_id);
+    } catch (const std::exception& e) {
+        // 其余异常若漏到执行器，连接将停留在工作线程手中，既得不到响应也无法交还reactor
+        reply_error(client_fd,
+            HttpRequestException("unexpected error: " + std::string(e.what()), HTTP_ERR_INTERNAL_SERVER_ERROR),
+            stream_id);
+    }
+}
+
+// 工作线程处理完一个请求后调用：缓冲区中已有下一个管线化请求时取出，连接仍归本线程所有；
+// 否则把连接交还给reactor，期间被推迟的关闭由本线程完成
+bool HttpServer::next_or_hand_back(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+    std::string& header, int64_t& first_byte)
+{
+    bool close_now = false;
+    {
+        // 管线化请求之后的HTTP/2连接前言交还给reactor切换协议
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        bool complete = false;
+        if (!connection->closed && !connection->close_pending && !connection->upload &&
+            !Http2Session::match_preface(connection->input, complete) && next_request(*connection, header, first_byte)) {
+            return true;
         }
-        
-        if (request_queue.empty()) {
+
+        connection->worker_owned = false;
+        close_now = connection->close_pending && !connection->closed;
+        if (!close_now) {
+            try {
+                rearm_connection(client_fd, *connection);
+            } catch (const TcpRuntimeException& e) {
+                LOG_ERR("hand back client %d failed: %s", client_fd, e.what());
+                close_now = !connection->closed;
+            }
+        }
+    }
+
+    if (close_now) {
+        close_client(client_fd);
+    }
+    return false;
+}
+
+// 工作线程的处理函数：依次处理本次移交的请求及其后已缓冲的管线化请求，最后交还连接
+// 排队超时的请求回复503，连接随后关闭，其后的管线化请求一并丢弃
+void HttpServer::process_request(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request,
+    bool expired)
+{
+    int32_t client_fd = request.client_fd;
+    if (expired) {
+        shed_request(client_fd, connection, 0);
+    } else {
+        serve_request(std::move(request));
+    }
+
+    std::string header;
+    int64_t first_byte = 0;
+    while (next_or_hand_back(client_fd, connection, header, first_byte)) {
+        try {
+            HttpRequest next(client_fd, header);
+            begin_trace(next, *connection, first_byte);
+            if (next.is_upload()) {
+                begin_upload(client_fd, connection, next);
+            } else if (is_proxied(next)) {
+                next.head = std::move(header);
+                serve_request(std::move(next));
+            } else if (!reply_from_cache(next)) {
+                serve_request(std::move(next));
+            }
+        } catch (const HttpRequestException& e) {
+            reply_error(client_fd, e);
+        } catch (const TcpRuntimeException& e) {
+            reply_error(client_fd,
+                HttpRequestException("while parsing request: \n" + std::string(e.what()),
+                HTTP_ERR_INTERNAL_SERVER_ERROR));
+        } catch (const std::exception& e) {
+            reply_error(client_fd,
+                HttpRequestException("unexpected error: " + std::string(e.what()), HTTP_ERR_INTERNAL_SERVER_ERROR));
+        }
+    }
+}
+
+// 工作线程处理单个HTTP/2流，最后一个流处理完毕时完成被推迟的关闭
+void HttpServer::process_stream(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request,
+    bool expired)
+{
+    int32_t client_fd = request.client_fd;
+    if (expired) {
+        shed_request(client_fd, connection, request.stream_id);
+    } else {
+        serve_request(std::move(request));
+    }
+
+    bool close_now = false;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->worker_streams--;
+        close_now = connection->close_pending && !connection->closed && !connection->worker_owned &&
+            connection->worker_streams == 0;
+    }
+    if (close_now) {
+        close_client(client_fd);
+    }
+}
+
+// 过载时回复503；HTTP/1.1连接随后关闭，已缓冲的管线化请求不再处理
+void HttpServer::shed_request(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+    uint32_t stream_id)
+{
+    if (stream_id == 0) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->input.clear();
+    }
+    reply_error(client_fd, HttpRequestException("server is overloaded", HTTP_ERR_SERVICE_UNAVAILABLE), stream_id);
+}
+
+// 把连接移交给工作线程处理请求；HTTP/2流不移交连接，各流并发处理
+// 排队请求数已达上限或工作队列已满时直接回复503，reactor线程不就地处理请求
+void HttpServer::dispatch_request(const std::shared_ptr<HttpConnection>& connection, HttpRequest&& request)
+{
+    bool is_stream = request.stream_id != 0;
+    int32_t client_fd = request.client_fd;
+    uint32_t stream_id = request.stream_id;
+    if (!admission.try_admit()) {
+        LOG_DEBUG("admission queue is full, shed request on client %d", client_fd);
+        shed_request(client_fd, connection, stream_id);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (is_stream) {
+            connection->worker_streams++;
+        } else {
+            connection->worker_owned = true;
+        }
+    }
+
+    auto enqueued = std::chrono::steady_clock::now();
+    ExecutorTask task = [this, connection, is_stream, enqueued, request = std::move(request)]() mutable {
+        if (request.trace.active()) {
+            request.trace.mark(HTTP_PHASE_DEQUEUED);
+        }
+        bool expired = !admission.begin(enqueued);
+        if (reading_paused && admission.should_resume()) {
+            resume_reading();
+        }
+        if (is_stream) {
+            process_stream(connection, std::move(request), expired);
+        } else {
+            process_request(connection, std::move(request), expired);
+        }
+    };
+    if (!executor->submit(std::move(task))) {
+        admission.cancel();
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            if (is_stream) {
+                connection->worker_streams--;
+            } else {
+                connection->worker_owned = false;
+            }
+        }
+        LOG_ERR("worker queues are full, shed request on client %d", client_fd);
+        shed_request(client_fd, connection, stream_id);
+    }
+}
+
+// 工作队列积压时暂停读取该连接，并暂停accept新连接；返回false表示连接已关闭，按原流程处理
+bool HttpServer::pause_reading(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed || connection->close_pending) {
+            return false;
+        }
+        connection->paused = true;
+        try {
+            rearm_connection(client_fd, *connection);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("pause client %d failed: %s", client_fd, e.what());
+        }
+    }
+
+    bool first = false;
+    {
+        std::lock_guard<std::mutex> lock(paused_mutex);
+        paused_connections.emplace_back(client_fd, connection);
+        first = !reading_paused.exchange(true);
+    }
+    if (first) {
+        admission.record_pause();
+        try {
+            set_accept_paused(true);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("pause accepting failed: %s", e.what());
+        }
+        LOG_INFO("worker queues are backlogged, pause reading and accepting");
+    }
+
+    // 登记之前队列可能已经回落，此时不会再有工作线程来恢复
+    if (admission.should_resume()) {
+        resume_reading();
+    }
+    return true;
+}
+
+// 队列回落到低水位后恢复accept，并让暂停的连接重新关注EPOLLIN；
+// 未读取的数据仍在内核接收缓冲区中，水平触发的EPOLLIN会立即到来
+void HttpServer::resume_reading()
+{
+    std::vector<std::pair<int32_t, std::weak_ptr<HttpConnection>>> resumed;
+    {
+        std::lock_guard<std::mutex> lock(paused_mutex);
+        if (!reading_paused.exchange(false)) {
+            return;
+        }
+        resumed.swap(paused_connections);
+    }
+
+    try {
+        set_accept_paused(false);
+    } catch (const TcpRuntimeException& e) {
+        LOG_ERR("resume accepting failed: %s", e.what());
+    }
+    LOG_INFO("worker queues drained, resume reading %zu clients", resumed.size());
+
+    for (auto& [client_fd, weak_connection] : resumed) {
+        std::shared_ptr<HttpConnection> connection = weak_connection.lock();
+        if (!connection) {
             continue;
         }
-        
-        // 获取请求
-        HttpRequest request = std::move(request_queue.front());
-        request_queue.pop();
-        lock.unlock();
-        
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->paused = false;
+        try {
+            rearm_connection(client_fd, *connection);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("resume client %d failed: %s", client_fd, e.what());
+        }
+    }
+}
+
+// 开始接收上传请求的请求体，调用方须是连接的当前所有者；客户端要求100-continue时先回复中间响应
+// @exception 未启用上传时抛出HttpRequestException（405），缺少长度时抛出HttpRequestException（411），
+// 其余同validate_upload_path()与continue_upload()
+HttpUploadStatus HttpServer::begin_upload(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+    const HttpRequest& request)
+{
+    std::unique_ptr<HttpUpload> upload;
+    try {
+        if (max_upload_size == 0 || pack) {
+            throw HttpRequestException("uploads are not enabled", HTTP_ERR_METHOD_NOT_ALLOWED);
+        }
+        if (is_proxied(request)) {
+            throw HttpRequestException("request bodies are not forwarded to upstreams", HTTP_ERR_METHOD_NOT_ALLOWED);
+        }
+        if (request.content_length < 0 && !request.chunked) {
+            throw HttpRequestException("upload without Content-Length", HTTP_ERR_LENGTH_REQUIRED);
+        }
+        upload = std::make_unique<HttpUpload>(validate_upload_path(request.filepath), request.content_length,
+            max_upload_size);
+    } catch (...) {
+        // 被拒绝的请求体不能当作后续请求解析
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        connection->input.clear();
+        connection->discard_input = true;
+        throw;
+    }
+
+    if (request.expect_continue && request.content_length != 0) {
+        auto transfer = std::make_unique<HttpTransfer>();
+        transfer->add_buffer("HTTP/1.1 100 Continue\r\n\r\n");
+        submit_transfer(client_fd, std::move(transfer));
+    }
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed) {
+            return HTTP_UPLOAD_CLOSED;
+        }
+        connection->upload = std::move(upload);
+    }
+    LOG_INFO("Upload %s on client %d started", request.filepath.c_str(), client_fd);
+    return continue_upload(client_fd, connection);
+}
+
+// 推进连接上的上传：reactor线程上从socket接收，工作线程上只消耗已缓冲的数据；
+// 请求体收齐后把临时文件rename到目标路径，新建时回复201，替换已有文件时回复204
+// @exception 请求体非法或超出上限时抛出HttpRequestException，读写失败时抛出TcpRuntimeException，上传随即放弃
+HttpUploadStatus HttpServer::continue_upload(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    std::unique_ptr<HttpUpload> upload;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (!connection->upload) {
+            return HTTP_UPLOAD_DONE;
+        }
+
+        HttpUploadStatus status = HTTP_UPLOAD_AGAIN;
+        try {
+            status = is_loop_thread() ?
+                connection->upload->receive(client_fd, connection->input, connection->tls.get()) :
+                connection->upload->consume(connection->input);
+        } catch (...) {
+            // 请求边界已无法确定，缓冲的数据一并丢弃，错误响应发出后关闭连接
+            connection->upload.reset();
+            connection->input.clear();
+            connection->discard_input = true;
+            throw;
+        }
+        if (status == HTTP_UPLOAD_CLOSED) {
+            connection->upload.reset();
+        }
+        if (status != HTTP_UPLOAD_DONE) {
+            return status;
+        }
+        upload = std::move(connection->upload);
+    }
+
+    bool created = upload->commit();
+    LOG_INFO("Upload on client %d stored, %lu bytes", client_fd, upload->get_received());
+
+    auto transfer = std::make_unique<HttpTransfer>();
+    HttpHeaderBuilder& header = transfer->begin_header();
+    header.status(created ? HTTP_ERR_CREATED : HTTP_ERR_NO_CONTENT);
+    if (created) {
+        header.add("Content-Length", static_cast<int64_t>(0));
+    }
+    header.add("Connection", "keep-alive").finish();
+    transfer->add_header();
+    submit_transfer(client_fd, std::move(transfer));
+    return HTTP_UPLOAD_DONE;
+}
+
+// HTTP/2的DATA帧远小于MSS，开启Nagle时每批末尾的小段要等对端的延迟ACK才能发出，
+// 而对端在收到足够数据前不会发送WINDOW_UPDATE，因此切换到HTTP/2的连接关闭Nagle
+static void disable_nagle(int32_t client_fd)
+{
+    int optval = 1;
+    if (setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &optval, sizeof(optval)) < 0) {
+        LOG_ERR("set TCP_NODELAY on client %d failed, errno %d", client_fd, errno);
+    }
+}
+
+// 处理Upgrade: h2c：回复101后切换到HTTP/2，原请求改在流1上响应；HTTP2-Settings非法时忽略升级
+bool HttpServer::upgrade_to_h2c(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection,
+    HttpRequest& request)
+{
+    auto session = std::make_unique<Http2Session>();
+    try {
+        session->upgrade(request.http2_settings);
+    } catch (const Http2Exception& e) {
+        LOG_DEBUG("ignore h2c upgrade from client %d: %s", client_fd, e.what());
+        return false;
+    }
+
+    auto transfer = std::make_unique<HttpTransfer>();
+    transfer->add_buffer(
+        "HTTP/1.1 101 Switching Protocols\r\n"
+        "Connection: Upgrade\r\n"
+        "Upgrade: h2c\r\n"
+        "\r\n");
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed) {
+            return false;
+        }
+        connection->transfers.push_back(std::move(transfer));
+        active_transfers++;
+        connection->h2 = std::move(session);
+    }
+
+    disable_nagle(client_fd);
+    request.stream_id = 1;
+    LOG_DEBUG("client %d upgraded to h2c", client_fd);
+    return true;
+}
+
+// 解析缓冲区中的HTTP/2帧：缓存命中的流在reactor线程直接回复，其余流交给工作线程并发处理
+void HttpServer::serve_h2_streams(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    std::vector<Http2Request> requests;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        if (connection->closed) {
+            return;
+        }
         try {
-            handle_request(std::move(request));
+            connection->h2->feed(connection->input, requests);
+        } catch (const Http2Exception& e) {
+            LOG_ERR("HTTP/2 connection error on client %d: %s", client_fd, e.what());
+            connection->h2->go_away(e.get_error_code());
+        }
+    }
 
-            LOG_INFO("Request %s on client %d handled successfully", request.filepath.c_str(), request.client_fd);
+    for (Http2Request& h2_request : requests) {
+        LOG_DEBUG("Received HTTP/2 request on stream %u: \n%s", h2_request.stream_id, h2_request.head.c_str());
+        try {
+            HttpRequest request(client_fd, h2_request.head);
+            request.stream_id = h2_request.stream_id;
+            if (request.is_upload()) {
+                throw HttpRequestException("uploads over HTTP/2 are not supported", HTTP_ERR_METHOD_NOT_ALLOWED);
+            }
+            if (is_proxied(request)) {
+                // 响应体直接从上游连接转发，无法切分为HTTP/2帧
+                throw HttpRequestException("proxying over HTTP/2 is not supported", HTTP_ERR_BAD_GATEWAY);
+            }
+            if (!reply_from_cache(request)) {
+                dispatch_request(connection, std::move(request));
+            }
         } catch (const HttpRequestException& e) {
-            reply_error(request.client_fd, e);
+            reply_error(client_fd, e, h2_request.stream_id);
+        } catch (const TcpRuntimeException& e) {
+            reply_error(client_fd,
+                HttpRequestException("while parsing request: \n" + std::string(e.what()),
+                HTTP_ERR_INTERNAL_SERVER_ERROR), h2_request.stream_id);
+        }
+    }
+
+    // 控制帧（SETTINGS确认、PING回应、WINDOW_UPDATE等）随即发出
+    bool keep_alive = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        try {
+            keep_alive = connection->closed || flush_output(client_fd, connection);
         } catch (const TcpRuntimeException& e) {
-            reply_error(request.client_fd,
-                HttpRequestException("while sending file\n" + std::string(e.what()), HTTP_ERR_INTERNAL_SERVER_ERROR));
+            LOG_ERR("send HTTP/2 frames to client %d failed: %s", client_fd, e.what());
+            keep_alive = false;
+        }
+    }
+    if (!keep_alive) {
+        close_connection(client_fd, connection);
+    }
+}
+
+// 依次处理缓冲区中的完整请求：热点缓存命中时在reactor线程直接回复，
+// 未命中时移交给工作线程，在其交还连接之前不再解析后续请求，保证响应顺序；
+// 明文连接以HTTP/2连接前言开头或请求Upgrade: h2c时切换到HTTP/2
+void HttpServer::serve_buffered_requests(int32_t client_fd, const std::shared_ptr<HttpConnection>& connection)
+{
+    for (;;) {
+        std::string header;
+        int64_t first_byte = 0;
+        {
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            if (connection->closed || connection->worker_owned || connection->upload) {
+                return;
+            }
+            bool complete = false;
+            if (!connection->h2 && !connection->tls && Http2Session::match_preface(connection->input, complete)) {
+                if (!complete) {
+                    return;
+                }
+                connection->h2 = std::make_unique<Http2Session>();
+                disable_nagle(client_fd);
+                LOG_DEBUG("client %d speaks h2c with prior knowledge", client_fd);
+            }
+            if (connection->h2) {
+                break;
+            }
+            if (!next_request(*connection, header, first_byte)) {
+                return;
+            }
+        }
+
+        LOG_DEBUG("Received request: \n%s", header.c_str());
+        HttpRequest request(client_fd, header);
+        begin_trace(request, *connection, first_byte);
+        if (request.is_upload()) {
+            if (begin_upload(client_fd, connection, request) == HTTP_UPLOAD_CLOSED) {
+                close_connection(client_fd, connection);
+                return;
+            }
+            continue;
+        }
+        // 转发的请求总是交给工作线程，不经过缓存，也不切换协议
+        if (is_proxied(request)) {
+            request.head = std::move(header);
+            dispatch_request(connection, std::move(request));
+            continue;
+        }
+        if (request.upgrade_h2c && !connection->tls) {
+            upgrade_to_h2c(client_fd, connection, request);
+        }
+
+        if (reply_from_cache(request)) {
+            continue;
         }
+        dispatch_request(connection, std::move(request));
     }
+
+    serve_h2_streams(client_fd, connection);
 }
 
 void HttpServer::deal_client_msg(int32_t client_fd) {
-    try {
-        // 循环读取数据直到找到HTTP头部结束符 \r\n\r\n
-        std::string request_data = recv_with_eof(client_fd, UINT16_MAX, "\r\n\r\n");
+    if (resume_relay(client_fd)) {
+        return;
+    }
+    std::shared_ptr<HttpConnection> connection = find_connection(client_fd);
+    if (!connection) {
+        return;
+    }
 
-        LOG_DEBUG("Received request: \n%s", request_data.c_str());
-        HttpRequest request(client_fd, request_data);
-        
-        // 将文件传输请求交给工作线程处理（包含 Range 信息）
+    // 工作队列积压时不再读取，请求留在内核接收缓冲区，由TCP流量控制把压力传回客户端
+    if (admission.should_pause() && pause_reading(client_fd, connection)) {
+        return;
+    }
+
+    // TLS握手失败时不回复错误页，直接断开
+    bool peer_open = true;
+    if (connection->tls && !connection->tls->is_established()) {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        try {
+            peer_open = advance_handshake(client_fd, *connection);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("TLS handshake with client %d failed: %s", client_fd, e.what());
+            peer_open = false;
+        }
+    }
+    if (!peer_open) {
+        close_connection(client_fd, connection);
+        return;
+    }
+
+    try {
+        bool uploading = false;
         {
-            std::lock_guard<std::mutex> lock(queue_mutex);
-            request_queue.emplace(std::move(request));
+            // 握手尚未完成时没有应用数据可读；接收请求体期间数据由上传直接从socket取走
+            std::lock_guard<std::mutex> lock(connection->mutex);
+            uploading = connection->upload != nullptr;
+            if (!uploading && (!connection->tls || connection->tls->is_established())) {
+                peer_open = read_input(client_fd, *connection);
+            }
+        }
+        if (uploading) {
+            peer_open = continue_upload(client_fd, connection) != HTTP_UPLOAD_CLOSED;
+        }
+        if (peer_open) {
+            serve_buffered_requests(client_fd, connection);
         }
-        queue_cv.notify_one();
-        
     } catch (const HttpRequestException& e) {
         reply_error(client_fd, e);
     } catch (const TcpRuntimeException& e) {
@@ -294,4 +1994,23 @@ void HttpServer::deal_client_msg(int32_t client_fd) {
             HttpRequestException("while parsing request: \n" + std::string(e.what()),
             HTTP_ERR_INTERNAL_SERVER_ERROR));
     }
-}
\ No newline at end of file
+
+    if (!peer_open) {
+        close_connection(client_fd, connection);
+        return;
+    }
+
+    bool keep_alive = true;
+    {
+        std::lock_guard<std::mutex> lock(connection->mutex);
+        try {
+            rearm_connection(client_fd, *connection);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR("rearm client %d failed: %s", client_fd, e.what());
+            keep_alive = false;
+        }
+    }
+    if (!keep_alive) {
+        close_connection(client_fd, connection);
+    }
+}
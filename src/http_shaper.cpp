@@ -0,0 +1,178 @@
+#include <algorithm>
+
+#include "http_shaper.hpp"
+
+HttpTokenBucket::HttpTokenBucket(uint64_t rate, size_t burst)
+{
+    configure(rate, burst);
+}
+
+void HttpTokenBucket::configure(uint64_t rate, size_t burst)
+{
+    bool was_unlimited = unlimited();
+    this->rate = rate;
+    this->burst = std::max(burst != 0 ? burst : static_cast<size_t>(rate / 10), MIN_GRANT);
+    this->tokens = was_unlimited ? static_cast<double>(this->burst) :
+        std::min(this->tokens, static_cast<double>(this->burst));
+    this->last_refill = std::chrono::steady_clock::now();
+}
+
+bool HttpTokenBucket::unlimited() const
+{
+    return this->rate == 0;
+}
+
+size_t HttpTokenBucket::available(std::chrono::steady_clock::time_point now)
+{
+    if (unlimited()) {
+        return SIZE_MAX;
+    }
+    if (now > this->last_refill) {
+        double elapsed = std::chrono::duration<double>(now - this->last_refill).count();
+        this->tokens = std::min(this->tokens + elapsed * static_cast<double>(this->rate),
+            static_cast<double>(this->burst));
+        this->last_refill = now;
+    }
+    return this->tokens > 0 ? static_cast<size_t>(this->tokens) : 0;
+}
+
+// 实际发送量可能略超出额度（如整块的TLS记录），令牌允许暂时为负，由后续补充抵扣
+void HttpTokenBucket::consume(size_t bytes)
+{
+    if (!unlimited()) {
+        this->tokens -= static_cast<double>(bytes);
+    }
+}
+
+std::chrono::nanoseconds HttpTokenBucket::wait_time(std::chrono::steady_clock::time_point now) const
+{
+    if (unlimited()) {
+        return std::chrono::nanoseconds(0);
+    }
+    double elapsed = now > this->last_refill ? std::chrono::duration<double>(now - this->last_refill).count() : 0;
+    double missing = static_cast<double>(MIN_GRANT) - (this->tokens + elapsed * static_cast<double>(this->rate));
+    if (missing <= 0) {
+        return std::chrono::nanoseconds(0);
+    }
+    return std::chrono::nanoseconds(static_cast<int64_t>(missing * 1e9 / static_cast<double>(this->rate)) + 1);
+}
+
+HttpShaper::HttpShaper(const HttpShapingConfig& config) : config(config)
+{
+}
+
+HttpTrafficClass HttpShaper::classify(std::string_view mime_type)
+{
+    if (mime_type.compare(0, 5, "text/") == 0 || mime_type == "application/javascript" ||
+        mime_type == "application/json" || mime_type == "application/xml" || mime_type == "image/svg+xml") {
+        return HTTP_TRAFFIC_INTERACTIVE;
+    }
+    if (mime_type.compare(0, 6, "image/") == 0) {
+        return HTTP_TRAFFIC_IMAGE;
+    }
+    if (mime_type.compare(0, 6, "video/") == 0 || mime_type.compare(0, 6, "audio/") == 0) {
+        return HTTP_TRAFFIC_MEDIA;
+    }
+    return HTTP_TRAFFIC_BULK;
+}
+
+const char *HttpShaper::get_class_name(HttpTrafficClass traffic_class)
+{
+    switch (traffic_class) {
+    case HTTP_TRAFFIC_INTERACTIVE:
+        return "interactive";
+    case HTTP_TRAFFIC_IMAGE:
+        return "image";
+    case HTTP_TRAFFIC_MEDIA:
+        return "media";
+    case HTTP_TRAFFIC_BULK:
+        return "bulk";
+    default:
+        return "unknown";
+    }
+}
+
+void HttpShaper::attach(HttpFlow& flow, uint32_t client_ip)
+{
+    if (this->config.client_rate == 0) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(this->clients_mutex);
+    std::weak_ptr<HttpTokenBucket>& slot = this->clients[client_ip];
+    std::shared_ptr<HttpTokenBucket> bucket = slot.lock();
+    if (!bucket) {
+        bucket = std::make_shared<HttpTokenBucket>(this->config.client_rate, this->config.client_burst);
+        slot = bucket;
+    }
+    flow.client_bucket = std::move(bucket);
+
+    // 客户端的全部连接关闭后令牌桶随之释放，表项在此批量清理
+    if (this->clients.size() >= this->sweep_at) {
+        for (auto it = this->clients.begin(); it != this->clients.end(); ) {
+            it = it->second.expired() ? this->clients.erase(it) : std::next(it);
+        }
+        this->sweep_at = std::max<size_t>(1024, this->clients.size() * 2);
+    }
+}
+
+size_t HttpShaper::grant(HttpFlow& flow, HttpTrafficClass traffic_class, std::chrono::steady_clock::time_point now)
+{
+    const HttpTrafficPolicy& policy = this->config.classes[traffic_class];
+    if (flow.traffic_class != traffic_class) {
+        flow.traffic_class = traffic_class;
+        flow.bucket.configure(policy.rate, policy.burst);
+    }
+
+    size_t tokens = flow.bucket.available(now);
+    if (flow.client_bucket) {
+        tokens = std::min(tokens, flow.client_bucket->available(now));
+    }
+    if (tokens < HttpTokenBucket::MIN_GRANT) {
+        this->throttled.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+
+    flow.deficit += policy.quantum;
+    return std::min(flow.deficit, tokens);
+}
+
+void HttpShaper::charge(HttpFlow& flow, size_t sent, bool drained)
+{
+    flow.deficit -= std::min(flow.deficit, sent);
+    if (drained) {
+        flow.deficit = 0;
+    }
+    flow.bucket.consume(sent);
+    if (flow.client_bucket) {
+        flow.client_bucket->consume(sent);
+    }
+    if (flow.traffic_class < HTTP_TRAFFIC_CLASS_COUNT) {
+        this->bytes[flow.traffic_class].fetch_add(sent, std::memory_order_relaxed);
+    }
+}
+
+std::chrono::nanoseconds HttpShaper::wait_time(const HttpFlow& flow, std::chrono::steady_clock::time_point now) const
+{
+    std::chrono::nanoseconds wait = flow.bucket.wait_time(now);
+    if (flow.client_bucket) {
+        wait = std::max(wait, flow.client_bucket->wait_time(now));
+    }
+    return wait;
+}
+
+void HttpShaper::record_round()
+{
+    this->rounds.fetch_add(1, std::memory_order_relaxed);
+}
+
+HttpShapingStats HttpShaper::get_stats() const
+{
+    HttpShapingStats stats;
+    stats.rounds = this->rounds.load(std::memory_order_relaxed);
+    stats.throttled = this->throttled.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < HTTP_TRAFFIC_CLASS_COUNT; i++) {
+        stats.bytes[i] = this->bytes[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
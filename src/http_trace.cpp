@@ -0,0 +1,192 @@
+#include "http_trace.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "tcp_public.hpp"
+
+// 校准TSC频率的采样时长，误差约为steady_clock读数误差与该时长之比
+static constexpr std::chrono::milliseconds TSC_CALIBRATION_TIME{10};
+
+// CPUID 0x80000007的EDX第8位：TSC以恒定频率递增，且不随深度睡眠停止
+static bool has_invariant_tsc()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) == 0) {
+        return false;
+    }
+    return (edx & (1u << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+void HttpTrace::calibrate()
+{
+    static std::once_flag calibrated;
+    std::call_once(calibrated, []() {
+        if (!has_invariant_tsc()) {
+            LOG_INFO("trace clock: steady_clock");
+            return;
+        }
+#if defined(__x86_64__) || defined(__i386__)
+        auto start = std::chrono::steady_clock::now();
+        uint64_t start_ticks = __rdtsc();
+        std::this_thread::sleep_for(TSC_CALIBRATION_TIME);
+        auto end = std::chrono::steady_clock::now();
+        uint64_t end_ticks = __rdtsc();
+        if (end_ticks <= start_ticks) {
+            return;
+        }
+        ns_per_tick = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()) /
+            static_cast<double>(end_ticks - start_ticks);
+        use_tsc = true;
+        LOG_INFO("trace clock: TSC at %.1f MHz", 1000.0 / ns_per_tick);
+#endif
+    });
+}
+
+int64_t HttpTrace::to_nanoseconds(int64_t ticks)
+{
+    if (!use_tsc) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::duration(ticks)).count();
+    }
+    return static_cast<int64_t>(static_cast<double>(ticks) * ns_per_tick);
+}
+
+int64_t HttpTrace::span(HttpTraceSpan span) const
+{
+    // 各阶段的起止时间点；缺失的时间点向前找最近一个已记录的
+    static constexpr HttpTracePhase BOUNDS[HTTP_SPAN_COUNT][2] = {
+        {HTTP_PHASE_FIRST_BYTE, HTTP_PHASE_PARSED},
+        {HTTP_PHASE_PARSED, HTTP_PHASE_DEQUEUED},
+        {HTTP_PHASE_DEQUEUED, HTTP_PHASE_HEADERS_SENT},
+        {HTTP_PHASE_HEADERS_SENT, HTTP_PHASE_BODY_DONE},
+        {HTTP_PHASE_FIRST_BYTE, HTTP_PHASE_BODY_DONE},
+    };
+
+    auto resolve = [this](HttpTracePhase phase) {
+        for (int32_t i = phase; i >= 0; i--) {
+            if (this->stamps[i] != 0) {
+                return this->stamps[i];
+            }
+        }
+        return int64_t(0);
+    };
+    int64_t begin = resolve(BOUNDS[span][0]);
+    int64_t end = resolve(BOUNDS[span][1]);
+    return begin != 0 && end > begin ? end - begin : 0;
+}
+
+HttpTracer::HttpTracer(const HttpTraceConfig& config) : config(config)
+{
+    HttpTrace::calibrate();
+    this->sample_countdown = config.sample_every;
+}
+
+// 单写者的relaxed读写，编译为普通的读与写，不带总线锁
+static void bump(std::atomic<uint64_t>& counter, uint64_t value = 1)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void HttpTracer::record(int32_t client_fd, const HttpTrace& trace)
+{
+    int64_t total_ns = 0;
+    for (size_t i = 0; i < HTTP_SPAN_COUNT; i++) {
+        int64_t ns = HttpTrace::to_nanoseconds(trace.span(static_cast<HttpTraceSpan>(i)));
+        uint64_t us = static_cast<uint64_t>(ns) / 1000;
+        if (i == HTTP_SPAN_TOTAL) {
+            total_ns = ns;
+        }
+
+        Histogram& histogram = this->histograms[i];
+        size_t bucket = us == 0 ? 0 : std::min<size_t>(63 - __builtin_clzll(us), SPAN_BUCKETS - 1);
+        bump(histogram.buckets[bucket]);
+        bump(histogram.total_us, us);
+        if (us > histogram.max_us.load(std::memory_order_relaxed)) {
+            histogram.max_us.store(us, std::memory_order_relaxed);
+        }
+    }
+    bump(this->traced);
+
+    if (this->config.slow_threshold.count() > 0 &&
+        total_ns >= std::chrono::duration_cast<std::chrono::nanoseconds>(this->config.slow_threshold).count()) {
+        bump(this->slow);
+        log_breakdown("slow", client_fd, trace);
+        return;
+    }
+    if (this->config.sample_every != 0 && --this->sample_countdown == 0) {
+        this->sample_countdown = this->config.sample_every;
+        bump(this->sampled);
+        log_breakdown("sampled", client_fd, trace);
+    }
+}
+
+// 输出各阶段耗时（毫秒），wait为连接accept到读到该请求之间的时长，keep-alive连接上包含空闲时间
+void HttpTracer::log_breakdown(const char *kind, int32_t client_fd, const HttpTrace& trace) const
+{
+    auto ms = [&trace](HttpTraceSpan span) {
+        return static_cast<double>(HttpTrace::to_nanoseconds(trace.span(span))) / 1e6;
+    };
+    double wait = 0;
+    if (trace.has(HTTP_PHASE_ACCEPT) && trace.stamps[HTTP_PHASE_FIRST_BYTE] > trace.stamps[HTTP_PHASE_ACCEPT]) {
+        wait = static_cast<double>(HttpTrace::to_nanoseconds(
+            trace.stamps[HTTP_PHASE_FIRST_BYTE] - trace.stamps[HTTP_PHASE_ACCEPT])) / 1e6;
+    }
+    LOG_INFO("%s request %s on client %d: total=%.3fms read=%.3f queue=%.3f handle=%.3f send=%.3f wait=%.3f",
+        kind, trace.target.c_str(), client_fd, ms(HTTP_SPAN_TOTAL), ms(HTTP_SPAN_READ), ms(HTTP_SPAN_QUEUE),
+        ms(HTTP_SPAN_HANDLE), ms(HTTP_SPAN_SEND), wait);
+}
+
+// 分位数取累计占比首次达到目标的桶的上界
+HttpSpanStats HttpTracer::summarize(const Histogram& histogram)
+{
+    HttpSpanStats stats;
+    std::array<uint64_t, SPAN_BUCKETS> counts;
+    uint64_t total = 0;
+    for (size_t i = 0; i < SPAN_BUCKETS; i++) {
+        counts[i] = histogram.buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    stats.max_us = histogram.max_us.load(std::memory_order_relaxed);
+    if (total == 0) {
+        return stats;
+    }
+    stats.mean_us = static_cast<double>(histogram.total_us.load(std::memory_order_relaxed)) /
+        static_cast<double>(total);
+
+    auto percentile = [&](double ratio) {
+        uint64_t target = static_cast<uint64_t>(static_cast<double>(total) * ratio);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < SPAN_BUCKETS; i++) {
+            seen += counts[i];
+            if (seen > target || seen == total) {
+                return (uint64_t(1) << (i + 1)) - 1;
+            }
+        }
+        return stats.max_us;
+    };
+    stats.p50_us = percentile(0.5);
+    stats.p99_us = percentile(0.99);
+    return stats;
+}
+
+HttpTraceStats HttpTracer::get_stats() const
+{
+    HttpTraceStats stats;
+    stats.traced = this->traced.load(std::memory_order_relaxed);
+    stats.slow = this->slow.load(std::memory_order_relaxed);
+    stats.sampled = this->sampled.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < HTTP_SPAN_COUNT; i++) {
+        stats.spans[i] = summarize(this->histograms[i]);
+    }
+    return stats;
+}
@@ -0,0 +1,740 @@
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+}
+
+#include <algorithm>
+
+#include "tcp_public.hpp"
+#include "tcp_socket_options.hpp"
+#include "http_transfer.hpp"
+#include "http_request.hpp"
+
+// === HttpFile ===
+
+HttpFile::HttpFile(const std::string& path)
+{
+    this->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (this->fd < 0) {
+        throw TcpRuntimeException("Open file failed: " + path, __FILENAME__, __LINE__);
+    }
+}
+
+HttpFile::~HttpFile()
+{
+    if (this->fd >= 0) {
+        close(this->fd);
+    }
+}
+
+int32_t HttpFile::get_fd() const
+{
+    return this->fd;
+}
+
+void HttpFile::advise_sequential(off_t offset, off_t length, size_t window)
+{
+    // 仅是提示，失败不影响发送
+    static_cast<void>(posix_fadvise(this->fd, offset, length, POSIX_FADV_SEQUENTIAL));
+    static_cast<void>(readahead(this->fd, offset, std::min(static_cast<size_t>(length), window)));
+}
+
+void HttpFile::prefetch(off_t offset, size_t length)
+{
+    static_cast<void>(posix_fadvise(this->fd, offset, static_cast<off_t>(length), POSIX_FADV_WILLNEED));
+}
+
+// === HttpTransfer ===
+
+HttpTransfer::~HttpTransfer()
+{
+    if (this->pipe_fds[0] >= 0) {
+        close(this->pipe_fds[0]);
+        close(this->pipe_fds[1]);
+    }
+}
+
+HttpFileStrategy HttpTransfer::resolve_strategy(HttpFileStrategy strategy, off_t length)
+{
+    if (strategy != HTTP_FILE_AUTO) {
+        return strategy;
+    }
+    return length <= MMAP_MAX_SIZE ? HTTP_FILE_MMAP : HTTP_FILE_SENDFILE;
+}
+
+const char *HttpTransfer::get_strategy_name(HttpFileStrategy strategy)
+{
+    switch (strategy) {
+        case HTTP_FILE_AUTO:
+            return "auto";
+        case HTTP_FILE_SENDFILE:
+            return "sendfile";
+        case HTTP_FILE_SPLICE:
+            return "splice";
+        case HTTP_FILE_MMAP:
+            return "mmap";
+    }
+    return "unknown";
+}
+
+HttpHeaderBuilder& HttpTransfer::begin_header()
+{
+    this->header.clear();
+    return this->header;
+}
+
+void HttpTransfer::add_header()
+{
+    std::string_view head = this->header.view();
+    add_buffer(nullptr, head.data(), head.size());
+}
+
+void HttpTransfer::add_buffer(std::string data)
+{
+    auto owner = std::make_shared<const std::string>(std::move(data));
+    const char *ptr = owner->data();
+    size_t length = owner->size();
+    add_buffer(std::move(owner), ptr, length);
+}
+
+void HttpTransfer::add_buffer(std::shared_ptr<const void> owner, const char *data, size_t length)
+{
+    HttpTransferSegment segment;
+    segment.owner = std::move(owner);
+    segment.data = data;
+    segment.length = static_cast<off_t>(length);
+    this->segments.push_back(std::move(segment));
+}
+
+void HttpTransfer::add_stream(std::shared_ptr<HttpStreamSource> source)
+{
+    HttpTransferSegment segment;
+    segment.stream = std::move(source);
+    this->segments.push_back(std::move(segment));
+}
+
+void HttpTransfer::add_file(std::shared_ptr<HttpFile> file, off_t offset, off_t length, HttpFileStrategy strategy)
+{
+    if (length <= 0) {
+        return;
+    }
+
+    strategy = resolve_strategy(strategy, length);
+    if (strategy == HTTP_FILE_MMAP) {
+        // 映射起点须按页对齐；映射由owner持有，最后一个引用释放时解除
+        // 注意文件在映射期间被截断时访问会触发SIGBUS，web_root中的文件应以rename方式原子替换
+        off_t page_size = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+        off_t aligned = offset & ~(page_size - 1);
+        size_t map_length = static_cast<size_t>(length + (offset - aligned));
+        void *addr = mmap(nullptr, map_length, PROT_READ, MAP_SHARED, file->get_fd(), aligned);
+        if (addr == MAP_FAILED) {
+            throw TcpRuntimeException("mmap failed", __FILENAME__, __LINE__);
+        }
+        static_cast<void>(madvise(addr, map_length, MADV_WILLNEED));
+
+        std::shared_ptr<const void> owner(addr, [map_length](const void *p) {
+            munmap(const_cast<void *>(p), map_length);
+        });
+        add_buffer(std::move(owner), static_cast<const char *>(addr) + (offset - aligned), static_cast<size_t>(length));
+        return;
+    }
+
+    HttpTransferSegment segment;
+    segment.file = std::move(file);
+    segment.strategy = strategy;
+    segment.offset = offset;
+    segment.length = length;
+    segment.prefetched_end = offset;
+    if (static_cast<size_t>(length) > READAHEAD_WINDOW) {
+        // 大文件与range流：从区间起点顺序预读，之后随发送进度按窗口继续提示
+        segment.file->advise_sequential(offset, length, READAHEAD_WINDOW);
+        segment.prefetched_end = offset + static_cast<off_t>(READAHEAD_WINDOW);
+    }
+    this->segments.push_back(std::move(segment));
+}
+
+void HttpTransfer::set_close_after(bool close_after)
+{
+    this->close_after = close_after;
+}
+
+bool HttpTransfer::get_close_after() const
+{
+    return this->close_after;
+}
+
+void HttpTransfer::set_traffic_class(HttpTrafficClass traffic_class)
+{
+    this->traffic_class = traffic_class;
+}
+
+HttpTrafficClass HttpTransfer::get_traffic_class() const
+{
+    return this->traffic_class;
+}
+
+void HttpTransfer::set_cork(bool cork)
+{
+    bool has_file = false;
+    for (const HttpTransferSegment& segment : this->segments) {
+        if (segment.stream) {
+            return;
+        }
+        has_file |= segment.file != nullptr;
+    }
+    this->cork = cork && has_file;
+}
+
+void HttpTransfer::set_trace(HttpTrace trace)
+{
+    this->trace = std::move(trace);
+    const HttpTransferSegment *first = this->segments.empty() ? nullptr : &this->segments.front();
+    this->head_length = first && first->data ? first->length : 0;
+}
+
+HttpTrace *HttpTransfer::get_trace()
+{
+    return this->trace.active() ? &this->trace : nullptr;
+}
+
+bool HttpTransfer::is_head_sent() const
+{
+    return this->bytes_sent >= this->head_length;
+}
+
+bool HttpTransfer::take_head(std::string& head)
+{
+    skip_empty_segments();
+    std::string scanned;
+    for (size_t i = this->current; i < this->segments.size() && !this->segments[i].file && !this->segments[i].stream;
+        i++) {
+        HttpTransferSegment& segment = this->segments[i];
+        size_t start = scanned.size() >= 3 ? scanned.size() - 3 : 0;
+        size_t before = scanned.size();
+        scanned.append(segment.data, static_cast<size_t>(segment.length));
+        size_t end = scanned.find("\r\n\r\n", start);
+        if (end == std::string::npos) {
+            continue;
+        }
+
+        // 响应头之前的段全部取出，所在段只取出属于响应头的部分
+        for (size_t j = this->current; j < i; j++) {
+            this->segments[j].length = 0;
+        }
+        size_t consumed = end + 4 - before;
+        segment.data += consumed;
+        segment.length -= static_cast<off_t>(consumed);
+        scanned.resize(end + 4);
+        head = std::move(scanned);
+        skip_empty_segments();
+        return true;
+    }
+    return false;
+}
+
+bool HttpTransfer::discard_body()
+{
+    skip_empty_segments();
+    std::string scanned;
+    for (size_t i = this->current; i < this->segments.size() && !this->segments[i].file && !this->segments[i].stream;
+        i++) {
+        HttpTransferSegment& segment = this->segments[i];
+        size_t start = scanned.size() >= 3 ? scanned.size() - 3 : 0;
+        size_t before = scanned.size();
+        scanned.append(segment.data, static_cast<size_t>(segment.length));
+        size_t end = scanned.find("\r\n\r\n", start);
+        if (end == std::string::npos) {
+            continue;
+        }
+
+        // 响应头所在段截断到空行，其后的段（含文件段与流段）全部丢弃
+        segment.length = static_cast<off_t>(end + 4 - before);
+        this->segments.resize(i + 1);
+        return true;
+    }
+    return false;
+}
+
+off_t HttpTransfer::move_front(HttpTransfer& target, off_t length)
+{
+    off_t moved = 0;
+    skip_empty_segments();
+    while (moved < length && !done()) {
+        HttpTransferSegment& segment = this->segments[this->current];
+        off_t part_length = std::min(segment.length, length - moved);
+        HttpTransferSegment part = segment;
+        part.length = part_length;
+        if (segment.file) {
+            // 预读仍由源段按整体进度推进，切出的小段不再各自预读
+            part.prefetched_end = part.offset + part_length;
+            segment.offset += part_length;
+        } else {
+            segment.data += part_length;
+        }
+        segment.length -= part_length;
+        moved += part_length;
+        target.segments.push_back(std::move(part));
+
+        if (segment.file) {
+            prefetch_ahead(segment);
+        }
+        skip_empty_segments();
+    }
+    return moved;
+}
+
+off_t HttpTransfer::get_remaining() const
+{
+    off_t remaining = static_cast<off_t>(this->pipe_pending + this->staged.size() - this->staged_pos);
+    for (size_t i = this->current; i < this->segments.size(); i++) {
+        remaining += this->segments[i].length;
+    }
+    return remaining;
+}
+
+bool HttpTransfer::done() const
+{
+    return this->current >= this->segments.size();
+}
+
+off_t HttpTransfer::get_bytes_sent() const
+{
+    return this->bytes_sent;
+}
+
+std::shared_ptr<HttpStreamSource> HttpTransfer::get_waiting_source() const
+{
+    if (!this->waiting_source || done()) {
+        return nullptr;
+    }
+    return this->segments[this->current].stream;
+}
+
+void HttpTransfer::skip_empty_segments()
+{
+    // splice的管道或TLS暂存区中仍有数据时，当前段尚未发完；流段在消息体结束后才算发完
+    while (this->current < this->segments.size() && this->segments[this->current].length == 0 &&
+        (!this->segments[this->current].stream || this->segments[this->current].stream->get_framing().is_done()) &&
+        this->pipe_pending == 0 && this->staged.empty()) {
+        // 已发完的段尽早释放其持有的内存与文件
+        this->segments[this->current] = HttpTransferSegment();
+        this->current++;
+    }
+}
+
+// 把当前起相邻的内存段聚合为一次sendmsg，返回false表示发送缓冲区已满
+bool HttpTransfer::send_buffers(int32_t socket_fd, size_t& budget)
+{
+    struct iovec iov[MAX_IOV_COUNT];
+    size_t iov_count = 0;
+    size_t total = 0;
+    bool file_follows = false;
+    for (size_t i = this->current; i < this->segments.size() && iov_count < MAX_IOV_COUNT && total < budget; i++) {
+        const HttpTransferSegment& segment = this->segments[i];
+        if (segment.file || segment.stream) {
+            // 流段的数据何时到达未知，不能让响应头等待与之合并
+            file_follows = segment.file != nullptr;
+            break;
+        }
+        size_t length = std::min(static_cast<size_t>(segment.length), budget - total);
+        iov[iov_count++] = { const_cast<char *>(segment.data), length };
+        total += length;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov_count;
+    // 后面紧跟文件段时（响应头、HTTP/2帧头），让内核与随后sendfile的数据合并成满的报文再发出
+    ssize_t len = sendmsg(socket_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL | (file_follows ? MSG_MORE : 0));
+    if (len < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        }
+        throw TcpRuntimeException("sendmsg error", __FILENAME__, __LINE__);
+    }
+
+    // 按已发送长度推进各段
+    size_t remaining = static_cast<size_t>(len);
+    for (size_t i = this->current; remaining > 0; i++) {
+        HttpTransferSegment& segment = this->segments[i];
+        size_t consumed = std::min(static_cast<size_t>(segment.length), remaining);
+        segment.data += consumed;
+        segment.length -= static_cast<off_t>(consumed);
+        remaining -= consumed;
+    }
+    this->bytes_sent += len;
+    budget -= static_cast<size_t>(len);
+    return true;
+}
+
+// 发送进度接近已预读的位置时，异步预读下一个窗口
+void HttpTransfer::prefetch_ahead(HttpTransferSegment& segment)
+{
+    off_t end = segment.offset + segment.length;
+    if (segment.prefetched_end >= end ||
+        segment.offset + static_cast<off_t>(READAHEAD_WINDOW / 2) < segment.prefetched_end) {
+        return;
+    }
+    segment.file->prefetch(segment.prefetched_end, READAHEAD_WINDOW);
+    segment.prefetched_end += static_cast<off_t>(READAHEAD_WINDOW);
+}
+
+// 以sendfile发送当前文件段的一块，返回false表示发送缓冲区已满
+bool HttpTransfer::send_file(int32_t socket_fd, size_t& budget)
+{
+    HttpTransferSegment& segment = this->segments[this->current];
+    size_t chunk = std::min({ static_cast<size_t>(segment.length), SENDFILE_CHUNK_SIZE, budget });
+
+    off_t offset = segment.offset;
+    ssize_t len = sendfile(socket_fd, segment.file->get_fd(), &offset, chunk);
+    if (len < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        }
+        throw TcpRuntimeException("sendfile error", __FILENAME__, __LINE__);
+    }
+    if (len == 0) {
+        // 响应头中的长度已发出，文件却提前结束，只能断开连接
+        throw TcpRuntimeException("File is truncated during transfer", __FILENAME__, __LINE__);
+    }
+
+    segment.offset += len;
+    segment.length -= len;
+    this->bytes_sent += len;
+    budget -= static_cast<size_t>(len);
+    prefetch_ahead(segment);
+    return true;
+}
+
+// 经管道splice发送当前文件段：管道为空时从文件读入一块，再把管道中的数据送入socket，
+// 返回false表示发送缓冲区已满，已读入管道的数据留待下一次EPOLLOUT
+bool HttpTransfer::splice_file(int32_t socket_fd, size_t& budget)
+{
+    HttpTransferSegment& segment = this->segments[this->current];
+    if (this->pipe_fds[0] < 0 && pipe2(this->pipe_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        this->pipe_fds[0] = -1;
+        throw TcpRuntimeException("pipe2 failed", __FILENAME__, __LINE__);
+    }
+
+    if (this->pipe_pending == 0) {
+        size_t chunk = std::min({ static_cast<size_t>(segment.length), SPLICE_CHUNK_SIZE, budget });
+        off_t offset = segment.offset;
+        ssize_t len = splice(segment.file->get_fd(), &offset, this->pipe_fds[1], nullptr, chunk,
+            SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (len < 0) {
+            if (errno == EINTR) {
+                return true;
+            }
+            throw TcpRuntimeException("splice from file error", __FILENAME__, __LINE__);
+        }
+        if (len == 0) {
+            throw TcpRuntimeException("File is truncated during transfer", __FILENAME__, __LINE__);
+        }
+        segment.offset += len;
+        segment.length -= len;
+        this->pipe_pending = static_cast<size_t>(len);
+        prefetch_ahead(segment);
+    }
+
+    return drain_pipe(socket_fd, budget, segment.length > 0);
+}
+
+// 把管道中的数据送入socket，more表示其后还有数据，返回false表示发送缓冲区已满
+bool HttpTransfer::drain_pipe(int32_t socket_fd, size_t& budget, bool more)
+{
+    unsigned int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK | (more ? SPLICE_F_MORE : 0);
+    ssize_t len = splice(this->pipe_fds[0], nullptr, socket_fd, nullptr, this->pipe_pending, flags);
+    if (len < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        }
+        throw TcpRuntimeException("splice to socket error", __FILENAME__, __LINE__);
+    }
+
+    this->pipe_pending -= static_cast<size_t>(len);
+    this->bytes_sent += len;
+    budget -= std::min(budget, static_cast<size_t>(len));
+    return true;
+}
+
+// 以明文发送暂存区中的数据，返回false表示发送缓冲区已满
+bool HttpTransfer::send_staged(int32_t socket_fd, size_t& budget)
+{
+    ssize_t len = send(socket_fd, this->staged.data() + this->staged_pos, this->staged.size() - this->staged_pos,
+        MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (len < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return false;
+        }
+        throw TcpRuntimeException("send error", __FILENAME__, __LINE__);
+    }
+
+    this->staged_pos += static_cast<size_t>(len);
+    if (this->staged_pos == this->staged.size()) {
+        this->staged.clear();
+        this->staged_pos = 0;
+    }
+    this->bytes_sent += len;
+    budget -= std::min(budget, static_cast<size_t>(len));
+    return true;
+}
+
+// 从流段来源读入至多length字节到暂存区，并按分帧推进；消息体之后多余的数据不转发，来源标记为不可复用。
+// 返回false表示来源暂无数据
+bool HttpTransfer::read_stream(HttpStreamSource& source, size_t length)
+{
+    this->staged.resize(length);
+    ssize_t len = recv(source.get_fd(), &this->staged[0], length, MSG_DONTWAIT);
+    if (len <= 0) {
+        this->staged.clear();
+        if (len == 0) {
+            source.get_framing().finish();
+            return true;
+        }
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            this->waiting_source = true;
+            return false;
+        }
+        throw TcpRuntimeException("recv from stream source error", __FILENAME__, __LINE__);
+    }
+    this->staged.resize(static_cast<size_t>(len));
+    this->staged_pos = 0;
+
+    HttpBodyFraming& framing = source.get_framing();
+    size_t pos = 0;
+    try {
+        while (pos < this->staged.size() && !framing.is_done()) {
+            uint64_t data = framing.get_data_remaining();
+            if (data > 0) {
+                size_t part = static_cast<size_t>(std::min<uint64_t>(data, this->staged.size() - pos));
+                framing.consume_data(part);
+                pos += part;
+            } else {
+                pos += framing.feed(this->staged.data() + pos, this->staged.size() - pos);
+            }
+        }
+    } catch (const HttpRequestException& e) {
+        // 响应头已经发出，分帧错误只能断开连接
+        throw TcpRuntimeException(std::string("invalid stream framing: ") + e.what(), __FILENAME__, __LINE__);
+    }
+    if (pos < this->staged.size()) {
+        source.set_broken();
+        this->staged.resize(pos);
+    }
+    return true;
+}
+
+// 转发当前流段：数据段经管道从来源splice到socket，分帧字节读入暂存区后发送。
+// 返回false表示发送缓冲区已满或来源暂无数据，后者会设置waiting_source
+bool HttpTransfer::relay_stream(int32_t socket_fd, size_t& budget)
+{
+    HttpStreamSource& source = *this->segments[this->current].stream;
+    HttpBodyFraming& framing = source.get_framing();
+    if (!this->staged.empty()) {
+        return send_staged(socket_fd, budget);
+    }
+    if (this->pipe_pending > 0) {
+        return drain_pipe(socket_fd, budget, !framing.is_done());
+    }
+
+    uint64_t data = framing.get_data_remaining();
+    if (data == 0) {
+        return read_stream(source, STREAM_READ_SIZE);
+    }
+
+    if (this->pipe_fds[0] < 0 && pipe2(this->pipe_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        this->pipe_fds[0] = -1;
+        throw TcpRuntimeException("pipe2 failed", __FILENAME__, __LINE__);
+    }
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>({ data, SPLICE_CHUNK_SIZE, budget }));
+    ssize_t len = splice(source.get_fd(), nullptr, this->pipe_fds[1], nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (len < 0) {
+        if (errno == EINTR) {
+            return true;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            this->waiting_source = true;
+            return false;
+        }
+        throw TcpRuntimeException("splice from stream source error", __FILENAME__, __LINE__);
+    }
+    if (len == 0) {
+        framing.finish();
+        return true;
+    }
+    framing.consume_data(static_cast<uint64_t>(len));
+    this->pipe_pending = static_cast<size_t>(len);
+    return drain_pipe(socket_fd, budget, !framing.is_done());
+}
+
+bool HttpTransfer::resume(int32_t socket_fd, size_t budget)
+{
+    this->waiting_source = false;
+    skip_empty_segments();
+    if (this->cork && !this->corked && !done()) {
+        this->corked = TcpSocketOptions::set_cork(socket_fd, true);
+    }
+    while (!done() && budget > 0) {
+        const HttpTransferSegment& segment = this->segments[this->current];
+        bool writable = false;
+        if (segment.stream) {
+            writable = relay_stream(socket_fd, budget);
+        } else if (!segment.file) {
+            writable = send_buffers(socket_fd, budget);
+        } else if (segment.strategy == HTTP_FILE_SPLICE) {
+            writable = splice_file(socket_fd, budget);
+        } else {
+            writable = send_file(socket_fd, budget);
+        }
+        if (!writable) {
+            return false;
+        }
+        skip_empty_segments();
+    }
+    if (done() && this->corked) {
+        // 解除时内核立即发出最后不满一个报文的数据
+        this->corked = false;
+        static_cast<void>(TcpSocketOptions::set_cork(socket_fd, false));
+    }
+    return done();
+}
+
+// 经TLS发送当前内存段的一个记录；重试时长度保持不变，满足SSL_write的重试要求
+bool HttpTransfer::write_buffer_tls(TlsSession& tls, size_t& budget)
+{
+    HttpTransferSegment& segment = this->segments[this->current];
+    size_t chunk = std::min(static_cast<size_t>(segment.length), TLS_CHUNK_SIZE);
+
+    TlsStatus status = TLS_OK;
+    ssize_t len = tls.write(segment.data, chunk, status);
+    if (len <= 0) {
+        if (status == TLS_CLOSED) {
+            throw TcpRuntimeException("TLS session closed by peer", __FILENAME__, __LINE__);
+        }
+        return false;
+    }
+
+    segment.data += len;
+    segment.length -= len;
+    this->bytes_sent += len;
+    budget -= std::min(budget, static_cast<size_t>(len));
+    return true;
+}
+
+bool HttpTransfer::write_staged_tls(TlsSession& tls, size_t& budget)
+{
+    TlsStatus status = TLS_OK;
+    ssize_t len = tls.write(this->staged.data() + this->staged_pos,
+        std::min(this->staged.size() - this->staged_pos, TLS_CHUNK_SIZE), status);
+    if (len <= 0) {
+        if (status == TLS_CLOSED) {
+            throw TcpRuntimeException("TLS session closed by peer", __FILENAME__, __LINE__);
+        }
+        return false;
+    }
+
+    this->staged_pos += static_cast<size_t>(len);
+    if (this->staged_pos == this->staged.size()) {
+        this->staged.clear();
+        this->staged_pos = 0;
+    }
+    this->bytes_sent += len;
+    budget -= std::min(budget, static_cast<size_t>(len));
+    return true;
+}
+
+// 经TLS发送当前文件段：kTLS可用时由内核加密并零拷贝发送，否则读出一块暂存后在用户态加密
+bool HttpTransfer::send_file_tls(TlsSession& tls, size_t& budget)
+{
+    HttpTransferSegment& segment = this->segments[this->current];
+    if (!this->staged.empty()) {
+        return write_staged_tls(tls, budget);
+    }
+
+    if (tls.is_ktls_send()) {
+        size_t chunk = std::min({ static_cast<size_t>(segment.length), SENDFILE_CHUNK_SIZE, budget });
+        TlsStatus status = TLS_OK;
+        ssize_t len = tls.sendfile(segment.file->get_fd(), segment.offset, chunk, status);
+        if (len <= 0) {
+            if (status == TLS_CLOSED) {
+                throw TcpRuntimeException("TLS session closed by peer", __FILENAME__, __LINE__);
+            }
+            return false;
+        }
+        segment.offset += len;
+        segment.length -= len;
+        this->bytes_sent += len;
+        budget -= std::min(budget, static_cast<size_t>(len));
+        prefetch_ahead(segment);
+        return true;
+    }
+
+    size_t chunk = std::min(static_cast<size_t>(segment.length), TLS_CHUNK_SIZE);
+    this->staged.resize(chunk);
+    ssize_t len = pread(segment.file->get_fd(), &this->staged[0], chunk, segment.offset);
+    if (len <= 0) {
+        this->staged.clear();
+        if (len < 0 && errno == EINTR) {
+            return true;
+        }
+        throw TcpRuntimeException(len == 0 ? "File is truncated during transfer" : "pread error", __FILENAME__, __LINE__);
+    }
+    this->staged.resize(static_cast<size_t>(len));
+    this->staged_pos = 0;
+    segment.offset += len;
+    segment.length -= len;
+    prefetch_ahead(segment);
+    return write_staged_tls(tls, budget);
+}
+
+// 经TLS转发当前流段：数据须在用户态加密，按记录大小读入暂存区后写出
+bool HttpTransfer::relay_stream_tls(TlsSession& tls, size_t& budget)
+{
+    if (!this->staged.empty()) {
+        return write_staged_tls(tls, budget);
+    }
+    HttpStreamSource& source = *this->segments[this->current].stream;
+    uint64_t data = source.get_framing().get_data_remaining();
+    return read_stream(source, data > 0 ? static_cast<size_t>(std::min<uint64_t>(data, TLS_CHUNK_SIZE)) : STREAM_READ_SIZE);
+}
+
+bool HttpTransfer::resume(TlsSession& tls, size_t budget)
+{
+    this->waiting_source = false;
+    skip_empty_segments();
+    while (!done() && budget > 0) {
+        const HttpTransferSegment& segment = this->segments[this->current];
+        bool writable = false;
+        if (segment.stream) {
+            writable = relay_stream_tls(tls, budget);
+        } else if (segment.file) {
+            writable = send_file_tls(tls, budget);
+        } else {
+            writable = write_buffer_tls(tls, budget);
+        }
+        if (!writable) {
+            return false;
+        }
+        skip_empty_segments();
+    }
+    return done();
+}
@@ -0,0 +1,217 @@
+extern "C" {
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+}
+
+#include <algorithm>
+
+#include "http_upload.hpp"
+#include "http_request.hpp"
+
+HttpUpload::HttpUpload(const std::filesystem::path& target_path, int64_t content_length, uint64_t max_size) :
+    target_path(target_path),
+    framing(content_length >= 0 ? HTTP_BODY_LENGTH : HTTP_BODY_CHUNKED,
+        content_length >= 0 ? static_cast<uint64_t>(content_length) : 0),
+    max_size(max_size)
+{
+    if (this->framing.get_declared() > max_size) {
+        throw HttpRequestException("request body exceeds the upload limit", HTTP_ERR_CONTENT_TOO_LARGE);
+    }
+
+    // 临时文件与目标在同一目录，保证rename在同一文件系统内原子完成
+    std::string name = "." + target_path.filename().string() + ".upload-XXXXXX";
+    this->temp_path = (target_path.parent_path() / name).string();
+    this->file_fd = mkostemp(this->temp_path.data(), O_CLOEXEC);
+    if (this->file_fd < 0) {
+        throw TcpRuntimeException("create temp file failed: " + this->temp_path, __FILENAME__, __LINE__);
+    }
+    // mkostemp创建的文件只有属主可读写，改为与普通静态文件相同的权限
+    static_cast<void>(fchmod(this->file_fd, 0644));
+    // 已知长度时预先分配空间，减少碎片；仅是优化，文件系统不支持时忽略
+    if (content_length > 0) {
+        static_cast<void>(fallocate(this->file_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(content_length)));
+    }
+}
+
+HttpUpload::~HttpUpload()
+{
+    if (this->pipe_fds[0] >= 0) {
+        close(this->pipe_fds[0]);
+        close(this->pipe_fds[1]);
+    }
+    if (this->file_fd >= 0) {
+        close(this->file_fd);
+    }
+    if (!this->committed) {
+        unlink(this->temp_path.c_str());
+    }
+}
+
+void HttpUpload::write_file(const char *data, size_t length)
+{
+    while (length > 0) {
+        ssize_t len = write(this->file_fd, data, length);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw TcpRuntimeException("write upload file failed: " + this->temp_path, __FILENAME__, __LINE__);
+        }
+        data += len;
+        length -= static_cast<size_t>(len);
+    }
+}
+
+// 请求体数据写入文件并推进分帧
+void HttpUpload::write_data(const char *data, size_t length)
+{
+    write_file(data, length);
+    this->framing.consume_data(length);
+    this->received += length;
+}
+
+HttpUploadStatus HttpUpload::consume(std::string& input)
+{
+    size_t pos = 0;
+    while (!this->framing.is_done() && pos < input.size()) {
+        uint64_t data = this->framing.get_data_remaining();
+        if (data > 0) {
+            size_t length = static_cast<size_t>(std::min<uint64_t>(data, input.size() - pos));
+            write_data(input.data() + pos, length);
+            pos += length;
+            continue;
+        }
+        pos += this->framing.feed(input.data() + pos, input.size() - pos);
+        if (this->framing.get_declared() > this->max_size) {
+            throw HttpRequestException("request body exceeds the upload limit", HTTP_ERR_CONTENT_TOO_LARGE);
+        }
+    }
+    input.erase(0, pos);
+    return this->framing.is_done() ? HTTP_UPLOAD_DONE : HTTP_UPLOAD_AGAIN;
+}
+
+// 经管道把socket中当前分块的数据送入文件，返回本次收到的字节数，对端关闭时返回0，暂无数据时返回-1
+ssize_t HttpUpload::splice_body(int32_t client_fd)
+{
+    if (this->pipe_fds[0] < 0 && pipe2(this->pipe_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        this->pipe_fds[0] = -1;
+        throw TcpRuntimeException("pipe2 failed", __FILENAME__, __LINE__);
+    }
+
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(this->framing.get_data_remaining(), SPLICE_CHUNK_SIZE));
+    ssize_t len = splice(client_fd, nullptr, this->pipe_fds[1], nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (len < 0) {
+        if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+            return -1;
+        }
+        throw TcpRuntimeException("splice from socket error", __FILENAME__, __LINE__);
+    }
+    if (len == 0) {
+        return 0;
+    }
+
+    // 每次都把管道排空，下一次从socket读入时管道总是空的
+    size_t pending = static_cast<size_t>(len);
+    while (pending > 0) {
+        ssize_t written = splice(this->pipe_fds[0], nullptr, this->file_fd, nullptr, pending, SPLICE_F_MOVE);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            throw TcpRuntimeException("splice to upload file failed: " + this->temp_path, __FILENAME__, __LINE__);
+        }
+        pending -= static_cast<size_t>(written);
+    }
+
+    this->framing.consume_data(static_cast<uint64_t>(len));
+    this->received += static_cast<uint64_t>(len);
+    return len;
+}
+
+// TLS连接上读出解密后的数据再写入文件，返回值同splice_body()
+ssize_t HttpUpload::read_body_tls(TlsSession& tls)
+{
+    char buf[SPLICE_CHUNK_SIZE];
+    TlsStatus status = TLS_OK;
+    ssize_t len = tls.read(buf, static_cast<size_t>(std::min<uint64_t>(this->framing.get_data_remaining(), sizeof(buf))),
+        status);
+    if (len <= 0) {
+        return status == TLS_CLOSED ? 0 : -1;
+    }
+
+    write_data(buf, static_cast<size_t>(len));
+    return len;
+}
+
+// 读入一小块数据到input以解析长度行或trailer，返回值同splice_body()
+ssize_t HttpUpload::read_line_data(int32_t client_fd, TlsSession *tls, std::string& input)
+{
+    char buf[LINE_READ_SIZE];
+    ssize_t len = 0;
+    if (tls != nullptr) {
+        TlsStatus status = TLS_OK;
+        len = tls->read(buf, sizeof(buf), status);
+        if (len <= 0) {
+            return status == TLS_CLOSED ? 0 : -1;
+        }
+    } else {
+        len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+                return -1;
+            }
+            throw TcpRuntimeException("recv error", __FILENAME__, __LINE__);
+        }
+    }
+    input.append(buf, static_cast<size_t>(len));
+    return len;
+}
+
+HttpUploadStatus HttpUpload::receive(int32_t client_fd, std::string& input, TlsSession *tls)
+{
+    uint64_t start = this->received;
+    for (;;) {
+        HttpUploadStatus status = consume(input);
+        if (status == HTTP_UPLOAD_DONE) {
+            return status;
+        }
+
+        // consume()返回时缓冲区已无可用的请求体数据，数据状态下直接从socket送入文件
+        ssize_t len = 0;
+        if (this->framing.get_data_remaining() > 0) {
+            len = tls != nullptr ? read_body_tls(*tls) : splice_body(client_fd);
+        } else {
+            len = read_line_data(client_fd, tls, input);
+        }
+        if (len == 0) {
+            return HTTP_UPLOAD_CLOSED;
+        }
+        // 明文连接每次至多接收RECEIVE_BUDGET字节，socket中剩余的数据使EPOLLIN再次触发，避免快速上传独占reactor；
+        // TLS会话内部可能缓冲着已解密的数据，不会再触发事件，因此一直读到暂无数据
+        if (len < 0) {
+            return HTTP_UPLOAD_AGAIN;
+        }
+        if (tls == nullptr && this->received - start >= RECEIVE_BUDGET) {
+            // 用完配额的这次读取可能恰好收齐了请求体，此时socket已空、不会再触发EPOLLIN，须在此报告完成
+            return consume(input);
+        }
+    }
+}
+
+bool HttpUpload::commit()
+{
+    bool created = access(this->target_path.c_str(), F_OK) != 0;
+    if (rename(this->temp_path.c_str(), this->target_path.c_str()) < 0) {
+        throw TcpRuntimeException("rename " + this->temp_path + " to " + this->target_path.string() + " failed",
+            __FILENAME__, __LINE__);
+    }
+    this->committed = true;
+    return created;
+}
+
+uint64_t HttpUpload::get_received() const
+{
+    return this->received;
+}
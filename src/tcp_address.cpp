@@ -0,0 +1,136 @@
+extern "C" {
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+}
+
+#include <cstddef>
+#include <cstring>
+
+#include "tcp_public.hpp"
+#include "tcp_address.hpp"
+
+static const std::string LOCAL_PREFIX = "unix:";
+
+TcpAddress TcpAddress::inet(const std::string& host, uint16_t port)
+{
+    TcpAddress address;
+    sockaddr_in *addr = reinterpret_cast<sockaddr_in *>(&address.storage);
+    addr->sin_family = AF_INET;
+    addr->sin_port = htons(port);
+    int32_t rc = inet_pton(AF_INET, host.c_str(), &addr->sin_addr);
+    if (rc != 1) {
+        throw TcpRuntimeException("inet_pton ret is " + std::to_string(rc) + " for " + host, __FILENAME__, __LINE__);
+    }
+    address.length = sizeof(sockaddr_in);
+    return address;
+}
+
+// 抽象命名空间的sun_path以'\0'开头，名字不以'\0'结尾，地址长度须精确到名字末尾
+TcpAddress TcpAddress::local(const std::string& path)
+{
+    TcpAddress address;
+    sockaddr_un *addr = reinterpret_cast<sockaddr_un *>(&address.storage);
+    if (path.empty() || path == "@" || path.size() >= sizeof(addr->sun_path)) {
+        throw TcpRuntimeException("invalid unix socket path: " + path, __FILENAME__, __LINE__);
+    }
+    addr->sun_family = AF_UNIX;
+    memcpy(addr->sun_path, path.data(), path.size());
+    if (path[0] == '@') {
+        addr->sun_path[0] = '\0';
+        address.length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+    } else {
+        address.length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    }
+    return address;
+}
+
+TcpAddress TcpAddress::parse(const std::string& spec)
+{
+    if (spec.compare(0, LOCAL_PREFIX.size(), LOCAL_PREFIX) == 0) {
+        return local(spec.substr(LOCAL_PREFIX.size()));
+    }
+    size_t colon = spec.rfind(':');
+    if (colon == std::string::npos) {
+        throw TcpRuntimeException("invalid address: " + spec, __FILENAME__, __LINE__);
+    }
+    try {
+        unsigned long port = std::stoul(spec.substr(colon + 1));
+        if (port > UINT16_MAX) {
+            throw std::out_of_range(spec);
+        }
+        return inet(spec.substr(0, colon), static_cast<uint16_t>(port));
+    } catch (const std::logic_error&) {
+        throw TcpRuntimeException("invalid address: " + spec, __FILENAME__, __LINE__);
+    }
+}
+
+TcpAddress TcpAddress::from_sockaddr(const sockaddr *addr, socklen_t length)
+{
+    if (length > sizeof(sockaddr_storage) || length < sizeof(sa_family_t) ||
+        (addr->sa_family != AF_INET && addr->sa_family != AF_UNIX)) {
+        throw TcpRuntimeException("unsupported address family", __FILENAME__, __LINE__);
+    }
+    TcpAddress address;
+    memcpy(&address.storage, addr, length);
+    address.length = length;
+    return address;
+}
+
+int32_t TcpAddress::get_family() const
+{
+    return this->storage.ss_family;
+}
+
+bool TcpAddress::is_local() const
+{
+    return this->storage.ss_family == AF_UNIX;
+}
+
+bool TcpAddress::is_abstract() const
+{
+    const sockaddr_un *addr = reinterpret_cast<const sockaddr_un *>(&this->storage);
+    return is_local() && this->length > offsetof(sockaddr_un, sun_path) && addr->sun_path[0] == '\0';
+}
+
+const sockaddr *TcpAddress::get_sockaddr() const
+{
+    return reinterpret_cast<const sockaddr *>(&this->storage);
+}
+
+socklen_t TcpAddress::get_length() const
+{
+    return this->length;
+}
+
+std::string TcpAddress::get_host() const
+{
+    if (is_local()) {
+        const sockaddr_un *addr = reinterpret_cast<const sockaddr_un *>(&this->storage);
+        size_t size = this->length > offsetof(sockaddr_un, sun_path) ? this->length - offsetof(sockaddr_un, sun_path) : 0;
+        if (is_abstract()) {
+            return "@" + std::string(addr->sun_path + 1, size - 1);
+        }
+        return std::string(addr->sun_path, strnlen(addr->sun_path, size));
+    }
+    char host[INET_ADDRSTRLEN] = {0};
+    static_cast<void>(inet_ntop(AF_INET, &reinterpret_cast<const sockaddr_in *>(&this->storage)->sin_addr, host,
+        sizeof(host)));
+    return host;
+}
+
+uint16_t TcpAddress::get_port() const
+{
+    if (is_local()) {
+        return 0;
+    }
+    return ntohs(reinterpret_cast<const sockaddr_in *>(&this->storage)->sin_port);
+}
+
+std::string TcpAddress::to_string() const
+{
+    if (is_local()) {
+        return LOCAL_PREFIX + get_host();
+    }
+    return get_host() + ":" + std::to_string(get_port());
+}
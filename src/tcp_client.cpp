@@ -13,30 +13,35 @@ extern "C" {
 #include "tcp_client.hpp"
 
 TcpClient::TcpClient(const std::string& server_addr, uint16_t server_port) :
-    server_addr(server_addr),
-    server_port(server_port)
+    TcpClient(server_addr, server_port, TcpSocketOptions())
 {
-    struct sockaddr_in socket_addr = {0};
+}
 
+TcpClient::TcpClient(const std::string& server_addr, uint16_t server_port, const TcpSocketOptions& options) :
+    TcpClient(TcpAddress::inet(server_addr, server_port), options)
+{
+}
+
+TcpClient::TcpClient(const TcpAddress& address, const TcpSocketOptions& options) :
+    server_addr(address.get_host()),
+    server_port(address.get_port())
+{
     // 创建套接字；此时在参数2中可指定非阻塞
-    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    int sockfd = socket(address.get_family(), SOCK_STREAM, 0);
     if (sockfd < 0)
     {
         throw TcpRuntimeException("create socket failed!", __FILENAME__, __LINE__);
     }
 
-    // 连接服务器
-    socket_addr.sin_family = AF_INET;
-    socket_addr.sin_port = htons(server_port);
-    int rc = inet_pton(AF_INET, server_addr.c_str(), &socket_addr.sin_addr);
-    if (rc != 1)
-    {
-        throw TcpRuntimeException("inet_pton failed! rc=" + std::to_string(rc), __FILENAME__, __LINE__);
+    if (!address.is_local()) {
+        static_cast<void>(options.apply_connect(sockfd));
     }
-    
-    LOG_INFO("connecting to %s:%hu...\n", server_addr.c_str(), server_port);
-    rc = connect(sockfd, (struct sockaddr *)&socket_addr, sizeof(socket_addr));
+
+    // 连接服务器
+    LOG_INFO("connecting to %s...\n", address.to_string().c_str());
+    int rc = connect(sockfd, address.get_sockaddr(), address.get_length());
     if (rc < 0) {
+        close(sockfd);
         throw TcpRuntimeException("connect failed! rc=" + std::to_string(rc), __FILENAME__, __LINE__);
     }
 
@@ -52,7 +57,7 @@ TcpClient::TcpClient(const std::string& server_addr, uint16_t server_port) :
     }
     */
 
-    LOG_INFO("connected to %s:%hu\n", server_addr.c_str(), server_port);
+    LOG_INFO("connected to %s\n", address.to_string().c_str());
     this->conn_fd = sockfd;
 }
 
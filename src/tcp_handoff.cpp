@@ -0,0 +1,202 @@
+extern "C" {
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+}
+
+#include <cerrno>
+#include <cstring>
+
+#include "tcp_handoff.hpp"
+
+// hand_over()在accept前轮询等待的间隔，决定cancel()生效的延迟
+static constexpr int32_t CANCEL_POLL_INTERVAL = 200; // ms
+
+static sockaddr_un make_unix_addr(const std::string& socket_path)
+{
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(addr.sun_path)) {
+        throw TcpRuntimeException("Unix socket path is too long: " + socket_path, __FILENAME__, __LINE__);
+    }
+    memcpy(addr.sun_path, socket_path.c_str(), socket_path.size());
+    return addr;
+}
+
+// 等待fd可读，超时或出错返回false
+static bool wait_readable(int32_t fd, int32_t timeout_ms)
+{
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    int32_t rc = 0;
+    do {
+        rc = poll(&pfd, 1, timeout_ms);
+    } while (rc < 0 && errno == EINTR);
+    return rc > 0;
+}
+
+// 以SCM_RIGHTS附带fd发送，附带1字节的普通数据，否则对端的recvmsg无法区分fd与连接关闭
+static bool send_fd(int32_t channel_fd, int32_t fd)
+{
+    char payload = 'L';
+    struct iovec iov = { &payload, sizeof(payload) };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int32_t))] = {0};
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int32_t));
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(int32_t));
+
+    return sendmsg(channel_fd, &msg, MSG_NOSIGNAL) == sizeof(payload);
+}
+
+static int32_t recv_fd(int32_t channel_fd)
+{
+    char payload = 0;
+    struct iovec iov = { &payload, sizeof(payload) };
+    alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int32_t))] = {0};
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    if (recvmsg(channel_fd, &msg, MSG_CMSG_CLOEXEC) != sizeof(payload) || (msg.msg_flags & MSG_CTRUNC)) {
+        return -1;
+    }
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    if (cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(sizeof(int32_t))) {
+        return -1;
+    }
+    int32_t fd = -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(int32_t));
+    return fd;
+}
+
+ListenHandoff::ListenHandoff(const std::string& socket_path) : socket_path(socket_path)
+{
+}
+
+ListenHandoff::~ListenHandoff()
+{
+    if (this->channel_fd >= 0) {
+        close(this->channel_fd);
+    }
+    if (this->server_fd >= 0) {
+        close(this->server_fd);
+    }
+    // 交接完成后路径已属于新进程，不能删除
+    if (this->path_owned) {
+        unlink(this->socket_path.c_str());
+    }
+}
+
+int32_t ListenHandoff::receive(int32_t timeout_ms)
+{
+    sockaddr_un addr = make_unix_addr(this->socket_path);
+    int32_t fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw TcpRuntimeException("socket", __FILENAME__, __LINE__);
+    }
+    // 路径不存在或无进程在监听，说明是首次启动
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+
+    int32_t listen_fd = wait_readable(fd, timeout_ms) ? recv_fd(fd) : -1;
+    if (listen_fd < 0) {
+        close(fd);
+        throw TcpRuntimeException("Failed to receive listen fd from " + this->socket_path, __FILENAME__, __LINE__);
+    }
+    this->channel_fd = fd;
+    LOG_INFO("Received listen fd %d from the previous process", listen_fd);
+    return listen_fd;
+}
+
+void ListenHandoff::confirm()
+{
+    if (this->channel_fd < 0) {
+        return;
+    }
+    char ack = 'C';
+    if (send(this->channel_fd, &ack, sizeof(ack), MSG_NOSIGNAL) != sizeof(ack)) {
+        LOG_ERR("Failed to confirm the handoff, errno=%d", errno);
+    }
+    close(this->channel_fd);
+    this->channel_fd = -1;
+}
+
+void ListenHandoff::listen()
+{
+    sockaddr_un addr = make_unix_addr(this->socket_path);
+    if (this->server_fd >= 0) {
+        close(this->server_fd);
+        this->server_fd = -1;
+    }
+
+    int32_t fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        throw TcpRuntimeException("socket", __FILENAME__, __LINE__);
+    }
+    // 旧进程仍在等待时，它的socket已经接受过本进程的连接，此时替换路径不影响交接
+    unlink(this->socket_path.c_str());
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || ::listen(fd, 1) < 0) {
+        close(fd);
+        throw TcpRuntimeException("Failed to listen on " + this->socket_path, __FILENAME__, __LINE__);
+    }
+    this->server_fd = fd;
+    this->path_owned = true;
+}
+
+bool ListenHandoff::hand_over(int32_t listen_fd, int32_t confirm_timeout_ms)
+{
+    while (!this->cancelled.load()) {
+        if (!wait_readable(this->server_fd, CANCEL_POLL_INTERVAL)) {
+            continue;
+        }
+        int32_t fd = accept4(this->server_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+
+        char ack = 0;
+        bool confirmed = send_fd(fd, listen_fd) && wait_readable(fd, confirm_timeout_ms) &&
+            recv(fd, &ack, sizeof(ack), 0) == sizeof(ack) && ack == 'C';
+        close(fd);
+        if (confirmed) {
+            close(this->server_fd);
+            this->server_fd = -1;
+            this->path_owned = false;
+            LOG_INFO("Listen fd %d handed over through %s", listen_fd, this->socket_path.c_str());
+            return true;
+        }
+
+        // 新进程可能已替换了路径后才失败，重新占用路径以便下一次交接
+        LOG_ERR("Handoff through %s was not confirmed, keep serving", this->socket_path.c_str());
+        try {
+            listen();
+        } catch (TcpRuntimeException& e) {
+            LOG_ERR(e.what());
+            return false;
+        }
+    }
+    return false;
+}
+
+void ListenHandoff::cancel()
+{
+    this->cancelled.store(true);
+}
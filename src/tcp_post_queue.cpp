@@ -0,0 +1,48 @@
+#include "tcp_post_queue.hpp"
+
+TcpPostQueue::TcpPostQueue()
+{
+    Node *stub = new Node();
+    this->tail.store(stub, std::memory_order_relaxed);
+    this->head = stub;
+}
+
+TcpPostQueue::~TcpPostQueue()
+{
+    Node *node = this->head;
+    while (node != nullptr) {
+        Node *next = node->next.load(std::memory_order_relaxed);
+        delete node;
+        node = next;
+    }
+}
+
+// 先交换尾指针占位，再把前驱的next指向新节点；两步之间其他生产者可继续在新节点之后追加
+void TcpPostQueue::push(uint64_t conn_id, std::shared_ptr<const std::string> frame)
+{
+    Node *node = new Node();
+    node->conn_id = conn_id;
+    node->frame = std::move(frame);
+    Node *prev = this->tail.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+}
+
+// 取出的节点成为新的哑节点，其内容移走后释放旧的哑节点
+bool TcpPostQueue::pop(uint64_t& conn_id, std::shared_ptr<const std::string>& frame)
+{
+    Node *next = this->head->next.load(std::memory_order_acquire);
+    if (next == nullptr) {
+        return false;
+    }
+    conn_id = next->conn_id;
+    frame = std::move(next->frame);
+    delete this->head;
+    this->head = next;
+    return true;
+}
+
+bool TcpPostQueue::empty() const
+{
+    return this->head->next.load(std::memory_order_acquire) == nullptr &&
+        this->tail.load(std::memory_order_acquire) == this->head;
+}
@@ -202,6 +202,89 @@ std::string recv_with_eof(int32_t socket_fd, size_t max_size, const std::string&
     return result;
 }
 
+/**
+ * @brief 非阻塞方式聚合发送多段内存数据
+ * 
+ * 使用sendmsg实现writev语义（可指定MSG_NOSIGNAL），适用于响应头与内容一并发出的场景，
+ * 数据量不受uint16_t限制；发送不完整时会修改传入的iov数组
+ * 
+ * @param socket_fd 文件描述符，用于标识要发送数据的套接字
+ * @param iov 待发送的内存段数组
+ * @param iov_count 内存段数量
+ * 
+ * @throw TcpRuntimeException 当发送失败且错误不可忽略或达到最大重试次数时抛出异常
+ */
+void sendv_nonblock(int32_t socket_fd, struct iovec *iov, int32_t iov_count)
+{
+    // 跳过开头的空段
+    while (iov_count > 0 && iov->iov_len == 0) {
+        iov++;
+        iov_count--;
+    }
+
+    for (uint32_t retry_times = 0; iov_count > 0 && retry_times < MAX_RETRY_TIMES; ) {
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = static_cast<size_t>(iov_count);
+
+        ssize_t len = sendmsg(socket_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len < 0) {
+            if (is_ignorable_error()) {
+                retry_times++;
+                usleep(IO_WAIT_TIMEOUT);
+                continue;
+            }
+            LOG_ERR("sendmsg error: %s", strerror(errno));
+            throw TcpRuntimeException("sendmsg failed", __FILENAME__, __LINE__);
+        }
+
+        retry_times = 0;
+
+        // 按已发送长度前移iov
+        size_t sent = static_cast<size_t>(len);
+        while (iov_count > 0 && sent >= iov->iov_len) {
+            sent -= iov->iov_len;
+            iov++;
+            iov_count--;
+        }
+        if (iov_count > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + sent;
+            iov->iov_len -= sent;
+        }
+    }
+
+    if (iov_count > 0) {
+        LOG_ERR("Failed to send data, Reached max retries, remaining segments: %d", iov_count);
+        throw TcpRuntimeException("sendmsg failed, incomplete transfer", __FILENAME__, __LINE__);
+    }
+}
+
+// 将整个文件读入内存；仅适用于小文件
+std::string read_file_content(const std::string& file_path, off_t size)
+{
+    int file_fd = open(file_path.c_str(), O_RDONLY);
+    if (file_fd < 0) {
+        throw TcpRuntimeException("Open file failed", __FILENAME__, __LINE__);
+    }
+
+    std::string content(static_cast<size_t>(size), '\0');
+    size_t total_read = 0;
+    while (total_read < content.size()) {
+        ssize_t len = read(file_fd, &content[total_read], content.size() - total_read);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len <= 0) {
+            close(file_fd);
+            throw TcpRuntimeException("Read file failed", __FILENAME__, __LINE__);
+        }
+        total_read += static_cast<size_t>(len);
+    }
+
+    close(file_fd);
+    return content;
+}
+
 // 利用sendfile向socket发送文件；有更精细需求的不适用本函数
 void sendfile_nonblock(int32_t socket_fd, const std::string& file_path, off_t offset, off_t length)
 {
@@ -210,6 +293,18 @@ void sendfile_nonblock(int32_t socket_fd, const std::string& file_path, off_t of
         throw TcpRuntimeException("Open file failed", __FILENAME__, __LINE__);
     }
 
+    try {
+        sendfile_nonblock(socket_fd, file_fd, offset, length);
+    } catch (TcpRuntimeException& e) {
+        close(file_fd);
+        RETHROW(e);
+    }
+    close(file_fd);
+}
+
+// 同上，但使用调用方已打开的文件，便于同一文件的多个分段复用一个fd
+void sendfile_nonblock(int32_t socket_fd, int32_t file_fd, off_t offset, off_t length)
+{
     off_t remaining = length;
     
     uint32_t retry_times = 0;
@@ -225,7 +320,6 @@ void sendfile_nonblock(int32_t socket_fd, const std::string& file_path, off_t of
                 continue;
             }
             
-            close(file_fd);
             LOG_ERR("Send file failed, errno=%d", errno);
             throw TcpRuntimeException("Send file failed", __FILENAME__, __LINE__);
         }
@@ -245,7 +339,6 @@ void sendfile_nonblock(int32_t socket_fd, const std::string& file_path, off_t of
         LOG_DEBUG("Sent %d bytes, remaining %d bytes, offset %d", sent, remaining, offset);
     }
     
-    close(file_fd);
     // 检查是否所有数据都已发送
     if (remaining > 0) {
         LOG_ERR("Send file failed, incomplete transfer");
@@ -4,30 +4,48 @@ extern "C" {
 // 网络库四大天王
 #include <sys/socket.h>
 #include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h> // 获取tcp建链状态依赖
 #include <arpa/inet.h>
 }
 
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
 #include <iostream>
 #include <string>
 
 #include "tcp_server.hpp"
+#include "cpu_placement.hpp"
+
+// epoll实例的忙轮询参数，与内核的struct epoll_params布局一致（Linux 6.9起），旧版头文件中没有该定义
+struct TcpEpollParams {
+    uint32_t busy_poll_usecs;
+    uint16_t busy_poll_budget;
+    uint8_t prefer_busy_poll;
+    uint8_t pad;
+};
+static const unsigned long TCP_EPIOCSPARAMS = _IOW(0x8A, 0x01, TcpEpollParams);
 
 void TcpServer::accept_new_client(int32_t listen_fd)
 {
     int32_t new_socket = -1;
 
-    sockaddr_in client_addr;
-    socklen_t client_address_size = sizeof(client_addr);
+    sockaddr_storage peer_addr;
+    socklen_t peer_address_size = sizeof(peer_addr);
+    bool inet = !this->listen_address.is_local();
 
     // 当有多个连接接入时，需要加循环处理
     // epoll中socket的模式是ET（边缘）触发时，必须在一次事件处理中**处理完全部的新输入**
     // 否则其他连接不会再继续触发事件，会导致事件丢失
     for (uint32_t retry_times = 0; retry_times < MAX_ACCEPT_SIZE; ) {
         // 在接受新连接时，可以使用accept4而非accept，当场指定新连接的socket为非阻塞模式
-        new_socket = accept4(listen_fd, (sockaddr *)&client_addr, &client_address_size, SOCK_NONBLOCK);
+        peer_address_size = sizeof(peer_addr);
+        new_socket = accept4(listen_fd, (sockaddr *)&peer_addr, &peer_address_size, SOCK_NONBLOCK);
         if (new_socket < 0) {
             // 非阻塞accept下，返回-1并不一定是出错
             break;
@@ -41,13 +59,30 @@ void TcpServer::accept_new_client(int32_t listen_fd)
         }
         */
 
-        struct epoll_event event = { .events = EPOLLIN | EPOLLRDHUP, .data = { .fd = new_socket } };
+        struct epoll_event event = { .events = this->get_client_events(), .data = { .fd = new_socket } };
         int32_t rc = epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, new_socket, &event);
         if (rc < 0) {
             close(new_socket);
             throw TcpRuntimeException("Failed to add new client to epoll", __FILENAME__, __LINE__);
         }
+        if (inet && !this->socket_options.apply_accepted(new_socket) && !this->socket_options_failed) {
+            this->socket_options_failed = true;
+            LOG_ERR("some socket options are not applied to client %d", new_socket);
+        }
+        if (inet && this->busy_poll) {
+            this->set_socket_busy_poll(new_socket);
+        }
 
+        // 连接ID的高32位为递增序号，fd被复用后ID也不同
+        this->conn_ids[new_socket] = (++this->next_conn_seq << 32) | static_cast<uint32_t>(new_socket);
+
+        // Unix域的对端通常没有绑定地址，回调只告知地址族
+        sockaddr_in client_addr = {};
+        if (inet) {
+            memcpy(&client_addr, &peer_addr, sizeof(client_addr));
+        } else {
+            client_addr.sin_family = AF_UNIX;
+        }
         this->deal_new_client(new_socket, client_addr);
     }
 
@@ -63,10 +98,64 @@ void TcpServer::close_client(int32_t client_fd)
         throw TcpRuntimeException("Invalid client fd, fd cannot be stdio", __FILENAME__, __LINE__);
     }
 
+    this->deal_client_close(client_fd);
+    this->remove_output(client_fd);
+    this->conn_ids.erase(client_fd);
+
     epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, client_fd, nullptr);
     close(client_fd);
 }
 
+void TcpServer::modify_client_events(int32_t client_fd, uint32_t events)
+{
+    struct epoll_event event = { .events = events, .data = { .fd = client_fd } };
+    int32_t rc = epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, client_fd, &event);
+    if (rc < 0) {
+        throw TcpRuntimeException("Failed to modify client events, fd=" + std::to_string(client_fd), __FILENAME__, __LINE__);
+    }
+}
+
+void TcpServer::watch_fd(int32_t fd, uint32_t events)
+{
+    struct epoll_event event = { .events = events, .data = { .fd = fd } };
+    int32_t rc = epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, fd, &event);
+    if (rc < 0 && errno == EEXIST) {
+        rc = epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, fd, &event);
+    }
+    if (rc < 0) {
+        throw TcpRuntimeException("Failed to watch fd=" + std::to_string(fd), __FILENAME__, __LINE__);
+    }
+}
+
+void TcpServer::unwatch_fd(int32_t fd)
+{
+    if (epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, fd, nullptr) < 0 && errno != ENOENT) {
+        throw TcpRuntimeException("Failed to unwatch fd=" + std::to_string(fd), __FILENAME__, __LINE__);
+    }
+}
+
+bool TcpServer::is_loop_thread() const
+{
+    return this->loop_thread.load(std::memory_order_relaxed) == std::this_thread::get_id();
+}
+
+// listen_fd为ET触发，暂停期间到达的连接不会再产生边沿；
+// 恢复时EPOLL_CTL_MOD会重新检查就绪状态，全连接队列非空时立即产生一次事件
+void TcpServer::set_accept_paused(bool paused)
+{
+    std::lock_guard<std::mutex> lock(this->accept_mutex);
+    if (this->accept_stopped) {
+        return;
+    }
+    struct epoll_event event = { .events = paused ? 0u : static_cast<uint32_t>(EPOLLIN | EPOLLET),
+        .data = { .fd = this->listen_fd } };
+    int32_t rc = epoll_ctl(this->epoll_fd, EPOLL_CTL_MOD, this->listen_fd, &event);
+    if (rc < 0) {
+        throw TcpRuntimeException("Failed to modify listen events, paused=" + std::to_string(paused),
+            __FILENAME__, __LINE__);
+    }
+}
+
 void TcpServer::deal_client_msg(int32_t client_fd)
 {
     try {
@@ -94,13 +183,52 @@ void TcpServer::deal_client_msg(int32_t client_fd)
 
 void TcpServer::deal_new_client(int32_t client_fd, const sockaddr_in& client_addr)
 {
+    if (client_addr.sin_family == AF_UNIX) {
+        LOG_INFO("New client connected on %s, fd is %d", this->listen_address.to_string().c_str(), client_fd);
+        return;
+    }
     char peer_ip[INET_ADDRSTRLEN] = {0};
     static_cast<void>(inet_ntop(AF_INET, &client_addr.sin_addr, peer_ip, sizeof(peer_ip)));
     LOG_INFO("New client connected from %s:%hu, fd is %d", peer_ip, ntohs(client_addr.sin_port), client_fd);
 }
 
+void TcpServer::deal_client_writable(int32_t client_fd)
+{
+    // 基类不关注EPOLLOUT，不会走到这里
+    static_cast<void>(client_fd);
+}
+
+void TcpServer::deal_client_close(int32_t client_fd)
+{
+    static_cast<void>(client_fd);
+}
+
+void TcpServer::deal_client_hangup(int32_t client_fd)
+{
+    this->close_client(client_fd);
+}
+
+uint32_t TcpServer::get_client_events() const
+{
+    return EPOLLIN | EPOLLRDHUP;
+}
+
+void TcpServer::deal_loop_end()
+{
+}
+
+int32_t TcpServer::get_loop_timeout()
+{
+    return EPOLL_TIMEOUT;
+}
+
 TcpServer::TcpServer(const std::string &listen_addr, uint16_t listen_port) :
-    listen_addr(listen_addr), listen_port(listen_port)
+    TcpServer(TcpAddress::inet(listen_addr, listen_port))
+{
+}
+
+TcpServer::TcpServer(const TcpAddress &listen_address) :
+    listen_address(listen_address), listen_addr(listen_address.get_host()), listen_port(listen_address.get_port())
 {
     // 创建epoll
     // 在现在的Linux内核，epoll_create的size参数已经无意义
@@ -112,47 +240,41 @@ TcpServer::TcpServer(const std::string &listen_addr, uint16_t listen_port) :
     // 创建处理新连接进入的监听socket
     // 为了不使单个接入连接把accept阻塞而饿死整个流程，该socket本身应声明为非阻塞
     // 这样accept也需要像非阻塞收发数据一样做特殊判断逻辑，见accept处注释
-    int32_t new_socket = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    int32_t new_socket = socket(listen_address.get_family(), SOCK_STREAM | SOCK_NONBLOCK, 0);
     if (new_socket < 0) {
         close(this->epoll_fd);
         throw TcpRuntimeException("socket", __FILENAME__, __LINE__);
     }
 
-    // 打开SO_REUSEADDR，防止同地址socket无法再次绑定
-    // 该情况通常出现在socket由对端提出关闭，本端第三次挥手后进入TIME_WAIT状态
-    // 此时同一地址上又产生新连接，若不做该配置，则无法再次绑定
-    int32_t optval = 1;
-    int32_t rc = setsockopt(new_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
-    if (rc < 0) {
-        close(new_socket);
-        close(this->epoll_fd);
-        throw TcpRuntimeException("Failed to set reuse addr", __FILENAME__, __LINE__);
-    }
-
-    // 文本型地址转换为二进制
-    struct sockaddr_in socket_addr = {
-        .sin_family = AF_INET,
-        .sin_port = htons(listen_port),
-        .sin_addr = {
-            .s_addr = INADDR_ANY
-        },
-        .sin_zero = {0}
-    };
-    rc = inet_pton(AF_INET, listen_addr.c_str(), &socket_addr.sin_addr);
-    if (rc != 1) {
-        close(new_socket);
-        close(this->epoll_fd);
-        throw TcpRuntimeException("inet_pton ret is " + std::to_string(rc), __FILENAME__, __LINE__);
+    int32_t rc = 0;
+    if (!listen_address.is_local()) {
+        // 打开SO_REUSEADDR，防止同地址socket无法再次绑定
+        // 该情况通常出现在socket由对端提出关闭，本端第三次挥手后进入TIME_WAIT状态
+        // 此时同一地址上又产生新连接，若不做该配置，则无法再次绑定
+        int32_t optval = 1;
+        rc = setsockopt(new_socket, SOL_SOCKET, SO_REUSEADDR, &optval, sizeof(optval));
+        if (rc < 0) {
+            close(new_socket);
+            close(this->epoll_fd);
+            throw TcpRuntimeException("Failed to set reuse addr", __FILENAME__, __LINE__);
+        }
+    } else if (!listen_address.is_abstract()) {
+        // Unix域socket文件在监听关闭后仍留在文件系统中，不删除则无法再次绑定；只删除socket文件，不误删普通文件
+        struct stat st;
+        if (lstat(this->listen_addr.c_str(), &st) == 0 && S_ISSOCK(st.st_mode)) {
+            static_cast<void>(unlink(this->listen_addr.c_str()));
+        }
     }
 
     // 绑定地址
-    rc = bind(new_socket, (struct sockaddr *)&socket_addr, sizeof(socket_addr));
+    rc = bind(new_socket, listen_address.get_sockaddr(), listen_address.get_length());
     if (rc < 0) {
         close(new_socket);
         close(this->epoll_fd);
-        throw TcpRuntimeException("bind ret is " + std::to_string(rc) + " addr is " +
-            std::to_string(socket_addr.sin_addr.s_addr) + ":" + std::to_string(listen_port), __FILENAME__, __LINE__);
+        throw TcpRuntimeException("bind ret is " + std::to_string(rc) + " addr is " + listen_address.to_string(),
+            __FILENAME__, __LINE__);
     }
+    this->unlink_on_close = listen_address.is_local() && !listen_address.is_abstract();
 
     rc = listen(new_socket, 5);
     if (rc < 0) {
@@ -171,12 +293,83 @@ TcpServer::TcpServer(const std::string &listen_addr, uint16_t listen_port) :
     }
 
     this->listen_fd = new_socket;
+
+    try {
+        this->init_wakeup();
+    } catch (TcpRuntimeException &e) {
+        close(this->listen_fd);
+        close(this->epoll_fd);
+        if (this->unlink_on_close) {
+            static_cast<void>(unlink(this->listen_addr.c_str()));
+        }
+        RETHROW(e);
+    }
 }
 
+TcpServer::TcpServer(int32_t listen_fd) : listen_port(0)
+{
+    int32_t accepting = 0;
+    int32_t domain = 0;
+    socklen_t optlen = sizeof(accepting);
+    int32_t rc = getsockopt(listen_fd, SOL_SOCKET, SO_ACCEPTCONN, &accepting, &optlen);
+    optlen = sizeof(domain);
+    if (rc < 0 || accepting == 0 || getsockopt(listen_fd, SOL_SOCKET, SO_DOMAIN, &domain, &optlen) < 0 ||
+        (domain != AF_INET && domain != AF_UNIX)) {
+        throw TcpRuntimeException("fd " + std::to_string(listen_fd) + " is not a listening IPv4 or unix socket",
+            __FILENAME__, __LINE__);
+    }
+
+    sockaddr_storage socket_addr;
+    socklen_t addr_size = sizeof(socket_addr);
+    rc = getsockname(listen_fd, (struct sockaddr *)&socket_addr, &addr_size);
+    if (rc < 0) {
+        throw TcpRuntimeException("getsockname ret is " + std::to_string(rc), __FILENAME__, __LINE__);
+    }
+    // 交接来的Unix域socket文件仍归交出方所有，本对象不负责删除
+    this->listen_address = TcpAddress::from_sockaddr((struct sockaddr *)&socket_addr, addr_size);
+    this->listen_addr = this->listen_address.get_host();
+    this->listen_port = this->listen_address.get_port();
+
+    // 交接来的socket不一定是非阻塞的，accept的循环依赖非阻塞模式
+    int32_t flags = fcntl(listen_fd, F_GETFL);
+    if (flags < 0 || fcntl(listen_fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        throw TcpRuntimeException("Failed to set listen socket to nonblock", __FILENAME__, __LINE__);
+    }
+
+    this->epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        throw TcpRuntimeException("epoll_create", __FILENAME__, __LINE__);
+    }
+
+    // 与自行创建的监听socket一致使用ET；加入时全连接队列中已有的连接会立即产生一次事件
+    struct epoll_event event = { .events = EPOLLIN | EPOLLET, .data = { .fd = listen_fd } };
+    rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, listen_fd, &event);
+    if (rc < 0) {
+        close(this->epoll_fd);
+        throw TcpRuntimeException("epoll_ctl ret is " + std::to_string(rc), __FILENAME__, __LINE__);
+    }
+
+    this->listen_fd = listen_fd;
+
+    try {
+        this->init_wakeup();
+    } catch (TcpRuntimeException &e) {
+        close(this->epoll_fd);
+        RETHROW(e);
+    }
+}
+
+// 已调用stop_accepting()时监听socket可能已交接给其他进程，此时保留socket文件
 TcpServer::~TcpServer()
 {
-    static_cast<void>(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, listen_fd, NULL));
-    close(listen_fd);
+    if (listen_fd >= 0) {
+        static_cast<void>(epoll_ctl(epoll_fd, EPOLL_CTL_DEL, listen_fd, NULL));
+        close(listen_fd);
+        if (this->unlink_on_close) {
+            static_cast<void>(unlink(this->listen_addr.c_str()));
+        }
+    }
+    close(this->wakeup_fd);
     close(epoll_fd);
 }
 
@@ -190,37 +383,535 @@ uint16_t TcpServer::get_listen_port() const
     return this->listen_port;
 }
 
+const TcpAddress &TcpServer::get_listen_address() const
+{
+    return this->listen_address;
+}
+
+int32_t TcpServer::get_listen_fd() const
+{
+    return this->listen_fd;
+}
+
+// 监听socket交接给其他进程后两个进程共享同一个打开的文件，仅close不会把它从本进程的epoll中移除，需先显式删除
+void TcpServer::stop_accepting()
+{
+    std::lock_guard<std::mutex> lock(this->accept_mutex);
+    if (this->accept_stopped) {
+        return;
+    }
+    this->accept_stopped = true;
+    static_cast<void>(epoll_ctl(this->epoll_fd, EPOLL_CTL_DEL, this->listen_fd, nullptr));
+    close(this->listen_fd);
+    this->listen_fd = -1;
+    LOG_INFO("Stop accepting on %s", this->listen_address.to_string().c_str());
+}
+
+void TcpServer::set_socket_options(const TcpSocketOptions& options)
+{
+    this->socket_options = options;
+    this->socket_options_failed = false;
+    if (this->listen_fd >= 0 && !this->listen_address.is_local() && !options.apply_listen(this->listen_fd)) {
+        LOG_ERR("some socket options are not applied to listen socket %d", this->listen_fd);
+    }
+}
+
+const TcpSocketOptions& TcpServer::get_socket_options() const
+{
+    return this->socket_options;
+}
+
+// SO_BUSY_POLL超过net.core.busy_read时需要CAP_NET_ADMIN；设置失败不影响连接，只在首次记录日志
+void TcpServer::set_socket_busy_poll(int32_t client_fd)
+{
+    const TcpBusyPollConfig& config = this->busy_poll_config;
+    int32_t usecs = static_cast<int32_t>(config.socket_busy_poll_us);
+    int32_t prefer = config.prefer_busy_poll ? 1 : 0;
+    int32_t budget = config.busy_poll_budget;
+    bool applied = usecs == 0 || setsockopt(client_fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) == 0;
+    if (applied && prefer != 0) {
+        applied = setsockopt(client_fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &prefer, sizeof(prefer)) == 0;
+    }
+    if (applied && budget != 0) {
+        applied = setsockopt(client_fd, SOL_SOCKET, SO_BUSY_POLL_BUDGET, &budget, sizeof(budget)) == 0;
+    }
+
+    if (!this->socket_busy_poll_tried) {
+        this->socket_busy_poll_tried = true;
+        this->socket_busy_poll.store(applied, std::memory_order_relaxed);
+        if (!applied) {
+            LOG_ERR("socket busy poll is not available: %s", strerror(errno));
+        }
+    }
+}
+
+void TcpServer::enable_busy_poll(const TcpBusyPollConfig& config)
+{
+    this->busy_poll = true;
+    this->busy_poll_config = config;
+
+    if (config.epoll_busy_poll_us != 0) {
+        TcpEpollParams params = {};
+        params.busy_poll_usecs = config.epoll_busy_poll_us;
+        params.busy_poll_budget = config.busy_poll_budget;
+        params.prefer_busy_poll = config.prefer_busy_poll ? 1 : 0;
+        this->epoll_busy_poll = ioctl(this->epoll_fd, TCP_EPIOCSPARAMS, &params) == 0;
+        if (!this->epoll_busy_poll) {
+            LOG_ERR("epoll busy poll is not available: %s", strerror(errno));
+        }
+    }
+    LOG_INFO("busy poll enabled, spin budget %ld us", static_cast<long>(config.spin_budget.count()));
+}
+
+TcpBusyPollStats TcpServer::get_busy_poll_stats() const
+{
+    TcpBusyPollStats stats;
+    stats.spin_polls = this->spin_polls.load(std::memory_order_relaxed);
+    stats.spin_hits = this->spin_hits.load(std::memory_order_relaxed);
+    stats.blocking_waits = this->blocking_waits.load(std::memory_order_relaxed);
+    stats.spin_us = this->spin_us.load(std::memory_order_relaxed);
+    stats.socket_busy_poll = this->socket_busy_poll.load(std::memory_order_relaxed);
+    stats.epoll_busy_poll = this->epoll_busy_poll;
+    return stats;
+}
+
+// 以超时0轮询epoll直到有事件或自旋预算用尽，之后阻塞等待至timeout；统计只有事件循环线程写入
+int32_t TcpServer::busy_wait(struct epoll_event *events, int32_t timeout)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::chrono::microseconds budget = this->busy_poll_config.spin_budget;
+    if (timeout > 0) {
+        budget = std::min<std::chrono::microseconds>(budget, std::chrono::milliseconds(timeout));
+    }
+    auto deadline = start + budget;
+    int32_t event_count = 0;
+    uint64_t polls = 0;
+    std::chrono::steady_clock::time_point now;
+    do {
+        event_count = epoll_wait(this->epoll_fd, events, MAX_EPOLL_EVENT_SIZE, 0);
+        polls++;
+        now = std::chrono::steady_clock::now();
+    } while (event_count == 0 && now < deadline);
+
+    auto spun = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+    this->spin_polls.store(this->spin_polls.load(std::memory_order_relaxed) + polls, std::memory_order_relaxed);
+    this->spin_us.store(this->spin_us.load(std::memory_order_relaxed) + static_cast<uint64_t>(spun),
+        std::memory_order_relaxed);
+    if (event_count != 0) {
+        this->spin_hits.store(this->spin_hits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return event_count;
+    }
+    this->blocking_waits.store(this->blocking_waits.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (timeout > 0) {
+        // 自旋已占用的时间从超时中扣除，保证get_loop_timeout()的到期工作按时执行
+        timeout = std::max<int32_t>(timeout - static_cast<int32_t>(spun / 1000), 0);
+    }
+    return epoll_wait(this->epoll_fd, events, MAX_EPOLL_EVENT_SIZE, timeout);
+}
+
+void TcpServer::set_topic_config(const std::string& topic, const TcpTopicConfig& config)
+{
+    this->topics[topic].config = config;
+}
+
+void TcpServer::subscribe(int32_t client_fd, const std::string& topic)
+{
+    FanoutTopic& fanout_topic = this->topics[topic];
+    FanoutOutput& output = this->outputs[client_fd];
+    output.fd = client_fd;
+    if (std::find(output.topics.begin(), output.topics.end(), &fanout_topic) != output.topics.end()) {
+        return;
+    }
+    output.topics.push_back(&fanout_topic);
+    fanout_topic.subscriptions.push_back(FanoutSubscription{ &output });
+}
+
+void TcpServer::unsubscribe(int32_t client_fd, const std::string& topic)
+{
+    auto topic_it = this->topics.find(topic);
+    auto output_it = this->outputs.find(client_fd);
+    if (topic_it == this->topics.end() || output_it == this->outputs.end()) {
+        return;
+    }
+    FanoutTopic *fanout_topic = &topic_it->second;
+    FanoutOutput *output = &output_it->second;
+
+    // 已排队的帧仍会发出
+    auto& topics = output->topics;
+    topics.erase(std::remove(topics.begin(), topics.end(), fanout_topic), topics.end());
+    auto& subscriptions = fanout_topic->subscriptions;
+    auto it = std::find_if(subscriptions.begin(), subscriptions.end(),
+        [output](const FanoutSubscription& subscription) { return subscription.output == output; });
+    if (it != subscriptions.end()) {
+        *it = subscriptions.back();
+        subscriptions.pop_back();
+    }
+}
+
+// 订阅的主题通常很少，主题的订阅者列表按值交换删除，不保持顺序
+void TcpServer::remove_output(int32_t client_fd)
+{
+    auto output_it = this->outputs.find(client_fd);
+    if (output_it == this->outputs.end()) {
+        return;
+    }
+    FanoutOutput *output = &output_it->second;
+    for (FanoutTopic *topic : output->topics) {
+        auto& subscriptions = topic->subscriptions;
+        auto it = std::find_if(subscriptions.begin(), subscriptions.end(),
+            [output](const FanoutSubscription& subscription) { return subscription.output == output; });
+        if (it != subscriptions.end()) {
+            *it = subscriptions.back();
+            subscriptions.pop_back();
+        }
+    }
+    this->outputs.erase(output_it);
+}
+
+bool TcpServer::enqueue_frame(FanoutTopic& topic, FanoutSubscription& subscription, const TcpSharedFrame& frame)
+{
+    FanoutOutput& output = *subscription.output;
+    const TcpTopicConfig& config = topic.config;
+
+    if (config.policy == TCP_SLOW_CONFLATE && subscription.conflate_seq >= output.pending_head &&
+        subscription.conflate_seq - output.pending_head < output.pending.size()) {
+        QueuedFrame& queued = output.pending[subscription.conflate_seq - output.pending_head];
+        if (queued.topic == &topic) {
+            queued.frame = frame;
+            this->fanout_stats.conflated++;
+            return true;
+        }
+    }
+
+    // 一轮中突发的帧可能超过队列上限，先写入内核缓冲区，写不下时才按慢订阅者处理
+    if (output.pending.size() >= config.max_queued && !output.waiting_writable) {
+        if (!this->write_output(output)) {
+            LOG_ERR("send to subscriber %d failed: %s", output.fd, strerror(errno));
+            return false;
+        }
+        if (output.sending || !output.pending.empty()) {
+            output.waiting_writable = true;
+            this->modify_client_events(output.fd, this->get_client_events() | EPOLLOUT);
+        }
+    }
+    if (output.pending.size() >= config.max_queued) {
+        if (config.policy == TCP_SLOW_DISCONNECT) {
+            LOG_ERR("subscriber %d is too slow, closing", output.fd);
+            this->fanout_stats.disconnected++;
+            return false;
+        }
+        // post_send()的帧不丢弃，队首是这样的帧时改为丢弃新帧
+        this->fanout_stats.dropped++;
+        if (output.pending.empty() || output.pending.front().topic == nullptr) {
+            return true;
+        }
+        output.pending.pop_front();
+        output.pending_head++;
+    }
+    output.pending.push_back(QueuedFrame{ frame, &topic });
+    subscription.conflate_seq = output.pending_head + output.pending.size() - 1;
+    this->fanout_stats.enqueued++;
+
+    // 等待EPOLLOUT的订阅者由可写事件继续发送
+    if (!output.dirty && !output.waiting_writable) {
+        output.dirty = true;
+        this->dirty_outputs.push_back(output.fd);
+    }
+    return true;
+}
+
+size_t TcpServer::publish(const std::string& topic, const TcpSharedFrame& frame)
+{
+    auto topic_it = this->topics.find(topic);
+    if (topic_it == this->topics.end() || topic_it->second.subscriptions.empty() || !frame || frame->empty()) {
+        return 0;
+    }
+    FanoutTopic& fanout_topic = topic_it->second;
+    this->fanout_stats.published++;
+
+    size_t queued = 0;
+    std::vector<int32_t> failed_clients;
+    for (FanoutSubscription& subscription : fanout_topic.subscriptions) {
+        if (this->enqueue_frame(fanout_topic, subscription, frame)) {
+            queued++;
+        } else {
+            failed_clients.push_back(subscription.output->fd);
+        }
+    }
+
+    // 关闭连接会修改订阅者列表，遍历结束后再关闭
+    for (int32_t client_fd : failed_clients) {
+        this->close_client(client_fd);
+    }
+    return queued;
+}
+
+size_t TcpServer::publish(const std::string& topic, const char *data, size_t length)
+{
+    return this->publish(topic, make_shared_frame(data, length));
+}
+
+// 每次最多聚合IOV_BATCH帧，写到EAGAIN为止
+bool TcpServer::write_output(FanoutOutput& output)
+{
+    constexpr size_t IOV_BATCH = 64;
+    struct iovec iov[IOV_BATCH];
+
+    while (output.sending || !output.pending.empty()) {
+        size_t iov_count = 0;
+        if (output.sending) {
+            iov[iov_count].iov_base = const_cast<char *>(output.sending->data() + output.sending_offset);
+            iov[iov_count].iov_len = output.sending->size() - output.sending_offset;
+            iov_count++;
+        }
+        for (size_t i = 0; i < output.pending.size() && iov_count < IOV_BATCH; i++) {
+            const std::string& frame = *output.pending[i].frame;
+            iov[iov_count].iov_base = const_cast<char *>(frame.data());
+            iov[iov_count].iov_len = frame.size();
+            iov_count++;
+        }
+
+        struct msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+        ssize_t len = sendmsg(output.fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        // 按已发送长度出队，发出一部分的帧转入sending，之后不再参与丢弃与替换
+        size_t sent = static_cast<size_t>(len);
+        if (output.sending) {
+            size_t remaining = output.sending->size() - output.sending_offset;
+            if (sent < remaining) {
+                output.sending_offset += sent;
+                continue;
+            }
+            sent -= remaining;
+            output.sending.reset();
+            output.sending_offset = 0;
+        }
+        while (sent > 0) {
+            TcpSharedFrame frame = std::move(output.pending.front().frame);
+            output.pending.pop_front();
+            output.pending_head++;
+            if (sent < frame->size()) {
+                output.sending = std::move(frame);
+                output.sending_offset = sent;
+                break;
+            }
+            sent -= frame->size();
+        }
+    }
+    return true;
+}
+
+void TcpServer::flush_outputs()
+{
+    if (this->dirty_outputs.empty()) {
+        return;
+    }
+    std::vector<int32_t> dirty;
+    dirty.swap(this->dirty_outputs);
+    for (int32_t client_fd : dirty) {
+        auto it = this->outputs.find(client_fd);
+        if (it == this->outputs.end() || !it->second.dirty) {
+            continue;
+        }
+        FanoutOutput& output = it->second;
+        output.dirty = false;
+        try {
+            if (!this->write_output(output)) {
+                LOG_ERR("send to subscriber %d failed: %s", client_fd, strerror(errno));
+                this->close_client(client_fd);
+                continue;
+            }
+            if (output.sending || !output.pending.empty()) {
+                output.waiting_writable = true;
+                this->modify_client_events(client_fd, this->get_client_events() | EPOLLOUT);
+            }
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR(e.what());
+        }
+    }
+}
+
+void TcpServer::deal_output_writable(int32_t client_fd)
+{
+    auto it = this->outputs.find(client_fd);
+    if (it == this->outputs.end() || !it->second.waiting_writable) {
+        return;
+    }
+    FanoutOutput& output = it->second;
+    if (!this->write_output(output)) {
+        LOG_ERR("send to subscriber %d failed: %s", client_fd, strerror(errno));
+        this->close_client(client_fd);
+        return;
+    }
+    if (!output.sending && output.pending.empty()) {
+        output.waiting_writable = false;
+        this->modify_client_events(client_fd, this->get_client_events());
+    }
+}
+
+size_t TcpServer::get_queued_frames(int32_t client_fd) const
+{
+    auto it = this->outputs.find(client_fd);
+    return it == this->outputs.end() ? 0 : it->second.pending.size();
+}
+
+const TcpFanoutStats& TcpServer::get_fanout_stats() const
+{
+    return this->fanout_stats;
+}
+
+void TcpServer::init_wakeup()
+{
+    this->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (this->wakeup_fd < 0) {
+        throw TcpRuntimeException("eventfd", __FILENAME__, __LINE__);
+    }
+    struct epoll_event event = { .events = EPOLLIN, .data = { .fd = this->wakeup_fd } };
+    if (epoll_ctl(this->epoll_fd, EPOLL_CTL_ADD, this->wakeup_fd, &event) < 0) {
+        close(this->wakeup_fd);
+        throw TcpRuntimeException("Failed to add eventfd to epoll", __FILENAME__, __LINE__);
+    }
+}
+
+// 事件循环处理唤醒之前只写一次eventfd，生产者连续投递时不产生多余的系统调用
+void TcpServer::wake_loop()
+{
+    if (!this->wakeup_pending.exchange(true)) {
+        uint64_t one = 1;
+        static_cast<void>(write(this->wakeup_fd, &one, sizeof(one)));
+    }
+}
+
+// 先清除wakeup_pending再取队列：清除之后投递的帧要么在本次取到，要么会再次唤醒；
+// 清除用读改写，与生产者置位的交换同步，置位之前入队的帧在本次一定可见
+void TcpServer::drain_posts()
+{
+    uint64_t value = 0;
+    static_cast<void>(read(this->wakeup_fd, &value, sizeof(value)));
+    static_cast<void>(this->wakeup_pending.exchange(false));
+
+    uint64_t conn_id = 0;
+    TcpSharedFrame frame;
+    while (this->post_queue.pop(conn_id, frame)) {
+        int32_t client_fd = static_cast<int32_t>(conn_id & UINT32_MAX);
+        auto id_it = this->conn_ids.find(client_fd);
+        if (id_it == this->conn_ids.end() || id_it->second != conn_id) {
+            this->fanout_stats.orphaned++;
+            continue;
+        }
+        FanoutOutput& output = this->outputs[client_fd];
+        output.fd = client_fd;
+        output.pending.push_back(QueuedFrame{ std::move(frame), nullptr });
+        this->fanout_stats.posted++;
+        if (!output.dirty && !output.waiting_writable) {
+            output.dirty = true;
+            this->dirty_outputs.push_back(client_fd);
+        }
+    }
+
+    // 生产者尚未链接完的节点暂时取不到，下一轮再取
+    if (!this->post_queue.empty()) {
+        this->wake_loop();
+    }
+}
+
+uint64_t TcpServer::get_conn_id(int32_t client_fd) const
+{
+    auto it = this->conn_ids.find(client_fd);
+    return it == this->conn_ids.end() ? 0 : it->second;
+}
+
+void TcpServer::post_send(uint64_t conn_id, const TcpSharedFrame& frame)
+{
+    if (!frame || frame->empty()) {
+        return;
+    }
+    this->post_queue.push(conn_id, frame);
+    this->wake_loop();
+}
+
+void TcpServer::post_send(uint64_t conn_id, const char *data, size_t length)
+{
+    this->post_send(conn_id, make_shared_frame(data, length));
+}
+
+void TcpServer::set_loop_cpu(int32_t cpu)
+{
+    this->loop_cpu.store(cpu, std::memory_order_relaxed);
+}
+
 // 服务器初始化后，调用该函数进入消息循环
 void TcpServer::listen_loop()
 {
     struct epoll_event event[MAX_EPOLL_EVENT_SIZE];
 
-    int32_t event_count = epoll_wait(epoll_fd, event, MAX_EPOLL_EVENT_SIZE, EPOLL_TIMEOUT);
+    this->loop_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    int32_t cpu = this->loop_cpu.load(std::memory_order_relaxed);
+    if (cpu >= 0 && this->pinned_thread != std::this_thread::get_id()) {
+        this->pinned_thread = std::this_thread::get_id();
+        try {
+            CpuPlacement::pin_current_thread(cpu);
+            LOG_INFO("event loop pinned to cpu %d", cpu);
+        } catch (const TcpRuntimeException& e) {
+            LOG_ERR(e.what());
+        }
+    }
+    // 事件循环之外publish()的帧先发出
+    this->flush_outputs();
+
+    // 本轮已有到期工作（超时为0）时不必自旋
+    int32_t timeout = this->get_loop_timeout();
+    int32_t event_count = this->busy_poll && timeout != 0 ? this->busy_wait(event, timeout) :
+        epoll_wait(epoll_fd, event, MAX_EPOLL_EVENT_SIZE, timeout);
 
     for (int32_t i = 0; i < event_count; i++) {
         try {
             // 先检查是否是错误事件
             if (event[i].events & EPOLLRDHUP) {
                 // EPOLLRDHUP 表示对端关闭了连接，不算做错误
-                this->close_client(event[i].data.fd);
+                this->deal_client_hangup(event[i].data.fd);
                 LOG_INFO("Client %d is closed", event[i].data.fd);
                 continue;
             }
             if ((event[i].events & EPOLLERR) || (event[i].events & EPOLLHUP)) {
-                this->close_client(event[i].data.fd);
+                this->deal_client_hangup(event[i].data.fd);
                 throw TcpRuntimeException("abnormal event, close socket, event: " + std::to_string(event[i].events), __FILENAME__, __LINE__);
             }
 
             if (event[i].data.fd == this->listen_fd) {
                 // 监听fd上的事件说明有新连接进入
                 this->accept_new_client(this->listen_fd);
+            } else if (event[i].data.fd == this->wakeup_fd) {
+                // 其他线程post_send()了新的帧
+                this->drain_posts();
             } else {
-                // 其他fd的事件说明连接上有新报文
-                this->deal_client_msg(event[i].data.fd);
+                // 其他fd的事件说明连接上有新报文，或者待发送的数据可以继续发送
+                if (event[i].events & EPOLLIN) {
+                    this->deal_client_msg(event[i].data.fd);
+                }
+                if (event[i].events & EPOLLOUT) {
+                    this->deal_output_writable(event[i].data.fd);
+                    this->deal_client_writable(event[i].data.fd);
+                }
             }
         } catch (TcpRuntimeException &e) {
             LOG_ERR(e.what());
             continue;
         }
     }
-}
\ No newline at end of file
+
+    try {
+        this->deal_loop_end();
+    } catch (TcpRuntimeException &e) {
+        LOG_ERR(e.what());
+    }
+    this->flush_outputs();
+}
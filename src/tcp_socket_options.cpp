@@ -0,0 +1,109 @@
+extern "C" {
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+}
+
+#include "tcp_public.hpp"
+#include "tcp_socket_options.hpp"
+
+static bool set_int_option(int32_t fd, int32_t level, int32_t name, int32_t value, const char *what)
+{
+    if (setsockopt(fd, level, name, &value, sizeof(value)) < 0) {
+        LOG_DEBUG("set %s=%d on fd %d failed, errno %d", what, value, fd, errno);
+        return false;
+    }
+    return true;
+}
+
+// 监听socket与客户端socket上都需设置的收发缓冲区
+static bool apply_common(const TcpSocketOptions& options, int32_t fd)
+{
+    bool ok = true;
+    if (options.send_buffer > 0) {
+        ok &= set_int_option(fd, SOL_SOCKET, SO_SNDBUF, options.send_buffer, "SO_SNDBUF");
+    }
+    if (options.recv_buffer > 0) {
+        ok &= set_int_option(fd, SOL_SOCKET, SO_RCVBUF, options.recv_buffer, "SO_RCVBUF");
+    }
+    return ok;
+}
+
+TcpSocketOptions TcpSocketOptions::latency()
+{
+    TcpSocketOptions options;
+    options.nodelay = true;
+    options.fastopen_queue = 256;
+    options.fastopen_connect = true;
+    options.notsent_lowat = 16 * 1024;
+    return options;
+}
+
+TcpSocketOptions TcpSocketOptions::throughput()
+{
+    TcpSocketOptions options;
+    options.cork = true;
+    options.defer_accept = 1;
+    options.send_buffer = 1024 * 1024;
+    options.recv_buffer = 1024 * 1024;
+    return options;
+}
+
+TcpSocketOptions TcpSocketOptions::parse(const std::string& name)
+{
+    if (name == "latency") {
+        return latency();
+    }
+    if (name == "throughput") {
+        return throughput();
+    }
+    if (name == "default") {
+        return TcpSocketOptions();
+    }
+    throw TcpRuntimeException("unknown socket options profile: " + name, __FILENAME__, __LINE__);
+}
+
+bool TcpSocketOptions::apply_listen(int32_t listen_fd) const
+{
+    bool ok = apply_common(*this, listen_fd);
+    if (this->defer_accept > 0) {
+        ok &= set_int_option(listen_fd, IPPROTO_TCP, TCP_DEFER_ACCEPT, this->defer_accept, "TCP_DEFER_ACCEPT");
+    }
+    if (this->fastopen_queue > 0) {
+        ok &= set_int_option(listen_fd, IPPROTO_TCP, TCP_FASTOPEN, this->fastopen_queue, "TCP_FASTOPEN");
+    }
+    return ok;
+}
+
+bool TcpSocketOptions::apply_accepted(int32_t client_fd) const
+{
+    // 缓冲区大小已从监听socket继承
+    bool ok = true;
+    if (this->nodelay) {
+        ok &= set_int_option(client_fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+    if (this->notsent_lowat > 0) {
+        ok &= set_int_option(client_fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, this->notsent_lowat, "TCP_NOTSENT_LOWAT");
+    }
+    return ok;
+}
+
+bool TcpSocketOptions::apply_connect(int32_t fd) const
+{
+    bool ok = apply_common(*this, fd);
+    if (this->nodelay) {
+        ok &= set_int_option(fd, IPPROTO_TCP, TCP_NODELAY, 1, "TCP_NODELAY");
+    }
+    if (this->fastopen_connect) {
+        ok &= set_int_option(fd, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, 1, "TCP_FASTOPEN_CONNECT");
+    }
+    if (this->notsent_lowat > 0) {
+        ok &= set_int_option(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, this->notsent_lowat, "TCP_NOTSENT_LOWAT");
+    }
+    return ok;
+}
+
+bool TcpSocketOptions::set_cork(int32_t fd, bool on)
+{
+    return set_int_option(fd, IPPROTO_TCP, TCP_CORK, on ? 1 : 0, "TCP_CORK");
+}
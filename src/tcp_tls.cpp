@@ -0,0 +1,172 @@
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+#include <openssl/bio.h>
+
+#include "tcp_public.hpp"
+#include "tcp_tls.hpp"
+
+// === TlsContext ===
+
+TlsContext::TlsContext(const std::string& cert_file, const std::string& key_file, bool enable_ktls)
+{
+    this->ctx = SSL_CTX_new(TLS_server_method());
+    if (this->ctx == nullptr) {
+        throw TcpRuntimeException("SSL_CTX_new failed: " + TlsSession::get_error_string(), __FILENAME__, __LINE__);
+    }
+
+    SSL_CTX_set_min_proto_version(this->ctx, TLS1_2_VERSION);
+    uint64_t options = SSL_OP_NO_COMPRESSION;
+    if (enable_ktls) {
+        options |= SSL_OP_ENABLE_KTLS;
+    }
+    SSL_CTX_set_options(this->ctx, options);
+    // 非阻塞发送时允许部分写入，且重试时缓冲区地址可以变化
+    SSL_CTX_set_mode(this->ctx, SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+    if (SSL_CTX_use_certificate_chain_file(this->ctx, cert_file.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(this->ctx, key_file.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(this->ctx) != 1) {
+        std::string error = TlsSession::get_error_string();
+        SSL_CTX_free(this->ctx);
+        throw TcpRuntimeException("Failed to load certificate or key: " + error, __FILENAME__, __LINE__);
+    }
+}
+
+TlsContext::~TlsContext()
+{
+    SSL_CTX_free(this->ctx);
+}
+
+SSL_CTX *TlsContext::get() const
+{
+    return this->ctx;
+}
+
+// === TlsSession ===
+
+std::string TlsSession::get_error_string()
+{
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char buf[256] = {0};
+    ERR_error_string_n(code, buf, sizeof(buf));
+    ERR_clear_error();
+    return std::string(buf);
+}
+
+TlsSession::TlsSession(const TlsContext& context, int32_t socket_fd)
+{
+    this->ssl = SSL_new(context.get());
+    if (this->ssl == nullptr) {
+        throw TcpRuntimeException("SSL_new failed: " + get_error_string(), __FILENAME__, __LINE__);
+    }
+    if (SSL_set_fd(this->ssl, socket_fd) != 1) {
+        SSL_free(this->ssl);
+        throw TcpRuntimeException("SSL_set_fd failed: " + get_error_string(), __FILENAME__, __LINE__);
+    }
+    SSL_set_accept_state(this->ssl);
+}
+
+TlsSession::~TlsSession()
+{
+    SSL_free(this->ssl);
+}
+
+TlsStatus TlsSession::error_status(int rc)
+{
+    int error = SSL_get_error(this->ssl, rc);
+    switch (error) {
+        case SSL_ERROR_WANT_READ:
+            return TLS_WANT_READ;
+        case SSL_ERROR_WANT_WRITE:
+            return TLS_WANT_WRITE;
+        case SSL_ERROR_ZERO_RETURN:
+            return TLS_CLOSED;
+        case SSL_ERROR_SYSCALL:
+            // 未收到close_notify对端即断开
+            if (errno == 0) {
+                return TLS_CLOSED;
+            }
+            break;
+        default:
+            break;
+    }
+    throw TcpRuntimeException("TLS error " + std::to_string(error) + ": " + get_error_string(), __FILENAME__, __LINE__);
+}
+
+TlsStatus TlsSession::handshake()
+{
+    ERR_clear_error();
+    int rc = SSL_do_handshake(this->ssl);
+    if (rc != 1) {
+        return error_status(rc);
+    }
+
+    this->established = true;
+#ifndef OPENSSL_NO_KTLS
+    this->ktls_send = BIO_get_ktls_send(SSL_get_wbio(this->ssl)) == 1;
+#endif
+    LOG_DEBUG("TLS handshake done, %s, cipher %s, kTLS send %s", SSL_get_version(this->ssl),
+        SSL_get_cipher_name(this->ssl), this->ktls_send ? "on" : "off");
+    return TLS_OK;
+}
+
+bool TlsSession::is_established() const
+{
+    return this->established;
+}
+
+bool TlsSession::is_ktls_send() const
+{
+    return this->ktls_send;
+}
+
+ssize_t TlsSession::read(char *buf, size_t length, TlsStatus& status)
+{
+    ERR_clear_error();
+    errno = 0;
+    int rc = SSL_read(this->ssl, buf, static_cast<int>(length));
+    if (rc > 0) {
+        status = TLS_OK;
+        return rc;
+    }
+    status = error_status(rc);
+    return 0;
+}
+
+ssize_t TlsSession::write(const char *buf, size_t length, TlsStatus& status)
+{
+    ERR_clear_error();
+    errno = 0;
+    int rc = SSL_write(this->ssl, buf, static_cast<int>(length));
+    if (rc > 0) {
+        status = TLS_OK;
+        return rc;
+    }
+    status = error_status(rc);
+    return 0;
+}
+
+ssize_t TlsSession::sendfile(int32_t file_fd, off_t offset, size_t length, TlsStatus& status)
+{
+    ERR_clear_error();
+    errno = 0;
+    ossl_ssize_t rc = SSL_sendfile(this->ssl, file_fd, offset, length, 0);
+    if (rc > 0) {
+        status = TLS_OK;
+        return rc;
+    }
+    status = error_status(static_cast<int>(rc));
+    return 0;
+}
+
+void TlsSession::shutdown() noexcept
+{
+    if (this->established) {
+        ERR_clear_error();
+        static_cast<void>(SSL_shutdown(this->ssl));
+        ERR_clear_error();
+    }
+}
@@ -0,0 +1,91 @@
+// test_cpu_placement.cpp
+extern "C" {
+#include <sched.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+#include "cpu_placement.hpp"
+#include "executor.hpp"
+#include "tcp_public.hpp"
+#include "test_helper.hpp"
+
+static bool throws_on(const std::string& spec)
+{
+    try {
+        CpuPlacement::parse(spec);
+    } catch (const TcpRuntimeException&) {
+        return true;
+    }
+    return false;
+}
+
+int test_cpu_placement()
+{
+    bool ok = true;
+
+    ok &= check(CpuPlacement::parse_cpu_list("0-3,6,2") == std::vector<int32_t>({0, 1, 2, 3, 6}), "cpulist parsed");
+    ok &= check(throws_on("0") && throws_on("x:1") && throws_on("0:3-1") && throws_on("0-1:2"),
+        "malformed placement rejected");
+
+    std::vector<int32_t> allowed = CpuPlacement::get_allowed_cpus();
+    size_t usable = CpuPlacement::get_usable_cpu_count();
+    double limit = CpuPlacement::get_cgroup_cpu_limit();
+    std::cout << "allowed cpus: " << allowed.size() << ", cgroup limit: " << limit << ", usable: " << usable
+        << std::endl;
+    ok &= check(!allowed.empty() && usable >= 1 && usable <= allowed.size(), "usable cpus within the affinity mask");
+    ok &= check(WorkStealingExecutor::default_thread_count() == usable, "executor sized by usable cpus");
+
+    CpuPlacement placement = CpuPlacement::automatic();
+    auto is_allowed = [&allowed](int32_t cpu) { return std::find(allowed.begin(), allowed.end(), cpu) != allowed.end(); };
+    ok &= check(is_allowed(placement.reactor_cpu) && !placement.worker_cpus.empty() &&
+        std::all_of(placement.worker_cpus.begin(), placement.worker_cpus.end(), is_allowed) &&
+        placement.worker_cpus.size() == std::max<size_t>(usable - 1, 1), "automatic placement uses allowed cpus");
+    std::string outside = std::to_string(allowed.back() + 1);
+    ok &= check(throws_on(std::to_string(allowed.front()) + ":" + outside) && throws_on(outside + ":" +
+        std::to_string(allowed.front())), "cpus outside the affinity mask rejected");
+
+    {
+        // 在独立线程上绑定，不影响调用线程
+        int32_t target = allowed.back();
+        int32_t observed = -1;
+        std::thread pinned([&]() {
+            CpuPlacement::pin_current_thread(target);
+            observed = sched_getcpu();
+        });
+        pinned.join();
+        ok &= check(observed == target, "thread runs on the pinned cpu");
+    }
+
+    {
+        // 绑定的工作线程上执行的任务都在其CPU上
+        std::vector<int32_t> cpus = placement.worker_cpus;
+        std::atomic<size_t> executed(0);
+        std::atomic<size_t> misplaced(0);
+        {
+            WorkStealingExecutor executor(cpus.size(), 64, cpus);
+            for (size_t i = 0; i < 1000; i++) {
+                ExecutorTask task = [&]() {
+                    int32_t cpu = sched_getcpu();
+                    if (std::find(cpus.begin(), cpus.end(), cpu) == cpus.end()) {
+                        misplaced++;
+                    }
+                    executed++;
+                };
+                while (!executor.submit(std::move(task))) {
+                    std::this_thread::yield();
+                }
+            }
+            executor.stop();
+        }
+        ok &= check(executed == 1000 && misplaced == 0, "pinned workers stay on their cpus");
+    }
+
+    std::cout << (ok ? "CPU placement test passed!" : "CPU placement test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
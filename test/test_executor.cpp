@@ -0,0 +1,83 @@
+// test_executor.cpp
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <chrono>
+
+#include "executor.hpp"
+
+// 多个生产者线程同时提交任务，检查全部任务恰好执行一次
+int test_work_stealing_executor()
+{
+    const size_t producer_count = 4;
+    const size_t tasks_per_producer = 50000;
+
+    std::atomic<uint64_t> executed(0);
+    std::atomic<uint64_t> inline_executed(0);
+    auto start_time = std::chrono::steady_clock::now();
+    {
+        WorkStealingExecutor executor(4, 256);
+
+        std::vector<std::thread> producers;
+        for (size_t p = 0; p < producer_count; p++) {
+            producers.emplace_back([&]() {
+                for (size_t i = 0; i < tasks_per_producer; i++) {
+                    ExecutorTask task = [&executed]() { executed++; };
+                    if (!executor.submit(std::move(task))) {
+                        // 队列满时与HttpServer一致，就地执行
+                        task();
+                        inline_executed++;
+                    }
+                }
+            });
+        }
+        for (auto& producer : producers) {
+            producer.join();
+        }
+        executor.stop();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    uint64_t expected = producer_count * tasks_per_producer;
+    std::cout << "Executor ran " << executed.load() << "/" << expected << " tasks ("
+              << inline_executed.load() << " inline) in " << elapsed << " ms" << std::endl;
+    if (executed.load() != expected) {
+        std::cerr << "Executor test FAILED!" << std::endl;
+        return 1;
+    }
+
+    // 提交与stop()并发：submit()返回true的任务都必须执行，即使工作线程已经退出
+    const size_t stop_rounds = 50;
+    for (size_t round = 0; round < stop_rounds; round++) {
+        std::atomic<uint64_t> accepted(0);
+        std::atomic<uint64_t> ran(0);
+        std::atomic<bool> stopped(false);
+        {
+            WorkStealingExecutor executor(2, 64);
+            std::thread producer([&]() {
+                // stop()返回之后再提交一轮，确认不再接受新任务
+                for (bool last = false; !last; ) {
+                    last = stopped;
+                    if (executor.submit([&ran]() { ran++; })) {
+                        accepted++;
+                    }
+                }
+            });
+            std::this_thread::sleep_for(std::chrono::microseconds(round % 50));
+            executor.stop();
+            stopped = true;
+            producer.join();
+        }
+        if (ran.load() != accepted.load()) {
+            std::cerr << "Executor lost " << accepted.load() - ran.load() << " accepted tasks on stop in round "
+                      << round << std::endl;
+            std::cerr << "Executor test FAILED!" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "Executor test passed!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,175 @@
+// test_helper.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <cerrno>
+#include <iostream>
+#include <chrono>
+#include <algorithm>
+
+#include "test_helper.hpp"
+#include "tcp_client.hpp"
+#include "http_body_framing.hpp"
+
+bool check(bool cond, const std::string& what)
+{
+    std::cout << (cond ? "[PASS] " : "[FAIL] ") << what << std::endl;
+    return cond;
+}
+
+bool send_all(int32_t fd, const std::string& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t len = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (len < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                return false;
+            }
+            struct pollfd pfd = { fd, POLLOUT, 0 };
+            poll(&pfd, 1, 10);
+            continue;
+        }
+        sent += static_cast<size_t>(len);
+    }
+    return true;
+}
+
+bool echo_round_trip(int32_t fd, const std::string& message)
+{
+    if (!send_all(fd, message)) {
+        return false;
+    }
+    std::string echoed;
+    char buf[4096];
+    while (echoed.size() < message.size()) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        echoed.append(buf, static_cast<size_t>(len));
+    }
+    return echoed == message;
+}
+
+bool wait_peer_closed(int32_t fd, int32_t timeout_ms)
+{
+    char buf[4096];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (std::chrono::steady_clock::now() < deadline) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0) {
+            continue;
+        }
+        if (recv(fd, buf, sizeof(buf), MSG_DONTWAIT) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 从pos开始的chunked消息体的结束位置，尚未收齐时返回npos
+static size_t chunked_end(const std::string& data, size_t pos)
+{
+    HttpBodyFraming framing(HTTP_BODY_CHUNKED);
+    while (pos < data.size() && !framing.is_done()) {
+        uint64_t remaining = framing.get_data_remaining();
+        if (remaining > 0) {
+            size_t part = static_cast<size_t>(std::min<uint64_t>(remaining, data.size() - pos));
+            framing.consume_data(part);
+            pos += part;
+        } else {
+            pos += framing.feed(data.data() + pos, data.size() - pos);
+        }
+    }
+    return framing.is_done() ? pos : std::string::npos;
+}
+
+size_t count_http_responses(const std::string& data)
+{
+    size_t complete = 0;
+    size_t pos = 0;
+    for (;;) {
+        size_t head_end = data.find("\r\n\r\n", pos);
+        if (head_end == std::string::npos) {
+            break;
+        }
+        std::string head = data.substr(pos, head_end + 4 - pos);
+        size_t body_start = head_end + 4;
+        bool interim = head.compare(0, 10, "HTTP/1.1 1") == 0;
+        size_t end = std::string::npos;
+        size_t length_pos = head.find("Content-Length: ");
+        if (interim || head.compare(0, 12, "HTTP/1.1 204") == 0 || head.compare(0, 12, "HTTP/1.1 304") == 0) {
+            end = body_start;
+        } else if (head.find("Transfer-Encoding: chunked") != std::string::npos) {
+            end = chunked_end(data, body_start);
+        } else if (length_pos != std::string::npos) {
+            size_t length = std::stoul(head.substr(length_pos + 16));
+            end = data.size() >= body_start + length ? body_start + length : std::string::npos;
+        }
+        if (end == std::string::npos) {
+            break;
+        }
+        if (!interim) {
+            complete++;
+        }
+        pos = end;
+    }
+    return complete;
+}
+
+std::string read_http_responses(int32_t fd, size_t count, int32_t timeout_ms)
+{
+    std::string response;
+    char buf[65536];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (count_http_responses(response) < count && std::chrono::steady_clock::now() < deadline) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0) {
+            continue;
+        }
+        ssize_t len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) {
+            break;
+        }
+        response.append(buf, static_cast<size_t>(len));
+    }
+    return response;
+}
+
+std::string http_roundtrip(int32_t fd, const std::string& request, int32_t timeout_ms)
+{
+    if (!request.empty() && !send_all(fd, request)) {
+        return "";
+    }
+    return read_http_responses(fd, 1, timeout_ms);
+}
+
+std::string http_request(const std::string& addr, uint16_t port, const std::string& request, int32_t timeout_ms)
+{
+    TcpClient client(addr, port);
+    return http_roundtrip(client.get_fd(), request, timeout_ms);
+}
+
+std::string http_body(const std::string& response)
+{
+    size_t head_end = response.find("\r\n\r\n");
+    return head_end == std::string::npos ? std::string() : response.substr(head_end + 4);
+}
+
+std::string http_header(const std::string& response, const std::string& name)
+{
+    size_t head_end = response.find("\r\n\r\n");
+    size_t pos = response.find("\r\n" + name + ": ");
+    if (pos == std::string::npos || pos >= head_end) {
+        return std::string();
+    }
+    pos += name.size() + 4;
+    return response.substr(pos, response.find("\r\n", pos) - pos);
+}
@@ -0,0 +1,41 @@
+#ifndef TEST_HELPER_HPP
+#define TEST_HELPER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// 测试用例共用的检查与收发工具，阻塞式实现，只在测试线程中使用
+
+// 打印一项检查的结果，返回cond，便于以ok &= check(...)累计
+bool check(bool cond, const std::string& what);
+
+// 发送全部数据，socket暂时不可写时等待；出错时返回false
+bool send_all(int32_t fd, const std::string& data);
+
+// 发送一条消息并等待对端完整回送，超时或回送内容不符时返回false
+bool echo_round_trip(int32_t fd, const std::string& message);
+
+// 等待对端关闭连接，期间收到的数据被丢弃
+bool wait_peer_closed(int32_t fd, int32_t timeout_ms);
+
+// 统计data开头已完整收到的HTTP/1.1响应数：依据Content-Length或chunked确定边界，
+// 1xx、204与304没有响应体，1xx中间响应不计入；两者皆无的响应以连接关闭结束，在此视为未收齐
+size_t count_http_responses(const std::string& data);
+
+// 读取数据直到收到count个完整响应，超时或连接关闭时返回已读到的部分
+std::string read_http_responses(int32_t fd, size_t count = 1, int32_t timeout_ms = 3000);
+
+// 在已有连接上发送请求（为空时只读取）并读取一个完整响应
+std::string http_roundtrip(int32_t fd, const std::string& request, int32_t timeout_ms = 5000);
+
+// 新建连接发送请求并读取一个完整响应
+std::string http_request(const std::string& addr, uint16_t port, const std::string& request, int32_t timeout_ms = 3000);
+
+// 第一个响应头之后的全部数据
+std::string http_body(const std::string& response);
+
+// 第一个响应中名为name的头部的值（区分大小写），不存在时返回空串
+std::string http_header(const std::string& response, const std::string& name);
+
+#endif // TEST_HELPER_HPP
@@ -0,0 +1,349 @@
+// test_http2_server.cpp
+extern "C" {
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "http2_frame.hpp"
+#include "http2_hpack.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+struct H2Response {
+    std::vector<HpackHeader> headers;
+    std::string body;
+    bool ended = false;
+    uint32_t reset_code = 0; // 被RST_STREAM重置时的错误码
+};
+
+// 测试用的极简HTTP/2客户端状态：每收到DATA帧立即归还流与连接窗口
+struct H2Client {
+    int32_t fd = -1;
+    std::string input;
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::map<uint32_t, H2Response> responses;
+    std::vector<uint32_t> finish_order;
+    bool settings_acked = false;
+    bool ping_acked = false;
+    bool closed = false;
+};
+
+static std::string from_hex(const std::string& hex)
+{
+    std::string out;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out += static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    return out;
+}
+
+static void append_uint32(std::string& out, uint32_t value)
+{
+    out += static_cast<char>((value >> 24) & 0xff);
+    out += static_cast<char>((value >> 16) & 0xff);
+    out += static_cast<char>((value >> 8) & 0xff);
+    out += static_cast<char>(value & 0xff);
+}
+
+static void send_frame(H2Client& client, uint8_t type, uint8_t flags, uint32_t stream_id, const std::string& payload)
+{
+    Http2FrameHeader header;
+    header.length = static_cast<uint32_t>(payload.size());
+    header.type = type;
+    header.flags = flags;
+    header.stream_id = stream_id;
+    std::string frame;
+    header.serialize(frame);
+    frame += payload;
+    send_all(client.fd, frame);
+}
+
+static void send_request(H2Client& client, uint32_t stream_id, const std::string& path,
+    const std::vector<HpackHeader>& extra = {})
+{
+    std::vector<HpackHeader> headers = {
+        { ":method", "GET" }, { ":scheme", "http" }, { ":authority", "127.0.0.1" }, { ":path", path },
+    };
+    headers.insert(headers.end(), extra.begin(), extra.end());
+    std::string block;
+    client.encoder.encode(headers, block);
+    send_frame(client, HTTP2_FRAME_HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, stream_id, block);
+}
+
+static void end_stream(H2Client& client, uint32_t stream_id)
+{
+    client.responses[stream_id].ended = true;
+    client.finish_order.push_back(stream_id);
+}
+
+static void handle_frame(H2Client& client, const Http2FrameHeader& header, const std::string& payload)
+{
+    H2Response& response = client.responses[header.stream_id];
+    switch (header.type) {
+        case HTTP2_FRAME_HEADERS:
+            response.headers = client.decoder.decode(payload);
+            if (header.flags & HTTP2_FLAG_END_STREAM) {
+                end_stream(client, header.stream_id);
+            }
+            break;
+        case HTTP2_FRAME_DATA:
+            response.body += payload;
+            if (!payload.empty()) {
+                std::string increment;
+                append_uint32(increment, static_cast<uint32_t>(payload.size()));
+                send_frame(client, HTTP2_FRAME_WINDOW_UPDATE, 0, 0, increment);
+                if (!(header.flags & HTTP2_FLAG_END_STREAM)) {
+                    send_frame(client, HTTP2_FRAME_WINDOW_UPDATE, 0, header.stream_id, increment);
+                }
+            }
+            if (header.flags & HTTP2_FLAG_END_STREAM) {
+                end_stream(client, header.stream_id);
+            }
+            break;
+        case HTTP2_FRAME_SETTINGS:
+            if (header.flags & HTTP2_FLAG_ACK) {
+                client.settings_acked = true;
+            } else {
+                send_frame(client, HTTP2_FRAME_SETTINGS, HTTP2_FLAG_ACK, 0, "");
+            }
+            break;
+        case HTTP2_FRAME_PING:
+            client.ping_acked |= (header.flags & HTTP2_FLAG_ACK) != 0;
+            break;
+        case HTTP2_FRAME_RST_STREAM:
+            response.reset_code = static_cast<uint8_t>(payload[3]);
+            end_stream(client, header.stream_id);
+            break;
+        case HTTP2_FRAME_GOAWAY:
+            client.closed = true;
+            break;
+        default:
+            break;
+    }
+}
+
+// 读取并处理帧，直到条件满足、连接关闭或超时
+static bool wait_until(H2Client& client, const std::function<bool()>& cond, int timeout_ms = 5000)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    char buf[65536];
+    while (!cond()) {
+        if (client.closed || std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        struct pollfd pfd = { client.fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 50) <= 0) {
+            continue;
+        }
+        ssize_t len = recv(client.fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len == 0) {
+            client.closed = true;
+            continue;
+        }
+        if (len < 0) {
+            continue;
+        }
+        client.input.append(buf, static_cast<size_t>(len));
+        while (client.input.size() >= Http2FrameHeader::SIZE) {
+            Http2FrameHeader header = Http2FrameHeader::parse(client.input.data());
+            if (client.input.size() < Http2FrameHeader::SIZE + header.length) {
+                break;
+            }
+            std::string payload = client.input.substr(Http2FrameHeader::SIZE, header.length);
+            client.input.erase(0, Http2FrameHeader::SIZE + header.length);
+            handle_frame(client, header, payload);
+        }
+    }
+    return true;
+}
+
+static std::string get_header(const H2Response& response, const std::string& name)
+{
+    for (const HpackHeader& header : response.headers) {
+        if (header.name == name) {
+            return header.value;
+        }
+    }
+    return "";
+}
+
+// RFC 7541 C.4中的请求示例，三个头部块共用一个解码器以验证动态表
+static bool check_hpack()
+{
+    bool ok = true;
+    HpackDecoder decoder;
+    std::vector<HpackHeader> first = decoder.decode(from_hex("828684418cf1e3c2e5f23a6ba0ab90f4ff"));
+    ok &= first.size() == 4 && first[3].name == ":authority" && first[3].value == "www.example.com";
+    std::vector<HpackHeader> second = decoder.decode(from_hex("828684be5886a8eb10649cbf"));
+    ok &= second.size() == 5 && second[3].value == "www.example.com" && second[4].value == "no-cache";
+    std::vector<HpackHeader> third = decoder.decode(from_hex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"));
+    ok &= third.size() == 5 && third[2].value == "/index.html" && third[4].name == "custom-key" &&
+        third[4].value == "custom-value";
+    ok = check(ok, "HPACK decodes RFC 7541 examples");
+
+    // 编码后再解码应还原；第二次编码命中动态表，结果更短
+    HpackEncoder encoder;
+    HpackDecoder round_trip;
+    std::vector<HpackHeader> headers = {
+        { ":status", "200" }, { "content-type", "text/html; charset=utf-8" }, { "content-length", "12345" },
+    };
+    std::string block1, block2;
+    encoder.encode(headers, block1);
+    encoder.encode(headers, block2);
+    std::vector<HpackHeader> decoded1 = round_trip.decode(block1);
+    std::vector<HpackHeader> decoded2 = round_trip.decode(block2);
+    bool same = decoded1.size() == headers.size() && decoded2.size() == headers.size();
+    for (size_t i = 0; same && i < headers.size(); i++) {
+        same = decoded1[i].name == headers[i].name && decoded1[i].value == headers[i].value &&
+            decoded2[i].name == headers[i].name && decoded2[i].value == headers[i].value;
+    }
+    ok &= check(same && block2.size() < block1.size(), "HPACK round trip uses the dynamic table");
+
+    bool rejected = false;
+    try {
+        decoder.decode(from_hex("ff"));
+    } catch (const Http2Exception& e) {
+        rejected = e.get_error_code() == HTTP2_ERR_COMPRESSION;
+    }
+    ok &= check(rejected, "truncated header block is rejected");
+    return ok;
+}
+
+int test_http2_server()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18083;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_http2_test";
+    // 远大于初始流窗口，需要多轮WINDOW_UPDATE才能发完
+    const size_t HUGE_FILE_SIZE = 8 * 1024 * 1024;
+
+    std::filesystem::create_directories(web_root);
+    {
+        std::ofstream(web_root / "index.html") << "<html><body>hello h2</body></html>";
+        std::ofstream(web_root / "small.txt") << "small";
+        std::ofstream data(web_root / "huge.bin");
+        for (size_t i = 0; i < HUGE_FILE_SIZE; i++) {
+            data.put(static_cast<char>('a' + i % 26));
+        }
+    }
+
+    bool ok = check_hpack();
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            // prior knowledge：直接以连接前言开始
+            TcpClient tcp_client(server_addr, server_port);
+            H2Client client;
+            client.fd = tcp_client.get_fd();
+            send_all(client.fd, Http2Session::CLIENT_PREFACE);
+            send_frame(client, HTTP2_FRAME_SETTINGS, 0, 0, "");
+            ok &= check(wait_until(client, [&]() { return client.settings_acked; }), "SETTINGS acknowledged");
+
+            // 大文件在前，小文件不应被它挡住
+            send_request(client, 1, "/huge.bin");
+            send_request(client, 3, "/small.txt");
+            bool finished = wait_until(client, [&]() { return client.finish_order.size() == 2; }, 20000);
+            ok &= check(finished && client.finish_order[0] == 3 && client.responses[3].body == "small",
+                "small stream finishes before the huge one");
+            const H2Response& huge = client.responses[1];
+            bool intact = get_header(huge, ":status") == "200" && huge.body.size() == HUGE_FILE_SIZE;
+            for (size_t i = 0; intact && i < HUGE_FILE_SIZE; i += 4099) {
+                intact = huge.body[i] == static_cast<char>('a' + i % 26);
+            }
+            ok &= check(intact, "huge file delivered through flow control");
+
+            send_request(client, 5, "/missing.html");
+            send_request(client, 7, "/index.html");
+            finished = wait_until(client, [&]() { return client.responses[7].ended && client.responses[5].ended; });
+            ok &= check(finished && get_header(client.responses[5], ":status") == "404", "404 on a stream");
+            ok &= check(client.responses[7].body == "<html><body>hello h2</body></html>" &&
+                get_header(client.responses[7], "content-length") == "34", "connection still usable after 404");
+
+            send_request(client, 9, "/huge.bin", { { "range", "bytes=100-109" } });
+            finished = wait_until(client, [&]() { return client.responses[9].ended; });
+            ok &= check(finished && get_header(client.responses[9], ":status") == "206" &&
+                client.responses[9].body == "wxyzabcdef", "range request on a stream");
+
+            // 缺少:path的请求只重置该流
+            std::string block;
+            client.encoder.encode({ { ":method", "GET" }, { ":scheme", "http" } }, block);
+            send_frame(client, HTTP2_FRAME_HEADERS, HTTP2_FLAG_END_HEADERS | HTTP2_FLAG_END_STREAM, 11, block);
+            send_request(client, 13, "/small.txt");
+            finished = wait_until(client, [&]() { return client.responses[11].ended && client.responses[13].ended; });
+            ok &= check(finished && client.responses[11].reset_code == HTTP2_ERR_PROTOCOL &&
+                client.responses[13].body == "small", "malformed request resets only its stream");
+
+            send_frame(client, HTTP2_FRAME_PING, 0, 0, "12345678");
+            ok &= check(wait_until(client, [&]() { return client.ping_acked; }), "PING acknowledged");
+        }
+
+        {
+            // 经HTTP/1.1 Upgrade切换，原请求在流1上响应
+            TcpClient tcp_client(server_addr, server_port);
+            H2Client client;
+            client.fd = tcp_client.get_fd();
+            send_all(client.fd,
+                "GET /index.html HTTP/1.1\r\n"
+                "Host: 127.0.0.1\r\n"
+                "Connection: Upgrade, HTTP2-Settings\r\n"
+                "Upgrade: h2c\r\n"
+                "HTTP2-Settings: AAMAAABkAAQAAP__\r\n"
+                "\r\n");
+            char buf[4096];
+            std::string head;
+            for (int retry = 0; retry < 200 && head.find("\r\n\r\n") == std::string::npos; retry++) {
+                struct pollfd pfd = { client.fd, POLLIN, 0 };
+                ssize_t len = poll(&pfd, 1, 10) > 0 ? recv(client.fd, buf, sizeof(buf), MSG_DONTWAIT) : -1;
+                if (len > 0) {
+                    head.append(buf, static_cast<size_t>(len));
+                }
+            }
+            size_t head_end = head.find("\r\n\r\n");
+            ok &= check(head.find("101 Switching Protocols") != std::string::npos, "h2c upgrade accepted");
+            if (head_end != std::string::npos) {
+                client.input = head.substr(head_end + 4);
+            }
+
+            send_all(client.fd, Http2Session::CLIENT_PREFACE);
+            send_frame(client, HTTP2_FRAME_SETTINGS, 0, 0, "");
+            bool finished = wait_until(client, [&]() { return client.responses[1].ended; });
+            ok &= check(finished && client.responses[1].body == "<html><body>hello h2</body></html>",
+                "upgraded request answered on stream 1");
+            send_request(client, 3, "/small.txt");
+            finished = wait_until(client, [&]() { return client.responses[3].ended; });
+            ok &= check(finished && client.responses[3].body == "small", "request after upgrade");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP/2 server test passed!" : "HTTP/2 server test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+// test_http_admission.cpp
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <memory>
+#include <vector>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+/*
+    测试用执行器：任务先积压在队列中，打开闸门后才由唯一的工作线程依次执行，
+    用于精确控制排队数与排队时长；accepting为false时模拟所有工作队列已满
+*/
+class GatedExecutor : public Executor {
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<ExecutorTask> tasks;
+    bool open = false;
+    bool stopping = false;
+    std::thread worker;
+
+public:
+    std::atomic<bool> accepting{true};
+
+    GatedExecutor()
+    {
+        worker = std::thread([this]() {
+            for (;;) {
+                ExecutorTask task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [this]() { return (open || stopping) && (!tasks.empty() || stopping); });
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        });
+    }
+
+    ~GatedExecutor() override
+    {
+        stop();
+    }
+
+    bool submit(ExecutorTask&& task) override
+    {
+        if (!accepting) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        cond.notify_one();
+        return true;
+    }
+
+    void stop() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    size_t get_thread_count() const override
+    {
+        return 1;
+    }
+
+    void set_open(bool value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        open = value;
+        cond.notify_one();
+    }
+};
+
+int test_http_admission()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18084;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_admission_test";
+    // 超过热点缓存的单文件上限，请求必定交给工作线程
+    const std::string request = "GET /big.bin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "big.bin") << std::string(100000, 'x');
+
+    bool ok = true;
+    try {
+        auto executor = std::make_unique<GatedExecutor>();
+        GatedExecutor& gate = *executor;
+        HttpServer server(server_addr, server_port, web_root.string(), std::move(executor));
+        server.set_admission_limits(4, std::chrono::milliseconds(500));
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            // 工作队列已满时立即回复503，不在reactor线程上就地处理
+            gate.accepting = false;
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+            std::string response = read_http_responses(client.get_fd(), 1, 1000);
+            ok &= check(response.compare(0, 32, "HTTP/1.1 503 Service Unavailable") == 0 &&
+                response.find("Retry-After: 1\r\n") != std::string::npos, "503 with Retry-After when queues are full");
+            gate.accepting = true;
+        }
+
+        {
+            // 排队超过时限的请求不再处理
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(700));
+            gate.set_open(true);
+            std::string response = read_http_responses(client.get_fd(), 1, 1000);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 503") == 0, "503 after queue wait deadline");
+            ok &= check(server.get_admission_stats().expired == 1, "expired request counted");
+            gate.set_open(false);
+        }
+
+        {
+            // 排队数达到高水位（4的3/4）后暂停读取，后续请求留在内核缓冲区，队列放行后全部正常回复
+            std::vector<std::unique_ptr<TcpClient>> clients;
+            for (size_t i = 0; i < 4; i++) {
+                clients.push_back(std::make_unique<TcpClient>(server_addr, server_port));
+                send_data_nonblock(clients.back()->get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+                std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            }
+            HttpAdmissionStats stats = server.get_admission_stats();
+            ok &= check(stats.queued == 3 && stats.pauses == 1, "reading paused at the high watermark");
+            ok &= check(read_http_responses(clients[3]->get_fd(), 1, 100).empty(), "paused client gets no response");
+
+            gate.set_open(true);
+            size_t served = 0;
+            for (auto& client : clients) {
+                std::string response = read_http_responses(client->get_fd(), 1, 2000);
+                served += response.compare(0, 15, "HTTP/1.1 200 OK") == 0 && response.size() > 100000;
+            }
+            ok &= check(served == clients.size(), "all requests served after the queue drains");
+
+            // 暂停期间accept也已恢复
+            TcpClient late(server_addr, server_port);
+            send_data_nonblock(late.get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+            ok &= check(read_http_responses(late.get_fd(), 1, 2000).compare(0, 15, "HTTP/1.1 200 OK") == 0,
+                "accepting resumed");
+        }
+
+        HttpAdmissionStats stats = server.get_admission_stats();
+        ok &= check(stats.rejected == 1 && stats.admitted == 5 && stats.queued == 0, "admission counters");
+        ok &= check(stats.max_wait_us >= 500000 && stats.p99_wait_us >= stats.p50_wait_us, "queue wait recorded");
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP admission test passed!" : "HTTP admission test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+// test_http_drain.cpp
+extern "C" {
+#include <unistd.h>
+#include <sys/socket.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "tcp_handoff.hpp"
+#include "test_helper.hpp"
+
+// 读取一个完整响应，返回响应体长度，超时或连接关闭时返回0
+static size_t read_body(int32_t fd, int32_t timeout_ms)
+{
+    std::string response = read_http_responses(fd, 1, timeout_ms);
+    return count_http_responses(response) == 1 ? http_body(response).size() : 0;
+}
+
+int test_http_drain()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18086;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_drain_test";
+    const std::string handoff_path = (std::filesystem::temp_directory_path() / "tcp_example_drain_test.sock").string();
+    const size_t BIG_SIZE = 16 * 1024 * 1024;
+    const std::string big_request = "GET /big.bin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    const std::string small_request = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "big.bin") << std::string(BIG_SIZE, 'b');
+    std::ofstream(web_root / "index.html") << "<html><body>drain</body></html>";
+
+    bool ok = true;
+    try {
+        ok &= check(ListenHandoff(handoff_path).receive(100) == -1, "no previous process to hand over");
+
+        auto old_server = std::make_unique<HttpServer>(server_addr, server_port, web_root.string());
+        std::atomic<bool> old_running(true);
+        std::atomic<int32_t> drained(-1);
+        std::thread old_thread([&]() {
+            while (old_running) {
+                old_server->listen_loop();
+            }
+            drained = old_server->drain(std::chrono::seconds(5));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        // 慢速下载中的连接与已空闲的keep-alive连接
+        TcpClient downloading(server_addr, server_port);
+        send_data_nonblock(downloading.get_fd(), big_request.c_str(), static_cast<uint16_t>(big_request.size()));
+        TcpClient idle(server_addr, server_port);
+        send_data_nonblock(idle.get_fd(), small_request.c_str(), static_cast<uint16_t>(small_request.size()));
+        ok &= check(read_body(idle.get_fd(), 1000) > 0, "keep-alive request served by the old server");
+
+        // 经Unix socket交接监听fd，新服务器确认接管后旧服务器才停止accept
+        ListenHandoff old_handoff(handoff_path);
+        old_handoff.listen();
+        std::atomic<bool> handed_over(false);
+        std::thread handoff_thread([&]() {
+            handed_over = old_handoff.hand_over(old_server->get_listen_fd(), 2000);
+        });
+        ListenHandoff new_handoff(handoff_path);
+        int32_t listen_fd = new_handoff.receive(1000);
+        HttpServer new_server(listen_fd, web_root.string());
+        new_handoff.listen();
+        new_handoff.confirm();
+        handoff_thread.join();
+        ok &= check(handed_over && new_server.get_listen_port() == server_port, "listen fd handed over");
+
+        std::atomic<bool> new_running(true);
+        std::thread new_thread([&]() {
+            while (new_running) {
+                new_server.listen_loop();
+            }
+        });
+
+        // 旧服务器排空：空闲连接立即关闭，下载中的连接发完后关闭，新连接由新服务器处理
+        old_running = false;
+        ok &= check(wait_peer_closed(idle.get_fd(), 3000), "idle keep-alive connection closed during drain");
+        {
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), small_request.c_str(), static_cast<uint16_t>(small_request.size()));
+            ok &= check(read_body(client.get_fd(), 1000) > 0, "new connection served during drain");
+        }
+        HttpCacheStats stats = new_server.get_cache_stats();
+        ok &= check(stats.hits + stats.misses == 1, "new connection went to the new server");
+        ok &= check(read_body(downloading.get_fd(), 5000) == BIG_SIZE, "in-flight download completes");
+        ok &= check(wait_peer_closed(downloading.get_fd(), 3000), "drained connection closed after its response");
+        old_thread.join();
+        ok &= check(drained == 1, "drain finished before the deadline");
+        old_server.reset();
+
+        {
+            // 旧进程退出后监听socket仍在
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), small_request.c_str(), static_cast<uint16_t>(small_request.size()));
+            ok &= check(read_body(client.get_fd(), 1000) > 0, "served after the old server exits");
+        }
+
+        new_running = false;
+        new_thread.join();
+        new_server.stop();
+        new_server.stop();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    try {
+        // 未处于监听状态的socket不能接管
+        int32_t fd = socket(AF_INET, SOCK_STREAM, 0);
+        bool rejected = false;
+        try {
+            HttpServer server(fd, web_root.string());
+        } catch (const TcpRuntimeException&) {
+            rejected = true;
+        }
+        close(fd);
+        ok &= check(rejected, "non-listening socket rejected");
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP drain test passed!" : "HTTP drain test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
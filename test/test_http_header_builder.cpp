@@ -0,0 +1,60 @@
+// test_http_header_builder.cpp
+#include <iostream>
+#include <string>
+
+#include "tcp_public.hpp"
+#include "http_header_builder.hpp"
+#include "http_request.hpp"
+#include "test_helper.hpp"
+
+int test_http_header_builder()
+{
+    bool ok = true;
+
+    ok &= check(HttpHeaderBuilder::get_mime_type("/index.html") == "text/html" &&
+        HttpHeaderBuilder::get_mime_type("/a/b/app.js") == "application/javascript" &&
+        HttpHeaderBuilder::get_mime_type("/song.flac") == "audio/flac" &&
+        HttpHeaderBuilder::get_mime_type("/movie.webm") == "video/webm", "MIME lookup");
+    ok &= check(HttpHeaderBuilder::get_mime_type("/README") == "application/octet-stream" &&
+        HttpHeaderBuilder::get_mime_type("/archive.tar") == "application/octet-stream" &&
+        HttpHeaderBuilder::get_mime_type("/page.htm") == "application/octet-stream" &&
+        HttpHeaderBuilder::get_mime_type("/dir.js/file") == "application/octet-stream", "unknown extensions");
+
+    HttpHeaderBuilder header;
+    header.status(206)
+        .add("Content-Type", "text/plain")
+        .add_content_range(100, 199, 5000000)
+        .add("Content-Length", static_cast<int64_t>(100))
+        .finish();
+    ok &= check(header.view() ==
+        "HTTP/1.1 206 Partial Content\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Range: bytes 100-199/5000000\r\n"
+        "Content-Length: 100\r\n"
+        "\r\n", "header rendering");
+
+    bool overflow = false;
+    try {
+        header.clear();
+        header.add("X-Long", std::string(HttpHeaderBuilder::CAPACITY, 'x'));
+    } catch (const TcpRuntimeException&) {
+        overflow = true;
+    }
+    ok &= check(overflow, "overflow is reported");
+
+    // 错误响应预先渲染，不同的异常消息共享同一份响应，且消息不会回显给客户端
+    HttpRequestException not_found("cannot access /secret/path", HTTP_ERR_NOT_FOUND);
+    HttpRequestException another("other reason", HTTP_ERR_NOT_FOUND);
+    std::string_view response = not_found.get_err_resp();
+    ok &= check(response.data() == another.get_err_resp().data() &&
+        response.compare(0, 24, "HTTP/1.1 404 Not Found\r\n") == 0 &&
+        response.find("/secret/path") == std::string_view::npos, "pre-rendered error response");
+    size_t body = response.find("\r\n\r\n") + 4;
+    ok &= check(response.find("Content-Length: " + std::to_string(response.size() - body) + "\r\n") !=
+        std::string_view::npos, "error response length");
+    ok &= check(HttpRequestException("odd", 599).get_err_resp().compare(0, 12, "HTTP/1.1 500") == 0,
+        "unknown error code falls back to 500");
+
+    std::cout << (ok ? "HTTP header builder test passed!" : "HTTP header builder test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
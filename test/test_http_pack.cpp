@@ -0,0 +1,124 @@
+// test_http_pack.cpp
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "http_pack.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+int test_http_pack()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18087;
+    const std::filesystem::path temp_dir = std::filesystem::temp_directory_path() / "tcp_example_pack_test";
+    const std::filesystem::path source_dir = temp_dir / "site";
+    const std::filesystem::path empty_root = temp_dir / "empty";
+    const std::string pack_path = (temp_dir / "site.pack").string();
+
+    std::string page = "<html><body>";
+    for (size_t i = 0; i < 200; i++) {
+        page += "<p>packed page line " + std::to_string(i) + "</p>";
+    }
+    page += "</body></html>";
+    std::string big(1024 * 1024, '\0');
+    for (size_t i = 0; i < big.size(); i++) {
+        big[i] = static_cast<char>('a' + i % 26);
+    }
+
+    std::filesystem::create_directories(source_dir / "js");
+    std::filesystem::create_directories(empty_root);
+    std::ofstream(source_dir / "index.html") << page;
+    std::ofstream(source_dir / "js" / "app.js") << "console.log('pack');";
+    std::ofstream(source_dir / "big.bin") << big;
+
+    bool ok = true;
+    try {
+        HttpPackBuildStats stats = HttpPack::build(source_dir.string(), pack_path);
+        ok &= check(stats.files == 3 && stats.bytes == page.size() + big.size() + 20, "pack built");
+        ok &= check(stats.gzip_files == 1, "gzip variant only for compressible files worth compressing");
+
+        {
+            HttpPack pack(pack_path);
+            HttpPackEntry entry;
+            ok &= check(pack.get_entry_count() == 3 && pack.lookup("/js/app.js", entry) &&
+                entry.mime_type == "application/javascript" && entry.size == 20 &&
+                std::string(pack.get_data(entry.offset), 20) == "console.log('pack');", "lookup in pack index");
+            ok &= check(!pack.lookup("/js", entry) && !pack.lookup("/missing.html", entry), "missing paths not found");
+        }
+
+        // 源目录删除后仍从归档提供服务，web_root指向空目录
+        std::filesystem::remove_all(source_dir);
+        HttpServer server(server_addr, server_port, empty_root.string());
+        server.serve_pack(pack_path);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::string response = http_request(server_addr, server_port, "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        std::string etag = http_header(response, "ETag");
+        ok &= check(response.compare(0, 15, "HTTP/1.1 200 OK") == 0 && http_body(response) == page &&
+            http_header(response, "Content-Type") == "text/html" && !etag.empty(), "page served from pack");
+
+        response = http_request(server_addr, server_port,
+            "GET /index.html HTTP/1.1\r\nHost: localhost\r\nAccept-Encoding: gzip\r\n\r\n");
+        ok &= check(http_header(response, "Content-Encoding") == "gzip" &&
+            http_body(response).size() < page.size(), "precompressed variant served");
+
+        response = http_request(server_addr, server_port,
+            "GET /index.html HTTP/1.1\r\nHost: localhost\r\nIf-None-Match: " + etag + "\r\n\r\n");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 304") == 0, "conditional request answered with 304");
+
+        response = http_request(server_addr, server_port, "GET /big.bin HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        ok &= check(http_body(response) == big, "large file sent from the pack fd");
+
+        response = http_request(server_addr, server_port,
+            "GET /big.bin HTTP/1.1\r\nHost: localhost\r\nRange: bytes=1000-1009\r\n\r\n");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 206") == 0 && http_body(response) == big.substr(1000, 10),
+            "range served from the mapping");
+
+        {
+            // HEAD只返回响应头，随后的请求在同一连接上得到完整响应，说明没有多发响应体
+            TcpClient client(server_addr, server_port);
+            response = http_roundtrip(client.get_fd(), "HEAD /big.bin HTTP/1.1\r\nHost: localhost\r\n\r\n", 500);
+            ok &= check(response.compare(0, 15, "HTTP/1.1 200 OK") == 0 &&
+                http_header(response, "Content-Length") == std::to_string(big.size()) && http_body(response).empty(),
+                "HEAD answered with headers only");
+            response = http_roundtrip(client.get_fd(), "GET /js/app.js HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            ok &= check(response.compare(0, 15, "HTTP/1.1 200 OK") == 0 && http_body(response) == "console.log('pack');",
+                "connection intact after HEAD");
+        }
+
+        response = http_request(server_addr, server_port, "GET /../site.pack HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 404") == 0, "paths outside the pack not found");
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    // 损坏的归档在打开时即被拒绝
+    std::ofstream(temp_dir / "broken.pack") << std::string(256, 'x');
+    bool rejected = false;
+    try {
+        HttpPack pack((temp_dir / "broken.pack").string());
+    } catch (const TcpRuntimeException&) {
+        rejected = true;
+    }
+    ok &= check(rejected, "corrupt pack rejected");
+
+    std::filesystem::remove_all(temp_dir);
+    std::cout << (ok ? "HTTP pack test passed!" : "HTTP pack test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+// test_http_proxy.cpp
+extern "C" {
+#include <sys/socket.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include <algorithm>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 上游的替身：以TcpServer实现的最小HTTP/1.1服务器，按路径返回不同分帧的响应，并统计接受的连接数
+class ProxyTestBackend : public TcpServer {
+private:
+    std::string name;
+    std::unordered_map<int32_t, std::string> inputs; // 只在事件循环线程上访问
+
+    void respond(int32_t client_fd, const std::string& head)
+    {
+        size_t path_start = head.find(' ') + 1;
+        std::string path = head.substr(path_start, head.find(' ', path_start) - path_start);
+        std::string forwarded_for;
+        size_t xff = head.find("X-Forwarded-For: ");
+        if (xff != std::string::npos) {
+            forwarded_for = head.substr(xff + 17, head.find("\r\n", xff) - xff - 17);
+        }
+        requests++;
+
+        if (path.find("chunked") != std::string::npos) {
+            send_all(client_fd, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n" + chunked_body());
+            return;
+        }
+        if (path.find("large") != std::string::npos) {
+            std::string body = large_body();
+            send_all(client_fd, "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n");
+            send_all(client_fd, body);
+            return;
+        }
+        if (path.find("close") != std::string::npos) {
+            send_all(client_fd, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nuntil close from " + this->name);
+            close_client(client_fd);
+            return;
+        }
+        if (path.find("slow") != std::string::npos) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        }
+        std::string body = this->name + " " + path + " xff=" + forwarded_for;
+        // HEAD的响应只有响应头，Content-Length仍是GET时的长度
+        bool head_only = head.compare(0, 5, "HEAD ") == 0;
+        send_all(client_fd, "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nKeep-Alive: timeout=5\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + (head_only ? "" : body));
+    }
+
+public:
+    std::atomic<size_t> accepted{0};
+    std::atomic<size_t> requests{0};
+
+    ProxyTestBackend(const std::string& addr, uint16_t port, const std::string& name) :
+        TcpServer(addr, port), name(name) {}
+
+    static std::string chunked_body()
+    {
+        return "5\r\nhello\r\n7;ext=1\r\n, proxy\r\n1000\r\n" + std::string(4096, 'c') + "\r\n0\r\nX-Trailer: 1\r\n\r\n";
+    }
+
+    static std::string large_body()
+    {
+        std::string body(4 * 1024 * 1024, '\0');
+        for (size_t i = 0; i < body.size(); i++) {
+            body[i] = static_cast<char>('a' + i % 19);
+        }
+        return body;
+    }
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        accepted++;
+        TcpServer::deal_new_client(client_fd, client_addr);
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        std::string& input = this->inputs[client_fd];
+        char buf[16384];
+        for (;;) {
+            ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (len > 0) {
+                input.append(buf, static_cast<size_t>(len));
+                continue;
+            }
+            if (len == 0) {
+                close_client(client_fd);
+                return;
+            }
+            break;
+        }
+
+        size_t end = 0;
+        while ((end = input.find("\r\n\r\n")) != std::string::npos) {
+            std::string head = input.substr(0, end + 4);
+            input.erase(0, end + 4);
+            respond(client_fd, head);
+            if (this->inputs.count(client_fd) == 0) {
+                return; // 响应后已关闭
+            }
+        }
+    }
+
+    void deal_client_close(int32_t client_fd) override
+    {
+        this->inputs.erase(client_fd);
+    }
+};
+
+static std::string get(int32_t fd, const std::string& path)
+{
+    return http_roundtrip(fd, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+}
+
+int test_http_proxy()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18090;
+    const uint16_t backend_a_port = 18091;
+    const uint16_t backend_b_port = 18092;
+    const uint16_t dead_port = 18093; // 没有服务监听，连接被拒绝
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_proxy_test";
+
+    std::filesystem::create_directories(web_root);
+    {
+        std::ofstream out(web_root / "local.txt", std::ios::binary);
+        out << "served locally";
+    }
+
+    bool ok = true;
+    try {
+        ProxyTestBackend backend_a(server_addr, backend_a_port, "A");
+        ProxyTestBackend backend_b(server_addr, backend_b_port, "B");
+        HttpServer server(server_addr, server_port, web_root.string(), 4);
+        HttpProxyConfig config;
+        config.retry_interval = std::chrono::milliseconds(60000);
+        config.max_in_flight = 2;
+        server.add_proxy_route("/api/", {{server_addr, backend_a_port}, {server_addr, backend_b_port}}, config);
+        server.add_proxy_route("/solo/", {{server_addr, backend_a_port}});
+        server.add_proxy_route("/flaky/", {{server_addr, backend_a_port}, {server_addr, dead_port}});
+        server.add_proxy_route("/dead/", {{server_addr, dead_port}});
+
+        std::atomic<bool> running(true);
+        std::vector<std::thread> threads;
+        threads.emplace_back([&]() { while (running) { backend_a.listen_loop(); } });
+        threads.emplace_back([&]() { while (running) { backend_b.listen_loop(); } });
+        threads.emplace_back([&]() { while (running) { server.listen_loop(); } });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            TcpClient client(server_addr, server_port);
+            std::string response = get(client.get_fd(), "/api/hello");
+            std::string body = http_body(response);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 200") == 0 && body.find(" /api/hello xff=127.0.0.1") != std::string::npos,
+                "request forwarded with X-Forwarded-For");
+            ok &= check(response.find("Keep-Alive:") == std::string::npos &&
+                response.find("Connection: keep-alive") != std::string::npos, "hop-by-hop headers rewritten");
+
+            // 顺序请求在同一个客户端连接上，上游连接从池中复用
+            bool all_ok = true;
+            for (int i = 0; i < 20; i++) {
+                response = get(client.get_fd(), "/api/item" + std::to_string(i));
+                all_ok &= response.compare(0, 12, "HTTP/1.1 200") == 0 &&
+                    http_body(response).find("/api/item" + std::to_string(i)) != std::string::npos;
+            }
+            HttpProxyStats stats = server.get_proxy_stats();
+            ok &= check(all_ok && backend_a.accepted + backend_b.accepted <= 2 && stats.reused >= 19,
+                "keep-alive upstream connections reused (" + std::to_string(stats.connects) + " connects, " +
+                std::to_string(stats.reused) + " reused)");
+            ok &= check(backend_a.requests > 0 && backend_b.requests > 0, "requests spread over both upstreams");
+
+            response = get(client.get_fd(), "/local.txt");
+            ok &= check(http_body(response) == "served locally", "unmatched paths served from web_root");
+        }
+
+        {
+            TcpClient client(server_addr, server_port);
+            std::string response = get(client.get_fd(), "/solo/chunked");
+            std::string expected = ProxyTestBackend::chunked_body();
+            ok &= check(response.compare(0, 12, "HTTP/1.1 200") == 0 && http_body(response) == expected,
+                "chunked response relayed");
+            response = get(client.get_fd(), "/solo/next");
+            ok &= check(http_body(response).find("A /solo/next") == 0, "client connection kept alive after chunked body");
+
+            response = get(client.get_fd(), "/solo/large");
+            ok &= check(http_body(response) == ProxyTestBackend::large_body(), "large body relayed intact");
+
+            // 响应头声明了长度却没有响应体，读取等到超时为止
+            response = http_roundtrip(client.get_fd(), "HEAD /solo/head HTTP/1.1\r\nHost: localhost\r\n\r\n", 500);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 200") == 0 && http_header(response, "Content-Length") != "" &&
+                http_body(response).empty(), "HEAD forwarded and answered without a body");
+            response = get(client.get_fd(), "/solo/after-head");
+            ok &= check(http_body(response).find("A /solo/after-head") == 0, "connection intact after a proxied HEAD");
+        }
+
+        {
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "GET /solo/close HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            std::string response = read_http_responses(client.get_fd(), 1, 5000);
+            ok &= check(http_body(response) == "until close from A" && response.find("Connection: close") != std::string::npos,
+                "close-delimited body relayed and client connection closed");
+        }
+
+        {
+            // 慢请求占住一个上游时，其余请求交给在途请求更少的另一个
+            std::string slow_response;
+            std::thread slow([&]() {
+                TcpClient client(server_addr, server_port);
+                slow_response = get(client.get_fd(), "/api/slow");
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::string others;
+            TcpClient client(server_addr, server_port);
+            for (int i = 0; i < 4; i++) {
+                others += http_body(get(client.get_fd(), "/api/quick")).substr(0, 1);
+            }
+            slow.join();
+            std::string slow_backend = http_body(slow_response).substr(0, 1);
+            ok &= check(!slow_backend.empty() && others.size() == 4 && others.find(slow_backend) == std::string::npos,
+                "least outstanding upstream chosen (slow on " + slow_backend + ", others on " + others + ")");
+        }
+
+        {
+            // 在途请求达到上限后，再来的代理请求立即得到503，不再占用工作线程
+            std::vector<std::string> responses(3);
+            std::vector<std::thread> clients;
+            for (size_t i = 0; i < responses.size(); i++) {
+                clients.emplace_back([&, i]() {
+                    TcpClient client(server_addr, server_port);
+                    responses[i] = get(client.get_fd(), "/api/slow");
+                });
+            }
+            for (std::thread& client : clients) {
+                client.join();
+            }
+            size_t served = std::count_if(responses.begin(), responses.end(),
+                [](const std::string& response) { return response.compare(0, 12, "HTTP/1.1 200") == 0; });
+            size_t rejected = std::count_if(responses.begin(), responses.end(),
+                [](const std::string& response) { return response.compare(0, 12, "HTTP/1.1 503") == 0; });
+            ok &= check(served == 2 && rejected == 1 && server.get_proxy_stats().rejected == 1,
+                "proxied requests over max_in_flight rejected with 503");
+
+            TcpClient client(server_addr, server_port);
+            ok &= check(http_body(get(client.get_fd(), "/api/after")).find(" /api/after") == 1,
+                "in-flight slots released after the slow requests");
+        }
+
+        {
+            TcpClient client(server_addr, server_port);
+            bool all_ok = true;
+            for (int i = 0; i < 8; i++) {
+                std::string response = get(client.get_fd(), "/flaky/" + std::to_string(i));
+                all_ok &= http_body(response).find("A /flaky/") == 0;
+            }
+            HttpProxyStats stats = server.get_proxy_stats();
+            ok &= check(all_ok && stats.failures >= 1 && stats.unhealthy >= 1,
+                "failed upstream skipped and marked unhealthy");
+
+            std::string response = get(client.get_fd(), "/dead/x");
+            ok &= check(response.compare(0, 12, "HTTP/1.1 502") == 0, "502 when no upstream is reachable");
+        }
+
+        {
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "PUT /api/file HTTP/1.1\r\nHost: localhost\r\nContent-Length: 3\r\n\r\nabc");
+            std::string response = read_http_responses(client.get_fd(), 1, 5000);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 405") == 0 && wait_peer_closed(client.get_fd(), 1000),
+                "request bodies are not forwarded");
+        }
+
+        running = false;
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP proxy test passed!" : "HTTP proxy test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,235 @@
+// test_http_server.cpp
+extern "C" {
+#include <unistd.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+int test_http_server()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18081;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_http_test";
+    // 远大于socket发送缓冲区，客户端不读取时传输必然挂起
+    const size_t HUGE_FILE_SIZE = 32 * 1024 * 1024;
+
+    std::filesystem::create_directories(web_root);
+    {
+        std::ofstream(web_root / "index.html") << "<html><body>hello cache</body></html>";
+        std::ofstream(web_root / "big.bin") << std::string(100000, 'x');
+        std::ofstream(web_root / "huge.bin") << std::string(HUGE_FILE_SIZE, 'y');
+        std::ofstream script(web_root / "app.js");
+        for (int i = 0; i < 200; i++) {
+            script << "console.log('compressible line " << i % 10 << "');\n";
+        }
+    }
+
+    bool ok = true;
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            TcpClient client(server_addr, server_port);
+            const std::string get_req = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+            std::string first = http_roundtrip(client.get_fd(), get_req);
+            ok &= check(first.find("200 OK") != std::string::npos &&
+                first.find("hello cache") != std::string::npos, "full file response");
+
+            std::string second = http_roundtrip(client.get_fd(), get_req);
+            ok &= check(second == first, "cached response is identical");
+
+            std::string range = http_roundtrip(client.get_fd(),
+                "GET /index.html HTTP/1.1\r\nRange: bytes=6-11\r\n\r\n");
+            ok &= check(range.find("206 Partial Content") != std::string::npos &&
+                range.substr(range.size() - 6) == "<body>", "range sliced from cache");
+
+            HttpCacheStats stats = server.get_cache_stats();
+            ok &= check(stats.hits >= 2 && stats.entries == 1, "cache hits recorded");
+
+            // 修改文件后缓存条目应失效
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            {
+                std::ofstream(web_root / "index.html") << "<html><body>updated</body></html>";
+            }
+            std::string updated = http_roundtrip(client.get_fd(), get_req);
+            ok &= check(updated.find("updated") != std::string::npos, "cache refreshed on mtime change");
+            ok &= check(server.get_cache_stats().stale >= 1, "stale entry counted");
+
+            // gzip协商：首次以原文件回复并调度后台压缩，之后命中压缩版本
+            const std::string gzip_req = "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip, deflate\r\n\r\n";
+            std::string plain = http_roundtrip(client.get_fd(), gzip_req);
+            ok &= check(plain.find("Vary: Accept-Encoding") != std::string::npos &&
+                plain.find("Content-Encoding") == std::string::npos, "identity response before compression");
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            std::string gzipped = http_roundtrip(client.get_fd(), gzip_req);
+            ok &= check(gzipped.find("Content-Encoding: gzip") != std::string::npos &&
+                gzipped.size() < plain.size(), "compressed variant served");
+
+            std::string refused = http_roundtrip(client.get_fd(),
+                "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip;q=0\r\n\r\n");
+            ok &= check(refused.find("Content-Encoding") == std::string::npos, "gzip;q=0 is respected");
+
+            // 格式错误的q值按q=1处理，不会中断事件循环
+            std::string bad_q = http_roundtrip(client.get_fd(),
+                "GET /app.js HTTP/1.1\r\nAccept-Encoding: gzip;q=x\r\n\r\n");
+            ok &= check(bad_q.find("Content-Encoding: gzip") != std::string::npos, "malformed q-value treated as q=1");
+
+            {
+                std::ofstream(web_root / "index.html.gz") << "precompressed";
+            }
+            std::string precompressed = http_roundtrip(client.get_fd(),
+                "GET /index.html HTTP/1.1\r\nAccept-Encoding: gzip\r\n\r\n");
+            ok &= check(precompressed.find("Content-Encoding: gzip") != std::string::npos &&
+                precompressed.substr(precompressed.size() - 13) == "precompressed", "precompressed sibling served");
+            ok &= check(server.get_gzip_stats().bytes_saved > 0, "bytes saved recorded");
+
+            // 多range：合并重叠与相邻区间后以multipart/byteranges回复
+            std::string multi = http_roundtrip(client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nRange: bytes=0-9,5-19,20-29,100-109,70000-70009\r\n\r\n");
+            ok &= check(multi.find("multipart/byteranges; boundary=") != std::string::npos &&
+                multi.find("Content-Range: bytes 0-29/100000") != std::string::npos &&
+                multi.find("Content-Range: bytes 70000-70009/100000") != std::string::npos &&
+                multi.find("Content-Range: bytes 100-109/100000") != std::string::npos, "multipart from file");
+
+            std::string multi_cached = http_roundtrip(client.get_fd(),
+                "GET /index.html HTTP/1.1\r\nRange: bytes=0-1,3-4\r\n\r\n");
+            ok &= check(multi_cached.find("multipart/byteranges") != std::string::npos &&
+                multi_cached.find("Content-Range: bytes 3-4/") != std::string::npos, "multipart from cache");
+
+            // 格式错误或溢出的范围被忽略，其余范围照常回复
+            std::string bad_ranges = http_roundtrip(client.get_fd(),
+                "GET /index.html HTTP/1.1\r\nRange: bytes=x-1,99999999999999999999-,-y,2-3\r\n\r\n");
+            ok &= check(bad_ranges.find("206 Partial Content") != std::string::npos &&
+                bad_ranges.find("Content-Range: bytes 2-3/") != std::string::npos, "malformed ranges ignored");
+
+            std::string many_ranges = "GET /big.bin HTTP/1.1\r\nRange: bytes=0-0";
+            for (int i = 1; i <= 20; i++) {
+                many_ranges += "," + std::to_string(i * 10) + "-" + std::to_string(i * 10);
+            }
+            std::string too_many = http_roundtrip(client.get_fd(), many_ranges + "\r\n\r\n");
+            ok &= check(too_many.find("416 Range Not Satisfiable") != std::string::npos, "range part cap enforced");
+
+            // 错误响应携带Connection: close，服务端发送完毕后关闭连接，此后改用新连接
+            TcpClient conditional_client(server_addr, server_port);
+
+            // 条件请求：ETag与Last-Modified命中时回复304且不带body
+            std::string fresh = http_roundtrip(conditional_client.get_fd(), "GET /big.bin HTTP/1.1\r\n\r\n");
+            size_t etag_pos = fresh.find("ETag: ");
+            size_t lm_pos = fresh.find("Last-Modified: ");
+            ok &= check(etag_pos != std::string::npos && lm_pos != std::string::npos, "validators present");
+            std::string etag = fresh.substr(etag_pos + 6, fresh.find("\r\n", etag_pos) - etag_pos - 6);
+            std::string last_modified = fresh.substr(lm_pos + 15, fresh.find("\r\n", lm_pos) - lm_pos - 15);
+
+            std::string not_modified = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nIf-None-Match: " + etag + "\r\n\r\n");
+            ok &= check(not_modified.find("304 Not Modified") != std::string::npos &&
+                not_modified.size() == not_modified.find("\r\n\r\n") + 4, "If-None-Match returns 304");
+
+            std::string since = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nIf-Modified-Since: " + last_modified + "\r\n\r\n");
+            ok &= check(since.find("304 Not Modified") != std::string::npos, "If-Modified-Since returns 304");
+
+            std::string changed = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nIf-None-Match: \"other\"\r\n\r\n");
+            ok &= check(changed.find("200 OK") != std::string::npos, "mismatched ETag returns 200");
+
+            std::string if_range = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nRange: bytes=0-9\r\nIf-Range: \"stale\"\r\n\r\n");
+            ok &= check(if_range.find("200 OK") != std::string::npos, "stale If-Range ignores Range");
+            std::string if_range_ok = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nRange: bytes=0-9\r\nIf-Range: " + etag + "\r\n\r\n");
+            ok &= check(if_range_ok.find("206 Partial Content") != std::string::npos, "matching If-Range keeps Range");
+            std::string if_range_first = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nIf-Range: " + etag + "\r\nRange: bytes=0-9\r\n\r\n");
+            ok &= check(if_range_first.find("206 Partial Content") != std::string::npos &&
+                if_range_first.find("Content-Range: bytes 0-9/") != std::string::npos, "If-Range before Range");
+            std::string if_range_only = http_roundtrip(conditional_client.get_fd(),
+                "GET /big.bin HTTP/1.1\r\nIf-Range: " + etag + "\r\n\r\n");
+            ok &= check(if_range_only.find("200 OK") != std::string::npos, "If-Range without Range is ignored");
+
+            // 管线化请求：工作线程处理的请求在前、缓存命中的请求在后，响应仍须保持请求顺序
+            send_all(conditional_client.get_fd(), "GET /big.bin HTTP/1.1\r\n\r\nGET /index.html HTTP/1.1\r\n\r\n");
+            std::string pipelined = read_http_responses(conditional_client.get_fd(), 2);
+            size_t first_pos = pipelined.find("Content-Type: application/octet-stream");
+            size_t second_pos = pipelined.find("Content-Type: text/html");
+            ok &= check(first_pos != std::string::npos && second_pos != std::string::npos && first_pos < second_pos,
+                "pipelined responses keep request order");
+
+            std::string missing = http_roundtrip(conditional_client.get_fd(), "GET /missing.html HTTP/1.1\r\n\r\n");
+            ok &= check(missing.find("404 Not Found") != std::string::npos, "missing file returns 404");
+
+        }
+
+        {
+            // 工作线程上无法解析的路径同样得到错误响应，连接随后交还reactor并关闭，不会停留在工作线程手中
+            TcpClient overlong_client(server_addr, server_port);
+            std::string overlong = http_roundtrip(overlong_client.get_fd(),
+                "GET /" + std::string(300, 'n') + " HTTP/1.1\r\n\r\n");
+            ok &= check(overlong.find("404 Not Found") != std::string::npos &&
+                wait_peer_closed(overlong_client.get_fd(), 1000), "worker-side path error answered and connection released");
+        }
+
+        {
+            // 慢速下载：客户端暂不读取大文件，文件内容由reactor续传，不占住工作线程
+            TcpClient slow_client(server_addr, server_port);
+            const std::string huge_req = "GET /huge.bin HTTP/1.1\r\n\r\n";
+            send_data_nonblock(slow_client.get_fd(), huge_req.c_str(), static_cast<uint16_t>(huge_req.size()));
+            std::this_thread::sleep_for(std::chrono::milliseconds(200));
+            ok &= check(server.get_active_transfers() == 1, "slow download is parked on the reactor");
+
+            TcpClient other_client(server_addr, server_port);
+            auto begin = std::chrono::steady_clock::now();
+            std::string other = http_roundtrip(other_client.get_fd(), "GET /big.bin HTTP/1.1\r\n\r\n");
+            auto elapsed = std::chrono::steady_clock::now() - begin;
+            ok &= check(other.find("200 OK") != std::string::npos && elapsed < std::chrono::seconds(1),
+                "other clients are served during a slow download");
+
+            std::string huge = read_http_responses(slow_client.get_fd(), 1, 10000);
+            ok &= check(huge.size() == huge.find("\r\n\r\n") + 4 + HUGE_FILE_SIZE, "slow download completes");
+        }
+
+        {
+            // 各发送策略的响应内容应完全一致
+            TcpClient strategy_client(server_addr, server_port);
+            const std::string range_req = "GET /huge.bin HTTP/1.1\r\nRange: bytes=1000-2500000\r\n\r\n";
+            std::string expected = http_roundtrip(strategy_client.get_fd(), range_req);
+            bool same = expected.find("206 Partial Content") != std::string::npos;
+            for (HttpFileStrategy strategy : { HTTP_FILE_SENDFILE, HTTP_FILE_SPLICE, HTTP_FILE_MMAP }) {
+                server.set_file_strategy(strategy);
+                same &= http_roundtrip(strategy_client.get_fd(), range_req) == expected;
+                std::string full = http_roundtrip(strategy_client.get_fd(), "GET /big.bin HTTP/1.1\r\n\r\n");
+                same &= full.substr(full.find("\r\n\r\n") + 4) == std::string(100000, 'x');
+            }
+            server.set_file_strategy(HTTP_FILE_AUTO);
+            ok &= check(same, "file strategies produce identical bodies");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP server test passed!" : "HTTP server test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
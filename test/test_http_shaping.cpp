@@ -0,0 +1,106 @@
+// test_http_shaping.cpp
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 新建连接请求path，返回响应体长度，失败时返回0
+static size_t fetch_body(const std::string& addr, uint16_t port, const std::string& path)
+{
+    std::string response = http_request(addr, port, "GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n", 5000);
+    return count_http_responses(response) == 1 ? http_body(response).size() : 0;
+}
+
+int test_http_shaping()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18085;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_shaping_test";
+    const size_t BULK_SIZE = 2 * 1024 * 1024;
+    const uint64_t BULK_RATE = 4 * 1024 * 1024;
+    const uint64_t CLIENT_RATE = 6 * 1024 * 1024;
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "bulk.bin") << std::string(BULK_SIZE, 'b');
+    std::ofstream(web_root / "index.html") << "<html><body>small</body></html>";
+
+    bool ok = true;
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        HttpShapingConfig config;
+        config.classes[HTTP_TRAFFIC_BULK].rate = BULK_RATE;
+        config.classes[HTTP_TRAFFIC_BULK].burst = 256 * 1024;
+        config.client_rate = CLIENT_RATE;
+        server.enable_shaping(config);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            // 单连接受类别限速约束：扣除桶内初始令牌后，其余数据按BULK_RATE发出
+            auto begin = std::chrono::steady_clock::now();
+            std::atomic<size_t> bulk_received(0);
+            std::thread downloader([&]() {
+                bulk_received = fetch_body(server_addr, server_port, "/bulk.bin");
+            });
+
+            // 大文件下载进行中，小响应不受其影响
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            auto small_begin = std::chrono::steady_clock::now();
+            size_t small = fetch_body(server_addr, server_port, "/index.html");
+            double small_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+                small_begin).count();
+            downloader.join();
+            double bulk_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+            ok &= check(bulk_received == BULK_SIZE, "bulk download completes");
+            ok &= check(bulk_s >= 0.35, "per-connection rate limit (" + std::to_string(bulk_s) + "s)");
+            ok &= check(small > 0 && small_ms < 200, "small response during bulk transfer (" +
+                std::to_string(small_ms) + "ms)");
+        }
+
+        {
+            // 同一IP的两条连接合计受客户端限速约束，慢于两条连接各自限速之和
+            auto begin = std::chrono::steady_clock::now();
+            std::atomic<size_t> first(0);
+            std::thread downloader([&]() {
+                first = fetch_body(server_addr, server_port, "/bulk.bin");
+            });
+            size_t second = fetch_body(server_addr, server_port, "/bulk.bin");
+            downloader.join();
+            double total_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            ok &= check(first == BULK_SIZE && second == BULK_SIZE, "concurrent downloads complete");
+            ok &= check(total_s >= 0.5, "per-client rate limit (" + std::to_string(total_s) + "s)");
+        }
+
+        HttpShapingStats stats = server.get_shaping_stats();
+        ok &= check(stats.throttled > 0 && stats.rounds > 0, "throttling recorded");
+        ok &= check(stats.bytes[HTTP_TRAFFIC_BULK] >= 3 * BULK_SIZE &&
+            stats.bytes[HTTP_TRAFFIC_INTERACTIVE] > 0, "bytes accounted per traffic class");
+        ok &= check(HttpShaper::classify("video/mp4") == HTTP_TRAFFIC_MEDIA &&
+            HttpShaper::classify("image/svg+xml") == HTTP_TRAFFIC_INTERACTIVE &&
+            HttpShaper::classify("image/png") == HTTP_TRAFFIC_IMAGE &&
+            HttpShaper::classify("application/zip") == HTTP_TRAFFIC_BULK, "MIME classification");
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP shaping test passed!" : "HTTP shaping test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
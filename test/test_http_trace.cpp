@@ -0,0 +1,171 @@
+// test_http_trace.cpp
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <string>
+#include <memory>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+/*
+    测试用执行器：唯一的工作线程在执行每个任务之前先等待delay_ms，用于制造确定的排队时长
+*/
+class DelayedExecutor : public Executor {
+private:
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::deque<ExecutorTask> tasks;
+    bool stopping = false;
+    std::thread worker;
+
+public:
+    std::atomic<int32_t> delay_ms{0};
+
+    DelayedExecutor()
+    {
+        worker = std::thread([this]() {
+            for (;;) {
+                ExecutorTask task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cond.wait(lock, [this]() { return !tasks.empty() || stopping; });
+                    if (tasks.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms.load()));
+                task();
+            }
+        });
+    }
+
+    ~DelayedExecutor() override
+    {
+        stop();
+    }
+
+    bool submit(ExecutorTask&& task) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        cond.notify_one();
+        return true;
+    }
+
+    void stop() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cond.notify_one();
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    size_t get_thread_count() const override
+    {
+        return 1;
+    }
+};
+
+int test_http_trace()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18094;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_trace_test";
+    // 超过热点缓存的单文件上限，请求必定交给工作线程
+    const std::string request = "GET /big.bin HTTP/1.1\r\nHost: localhost\r\n\r\n";
+
+    std::filesystem::create_directories(web_root);
+    std::ofstream(web_root / "big.bin") << std::string(300000, 'x');
+
+    bool ok = true;
+    try {
+        // 未启用时不记录
+        HttpTrace untraced;
+        ok &= check(!untraced.active() && untraced.span(HTTP_SPAN_TOTAL) == 0, "empty trace has no spans");
+
+        auto executor = std::make_unique<DelayedExecutor>();
+        DelayedExecutor& delayed = *executor;
+        HttpServer server(server_addr, server_port, web_root.string(), std::move(executor));
+        HttpTraceConfig config;
+        config.slow_threshold = std::chrono::milliseconds(200);
+        config.sample_every = 2;
+        server.enable_tracing(config);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+            std::string response = read_http_responses(client.get_fd(), 1, 2000);
+            ok &= check(response.compare(0, 15, "HTTP/1.1 200 OK") == 0 && response.size() > 300000,
+                "traced request served");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            HttpTraceStats stats = server.get_trace_stats();
+            ok &= check(stats.traced == 1 && stats.slow == 0, "fast request traced but not slow");
+            ok &= check(stats.spans[HTTP_SPAN_TOTAL].max_us >= stats.spans[HTTP_SPAN_SEND].max_us &&
+                stats.spans[HTTP_SPAN_TOTAL].max_us < 200000, "total covers the send phase");
+        }
+
+        {
+            // 工作线程延迟300ms取出请求，耗时计入排队阶段，总耗时超过阈值
+            delayed.delay_ms = 300;
+            TcpClient client(server_addr, server_port);
+            send_data_nonblock(client.get_fd(), request.c_str(), static_cast<uint16_t>(request.size()));
+            std::string response = read_http_responses(client.get_fd(), 1, 3000);
+            ok &= check(response.compare(0, 15, "HTTP/1.1 200 OK") == 0, "delayed request served");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            HttpTraceStats stats = server.get_trace_stats();
+            ok &= check(stats.slow == 1, "slow request logged");
+            ok &= check(stats.spans[HTTP_SPAN_QUEUE].max_us >= 280000 &&
+                stats.spans[HTTP_SPAN_QUEUE].max_us < 1000000, "queue wait attributed to the queue phase");
+            ok &= check(stats.spans[HTTP_SPAN_READ].max_us < 100000 &&
+                stats.spans[HTTP_SPAN_HANDLE].max_us < 100000, "other phases stay short");
+            delayed.delay_ms = 0;
+        }
+
+        {
+            // 管线化的两个请求各自跟踪，第二个由工作线程直接解析，没有排队阶段；每两个请求抽样一个
+            TcpClient client(server_addr, server_port);
+            std::string pipelined = request + request;
+            send_data_nonblock(client.get_fd(), pipelined.c_str(), static_cast<uint16_t>(pipelined.size()));
+            std::string response = read_http_responses(client.get_fd(), 2, 3000);
+            ok &= check(response.size() > 600000, "pipelined requests served");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            HttpTraceStats stats = server.get_trace_stats();
+            ok &= check(stats.traced == 4, "pipelined requests traced separately");
+            ok &= check(stats.sampled == 1, "one in two non-slow requests sampled");
+            ok &= check(stats.spans[HTTP_SPAN_TOTAL].p50_us <= stats.spans[HTTP_SPAN_TOTAL].p99_us &&
+                stats.spans[HTTP_SPAN_TOTAL].p99_us >= stats.spans[HTTP_SPAN_QUEUE].max_us,
+                "percentiles ordered");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP trace test passed!" : "HTTP trace test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
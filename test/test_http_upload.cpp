@@ -0,0 +1,230 @@
+// test_http_upload.cpp
+extern "C" {
+#include <unistd.h>
+#include <sys/socket.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "http_upload.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+static std::string file_content(const std::filesystem::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+// 目录中是否残留上传临时文件
+static bool has_temp_files(const std::filesystem::path& dir)
+{
+    for (const auto& item : std::filesystem::directory_iterator(dir)) {
+        if (item.path().filename().string().find(".upload-") != std::string::npos) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 请求体恰好在receive()用完接收配额时收齐：除最后一段外都已在缓冲区中，最后一段经splice读完后须报告完成而不是等待
+static bool receive_ends_on_budget(const std::filesystem::path& dir)
+{
+    const size_t TAIL = HttpUpload::SPLICE_CHUNK_SIZE;
+    int32_t fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+        return false;
+    }
+    std::string tail(TAIL, 't');
+    bool ok = send(fds[1], tail.data(), tail.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(tail.size());
+    HttpUploadStatus status = HTTP_UPLOAD_AGAIN;
+    {
+        HttpUpload upload(dir / "budget.bin", static_cast<int64_t>(HttpUpload::RECEIVE_BUDGET), HttpUpload::RECEIVE_BUDGET);
+        std::string input(HttpUpload::RECEIVE_BUDGET - TAIL, 'b');
+        status = ok ? upload.receive(fds[0], input, nullptr) : HTTP_UPLOAD_AGAIN;
+        ok = ok && status == HTTP_UPLOAD_DONE && upload.get_received() == HttpUpload::RECEIVE_BUDGET && input.empty();
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return ok;
+}
+
+int test_http_upload()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18088;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_upload_test";
+    const uint64_t MAX_SIZE = 8 * 1024 * 1024;
+
+    std::filesystem::create_directories(web_root / "files");
+    std::string big(4 * 1024 * 1024, '\0');
+    for (size_t i = 0; i < big.size(); i++) {
+        big[i] = static_cast<char>('a' + i % 23);
+    }
+
+    bool ok = true;
+    try {
+        ok &= check(receive_ends_on_budget(web_root / "files"), "body ending on the receive budget completes");
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        server.enable_uploads(MAX_SIZE);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        std::string response = http_request(server_addr, server_port,
+            "PUT /files/hello.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 11\r\n\r\nhello world");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 201") == 0 &&
+            file_content(web_root / "files" / "hello.txt") == "hello world", "PUT creates the file");
+
+        response = http_request(server_addr, server_port,
+            "PUT /files/hello.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 7\r\n\r\nreplace");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 204") == 0 &&
+            file_content(web_root / "files" / "hello.txt") == "replace", "PUT replaces an existing file");
+
+        {
+            // 请求体分多次发出，大部分经splice写入文件
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "PUT /files/big.bin HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                std::to_string(big.size()) + "\r\n\r\n");
+            for (size_t pos = 0; pos < big.size(); pos += 300000) {
+                send_all(client.get_fd(), big.substr(pos, 300000));
+            }
+            response = read_http_responses(client.get_fd(), 1, 10000);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 201") == 0 &&
+                file_content(web_root / "files" / "big.bin") == big, "large body streamed to disk");
+        }
+
+        {
+            // chunked请求体，带扩展与trailer，之后紧跟一个管线化的GET
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(),
+                "POST /files/chunked.txt HTTP/1.1\r\nHost: localhost\r\nTransfer-Encoding: chunked\r\n\r\n"
+                "5\r\nhello\r\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            send_all(client.get_fd(), "7;ext=1\r\n, chunk\r\n" + std::string("1000\r\n") + std::string(4096, 'x') +
+                "\r\n0\r\nX-Trailer: 1\r\n\r\nGET /files/chunked.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+            response = read_http_responses(client.get_fd(), 2);
+            std::string expected = "hello, chunk" + std::string(4096, 'x');
+            ok &= check(response.compare(0, 12, "HTTP/1.1 201") == 0 &&
+                file_content(web_root / "files" / "chunked.txt") == expected, "chunked POST stored");
+            ok &= check(response.size() > expected.size() &&
+                response.compare(response.size() - expected.size(), expected.size(), expected) == 0,
+                "pipelined GET after the upload sees the new file");
+        }
+
+        {
+            // 100-continue：收到中间响应后再发送请求体
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "PUT /files/continue.txt HTTP/1.1\r\nHost: localhost\r\n"
+                "Content-Length: 8\r\nExpect: 100-continue\r\n\r\n");
+            std::string interim = read_http_responses(client.get_fd(), 1, 500);
+            send_all(client.get_fd(), "continue");
+            response = read_http_responses(client.get_fd(), 1);
+            ok &= check(interim.compare(0, 12, "HTTP/1.1 100") == 0 && response.find("HTTP/1.1 201") != std::string::npos &&
+                file_content(web_root / "files" / "continue.txt") == "continue", "Expect: 100-continue honoured");
+        }
+
+        response = http_request(server_addr, server_port, "PUT /files/too_big.bin HTTP/1.1\r\nHost: localhost\r\n"
+            "Content-Length: " + std::to_string(MAX_SIZE + 1) + "\r\n\r\n");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 413") == 0 &&
+            !std::filesystem::exists(web_root / "files" / "too_big.bin"), "oversized Content-Length rejected");
+
+        {
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "PUT /files/too_big.bin HTTP/1.1\r\nHost: localhost\r\n"
+                "Transfer-Encoding: chunked\r\n\r\n400000\r\n" + big + "\r\n400000\r\n" + big + "\r\n1\r\n");
+            response = read_http_responses(client.get_fd(), 1);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 413") == 0 &&
+                !std::filesystem::exists(web_root / "files" / "too_big.bin"), "oversized chunked body rejected");
+        }
+
+        {
+            // 被拒绝的请求体中的内容不会被当作请求执行
+            TcpClient client(server_addr, server_port);
+            std::string smuggled = "PUT /files/smuggled.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 1\r\n\r\nx";
+            send_all(client.get_fd(), "PUT /files/missing/a.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+                std::to_string(smuggled.size()) + "\r\n\r\n" + smuggled);
+            response = read_http_responses(client.get_fd(), 2, 500);
+            ok &= check(response.compare(0, 12, "HTTP/1.1 404") == 0 &&
+                response.find("HTTP/1.1 201") == std::string::npos &&
+                !std::filesystem::exists(web_root / "files" / "smuggled.txt"), "rejected body is not parsed as a request");
+        }
+
+        response = http_request(server_addr, server_port,
+            "PUT /../outside.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 1\r\n\r\nx");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 403") == 0, "upload outside web_root forbidden");
+
+        // 文件名超出NAME_MAX时路径无法解析，回复403而不是让filesystem_error终止服务
+        response = http_request(server_addr, server_port, "PUT /files/" + std::string(300, 'n') +
+            " HTTP/1.1\r\nHost: localhost\r\nContent-Length: 1\r\n\r\nx");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 403") == 0, "upload with an overlong file name rejected");
+        response = http_request(server_addr, server_port,
+            "PUT /files/after_long.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 2\r\n\r\nok");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 201") == 0, "server keeps serving after an overlong name");
+
+        response = http_request(server_addr, server_port, "POST /files/nolength.txt HTTP/1.1\r\nHost: localhost\r\n\r\n");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 411") == 0, "upload without length rejected");
+
+        {
+            // 中途断开：临时文件被删除，目标文件不出现
+            TcpClient client(server_addr, server_port);
+            send_all(client.get_fd(), "PUT /files/partial.bin HTTP/1.1\r\nHost: localhost\r\n"
+                "Content-Length: 1000000\r\n\r\n" + std::string(1000, 'p'));
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ok &= check(!std::filesystem::exists(web_root / "files" / "partial.bin") && !has_temp_files(web_root / "files"),
+            "aborted upload leaves no files behind");
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    try {
+        // 未启用上传时拒绝
+        HttpServer server(server_addr, server_port + 1, web_root.string());
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::string response = http_request(server_addr, server_port + 1,
+            "PUT /files/hello.txt HTTP/1.1\r\nHost: localhost\r\nContent-Length: 1\r\n\r\nx");
+        ok &= check(response.compare(0, 12, "HTTP/1.1 405") == 0 &&
+            file_content(web_root / "files" / "hello.txt") == "replace", "uploads disabled by default");
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTP upload test passed!" : "HTTP upload test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,203 @@
+// test_https_server.cpp
+extern "C" {
+#include <poll.h>
+}
+
+#include <openssl/ssl.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 生成localhost的自签名证书与私钥，写为PEM文件
+static bool make_self_signed_cert(const std::string& cert_file, const std::string& key_file)
+{
+    EVP_PKEY *key = EVP_EC_gen("prime256v1");
+    X509 *cert = X509_new();
+    if (key == nullptr || cert == nullptr) {
+        EVP_PKEY_free(key);
+        X509_free(cert);
+        return false;
+    }
+
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char *>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    bool ok = X509_sign(cert, key, EVP_sha256()) > 0;
+
+    FILE *fp = fopen(cert_file.c_str(), "w");
+    ok = ok && fp != nullptr && PEM_write_X509(fp, cert) == 1;
+    if (fp != nullptr) {
+        fclose(fp);
+    }
+    fp = fopen(key_file.c_str(), "w");
+    ok = ok && fp != nullptr && PEM_write_PrivateKey(fp, key, nullptr, nullptr, 0, nullptr, nullptr) == 1;
+    if (fp != nullptr) {
+        fclose(fp);
+    }
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+    return ok;
+}
+
+// 在非阻塞socket上等待TLS操作需要的事件
+static bool wait_tls(SSL *ssl, int32_t fd, int rc)
+{
+    int error = SSL_get_error(ssl, rc);
+    if (error != SSL_ERROR_WANT_READ && error != SSL_ERROR_WANT_WRITE) {
+        return false;
+    }
+    struct pollfd pfd = { fd, static_cast<short>(error == SSL_ERROR_WANT_READ ? POLLIN : POLLOUT), 0 };
+    return poll(&pfd, 1, 2000) > 0;
+}
+
+// 经TLS发送请求并读取完整的响应（依据Content-Length）
+static std::string https_roundtrip(SSL *ssl, int32_t fd, const std::string& request)
+{
+    for (size_t sent = 0; sent < request.size(); ) {
+        int rc = SSL_write(ssl, request.data() + sent, static_cast<int>(request.size() - sent));
+        if (rc > 0) {
+            sent += static_cast<size_t>(rc);
+        } else if (!wait_tls(ssl, fd, rc)) {
+            return "";
+        }
+    }
+
+    std::string response;
+    size_t expected = std::string::npos;
+    char buf[16384];
+    while (expected == std::string::npos || response.size() < expected) {
+        int rc = SSL_read(ssl, buf, sizeof(buf));
+        if (rc <= 0) {
+            if (!wait_tls(ssl, fd, rc)) {
+                break;
+            }
+            continue;
+        }
+        response.append(buf, static_cast<size_t>(rc));
+
+        size_t header_end = response.find("\r\n\r\n");
+        if (expected == std::string::npos && header_end != std::string::npos) {
+            size_t pos = response.find("Content-Length: ");
+            size_t body_len = 0;
+            if (pos != std::string::npos && pos < header_end) {
+                body_len = std::stoul(response.substr(pos + 16));
+            }
+            expected = header_end + 4 + body_len;
+        }
+    }
+    return response;
+}
+
+int test_https_server()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18082;
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_https_test";
+    const std::string cert_file = (web_root / "cert.pem").string();
+    const std::string key_file = (web_root / "key.pem").string();
+    const size_t FILE_SIZE = 3 * 1024 * 1024;
+
+    std::filesystem::create_directories(web_root);
+    {
+        std::ofstream(web_root / "index.html") << "<html><body>hello tls</body></html>";
+        std::ofstream data(web_root / "data.bin");
+        for (size_t i = 0; i < FILE_SIZE; i++) {
+            data.put(static_cast<char>('a' + i % 26));
+        }
+    }
+
+    bool ok = check(make_self_signed_cert(cert_file, key_file), "self-signed certificate generated");
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    try {
+        HttpServer server(server_addr, server_port, web_root.string());
+        server.enable_tls(cert_file, key_file);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        {
+            // 以自签名证书作为信任锚校验服务端
+            SSL_CTX_load_verify_locations(client_ctx, cert_file.c_str(), nullptr);
+            SSL_CTX_set_verify(client_ctx, SSL_VERIFY_PEER, nullptr);
+
+            TcpClient client(server_addr, server_port);
+            SSL *ssl = SSL_new(client_ctx);
+            SSL_set_fd(ssl, client.get_fd());
+            SSL_set_tlsext_host_name(ssl, "localhost");
+            int rc = 0;
+            while ((rc = SSL_connect(ssl)) != 1 && wait_tls(ssl, client.get_fd(), rc)) {
+            }
+            ok &= check(rc == 1 && SSL_get_verify_result(ssl) == X509_V_OK, "TLS handshake verified");
+
+            std::string page = https_roundtrip(ssl, client.get_fd(), "GET /index.html HTTP/1.1\r\n\r\n");
+            ok &= check(page.find("200 OK") != std::string::npos && page.find("hello tls") != std::string::npos,
+                "small file over TLS");
+            std::string cached = https_roundtrip(ssl, client.get_fd(), "GET /index.html HTTP/1.1\r\n\r\n");
+            ok &= check(cached == page, "cached response over TLS");
+
+            // 大文件走文件段：内核支持时经kTLS sendfile，否则在用户态加密
+            std::string data = https_roundtrip(ssl, client.get_fd(), "GET /data.bin HTTP/1.1\r\n\r\n");
+            std::string body = data.substr(data.find("\r\n\r\n") + 4);
+            bool intact = body.size() == FILE_SIZE;
+            for (size_t i = 0; intact && i < FILE_SIZE; i += 4099) {
+                intact = body[i] == static_cast<char>('a' + i % 26);
+            }
+            ok &= check(intact, "large file over TLS");
+
+            std::string range = https_roundtrip(ssl, client.get_fd(),
+                "GET /data.bin HTTP/1.1\r\nRange: bytes=2000000-2000025\r\n\r\n");
+            std::string expected_range;
+            for (size_t i = 2000000; i <= 2000025; i++) {
+                expected_range += static_cast<char>('a' + i % 26);
+            }
+            ok &= check(range.find("206 Partial Content") != std::string::npos &&
+                range.substr(range.size() - 26) == expected_range, "range over TLS");
+
+            SSL_shutdown(ssl);
+            SSL_free(ssl);
+        }
+
+        {
+            // 明文请求无法完成握手，连接被关闭
+            TcpClient plain_client(server_addr, server_port);
+            const std::string plain_req = "GET /index.html HTTP/1.1\r\n\r\n";
+            send_data_nonblock(plain_client.get_fd(), plain_req.c_str(), static_cast<uint16_t>(plain_req.size()));
+            struct pollfd pfd = { plain_client.get_fd(), POLLIN, 0 };
+            char buf[256];
+            bool closed = poll(&pfd, 1, 2000) > 0 && recv(plain_client.get_fd(), buf, sizeof(buf), 0) <= 0;
+            ok &= check(closed, "plaintext request is rejected");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const std::exception& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    SSL_CTX_free(client_ctx);
+    std::filesystem::remove_all(web_root);
+    std::cout << (ok ? "HTTPS server test passed!" : "HTTPS server test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// test_tcp_busy_poll.cpp
+extern "C" {
+#include <sys/socket.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 原样回送收到的字节
+class BusyPollEchoServer : public TcpServer {
+public:
+    BusyPollEchoServer(const std::string &listen_addr, uint16_t listen_port) : TcpServer(listen_addr, listen_port) {}
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[4096];
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            send_data_nonblock(client_fd, buf, static_cast<uint16_t>(len));
+        }
+    }
+};
+
+int test_tcp_busy_poll()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18098;
+    bool ok = true;
+
+    try {
+        BusyPollEchoServer server(server_addr, server_port);
+        TcpBusyPollConfig config;
+        config.spin_budget = std::chrono::microseconds(500);
+        config.epoll_busy_poll_us = 20;
+        server.enable_busy_poll(config);
+
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            TcpClient client(server_addr, server_port);
+            bool echoed = true;
+            for (int i = 0; i < 200 && echoed; i++) {
+                echoed = echo_round_trip(client.get_fd(), "ping " + std::to_string(i));
+            }
+            ok &= check(echoed, "messages echoed in busy poll mode");
+        }
+
+        // 空闲时自旋预算用尽后转为阻塞等待
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        running = false;
+        server_thread.join();
+
+        TcpBusyPollStats stats = server.get_busy_poll_stats();
+        std::cout << "spin polls: " << stats.spin_polls << ", spin hits: " << stats.spin_hits << ", blocking waits: "
+            << stats.blocking_waits << ", spin us: " << stats.spin_us << ", socket busy poll: "
+            << stats.socket_busy_poll << ", epoll busy poll: " << stats.epoll_busy_poll << std::endl;
+        ok &= check(stats.spin_polls >= stats.spin_hits + stats.blocking_waits && stats.spin_hits > 0,
+            "events picked up while spinning");
+        ok &= check(stats.blocking_waits > 0, "idle loop falls back to blocking wait");
+        ok &= check(stats.spin_hit_ratio() > 0 && stats.spin_hit_ratio() <= 1, "spin hit ratio in range");
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "TCP busy poll test passed!" : "TCP busy poll test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+// test_tcp_codec.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <array>
+
+#include "tcp_codec.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+enum CodecTestColor : uint8_t {
+    CODEC_RED = 1,
+    CODEC_BLUE = 2,
+};
+
+struct CodecPoint {
+    static constexpr uint16_t TYPE_ID = 7;
+    int32_t x = 0;
+    int16_t y = 0;
+    CodecTestColor color = CODEC_RED;
+    bool visible = false;
+    using Fields = TcpFields<&CodecPoint::x, &CodecPoint::y, &CodecPoint::color, &CodecPoint::visible>;
+};
+
+struct CodecLogin {
+    static constexpr uint16_t TYPE_ID = 1;
+    uint64_t session = 0;
+    std::string_view name;
+    std::array<uint16_t, 3> levels = {};
+    using Fields = TcpFields<&CodecLogin::session, &CodecLogin::name, &CodecLogin::levels>;
+};
+
+struct CodecReply {
+    static constexpr uint16_t TYPE_ID = 2;
+    uint32_t count = 0;
+    std::string text;
+    using Fields = TcpFields<&CodecReply::count, &CodecReply::text>;
+};
+
+// 编码与解码都可在编译期求值
+constexpr std::array<char, 15> encode_point()
+{
+    std::array<char, 15> frame = {};
+    CodecPoint point;
+    point.x = -2;
+    point.y = 300;
+    point.color = CODEC_BLUE;
+    point.visible = true;
+    tcp_encode(point, frame.data(), frame.size());
+    return frame;
+}
+
+constexpr bool point_round_trips()
+{
+    std::array<char, 15> frame = encode_point();
+    CodecPoint point;
+    return tcp_decode(frame.data(), 12, point) && point.x == -2 && point.y == 300 && point.color == CODEC_BLUE &&
+        point.visible;
+}
+
+static_assert(encode_point()[1] == 12 && encode_point()[3] == 7, "point frame header");
+static_assert(encode_point()[4] == static_cast<char>(0xFF) && encode_point()[7] == static_cast<char>(0xFE),
+    "point fields in network order");
+static_assert(point_round_trips(), "point decodes at compile time");
+
+// 收到登录消息后回复一条计数消息，其余类型的帧视为非法
+class CodecTestServer : public TcpMessageServer<CodecTestServer, CodecLogin, CodecPoint> {
+public:
+    std::atomic<uint32_t> logins{0};
+    std::atomic<uint32_t> points{0};
+    std::atomic<uint32_t> bad_frames{0};
+
+    using TcpMessageServer::TcpMessageServer;
+
+    void on_message(int32_t client_fd, const CodecLogin& login)
+    {
+        logins++;
+        CodecReply reply;
+        reply.count = logins;
+        reply.text = std::string(login.name) + ":" + std::to_string(login.session + login.levels[2]);
+        send_message(client_fd, reply);
+    }
+
+    void on_message(int32_t client_fd, const CodecPoint& point)
+    {
+        static_cast<void>(client_fd);
+        points += point.visible ? 1 : 0;
+    }
+
+protected:
+    void deal_bad_frame(int32_t client_fd, uint16_t type_id) override
+    {
+        bad_frames++;
+        TcpMessageServer::deal_bad_frame(client_fd, type_id);
+    }
+};
+
+// 读取一条完整的回复帧
+static bool recv_reply(int32_t fd, std::string& frame)
+{
+    frame.clear();
+    char buf[4096];
+    while (frame.size() < TCP_FRAME_HEADER_SIZE || frame.size() < tcp_frame_length(frame.data())) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        frame.append(buf, static_cast<size_t>(len));
+    }
+    return true;
+}
+
+static std::string encode_frame(const CodecLogin& login)
+{
+    std::string frame(tcp_encoded_size(login), '\0');
+    tcp_encode(login, frame.data(), frame.size());
+    return frame;
+}
+
+int test_tcp_codec()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18110;
+    bool ok = true;
+
+    {
+        CodecLogin login;
+        login.session = 0x0102030405060708ULL;
+        login.name = "alice";
+        login.levels = { 1, 2, 65535 };
+        std::string frame = encode_frame(login);
+        CodecLogin decoded;
+        ok &= check(frame.size() == 4 + 8 + 2 + 5 + 6 && tcp_decode(frame.data(), frame.size(), decoded) &&
+            decoded.session == login.session && decoded.name == "alice" && decoded.levels == login.levels &&
+            decoded.name.data() == frame.data() + 14, "string fields decode in place");
+
+        CodecPoint point;
+        CodecReply reply;
+        ok &= check(!tcp_decode(frame.data(), frame.size(), point) && !tcp_decode(frame.data(), frame.size() - 1, decoded),
+            "wrong type and truncated frame rejected");
+        frame[12] = 1; // 字符串长度超出帧尾
+        ok &= check(!tcp_decode(frame.data(), frame.size(), decoded), "overlong string rejected");
+
+        reply.text = std::string(TCP_FRAME_MAX_SIZE, 'x');
+        std::string big(TCP_FRAME_MAX_SIZE + 16, '\0');
+        ok &= check(tcp_encode(reply, big.data(), big.size()) == 0 &&
+            tcp_encode(login, big.data(), tcp_encoded_size(login) - 1) == 0, "oversized message not encoded");
+    }
+
+    try {
+        CodecTestServer server(server_addr, server_port);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            TcpClient client(server_addr, server_port);
+            CodecLogin login;
+            login.name = "bob";
+            login.session = 40;
+            login.levels = { 0, 0, 2 };
+            CodecPoint point;
+            point.visible = true;
+            std::string point_frame(tcp_encoded_size(point), '\0');
+            tcp_encode(point, point_frame.data(), point_frame.size());
+
+            // 两帧合并在一次发送中，第三帧拆成两次发送
+            std::string batch = encode_frame(login) + point_frame + encode_frame(login);
+            size_t split = batch.size() - 5;
+            send_data_nonblock(client.get_fd(), batch.data(), static_cast<uint16_t>(split));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            send_data_nonblock(client.get_fd(), batch.data() + split, static_cast<uint16_t>(batch.size() - split));
+
+            std::string frame;
+            CodecReply first;
+            CodecReply second;
+            ok &= check(recv_reply(client.get_fd(), frame) && tcp_decode(frame.data(), tcp_frame_length(frame.data()),
+                first) && first.count == 1 && first.text == "bob:42", "reply to the first frame");
+            frame.erase(0, tcp_frame_length(frame.data()));
+            ok &= check((!frame.empty() || recv_reply(client.get_fd(), frame)) &&
+                tcp_decode(frame.data(), tcp_frame_length(frame.data()), second) && second.count == 2,
+                "reply to the frame split across sends");
+            ok &= check(server.points == 1, "frames of different types dispatched");
+        }
+
+        {
+            // 未声明的类型ID关闭连接
+            TcpClient client(server_addr, server_port);
+            CodecReply unknown;
+            std::string frame(tcp_encoded_size(unknown), '\0');
+            tcp_encode(unknown, frame.data(), frame.size());
+            send_data_nonblock(client.get_fd(), frame.data(), static_cast<uint16_t>(frame.size()));
+            char buf[16];
+            struct pollfd pfd = { client.get_fd(), POLLIN, 0 };
+            ok &= check(poll(&pfd, 1, 2000) > 0 && recv(client.get_fd(), buf, sizeof(buf), 0) == 0 &&
+                server.bad_frames == 1, "unknown message type closes the connection");
+        }
+
+        running = false;
+        server_thread.join();
+        ok &= check(server.get_frame_pool().get_free_count() >= 1, "frame buffers returned to the pool");
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "TCP codec test passed!" : "TCP codec test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,263 @@
+// test_tcp_fanout.cpp
+extern "C" {
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <future>
+#include <functional>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 客户端每发送一行即订阅该行的主题；测试线程投递的任务在事件循环线程逐轮执行，每轮一个
+class FanoutTestServer : public TcpServer {
+private:
+    std::mutex tasks_mutex;
+    std::deque<std::function<void()>> tasks;
+
+public:
+    using TcpServer::TcpServer;
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[256];
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) {
+            this->close_client(client_fd);
+            return;
+        }
+        std::string lines(buf, static_cast<size_t>(len));
+        size_t begin = 0;
+        for (size_t end = lines.find('\n'); end != std::string::npos; end = lines.find('\n', begin)) {
+            this->subscribe(client_fd, lines.substr(begin, end - begin));
+            begin = end + 1;
+        }
+    }
+
+    void deal_loop_end() override
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(this->tasks_mutex);
+            if (this->tasks.empty()) {
+                return;
+            }
+            task = std::move(this->tasks.front());
+            this->tasks.pop_front();
+        }
+        task();
+    }
+
+    int32_t get_loop_timeout() override
+    {
+        std::lock_guard<std::mutex> lock(this->tasks_mutex);
+        return this->tasks.empty() ? 10 : 0;
+    }
+
+    // 在事件循环线程执行fn并等待其返回值
+    template <typename F>
+    auto run_in_loop(F fn) -> decltype(fn())
+    {
+        auto task = std::make_shared<std::packaged_task<decltype(fn())()>>(fn);
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(this->tasks_mutex);
+            this->tasks.push_back([task]() { (*task)(); });
+        }
+        return result.get();
+    }
+
+    // 投递count轮发布，每轮在topic上发布burst帧，返回最后一帧的序号
+    uint32_t publish_rounds(const std::string& topic, uint32_t first_seq, uint32_t count, uint32_t burst, size_t size)
+    {
+        uint32_t seq = first_seq;
+        for (uint32_t round = 0; round < count; round++) {
+            seq = run_in_loop([this, topic, seq, burst, size]() {
+                uint32_t next = seq;
+                for (uint32_t i = 0; i < burst; i++) {
+                    std::string frame(size, 'f');
+                    uint16_t length = htons(static_cast<uint16_t>(size));
+                    uint32_t net_seq = htonl(next++);
+                    memcpy(frame.data(), &length, sizeof(length));
+                    memcpy(frame.data() + sizeof(length), &net_seq, sizeof(net_seq));
+                    this->publish(topic, frame.data(), frame.size());
+                }
+                return next;
+            });
+        }
+        return seq - 1;
+    }
+};
+
+// 读取并校验收到的帧：内容完整且序号递增；读到last或对端关闭为止，返回收到的完整帧数，帧有误时返回-1
+static int64_t read_frames(int32_t fd, uint32_t last, bool& closed, uint32_t& last_seen)
+{
+    std::string stream;
+    std::vector<char> buf(64 * 1024);
+    int64_t frames = 0;
+    closed = false;
+    last_seen = 0;
+    bool first = true;
+    for (;;) {
+        while (stream.size() >= 6) {
+            uint16_t length = 0;
+            uint32_t seq = 0;
+            memcpy(&length, stream.data(), sizeof(length));
+            memcpy(&seq, stream.data() + 2, sizeof(seq));
+            length = ntohs(length);
+            seq = ntohl(seq);
+            if (length < 6 || stream.size() < length) {
+                break;
+            }
+            if ((!first && seq <= last_seen) || stream.find_first_not_of('f', 6) < length) {
+                return -1;
+            }
+            first = false;
+            last_seen = seq;
+            frames++;
+            stream.erase(0, length);
+        }
+        if (!first && last_seen == last && stream.empty()) {
+            return frames;
+        }
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 3000) <= 0) {
+            return frames;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            // 断开时已发出一部分的帧不再补齐，末尾可能是不完整的帧
+            closed = true;
+            return frames;
+        }
+        stream.append(buf.data(), static_cast<size_t>(len));
+    }
+}
+
+static void subscribe_client(int32_t fd, const std::string& topics)
+{
+    send_data_nonblock(fd, topics.c_str(), static_cast<uint16_t>(topics.size()));
+}
+
+int test_tcp_fanout()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18111;
+    bool ok = true;
+
+    try {
+        FanoutTestServer server(server_addr, server_port);
+        TcpSocketOptions server_options;
+        server_options.send_buffer = 16 * 1024;
+        server.set_socket_options(server_options);
+        TcpTopicConfig config;
+        config.max_queued = 8;
+        server.set_topic_config("drop", config);
+        config.policy = TCP_SLOW_CONFLATE;
+        server.set_topic_config("conflate", config);
+        config.policy = TCP_SLOW_DISCONNECT;
+        config.max_queued = 4;
+        server.set_topic_config("disconnect", config);
+
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            // 同一帧按序送达全部订阅者，未订阅的连接收不到
+            std::vector<std::unique_ptr<TcpClient>> clients;
+            for (int i = 0; i < 4; i++) {
+                clients.push_back(std::make_unique<TcpClient>(server_addr, server_port));
+                subscribe_client(clients.back()->get_fd(), i < 3 ? "news\nother\n" : "other\n");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            size_t receivers = server.run_in_loop([&server]() {
+                return server.publish("news", make_shared_frame("\x00\x06\x00\x00\x00\x00", 6));
+            });
+            uint32_t last = server.publish_rounds("news", 1, 20, 10, 100);
+
+            bool delivered = receivers == 3;
+            for (int i = 0; i < 3; i++) {
+                bool closed = false;
+                uint32_t last_seen = 0;
+                delivered &= read_frames(clients[i]->get_fd(), last, closed, last_seen) == 201 && last_seen == last;
+            }
+            ok &= check(delivered, "frames delivered in order to every subscriber");
+            char byte;
+            ok &= check(recv(clients[3]->get_fd(), &byte, 1, MSG_DONTWAIT) < 0, "other topics not delivered");
+            TcpFanoutStats stats = server.run_in_loop([&server]() { return server.get_fanout_stats(); });
+            ok &= check(stats.enqueued == 603, "each frame queued once per subscriber");
+
+            clients.erase(clients.begin());
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            receivers = server.run_in_loop([&server]() { return server.publish("news", "\x00\x06\x00\x00\x00\x00", 6); });
+            ok &= check(receivers == 2, "closed subscriber removed from topics");
+        }
+
+        for (const char *topic : { "drop", "conflate" }) {
+            // 不读取的订阅者：队列长度受限，恢复读取后收到完整且递增的帧，最后一帧为最新发布的帧
+            TcpSocketOptions options;
+            options.recv_buffer = 4096;
+            TcpClient slow(TcpAddress::inet(server_addr, server_port), options);
+            subscribe_client(slow.get_fd(), std::string(topic) + "\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+            TcpFanoutStats before = server.run_in_loop([&server]() { return server.get_fanout_stats(); });
+            uint32_t last = server.publish_rounds(topic, 1, 40, 50, 4000);
+            size_t queued = server.run_in_loop([&server]() {
+                size_t max_queued = 0;
+                for (int32_t fd = 3; fd < 1024; fd++) {
+                    max_queued = std::max(max_queued, server.get_queued_frames(fd));
+                }
+                return max_queued;
+            });
+            TcpFanoutStats after = server.run_in_loop([&server]() { return server.get_fanout_stats(); });
+
+            bool closed = false;
+            uint32_t last_seen = 0;
+            int64_t frames = read_frames(slow.get_fd(), last, closed, last_seen);
+            bool bounded = std::string(topic) == "drop" ? queued <= 8 && after.dropped > before.dropped :
+                queued <= 1 && after.conflated > before.conflated;
+            ok &= check(bounded && frames > 0 && frames < 2000 && last_seen == last && !closed,
+                std::string(topic) + ": slow subscriber queue bounded, latest frame delivered");
+        }
+
+        {
+            TcpSocketOptions options;
+            options.recv_buffer = 4096;
+            TcpClient slow(TcpAddress::inet(server_addr, server_port), options);
+            subscribe_client(slow.get_fd(), "disconnect\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            server.publish_rounds("disconnect", 1, 40, 50, 4000);
+
+            bool closed = false;
+            uint32_t last_seen = 0;
+            int64_t frames = read_frames(slow.get_fd(), UINT32_MAX, closed, last_seen);
+            TcpFanoutStats stats = server.run_in_loop([&server]() { return server.get_fanout_stats(); });
+            ok &= check(frames > 0 && closed && stats.disconnected == 1, "disconnect: slow subscriber closed");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "TCP fanout test passed!" : "TCP fanout test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,197 @@
+// test_tcp_post_send.cpp
+extern "C" {
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <poll.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <cstring>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+#include "test_helper.hpp"
+
+// 记录最新连入客户端的连接ID，供其他线程post_send()；事件循环使用默认的2s超时，只能由eventfd及时唤醒
+class PostTestServer : public TcpServer {
+private:
+    std::mutex id_mutex;
+    std::condition_variable id_cond;
+    uint64_t last_conn_id = 0;
+    std::atomic<uint64_t> orphaned{0};
+
+public:
+    using TcpServer::TcpServer;
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        static_cast<void>(client_addr);
+        std::lock_guard<std::mutex> lock(this->id_mutex);
+        this->last_conn_id = this->get_conn_id(client_fd);
+        this->id_cond.notify_all();
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[256];
+        if (recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT) == 0) {
+            this->close_client(client_fd);
+        }
+    }
+
+    void deal_loop_end() override
+    {
+        this->orphaned = this->get_fanout_stats().orphaned;
+    }
+
+    // 等待一个不同于previous的连接ID
+    uint64_t wait_conn_id(uint64_t previous)
+    {
+        std::unique_lock<std::mutex> lock(this->id_mutex);
+        this->id_cond.wait_for(lock, std::chrono::seconds(2), [&]() { return this->last_conn_id != previous; });
+        return this->last_conn_id;
+    }
+
+    uint64_t get_orphaned() const
+    {
+        return this->orphaned;
+    }
+};
+
+// 帧格式：2字节帧长 | 1字节生产者编号 | 4字节序号 | 填充为生产者编号
+static std::string make_frame(uint8_t producer, uint32_t seq)
+{
+    size_t size = 7 + (seq * 131 + producer * 17) % 3000;
+    std::string frame(size, static_cast<char>('a' + producer));
+    uint16_t length = htons(static_cast<uint16_t>(size));
+    uint32_t net_seq = htonl(seq);
+    memcpy(frame.data(), &length, sizeof(length));
+    frame[2] = static_cast<char>(producer);
+    memcpy(frame.data() + 3, &net_seq, sizeof(net_seq));
+    return frame;
+}
+
+// 读取total帧，校验每帧完整、每个生产者的序号连续；超时或帧有误时返回false
+static bool read_posted_frames(int32_t fd, size_t total, std::vector<uint32_t>& next_seq)
+{
+    std::string stream;
+    std::vector<char> buf(64 * 1024);
+    size_t frames = 0;
+    while (frames < total) {
+        while (stream.size() >= 7) {
+            uint16_t length = 0;
+            uint32_t seq = 0;
+            memcpy(&length, stream.data(), sizeof(length));
+            memcpy(&seq, stream.data() + 3, sizeof(seq));
+            length = ntohs(length);
+            seq = ntohl(seq);
+            if (stream.size() < length) {
+                break;
+            }
+            uint8_t producer = static_cast<uint8_t>(stream[2]);
+            if (producer >= next_seq.size() || seq != next_seq[producer] ||
+                stream.find_first_not_of(static_cast<char>('a' + producer), 7) < length) {
+                return false;
+            }
+            next_seq[producer]++;
+            frames++;
+            stream.erase(0, length);
+        }
+        if (frames == total) {
+            break;
+        }
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, 3000) <= 0) {
+            return false;
+        }
+        ssize_t len = recv(fd, buf.data(), buf.size(), MSG_DONTWAIT);
+        if (len <= 0) {
+            return false;
+        }
+        stream.append(buf.data(), static_cast<size_t>(len));
+    }
+    return stream.empty();
+}
+
+int test_tcp_post_send()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18116;
+    const uint8_t PRODUCERS = 8;
+    const uint32_t FRAMES_PER_PRODUCER = 2000;
+    bool ok = true;
+
+    try {
+        PostTestServer server(server_addr, server_port);
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            // 多个线程同时向同一连接投递，帧不交错且各自保持顺序
+            TcpClient client(server_addr, server_port);
+            uint64_t conn_id = server.wait_conn_id(0);
+            ok &= check(conn_id != 0 && static_cast<int32_t>(conn_id & UINT32_MAX) > 2, "connection id assigned");
+
+            std::vector<std::thread> producers;
+            for (uint8_t p = 0; p < PRODUCERS; p++) {
+                producers.emplace_back([&server, conn_id, p]() {
+                    for (uint32_t seq = 0; seq < FRAMES_PER_PRODUCER; seq++) {
+                        std::string frame = make_frame(p, seq);
+                        server.post_send(conn_id, frame.data(), frame.size());
+                    }
+                });
+            }
+            std::vector<uint32_t> next_seq(PRODUCERS, 0);
+            bool received = read_posted_frames(client.get_fd(), PRODUCERS * FRAMES_PER_PRODUCER, next_seq);
+            for (std::thread& producer : producers) {
+                producer.join();
+            }
+            ok &= check(received, "frames from concurrent producers arrive whole and in order");
+
+            // 事件循环空闲时阻塞在2s超时的epoll_wait中，投递后由eventfd立即唤醒
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            auto begin = std::chrono::steady_clock::now();
+            std::string frame = make_frame(0, FRAMES_PER_PRODUCER);
+            server.post_send(conn_id, make_shared_frame(frame.data(), frame.size()));
+            received = read_posted_frames(client.get_fd(), 1, next_seq);
+            auto elapsed = std::chrono::steady_clock::now() - begin;
+            ok &= check(received && elapsed < std::chrono::milliseconds(500), "idle event loop woken by post_send");
+        }
+
+        {
+            // 旧连接关闭后，其fd被新连接复用，发给旧连接ID的帧不会送达新连接
+            uint64_t old_id = server.wait_conn_id(0);
+            TcpClient client(server_addr, server_port);
+            uint64_t new_id = server.wait_conn_id(old_id);
+            server.post_send(old_id, "stale", 5);
+            std::string frame = make_frame(1, 0);
+            server.post_send(new_id, frame.data(), frame.size());
+
+            std::vector<uint32_t> next_seq(PRODUCERS, 0);
+            ok &= check(new_id != old_id && read_posted_frames(client.get_fd(), 1, next_seq) && next_seq[1] == 1,
+                "frames for a closed connection are not delivered to its successor");
+            ok &= check(server.get_orphaned() == 1, "stale frame discarded");
+        }
+
+        running = false;
+        server.post_send(0, "stop", 4); // 唤醒事件循环，使其及时退出
+        server_thread.join();
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "TCP post send test passed!" : "TCP post send test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,151 @@
+// test_tcp_socket_options.cpp
+extern "C" {
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+}
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "http_server.hpp"
+#include "tcp_client.hpp"
+#include "tcp_socket_options.hpp"
+#include "test_helper.hpp"
+
+static int32_t get_option(int32_t fd, int32_t level, int32_t name)
+{
+    int32_t value = -1;
+    socklen_t len = sizeof(value);
+    if (getsockopt(fd, level, name, &value, &len) < 0) {
+        return -1;
+    }
+    return value;
+}
+
+static bool throws_on(const std::string& name)
+{
+    try {
+        TcpSocketOptions::parse(name);
+    } catch (const TcpRuntimeException&) {
+        return true;
+    }
+    return false;
+}
+
+// 记录最近accept的连接，用于检查其选项
+class OptionsTestServer : public TcpServer {
+public:
+    std::atomic<int32_t> last_client{-1};
+
+    OptionsTestServer(const std::string &listen_addr, uint16_t listen_port) : TcpServer(listen_addr, listen_port) {}
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        TcpServer::deal_new_client(client_fd, client_addr);
+        last_client = client_fd;
+    }
+};
+
+// 发送请求并读完整个响应，返回响应体，失败时返回空
+static std::string fetch(int32_t fd, const std::string& request)
+{
+    std::string response = http_roundtrip(fd, request, 2000);
+    return count_http_responses(response) == 1 ? http_body(response) : "";
+}
+
+int test_tcp_socket_options()
+{
+    const std::string server_addr = "127.0.0.1";
+    const uint16_t server_port = 18101;
+    bool ok = true;
+
+    TcpSocketOptions latency = TcpSocketOptions::latency();
+    TcpSocketOptions throughput = TcpSocketOptions::throughput();
+    ok &= check(TcpSocketOptions::parse("latency").nodelay && TcpSocketOptions::parse("throughput").cork &&
+        !TcpSocketOptions::parse("default").nodelay && throws_on("fast"), "profiles parsed");
+
+    try {
+        OptionsTestServer server(server_addr, server_port);
+        server.set_socket_options(latency);
+        ok &= check(get_option(server.get_listen_fd(), IPPROTO_TCP, TCP_FASTOPEN) == latency.fastopen_queue,
+            "fast open queue set on the listen socket");
+
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            TcpClient client(server_addr, server_port, latency);
+            ok &= check(get_option(client.get_fd(), IPPROTO_TCP, TCP_NODELAY) == 1 &&
+                get_option(client.get_fd(), IPPROTO_TCP, TCP_FASTOPEN_CONNECT) == 1, "client options set");
+            // Fast Open下握手推迟到首次发送
+            send_data_nonblock(client.get_fd(), "x", 1);
+            for (int i = 0; i < 100 && server.last_client < 0; i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            int32_t accepted = server.last_client;
+            ok &= check(accepted >= 0 && get_option(accepted, IPPROTO_TCP, TCP_NODELAY) == 1 &&
+                get_option(accepted, IPPROTO_TCP, TCP_NOTSENT_LOWAT) == latency.notsent_lowat,
+                "accepted connection options set");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    // 吞吐预设下响应在cork期间发送，发完解除后最后的不满报文应立即发出，而不是等待内核200ms的cork超时
+    const std::filesystem::path web_root = std::filesystem::temp_directory_path() / "tcp_example_socket_options";
+    std::filesystem::create_directories(web_root);
+    const std::string large(300 * 1024 + 17, 'l');
+    std::ofstream(web_root / "large.bin") << large;
+    try {
+        HttpServer server(server_addr, static_cast<uint16_t>(server_port + 1), web_root.string(), 1);
+        server.set_socket_options(throughput);
+        ok &= check(get_option(server.get_listen_fd(), IPPROTO_TCP, TCP_DEFER_ACCEPT) > 0 &&
+            get_option(server.get_listen_fd(), SOL_SOCKET, SO_SNDBUF) >= throughput.send_buffer,
+            "defer accept and buffer size set on the listen socket");
+
+        std::atomic<bool> running(true);
+        std::thread server_thread([&]() {
+            while (running) {
+                server.listen_loop();
+            }
+        });
+
+        {
+            TcpClient client(server_addr, static_cast<uint16_t>(server_port + 1));
+            bool same = true;
+            auto begin = std::chrono::steady_clock::now();
+            for (int i = 0; i < 5 && same; i++) {
+                same = fetch(client.get_fd(), "GET /large.bin HTTP/1.1\r\n\r\n") == large;
+            }
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - begin);
+            ok &= check(same, "corked responses intact");
+            ok &= check(elapsed < std::chrono::milliseconds(800), "cork released at the end of each response");
+        }
+
+        running = false;
+        server_thread.join();
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+    std::filesystem::remove_all(web_root);
+
+    std::cout << (ok ? "TCP socket options test passed!" : "TCP socket options test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
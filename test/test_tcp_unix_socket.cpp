@@ -0,0 +1,124 @@
+// test_tcp_unix_socket.cpp
+extern "C" {
+#include <unistd.h>
+#include <sys/socket.h>
+}
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <string>
+#include <filesystem>
+
+#include "tcp_server.hpp"
+#include "tcp_client.hpp"
+#include "tcp_address.hpp"
+#include "test_helper.hpp"
+
+static bool throws_on(const std::string& spec)
+{
+    try {
+        TcpAddress::parse(spec);
+    } catch (const TcpRuntimeException&) {
+        return true;
+    }
+    return false;
+}
+
+// 原样回送收到的字节，并记录连入的地址族
+class UnixEchoServer : public TcpServer {
+public:
+    std::atomic<int32_t> last_family{-1};
+
+    explicit UnixEchoServer(const TcpAddress& address) : TcpServer(address) {}
+
+    void deal_new_client(int32_t client_fd, const sockaddr_in& client_addr) override
+    {
+        TcpServer::deal_new_client(client_fd, client_addr);
+        last_family = client_addr.sin_family;
+    }
+
+    void deal_client_msg(int32_t client_fd) override
+    {
+        char buf[4096];
+        ssize_t len = recv(client_fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len > 0) {
+            send_data_nonblock(client_fd, buf, static_cast<uint16_t>(len));
+        }
+    }
+};
+
+// 在address上启动回送服务器，经TcpClient往返若干消息
+static bool serve_and_echo(const TcpAddress& address)
+{
+    UnixEchoServer server(address);
+    std::atomic<bool> running(true);
+    std::thread server_thread([&]() {
+        while (running) {
+            server.listen_loop();
+        }
+    });
+
+    bool echoed = true;
+    {
+        TcpClient client(address);
+        for (int i = 0; i < 50 && echoed; i++) {
+            echoed = echo_round_trip(client.get_fd(), "local " + std::to_string(i));
+        }
+    }
+    running = false;
+    server_thread.join();
+    return echoed && server.last_family == AF_UNIX;
+}
+
+int test_tcp_unix_socket()
+{
+    bool ok = true;
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "tcp_example_unix_test.sock";
+
+    TcpAddress file_address = TcpAddress::parse("unix:" + path.string());
+    TcpAddress abstract_address = TcpAddress::parse("unix:@tcp_example_unix_test");
+    TcpAddress inet_address = TcpAddress::parse("127.0.0.1:18105");
+    ok &= check(file_address.is_local() && !file_address.is_abstract() && file_address.get_host() == path.string() &&
+        abstract_address.is_abstract() && abstract_address.to_string() == "unix:@tcp_example_unix_test" &&
+        !inet_address.is_local() && inet_address.get_port() == 18105 && inet_address.to_string() == "127.0.0.1:18105",
+        "addresses parsed");
+    ok &= check(throws_on("unix:") && throws_on("unix:@") && throws_on("localhost") && throws_on("1.2.3.4:99999") &&
+        throws_on("unix:" + std::string(200, 'p')), "malformed addresses rejected");
+
+    try {
+        // 上次未清理的socket文件不妨碍绑定
+        int32_t stale = socket(AF_UNIX, SOCK_STREAM, 0);
+        static_cast<void>(bind(stale, file_address.get_sockaddr(), file_address.get_length()));
+        close(stale);
+        ok &= check(std::filesystem::is_socket(path), "stale socket file left behind");
+
+        ok &= check(serve_and_echo(file_address), "messages echoed over a filesystem unix socket");
+        ok &= check(!std::filesystem::exists(path), "socket file removed when the server closes");
+        ok &= check(serve_and_echo(abstract_address), "messages echoed over an abstract unix socket");
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    try {
+        // 接管的Unix域监听socket不删除其文件
+        int32_t listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        static_cast<void>(bind(listen_fd, file_address.get_sockaddr(), file_address.get_length()));
+        static_cast<void>(listen(listen_fd, 5));
+        {
+            TcpServer server(listen_fd);
+            ok &= check(server.get_listen_address().is_local() && server.get_listen_addr() == path.string() &&
+                server.get_listen_port() == 0, "inherited unix listen socket accepted");
+        }
+        ok &= check(std::filesystem::is_socket(path), "inherited socket file kept");
+        std::filesystem::remove(path);
+    } catch (const TcpRuntimeException& e) {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        ok = false;
+    }
+
+    std::cout << (ok ? "TCP unix socket test passed!" : "TCP unix socket test FAILED!") << std::endl;
+    return ok ? 0 : 1;
+}
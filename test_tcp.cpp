@@ -2,12 +2,52 @@
 int test_tcp_communication();
 int test_tcp_10client();
 int test_parallel_communication();
+int test_http_server();
+int test_https_server();
+int test_http2_server();
+int test_http_header_builder();
+int test_http_admission();
+int test_http_shaping();
+int test_http_drain();
+int test_http_pack();
+int test_http_upload();
+int test_http_proxy();
+int test_http_trace();
+int test_work_stealing_executor();
+int test_cpu_placement();
+int test_tcp_busy_poll();
+int test_tcp_socket_options();
+int test_tcp_unix_socket();
+int test_tcp_codec();
+int test_tcp_fanout();
+int test_tcp_post_send();
 
 int main(const int argc, const char *argv[])
 {
-    test_tcp_communication();
-    test_tcp_10client();
-    test_parallel_communication();
+    // 每个测试函数失败时返回非0，任一失败则整体返回非0
+    int failed = 0;
+    failed |= test_tcp_communication() != 0;
+    failed |= test_tcp_10client() != 0;
+    failed |= test_parallel_communication() != 0;
+    failed |= test_http_server() != 0;
+    failed |= test_https_server() != 0;
+    failed |= test_http2_server() != 0;
+    failed |= test_http_header_builder() != 0;
+    failed |= test_http_admission() != 0;
+    failed |= test_http_shaping() != 0;
+    failed |= test_http_drain() != 0;
+    failed |= test_http_pack() != 0;
+    failed |= test_http_upload() != 0;
+    failed |= test_http_proxy() != 0;
+    failed |= test_http_trace() != 0;
+    failed |= test_work_stealing_executor() != 0;
+    failed |= test_cpu_placement() != 0;
+    failed |= test_tcp_busy_poll() != 0;
+    failed |= test_tcp_socket_options() != 0;
+    failed |= test_tcp_unix_socket() != 0;
+    failed |= test_tcp_codec() != 0;
+    failed |= test_tcp_fanout() != 0;
+    failed |= test_tcp_post_send() != 0;
 
-    return 0;
+    return failed;
 }
\ No newline at end of file